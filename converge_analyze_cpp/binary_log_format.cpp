@@ -0,0 +1,522 @@
+#include "binary_log_format.h"
+#include "event_clock.h"
+#include <cstring>
+#include <random>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "二进制日志格式按小端序直接拷贝整数，暂不支持大端平台"
+#endif
+
+namespace {
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// 有界读取，越界后 ok() 为false且后续读取返回0
+class Reader {
+public:
+    Reader(const char* data, size_t len) : data_(data), len_(len) {}
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (!ok_ || len_ - pos_ < sizeof(T)) {
+            ok_ = false;
+            return value;
+        }
+        memcpy(&value, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return value;
+    }
+
+    bool get_bytes(std::string& out, size_t n) {
+        if (!ok_ || len_ - pos_ < n) {
+            ok_ = false;
+            return false;
+        }
+        out.assign(data_ + pos_, n);
+        pos_ += n;
+        return true;
+    }
+
+    bool ok() const { return ok_; }
+
+private:
+    const char* data_;
+    size_t len_;
+    size_t pos_{0};
+    bool ok_{true};
+};
+
+std::string address_key(const struct in6_addr& addr) {
+    return std::string(reinterpret_cast<const char*>(&addr), sizeof(addr));
+}
+
+} // namespace
+
+namespace BinaryLog {
+
+Encoder::Encoder() {
+    std::random_device rd;
+    stream_id_ = rd();
+    body_.reserve(256);
+}
+
+void Encoder::append_frame(std::string& out, RecordType type, const std::string& body) const {
+    put<uint32_t>(out, static_cast<uint32_t>(body.size()));
+    put<uint32_t>(out, stream_id_);
+    put<uint8_t>(out, type);
+    out += body;
+}
+
+void Encoder::reset() {
+    header_written_ = false;
+    strings_.clear();
+}
+
+void Encoder::ensure_header(std::string& out) {
+    if (header_written_) {
+        return;
+    }
+    header_written_ = true;
+
+    int64_t realtime_ns, monotonic_ns;
+    EventClock::wall_anchor(realtime_ns, monotonic_ns);
+
+    std::string body;
+    put<uint32_t>(body, MAGIC);
+    put<uint16_t>(body, VERSION);
+    put<int64_t>(body, realtime_ns);
+    put<int64_t>(body, monotonic_ns);
+    append_frame(out, STREAM_HEADER, body);
+}
+
+uint32_t Encoder::intern(std::string& out, const std::string& str) {
+    auto it = strings_.find(str);
+    if (it != strings_.end()) {
+        return it->second;
+    }
+
+    uint32_t id = static_cast<uint32_t>(strings_.size() + 1);
+    strings_.emplace(str, id);
+
+    // 定义帧写在引用它的记录之前
+    std::string body;
+    put<uint32_t>(body, id);
+    body += str;
+    append_frame(out, STRING_DEF, body);
+    return id;
+}
+
+void Encoder::append_object(std::string& out, const JsonObject& json) {
+    ensure_header(out);
+
+    body_.clear();
+    put<uint16_t>(body_, static_cast<uint16_t>(json.size()));
+    for (const auto& pair : json) {
+        put<uint32_t>(body_, intern(out, pair.first));
+
+        const JsonValue& value = pair.second;
+        switch (value.get_type()) {
+            case JsonValue::STRING: {
+                const std::string& str = value.as_string();
+                if (str.size() <= MAX_INTERNED_LENGTH && strings_.size() < MAX_STRINGS) {
+                    put<uint8_t>(body_, VALUE_STRING_REF);
+                    put<uint32_t>(body_, intern(out, str));
+                } else {
+                    put<uint8_t>(body_, VALUE_STRING);
+                    put<uint32_t>(body_, static_cast<uint32_t>(str.size()));
+                    body_ += str;
+                }
+                break;
+            }
+            case JsonValue::INT64:
+                put<uint8_t>(body_, VALUE_INT64);
+                put<int64_t>(body_, value.as_int64());
+                break;
+            case JsonValue::DOUBLE:
+                put<uint8_t>(body_, VALUE_DOUBLE);
+                put<double>(body_, value.as_double());
+                break;
+            case JsonValue::BOOL:
+                put<uint8_t>(body_, VALUE_BOOL);
+                put<uint8_t>(body_, value.as_bool() ? 1 : 0);
+                break;
+        }
+    }
+    append_frame(out, JSON_OBJECT, body_);
+}
+
+void Encoder::append_route_event(std::string& out, const RouteEventLog& event,
+                                 const std::string& router_name, const std::string& user,
+                                 const std::string& interface) {
+    ensure_header(out);
+
+    const EventRecord& e = event.event;
+    body_.clear();
+    put<uint32_t>(body_, intern(out, router_name));
+    put<uint32_t>(body_, intern(out, user));
+    put<int32_t>(body_, event.session_id);
+    put<int32_t>(body_, event.session_event_number);
+    put<int64_t>(body_, event.route_event_number);
+    put<int64_t>(body_, event.offset_from_trigger_ns);
+    put<uint32_t>(body_, intern(out, interface));
+    put<uint8_t>(body_, e.cls);
+    put<int64_t>(body_, e.timestamp());
+    put<int32_t>(body_, e.ifindex());
+
+    switch (e.cls) {
+        case EventRecord::ROUTE: {
+            const RouteRecord& r = e.route;
+            put<uint16_t>(body_, r.nlmsg_type);
+            put<uint8_t>(body_, r.family);
+            put<uint8_t>(body_, r.dst_len);
+            put<uint8_t>(body_, r.protocol);
+            put<uint8_t>(body_, r.scope);
+            put<uint8_t>(body_, r.type);
+            put<uint8_t>(body_, r.flags);
+            put<uint32_t>(body_, r.table);
+            put<uint32_t>(body_, r.priority);
+            // 前缀与网关进入字符串表：同一前缀在多次震荡中反复出现
+            put<uint32_t>(body_, r.has(RouteRecord::HAS_DST) ? intern(out, address_key(r.dst)) : NO_STRING);
+            put<uint32_t>(body_, r.has(RouteRecord::HAS_GATEWAY) ? intern(out, address_key(r.gateway)) : NO_STRING);
+            put<uint32_t>(body_, r.has(RouteRecord::HAS_PREFSRC) ? intern(out, address_key(r.prefsrc)) : NO_STRING);
+            put<uint8_t>(body_, r.change);
+            put<uint16_t>(body_, r.nexthop_count);
+            put<uint32_t>(body_, r.nh_id);
+            put<uint32_t>(body_, r.nexthop_hash);
+            break;
+        }
+        case EventRecord::QDISC: {
+            const QdiscRecord& q = e.qdisc;
+            put<uint16_t>(body_, q.nlmsg_type);
+            put<uint8_t>(body_, q.family);
+            put<uint32_t>(body_, q.handle);
+            put<uint32_t>(body_, q.parent);
+            put<uint32_t>(body_, intern(out, q.kind));
+            break;
+        }
+        case EventRecord::LINK: {
+            const LinkRecord& l = e.link;
+            put<uint16_t>(body_, l.nlmsg_type);
+            put<uint8_t>(body_, l.up);
+            put<uint8_t>(body_, l.operstate);
+            put<uint32_t>(body_, l.flags);
+            put<uint32_t>(body_, intern(out, l.name));
+            break;
+        }
+        case EventRecord::NEXTHOP: {
+            const NexthopRecord& n = e.nexthop;
+            put<uint16_t>(body_, n.nlmsg_type);
+            put<uint8_t>(body_, n.family);
+            put<uint8_t>(body_, n.flags);
+            put<uint8_t>(body_, n.protocol);
+            put<uint8_t>(body_, n.change);
+            put<uint16_t>(body_, n.group_size);
+            put<uint32_t>(body_, n.id);
+            put<uint32_t>(body_, n.group_hash);
+            put<uint32_t>(body_, n.has(NexthopRecord::HAS_GATEWAY) ? intern(out, address_key(n.gateway)) : NO_STRING);
+            break;
+        }
+    }
+    append_frame(out, ROUTE_EVENT, body_);
+}
+
+Decoder::Decoder(RecordCallback callback) : callback_(std::move(callback)) {}
+
+bool Decoder::feed(const char* data, size_t len) {
+    if (streams_.empty() && pending_.empty() && len > 0 && data[0] == '{') {
+        error_ = "这是JSON文本日志，无需解码";
+        return false;
+    }
+
+    // 没有上次残留时直接在输入上解析（mmap整个文件时不复制），只把末尾不完整的记录留到下次
+    if (pending_.empty()) {
+        size_t consumed = 0;
+        if (!consume(data, len, consumed)) {
+            return false;
+        }
+        pending_.assign(data + consumed, len - consumed);
+        return true;
+    }
+
+    pending_.append(data, len);
+    size_t consumed = 0;
+    if (!consume(pending_.data(), pending_.size(), consumed)) {
+        return false;
+    }
+    pending_.erase(0, consumed);
+    return true;
+}
+
+bool Decoder::consume(const char* data, size_t len, size_t& consumed) {
+    size_t pos = 0;
+    while (len - pos >= FRAME_HEADER_SIZE) {
+        const char* frame = data + pos;
+        uint32_t body_len, stream_id;
+        uint8_t type;
+        memcpy(&body_len, frame, sizeof(body_len));
+        memcpy(&stream_id, frame + 4, sizeof(stream_id));
+        memcpy(&type, frame + 8, sizeof(type));
+
+        if (body_len > MAX_RECORD_SIZE) {
+            error_ = "记录长度异常(" + std::to_string(body_len) + ")，文件可能已损坏";
+            return false;
+        }
+        if (len - pos - FRAME_HEADER_SIZE < body_len) {
+            break; // 等待更多数据
+        }
+
+        if (!decode_record(stream_id, type, frame + FRAME_HEADER_SIZE, body_len)) {
+            return false;
+        }
+        pos += FRAME_HEADER_SIZE + body_len;
+    }
+    consumed = pos;
+    return true;
+}
+
+bool is_binary_log(const char* data, size_t len) {
+    if (len < FRAME_HEADER_SIZE + sizeof(uint32_t)) {
+        return false;
+    }
+    uint32_t magic;
+    memcpy(&magic, data + FRAME_HEADER_SIZE, sizeof(magic));
+    return static_cast<uint8_t>(data[8]) == STREAM_HEADER && magic == MAGIC;
+}
+
+bool Decoder::finish() {
+    if (!pending_.empty()) {
+        error_ = "文件末尾记录不完整(" + std::to_string(pending_.size()) + " 字节)";
+        return false;
+    }
+    return true;
+}
+
+bool Decoder::decode_record(uint32_t stream_id, uint8_t type, const char* body, size_t len) {
+    if (type == STREAM_HEADER) {
+        Reader reader(body, len);
+        uint32_t magic = reader.get<uint32_t>();
+        uint16_t version = reader.get<uint16_t>();
+        if (!reader.ok() || magic != MAGIC) {
+            error_ = "不是二进制收敛日志（缺少文件头）";
+            return false;
+        }
+        if (version > VERSION) {
+            error_ = "不支持的日志格式版本 " + std::to_string(version);
+            return false;
+        }
+
+        // 新的流：字符串表从头开始
+        Stream& stream = streams_[stream_id];
+        stream = Stream();
+        stream.version = version;
+        stream.anchor_realtime_ns = reader.get<int64_t>();
+        stream.anchor_monotonic_ns = reader.get<int64_t>();
+        return reader.ok();
+    }
+
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end()) {
+        error_ = "记录所属的流缺少文件头（流编号 " + std::to_string(stream_id) + "）";
+        return false;
+    }
+    Stream& stream = it->second;
+
+    switch (type) {
+        case STRING_DEF: {
+            Reader reader(body, len);
+            uint32_t id = reader.get<uint32_t>();
+            if (!reader.ok() || id != stream.strings.size()) {
+                error_ = "字符串表编号不连续";
+                return false;
+            }
+            stream.strings.emplace_back(body + sizeof(uint32_t), len - sizeof(uint32_t));
+            return true;
+        }
+        case JSON_OBJECT:
+            return decode_object(stream, body, len);
+        case ROUTE_EVENT:
+            return decode_route_event(stream, body, len);
+        default:
+            // 未知记录类型：跳过，便于旧解码器读取新版本增加的记录
+            return true;
+    }
+}
+
+namespace {
+
+bool lookup_string(const std::vector<std::string>& strings, uint32_t id, std::string& out) {
+    if (id >= strings.size()) {
+        return false;
+    }
+    out = strings[id];
+    return true;
+}
+
+} // namespace
+
+bool Decoder::decode_object(Stream& stream, const char* body, size_t len) {
+    Reader reader(body, len);
+    uint16_t count = reader.get<uint16_t>();
+
+    JsonObject json;
+    std::string key, str;
+    for (uint16_t i = 0; i < count && reader.ok(); ++i) {
+        if (!lookup_string(stream.strings, reader.get<uint32_t>(), key)) {
+            error_ = "字段名引用了未定义的字符串";
+            return false;
+        }
+
+        uint8_t tag = reader.get<uint8_t>();
+        switch (tag) {
+            case VALUE_STRING:
+                reader.get_bytes(str, reader.get<uint32_t>());
+                json[key] = str;
+                break;
+            case VALUE_STRING_REF:
+                if (!lookup_string(stream.strings, reader.get<uint32_t>(), str)) {
+                    error_ = "字段值引用了未定义的字符串";
+                    return false;
+                }
+                json[key] = str;
+                break;
+            case VALUE_INT64:
+                json[key] = reader.get<int64_t>();
+                break;
+            case VALUE_DOUBLE:
+                json[key] = reader.get<double>();
+                break;
+            case VALUE_BOOL:
+                json[key] = reader.get<uint8_t>() != 0;
+                break;
+            default:
+                error_ = "未知的字段类型 " + std::to_string(tag);
+                return false;
+        }
+    }
+
+    if (!reader.ok()) {
+        error_ = "结构化记录被截断";
+        return false;
+    }
+
+    ++record_count_;
+    callback_(json);
+    return true;
+}
+
+bool Decoder::decode_route_event(Stream& stream, const char* body, size_t len) {
+    Reader reader(body, len);
+    std::string router_name, user, interface, str;
+    bool refs_ok = lookup_string(stream.strings, reader.get<uint32_t>(), router_name);
+    refs_ok = lookup_string(stream.strings, reader.get<uint32_t>(), user) && refs_ok;
+
+    RouteEventLog event{};
+    event.source_id = -1;
+    event.session_id = reader.get<int32_t>();
+    event.session_event_number = reader.get<int32_t>();
+    event.route_event_number = reader.get<int64_t>();
+    event.offset_from_trigger_ns = reader.get<int64_t>();
+    refs_ok = lookup_string(stream.strings, reader.get<uint32_t>(), interface) && refs_ok;
+
+    uint8_t cls = reader.get<uint8_t>();
+    int64_t timestamp = reader.get<int64_t>();
+    int32_t ifindex = reader.get<int32_t>();
+
+    // 字符串表中的地址为 in6_addr 原始字节
+    auto read_address = [&](struct in6_addr& addr) {
+        uint32_t id = reader.get<uint32_t>();
+        if (id == NO_STRING) {
+            return false;
+        }
+        if (!lookup_string(stream.strings, id, str) || str.size() != sizeof(addr)) {
+            refs_ok = false;
+            return false;
+        }
+        memcpy(&addr, str.data(), sizeof(addr));
+        return true;
+    };
+
+    if (cls == EventRecord::ROUTE) {
+        RouteRecord r{};
+        r.timestamp = timestamp;
+        r.ifindex = ifindex;
+        r.nlmsg_type = reader.get<uint16_t>();
+        r.family = reader.get<uint8_t>();
+        r.dst_len = reader.get<uint8_t>();
+        r.protocol = reader.get<uint8_t>();
+        r.scope = reader.get<uint8_t>();
+        r.type = reader.get<uint8_t>();
+        r.flags = reader.get<uint8_t>();
+        r.table = reader.get<uint32_t>();
+        r.priority = reader.get<uint32_t>();
+        read_address(r.dst);
+        read_address(r.gateway);
+        read_address(r.prefsrc);
+        if (stream.version >= 2) {
+            r.change = reader.get<uint8_t>();
+        }
+        if (stream.version >= 3) {
+            r.nexthop_count = reader.get<uint16_t>();
+            r.nh_id = reader.get<uint32_t>();
+            r.nexthop_hash = reader.get<uint32_t>();
+        }
+        event.event = EventRecord(r);
+    } else if (cls == EventRecord::QDISC) {
+        QdiscRecord q{};
+        q.timestamp = timestamp;
+        q.ifindex = ifindex;
+        q.nlmsg_type = reader.get<uint16_t>();
+        q.family = reader.get<uint8_t>();
+        q.handle = reader.get<uint32_t>();
+        q.parent = reader.get<uint32_t>();
+        refs_ok = lookup_string(stream.strings, reader.get<uint32_t>(), str) && refs_ok;
+        strncpy(q.kind, str.c_str(), QdiscRecord::KIND_SIZE - 1);
+        event.event = EventRecord(q);
+    } else if (cls == EventRecord::LINK) {
+        LinkRecord l{};
+        l.timestamp = timestamp;
+        l.ifindex = ifindex;
+        l.nlmsg_type = reader.get<uint16_t>();
+        l.up = reader.get<uint8_t>();
+        l.operstate = reader.get<uint8_t>();
+        l.flags = reader.get<uint32_t>();
+        refs_ok = lookup_string(stream.strings, reader.get<uint32_t>(), str) && refs_ok;
+        strncpy(l.name, str.c_str(), LinkRecord::NAME_SIZE - 1);
+        event.event = EventRecord(l);
+    } else if (cls == EventRecord::NEXTHOP) {
+        NexthopRecord n{};
+        n.timestamp = timestamp;
+        n.ifindex = ifindex;
+        n.nlmsg_type = reader.get<uint16_t>();
+        n.family = reader.get<uint8_t>();
+        n.flags = reader.get<uint8_t>();
+        n.protocol = reader.get<uint8_t>();
+        n.change = reader.get<uint8_t>();
+        n.group_size = reader.get<uint16_t>();
+        n.id = reader.get<uint32_t>();
+        n.group_hash = reader.get<uint32_t>();
+        read_address(n.gateway);
+        event.event = EventRecord(n);
+    } else {
+        error_ = "未知的事件类别 " + std::to_string(cls);
+        return false;
+    }
+
+    if (!reader.ok() || !refs_ok) {
+        error_ = "路由事件记录损坏";
+        return false;
+    }
+
+    // 与写入进程相同的锚点换算，时间戳与文本日志一致
+    int64_t wall_ms = (stream.anchor_realtime_ns + (timestamp - stream.anchor_monotonic_ns)) / EventClock::NS_PER_MS;
+
+    ++record_count_;
+    callback_(LogJson::create_route_event_log(router_name, event, user, wall_ms, interface));
+    return true;
+}
+
+} // namespace BinaryLog
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "log_json.h"
+
+// 二进制事件日志格式（--log-format=binary）
+//
+// 文件由定长帧头 + 记录体组成，所有整数按小端序存储：
+//
+//   帧头(9字节): uint32 记录体长度 | uint32 流编号 | uint8 记录类型
+//
+// 每个日志记录器实例是一个"流"，以 STREAM_HEADER 开始，携带格式版本和时钟锚点；
+// 字段名、路由器名称、接口名称、前缀等重复字符串通过 STRING_DEF 定义一次，
+// 之后按编号引用。字符串表属于所在的流，多个监控器追加同一文件时按流编号区分。
+//
+// 路由事件使用定长字段（单调时钟时间戳、偏移、会话编号），其他记录按
+// "字段名编号 + 类型标签 + 值" 编码。converge_decode 工具将其还原为与文本日志相同的JSON。
+namespace BinaryLog {
+
+constexpr uint32_t MAGIC = 0x474c5643;         // "CVLG"
+constexpr uint16_t VERSION = 3;               // 2: 路由记录增加FIB镜像分类；3: 多路径摘要与下一跳对象
+constexpr size_t FRAME_HEADER_SIZE = 9;
+constexpr uint32_t MAX_RECORD_SIZE = 1 << 20;
+constexpr uint32_t NO_STRING = 0;               // 字符串编号0表示字段不存在
+constexpr size_t MAX_INTERNED_LENGTH = 64;      // 更长的字符串值直接内联
+constexpr size_t MAX_STRINGS = 1 << 20;         // 字符串表上限，超出后一律内联
+
+enum RecordType : uint8_t {
+    STREAM_HEADER = 1,
+    STRING_DEF = 2,
+    JSON_OBJECT = 3,
+    ROUTE_EVENT = 4
+};
+
+enum ValueTag : uint8_t {
+    VALUE_STRING = 0,       // uint32 长度 + 字节
+    VALUE_STRING_REF = 1,   // uint32 字符串编号
+    VALUE_INT64 = 2,
+    VALUE_DOUBLE = 3,
+    VALUE_BOOL = 4
+};
+
+// 编码器：只在日志线程中使用，不加锁
+class Encoder {
+public:
+    Encoder();
+
+    // 结构化日志 → JSON_OBJECT 记录
+    void append_object(std::string& out, const JsonObject& json);
+
+    // 路由事件 → ROUTE_EVENT 记录（定长字段，接口名称在写入时解析）
+    void append_route_event(std::string& out, const RouteEventLog& event,
+                            const std::string& router_name, const std::string& user,
+                            const std::string& interface);
+
+    uint32_t stream_id() const { return stream_id_; }
+
+    // 开始新的日志分段：下一条记录前重新写流头，字符串表从空开始（分段可单独解码）
+    void reset();
+
+private:
+    uint32_t stream_id_;
+    bool header_written_{false};
+    std::unordered_map<std::string, uint32_t> strings_;
+    std::string body_;
+
+    void ensure_header(std::string& out);
+    uint32_t intern(std::string& out, const std::string& str);
+    void append_frame(std::string& out, RecordType type, const std::string& body) const;
+};
+
+// 文件是否以二进制日志的流头开始（用于按内容区分JSON与二进制日志）
+bool is_binary_log(const char* data, size_t len);
+
+// 流式解码器：按块输入字节，每解析出一条完整记录调用一次回调
+class Decoder {
+public:
+    using RecordCallback = std::function<void(const JsonObject&)>;
+
+    explicit Decoder(RecordCallback callback);
+
+    // 输入一段数据，格式错误时返回false（错误信息见 error()）
+    bool feed(const char* data, size_t len);
+
+    // 输入结束；缓冲区中仍有不完整的记录时返回false
+    bool finish();
+
+    const std::string& error() const { return error_; }
+    int64_t record_count() const { return record_count_; }
+
+private:
+    struct Stream {
+        uint16_t version = VERSION;
+        int64_t anchor_realtime_ns = 0;
+        int64_t anchor_monotonic_ns = 0;
+        std::vector<std::string> strings{std::string()};   // 编号0保留
+    };
+
+    RecordCallback callback_;
+    std::string pending_;
+    std::unordered_map<uint32_t, Stream> streams_;
+    std::string error_;
+    int64_t record_count_{0};
+
+    bool consume(const char* data, size_t len, size_t& consumed);
+    bool decode_record(uint32_t stream_id, uint8_t type, const char* body, size_t len);
+    bool decode_object(Stream& stream, const char* body, size_t len);
+    bool decode_route_event(Stream& stream, const char* body, size_t len);
+};
+
+} // namespace BinaryLog
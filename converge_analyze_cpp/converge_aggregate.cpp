@@ -0,0 +1,1421 @@
+// 收敛日志并行汇总工具：替代 experiment_utils/log2csv_functional.py，输出相同的CSV列
+//
+// 每个日志文件由线程池中的一个任务处理：mmap整个文件，JSON日志逐行扫描（只有会话与监听摘要记录
+// 需要完整解析），二进制日志直接在映射区上流式解码。统计规则与Python脚本一致：每次监听都有直方图
+// 摘要时合并 monitoring_completed 中的收敛时间直方图，否则回退到逐条 session_completed 统计。
+//
+// --correlate 为关联模式：跨路由器对齐时钟后按故障注入归并会话，输出网络级收敛时间线（见文件后部）。
+#include "binary_log_format.h"
+#include "event_clock.h"
+#include "histogram.h"
+#include "log_rotation.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <getopt.h>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <queue>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// 与监控器的收敛时间直方图参数一致（微秒，3位有效数字），逐事件统计时用于生成可合并的直方图
+constexpr int HISTOGRAM_DIGITS = 3;
+constexpr int64_t HISTOGRAM_MAX_US = 3600LL * 1000000;
+
+// 稀疏直方图：区间下界(微秒) → 计数，以及样本的实际最小/最大值（旧日志缺失时为不截断的边界）
+struct Histogram {
+    std::map<int64_t, int64_t> bins;
+    int64_t min = std::numeric_limits<int64_t>::max();
+    int64_t max = std::numeric_limits<int64_t>::min();
+};
+
+void print_usage(const char* program_name) {
+    std::cout << "用法: " << program_name << " [选项] <输入目录或日志文件>...\n";
+    std::cout << "并行汇总各路由器的收敛日志(JSON或二进制)，输出与 log2csv_functional.py 相同的CSV\n\n";
+    std::cout << "选项:\n";
+    std::cout << "  -o, --output FILE             输出CSV文件(默认标准输出)\n";
+    std::cout << "  -H, --histogram-output FILE   同时输出每台路由器及全部路由器合并后的收敛时间直方图\n";
+    std::cout << "  -j, --jobs N                  并行处理的文件数(默认CPU核数)\n";
+    std::cout << "      --drop-lossy              丢弃接收溢出(lossy=true)且未完成RIB重新同步的会话样本\n";
+    std::cout << "      --correlate FILE          关联模式：把全部路由器的会话按故障注入归并为网络级收敛时间线(- 为标准输出)\n";
+    std::cout << "      --correlate-detail FILE   关联模式下同时输出每次注入中各路由器的激活顺序与传播延迟\n";
+    std::cout << "      --correlate-gap MS        无注入编号时，间隔超过MS毫秒的会话属于不同注入(默认2000)\n";
+    std::cout << "      --clock-offsets FILE      各时钟相对参考时钟的偏移(CSV: boot_id或路由器名称,偏移毫秒)\n";
+    std::cout << "      --reorder-window MS       单个文件内会话按触发时刻重排的窗口(默认60000)\n";
+    std::cout << "  -h, --help                    显示此帮助信息\n\n";
+    std::cout << "目录按递归方式查找 *.json 与 *.bin（含压缩的日志分段 *.zst），文件格式按内容识别。\n";
+    std::cout << "输出列: router_name, log_file_path, total_trigger_events, convergence_p50_ms,\n";
+    std::cout << "        convergence_p75_ms, convergence_p95_ms, lossy_sessions\n";
+    std::cout << "关联模式只输出时间线，按文件流式读取并多路归并，内存与事件数无关。\n";
+}
+
+// 与Python脚本相同的取值规则：索引为 (n-1)*pct 向上取整
+size_t percentile_index(size_t n, double pct) {
+    double idx_float = static_cast<double>(n - 1) * pct;
+    auto idx = static_cast<size_t>(idx_float);
+    if (std::floor(idx_float) != idx_float) {
+        idx++;
+    }
+    return std::min(idx, n - 1);
+}
+
+double pick_sorted(const std::vector<double>& data, double pct) {
+    return data[percentile_index(data.size(), pct)];
+}
+
+// 区间取值与 HdrHistogram::value_at_percentile 一致：区间上界截断到实际最小/最大值
+double pick_histogram(const Histogram& hist, int64_t total, double pct) {
+    static const HdrHistogram layout(HISTOGRAM_MAX_US, HISTOGRAM_DIGITS);
+    size_t idx = percentile_index(static_cast<size_t>(total), pct);
+    int64_t cumulative = 0;
+    int64_t lower = hist.bins.rbegin()->first;
+    for (const auto& bucket : hist.bins) {
+        cumulative += bucket.second;
+        if (cumulative > static_cast<int64_t>(idx)) {
+            lower = bucket.first;
+            break;
+        }
+    }
+    return std::clamp(layout.highest_equivalent_value(lower), hist.min, hist.max) / 1000.0;
+}
+
+int64_t histogram_total(const Histogram& hist) {
+    int64_t total = 0;
+    for (const auto& bucket : hist.bins) {
+        total += bucket.second;
+    }
+    return total;
+}
+
+void parse_histogram(const std::string& text, Histogram& hist) {
+    const char* pos = text.data();
+    const char* end = pos + text.size();
+    while (pos < end) {
+        const char* item_end = static_cast<const char*>(memchr(pos, ',', end - pos));
+        if (!item_end) {
+            item_end = end;
+        }
+        int64_t value = 0, count = 0;
+        auto first = std::from_chars(pos, item_end, value);
+        if (first.ec == std::errc() && first.ptr < item_end && *first.ptr == ':') {
+            auto second = std::from_chars(first.ptr + 1, item_end, count);
+            if (second.ec == std::errc()) {
+                hist.bins[value] += count;
+            }
+        }
+        pos = item_end + 1;
+    }
+}
+
+void merge_histogram(Histogram& target, const Histogram& hist) {
+    for (const auto& bucket : hist.bins) {
+        target.bins[bucket.first] += bucket.second;
+    }
+    target.min = std::min(target.min, hist.min);
+    target.max = std::max(target.max, hist.max);
+}
+
+std::string serialize_histogram(const Histogram& hist) {
+    std::string out;
+    for (const auto& bucket : hist.bins) {
+        if (!out.empty()) {
+            out += ',';
+        }
+        out += std::to_string(bucket.first);
+        out += ':';
+        out += std::to_string(bucket.second);
+    }
+    return out;
+}
+
+// 路径中第一个 router_ 开头的目录名，否则取文件名（不含扩展名）
+std::string infer_router_name(const std::string& path) {
+    fs::path p(path);
+    for (const auto& part : p) {
+        std::string name = part.string();
+        if (name.rfind("router_", 0) == 0) {
+            return name;
+        }
+    }
+    return p.stem().string();
+}
+
+int64_t get_int(const JsonObject& record, const char* key) {
+    auto it = record.find(key);
+    if (it == record.end()) {
+        return 0;
+    }
+    switch (it->second.get_type()) {
+        case JsonValue::INT64: return it->second.as_int64();
+        case JsonValue::DOUBLE: return static_cast<int64_t>(it->second.as_double());
+        case JsonValue::BOOL: return it->second.as_bool() ? 1 : 0;
+        case JsonValue::STRING: return std::atoll(it->second.as_string().c_str());
+    }
+    return 0;
+}
+
+bool is_truthy(const JsonObject& record, const char* key) {
+    auto it = record.find(key);
+    if (it == record.end()) {
+        return false;
+    }
+    switch (it->second.get_type()) {
+        case JsonValue::BOOL: return it->second.as_bool();
+        case JsonValue::INT64: return it->second.as_int64() != 0;
+        case JsonValue::DOUBLE: return it->second.as_double() != 0.0;
+        case JsonValue::STRING: return !it->second.as_string().empty();
+    }
+    return false;
+}
+
+const std::string* get_string(const JsonObject& record, const char* key) {
+    auto it = record.find(key);
+    if (it == record.end() || it->second.get_type() != JsonValue::STRING) {
+        return nullptr;
+    }
+    return &it->second.as_string();
+}
+
+struct CsvRow {
+    std::string router_name;
+    std::string log_file_path;
+    int64_t total_trigger_events = 0;
+    double p50_ms = -1.0;
+    double p75_ms = -1.0;
+    double p95_ms = -1.0;
+    int64_t lossy_sessions = 0;
+    Histogram histogram;
+};
+
+// 按首次出现的顺序保存各路由器的统计
+template <typename T>
+class RouterTable {
+public:
+    T& get(const std::string& router_name) {
+        auto it = index_.find(router_name);
+        if (it != index_.end()) {
+            return entries_[it->second];
+        }
+        index_.emplace(router_name, entries_.size());
+        entries_.emplace_back();
+        entries_.back().router_name = router_name;
+        return entries_.back();
+    }
+
+    const T* find(const std::string& router_name) const {
+        auto it = index_.find(router_name);
+        return it == index_.end() ? nullptr : &entries_[it->second];
+    }
+
+    const std::vector<T>& entries() const { return entries_; }
+    bool empty() const { return entries_.empty(); }
+
+private:
+    std::vector<T> entries_;
+    std::unordered_map<std::string, size_t> index_;
+};
+
+// 单个日志文件的汇总：一次扫描同时累计直方图摘要与逐事件统计，结束时按Python脚本的规则选择其一
+class FileAggregator {
+public:
+    FileAggregator(const std::string& path, bool drop_lossy)
+        : path_(path), fallback_router_(infer_router_name(path)), summaries_valid_(!drop_lossy),
+          drop_lossy_(drop_lossy) {}
+
+    // 只需登记路由器的记录（路由事件等），避免完整解析
+    void add_router(const std::string& router_name) {
+        events_.get(router_name.empty() ? fallback_router_ : router_name);
+    }
+
+    void add_record(const JsonObject& record) {
+        const std::string* name = get_string(record, "router_name");
+        const std::string& router_name = name && !name->empty() ? *name : fallback_router_;
+        const std::string* type = get_string(record, "event_type");
+        EventStats& stats = events_.get(router_name);
+        if (!type) {
+            return;
+        }
+
+        if (*type == "session_completed") {
+            bool lossy = is_truthy(record, "lossy");
+            if (lossy) {
+                stats.lossy_sessions++;
+            }
+            if (drop_lossy_ && lossy && !is_truthy(record, "resynced")) {
+                return;
+            }
+            auto it = record.find("convergence_time_ms");
+            if (it != record.end()) {
+                if (it->second.get_type() == JsonValue::DOUBLE) {
+                    stats.convergence_times.push_back(it->second.as_double());
+                } else if (it->second.get_type() == JsonValue::INT64) {
+                    stats.convergence_times.push_back(static_cast<double>(it->second.as_int64()));
+                }
+            }
+        } else if (*type == "netem_detected") {
+            stats.trigger_events++;
+        } else if (*type == "session_started") {
+            const std::string* source = get_string(record, "trigger_source");
+            if (source && *source == "route") {
+                stats.trigger_events++;
+            }
+        } else if (*type == "monitoring_started") {
+            started_[router_name]++;
+        } else if (*type == "monitoring_completed" && summaries_valid_) {
+            const std::string* histogram = get_string(record, "convergence_time_us_histogram");
+            if (!histogram) {
+                // 旧版本日志没有直方图摘要，整个文件回退到逐事件统计
+                summaries_valid_ = false;
+                return;
+            }
+            SummaryStats& summary = summaries_.get(router_name);
+            parse_histogram(*histogram, summary.histogram);
+            if (!histogram->empty()) {
+                // 旧版本日志没有样本范围，区间上界不截断
+                bool has_range = record.count("convergence_min_us") && record.count("convergence_max_us");
+                summary.histogram.min = std::min(summary.histogram.min,
+                                                 has_range ? get_int(record, "convergence_min_us") : 0);
+                summary.histogram.max = std::max(summary.histogram.max,
+                                                 has_range ? get_int(record, "convergence_max_us")
+                                                           : std::numeric_limits<int64_t>::max());
+            }
+            summary.trigger_events += get_int(record, "netem_detected_count") + get_int(record, "route_events_in_trigger");
+            summary.lossy_sessions += get_int(record, "lossy_sessions_count");
+            summary.runs++;
+        }
+    }
+
+    void finish(std::vector<CsvRow>& rows) const {
+        if (use_summaries()) {
+            for (const auto& summary : summaries_.entries()) {
+                CsvRow row = make_row(summary.router_name, summary.trigger_events, summary.lossy_sessions);
+                row.histogram = summary.histogram;
+                int64_t total = histogram_total(row.histogram);
+                if (total > 0) {
+                    row.p50_ms = pick_histogram(row.histogram, total, 0.5);
+                    row.p75_ms = pick_histogram(row.histogram, total, 0.75);
+                    row.p95_ms = pick_histogram(row.histogram, total, 0.95);
+                }
+                rows.push_back(std::move(row));
+            }
+            return;
+        }
+
+        for (const auto& stats : events_.entries()) {
+            CsvRow row = make_row(stats.router_name, stats.trigger_events, stats.lossy_sessions);
+            if (!stats.convergence_times.empty()) {
+                std::vector<double> sorted = stats.convergence_times;
+                std::sort(sorted.begin(), sorted.end());
+                row.p50_ms = pick_sorted(sorted, 0.5);
+                row.p75_ms = pick_sorted(sorted, 0.75);
+                row.p95_ms = pick_sorted(sorted, 0.95);
+
+                HdrHistogram hist(HISTOGRAM_MAX_US, HISTOGRAM_DIGITS);
+                for (double ms : sorted) {
+                    hist.record(std::llround(ms * 1000.0));
+                }
+                parse_histogram(hist.serialize(), row.histogram);
+                row.histogram.min = hist.min();
+                row.histogram.max = hist.max();
+            }
+            rows.push_back(std::move(row));
+        }
+    }
+
+private:
+    struct EventStats {
+        std::string router_name;
+        std::vector<double> convergence_times;
+        int64_t trigger_events = 0;
+        int64_t lossy_sessions = 0;
+    };
+
+    struct SummaryStats {
+        std::string router_name;
+        Histogram histogram;
+        int64_t trigger_events = 0;
+        int64_t lossy_sessions = 0;
+        int64_t runs = 0;
+    };
+
+    std::string path_;
+    std::string fallback_router_;
+    bool summaries_valid_;
+    bool drop_lossy_;
+    RouterTable<EventStats> events_;
+    RouterTable<SummaryStats> summaries_;
+    std::unordered_map<std::string, int64_t> started_;
+
+    // 每次监听都写出了带直方图的 monitoring_completed 时才使用摘要（未正常结束的监听回退）
+    bool use_summaries() const {
+        if (!summaries_valid_ || summaries_.empty()) {
+            return false;
+        }
+        for (const auto& pair : started_) {
+            const SummaryStats* summary = summaries_.find(pair.first);
+            if (!summary || summary->runs != pair.second) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    CsvRow make_row(const std::string& router_name, int64_t trigger_events, int64_t lossy_sessions) const {
+        CsvRow row;
+        row.router_name = router_name;
+        row.log_file_path = path_;
+        row.total_trigger_events = trigger_events;
+        row.lossy_sessions = lossy_sessions;
+        return row;
+    }
+};
+
+// 需要完整解析的记录类型；其余记录（路由事件等）只登记路由器
+bool needs_full_parse(const char* type, size_t len) {
+    static const char* const TYPES[] = {
+        "session_completed", "session_started", "netem_detected", "monitoring_started", "monitoring_completed"
+    };
+    for (const char* candidate : TYPES) {
+        if (strlen(candidate) == len && memcmp(candidate, type, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 查找 "key":"value" 形式的字符串字段；值中含转义字符时返回false（由调用者完整解析）
+bool find_plain_string(const char* line, size_t len, const char* key, size_t key_len,
+                       const char*& value, size_t& value_len) {
+    const char* match = static_cast<const char*>(memmem(line, len, key, key_len));
+    if (!match) {
+        return false;
+    }
+    const char* start = match + key_len;
+    const char* end = line + len;
+    const char* close = static_cast<const char*>(memchr(start, '"', end - start));
+    if (!close || memchr(start, '\\', close - start)) {
+        return false;
+    }
+    value = start;
+    value_len = static_cast<size_t>(close - start);
+    return true;
+}
+
+void scan_json(const char* data, size_t size, FileAggregator& aggregator) {
+    static const char EVENT_TYPE_KEY[] = "\"event_type\":\"";
+    static const char ROUTER_NAME_KEY[] = "\"router_name\":\"";
+
+    JsonObject record;
+    std::string router_name;
+    const char* pos = data;
+    const char* end = data + size;
+    while (pos < end) {
+        const char* line_end = static_cast<const char*>(memchr(pos, '\n', end - pos));
+        if (!line_end) {
+            line_end = end;
+        }
+        size_t len = static_cast<size_t>(line_end - pos);
+        const char* line = pos;
+        pos = line_end + 1;
+
+        while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == ' ')) {
+            len--;
+        }
+        if (len == 0) {
+            continue;
+        }
+
+        const char* type;
+        size_t type_len;
+        const char* name;
+        size_t name_len;
+        bool fast = find_plain_string(line, len, EVENT_TYPE_KEY, sizeof(EVENT_TYPE_KEY) - 1, type, type_len) &&
+                    !needs_full_parse(type, type_len) &&
+                    line[0] == '{' && line[len - 1] == '}';
+        if (fast) {
+            if (find_plain_string(line, len, ROUTER_NAME_KEY, sizeof(ROUTER_NAME_KEY) - 1, name, name_len)) {
+                router_name.assign(name, name_len);
+                aggregator.add_router(router_name);
+                continue;
+            }
+            if (!memmem(line, len, "\"router_name\"", 13)) {
+                aggregator.add_router(std::string());
+                continue;
+            }
+        }
+
+        // 无法解析的行（如被强制终止时截断的最后一行）直接跳过
+        if (LogJson::parse_json(line, len, record)) {
+            aggregator.add_record(record);
+        }
+    }
+}
+
+// 日志文件只读映射；压缩的日志分段（*.zst）整体解压到内存
+class MappedFile {
+public:
+    ~MappedFile() {
+        if (data_ && data_ != MAP_FAILED) {
+            munmap(data_, size_);
+        }
+    }
+
+    bool open(const std::string& path, std::string& error) {
+        if (path.size() > 4 && path.compare(path.size() - 4, 4, ".zst") == 0) {
+            if (!LogRotation::decompress_file(path, decompressed_, error)) {
+                return false;
+            }
+            size_ = decompressed_.size();
+            return true;
+        }
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            error = "无法打开 " + path + ": " + strerror(errno);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            error = "无法读取 " + path + ": " + strerror(errno);
+            close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data_ == MAP_FAILED) {
+                error = "无法映射 " + path + ": " + strerror(errno);
+                close(fd);
+                return false;
+            }
+            madvise(data_, size_, MADV_SEQUENTIAL);
+        }
+        close(fd);
+        return true;
+    }
+
+    const char* data() const {
+        return data_ ? static_cast<const char*>(data_) : decompressed_.data();
+    }
+    size_t size() const { return size_; }
+
+private:
+    void* data_{nullptr};
+    size_t size_{0};
+    std::string decompressed_;
+};
+
+struct FileResult {
+    std::vector<CsvRow> rows;
+    std::string error;
+    std::string warning;
+};
+
+void aggregate_file(const std::string& path, bool drop_lossy, FileResult& result) {
+    MappedFile file;
+    if (!file.open(path, result.error)) {
+        return;
+    }
+
+    FileAggregator aggregator(path, drop_lossy);
+    if (BinaryLog::is_binary_log(file.data(), file.size())) {
+        BinaryLog::Decoder decoder([&aggregator](const JsonObject& record) { aggregator.add_record(record); });
+        if (!decoder.feed(file.data(), file.size())) {
+            result.warning = decoder.error();
+        } else if (!decoder.finish()) {
+            // 监控器被强制终止时最后一批写入可能不完整，已解码的记录仍然有效
+            result.warning = decoder.error();
+        }
+    } else {
+        scan_json(file.data(), file.size(), aggregator);
+    }
+    aggregator.finish(result.rows);
+}
+
+void collect_files(const std::string& input, std::vector<std::string>& files) {
+    std::error_code ec;
+    if (fs::is_regular_file(input, ec)) {
+        files.push_back(input);
+        return;
+    }
+    if (!fs::is_directory(input, ec)) {
+        return;
+    }
+    for (auto it = fs::recursive_directory_iterator(input, fs::directory_options::skip_permission_denied, ec);
+         !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (!it->is_regular_file(ec)) {
+            continue;
+        }
+        std::string extension = it->path().extension().string();
+        if (extension == ".zst") {
+            // 压缩的日志分段（--log-compress zstd）
+            extension = it->path().stem().extension().string();
+        }
+        if (extension == ".json" || extension == ".bin") {
+            files.push_back(it->path().string());
+        }
+    }
+}
+
+void append_csv_field(std::string& out, const std::string& value) {
+    if (value.find_first_of(",\"\n\r") == std::string::npos) {
+        out += value;
+        return;
+    }
+    out += '"';
+    for (char c : value) {
+        if (c == '"') {
+            out += '"';
+        }
+        out += c;
+    }
+    out += '"';
+}
+
+// 与Python的 repr(float) 输出一致（最短往返表示，整数值带 .0）
+void append_float(std::string& out, double value) {
+    char buffer[64];
+    double magnitude = std::fabs(value);
+    bool scientific = magnitude != 0.0 && (magnitude < 1e-4 || magnitude >= 1e16);
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value,
+                                scientific ? std::chars_format::scientific : std::chars_format::fixed);
+    out.append(buffer, result.ptr);
+    if (!scientific && !memchr(buffer, '.', result.ptr - buffer)) {
+        out += ".0";
+    }
+}
+
+// Python csv 模块默认的行结束符为 \r\n
+constexpr const char* CSV_LINE_END = "\r\n";
+
+std::string format_rows(const std::vector<CsvRow>& rows) {
+    std::string out = "router_name,log_file_path,total_trigger_events,convergence_p50_ms,"
+                      "convergence_p75_ms,convergence_p95_ms,lossy_sessions";
+    out += CSV_LINE_END;
+    for (const auto& row : rows) {
+        append_csv_field(out, row.router_name);
+        out += ',';
+        append_csv_field(out, row.log_file_path);
+        out += ',';
+        out += std::to_string(row.total_trigger_events);
+        out += ',';
+        append_float(out, row.p50_ms);
+        out += ',';
+        append_float(out, row.p75_ms);
+        out += ',';
+        append_float(out, row.p95_ms);
+        out += ',';
+        out += std::to_string(row.lossy_sessions);
+        out += CSV_LINE_END;
+    }
+    return out;
+}
+
+std::string format_histograms(const std::vector<CsvRow>& rows, const Histogram& merged) {
+    std::string out = "router_name,log_file_path,convergence_samples,convergence_time_us_histogram";
+    out += CSV_LINE_END;
+    auto append_row = [&out](const std::string& router, const std::string& path, const Histogram& hist) {
+        append_csv_field(out, router);
+        out += ',';
+        append_csv_field(out, path);
+        out += ',';
+        out += std::to_string(histogram_total(hist));
+        out += ',';
+        append_csv_field(out, serialize_histogram(hist));
+        out += CSV_LINE_END;
+    };
+    for (const auto& row : rows) {
+        append_row(row.router_name, row.log_file_path, row.histogram);
+    }
+    append_row("ALL", "", merged);
+    return out;
+}
+
+bool write_file(const std::string& path, const std::string& content) {
+    FILE* file = path.empty() ? stdout : fopen(path.c_str(), "w");
+    if (!file) {
+        std::cerr << "❌ 错误: 无法创建输出文件 " << path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    fwrite(content.data(), 1, content.size(), file);
+    if (file == stdout) {
+        fflush(file);
+        return true;
+    }
+    return fclose(file) == 0;
+}
+
+// ---- 跨路由器关联（--correlate） ----
+//
+// 各监控器只从本地触发开始计时；关联模式把所有路由器的会话放到同一条时间轴上，按故障注入分组，
+// 得到从注入到拓扑中最后一台路由器收敛的网络级收敛时间，以及每台路由器的传播延迟。
+// 每个文件按顺序流式读取（只保留重排窗口内的会话），再按触发时刻多路归并，内存与事件数无关。
+
+// 关联用的会话：时间已换算到公共时间轴（Unix纳秒）
+struct CorrelatedSession {
+    std::string router_name;
+    std::string injection_id;
+    int64_t trigger_ns = 0;
+    int64_t settle_ns = 0;          // 最后一个路由事件，未收敛（无路由事件）时等于触发时刻
+    int64_t route_events = 0;
+    bool converged = false;
+    bool lossy = false;
+};
+
+struct LaterTrigger {
+    bool operator()(const CorrelatedSession& a, const CorrelatedSession& b) const {
+        return a.trigger_ns > b.trigger_ns;
+    }
+};
+
+// "2026-01-02T03:04:05.678Z" → Unix毫秒
+bool parse_iso_ms(const std::string& text, int64_t& ms) {
+    struct tm tm_utc{};
+    int millis = 0;
+    if (sscanf(text.c_str(), "%d-%d-%dT%d:%d:%d.%dZ", &tm_utc.tm_year, &tm_utc.tm_mon, &tm_utc.tm_mday,
+               &tm_utc.tm_hour, &tm_utc.tm_min, &tm_utc.tm_sec, &millis) != 7) {
+        return false;
+    }
+    tm_utc.tm_year -= 1900;
+    tm_utc.tm_mon -= 1;
+    ms = static_cast<int64_t>(timegm(&tm_utc)) * 1000 + millis;
+    return true;
+}
+
+// 时钟对齐：同一主机（boot_id相同）上的路由器使用共享的单调时钟，以该主机上第一个监控器的锚点
+// 换算为墙上时间，彼此之间没有锚点误差；其他情况使用各自的墙上时间。两者都可再减去
+// --clock-offsets 给出的偏移（键为 boot_id 或路由器名称，值为该时钟比参考时钟快的毫秒数）。
+class ClockAligner {
+public:
+    bool load_offsets(const std::string& path, std::string& error) {
+        FILE* file = fopen(path.c_str(), "r");
+        if (!file) {
+            error = "无法打开时钟偏移文件 " + path + ": " + strerror(errno);
+            return false;
+        }
+        char line[512];
+        while (fgets(line, sizeof(line), file)) {
+            char* comma = strchr(line, ',');
+            if (line[0] == '#' || !comma) {
+                continue;
+            }
+            *comma = '\0';
+            char* end = nullptr;
+            double offset_ms = strtod(comma + 1, &end);
+            if (end == comma + 1) {
+                continue;       // 表头
+            }
+            offsets_ns_[line] = std::llround(offset_ms * 1e6);
+        }
+        fclose(file);
+        return true;
+    }
+
+    void add_monitor(const std::string& router_name, const JsonObject& record) {
+        const std::string* boot_id = get_string(record, "clock_boot_id");
+        if (!boot_id || record.find("clock_monotonic_ns") == record.end()) {
+            routers_.erase(router_name);
+            return;
+        }
+        RouterClock clock;
+        clock.boot_id = *boot_id;
+        clock.timens_offset_ns = get_int(record, "clock_timens_offset_ns");
+        routers_[router_name] = clock;
+
+        // 主机单调时间 = 本地单调时间 - 时间命名空间偏移
+        int64_t host_mono = get_int(record, "clock_monotonic_ns") - clock.timens_offset_ns;
+        hosts_.emplace(*boot_id, get_int(record, "clock_realtime_ns") - host_mono);
+    }
+
+    bool align(const std::string& router_name, const JsonObject& record, int64_t& trigger_ns) {
+        auto clock = routers_.find(router_name);
+        if (clock != routers_.end() && record.find("trigger_mono_ns") != record.end()) {
+            int64_t host_mono = get_int(record, "trigger_mono_ns") - clock->second.timens_offset_ns;
+            trigger_ns = host_mono + hosts_[clock->second.boot_id] - offset_ns(clock->second.boot_id, router_name);
+            monotonic_aligned_++;
+            return true;
+        }
+
+        int64_t offset = offset_ns(std::string(), router_name);
+        if (record.find("trigger_wall_us") != record.end()) {
+            trigger_ns = get_int(record, "trigger_wall_us") * 1000 - offset;
+            wall_aligned_++;
+            return true;
+        }
+        // 旧版本日志：由完成记录的时间减去会话时长估算（毫秒精度）
+        const std::string* timestamp = get_string(record, "timestamp");
+        int64_t completed_ms = 0;
+        if (timestamp && parse_iso_ms(*timestamp, completed_ms)) {
+            trigger_ns = completed_ms * EventClock::NS_PER_MS - get_int(record, "session_duration_ms") * EventClock::NS_PER_MS - offset;
+            wall_aligned_++;
+            return true;
+        }
+        return false;
+    }
+
+    int64_t monotonic_aligned() const { return monotonic_aligned_; }
+    int64_t wall_aligned() const { return wall_aligned_; }
+    size_t host_count() const { return hosts_.size(); }
+
+private:
+    struct RouterClock {
+        std::string boot_id;
+        int64_t timens_offset_ns = 0;
+    };
+    std::unordered_map<std::string, RouterClock> routers_;
+    std::unordered_map<std::string, int64_t> hosts_;        // boot_id → 墙上时间 - 主机单调时间
+    std::unordered_map<std::string, int64_t> offsets_ns_;
+    int64_t monotonic_aligned_ = 0;
+    int64_t wall_aligned_ = 0;
+
+    int64_t offset_ns(const std::string& boot_id, const std::string& router_name) const {
+        auto it = boot_id.empty() ? offsets_ns_.end() : offsets_ns_.find(boot_id);
+        if (it == offsets_ns_.end()) {
+            it = offsets_ns_.find(router_name);
+        }
+        return it == offsets_ns_.end() ? 0 : it->second;
+    }
+};
+
+// 单个日志文件的会话流：按文件顺序读取，在重排窗口内按触发时刻排序后输出
+// （并发会话与多命名空间日志按完成顺序写入，触发顺序与文件顺序相差不超过会话时长）
+class SessionCursor {
+public:
+    SessionCursor(const std::string& path, ClockAligner& clocks, int64_t reorder_window_ns, bool drop_lossy)
+        : path_(path), fallback_router_(infer_router_name(path)), clocks_(clocks),
+          reorder_window_ns_(reorder_window_ns), drop_lossy_(drop_lossy) {}
+
+    bool open(std::string& error) {
+        if (!file_.open(path_, error)) {
+            return false;
+        }
+        if (BinaryLog::is_binary_log(file_.data(), file_.size())) {
+            decoder_ = std::make_unique<BinaryLog::Decoder>([this](const JsonObject& record) { add_record(record); });
+        }
+        return true;
+    }
+
+    // 触发时刻最早的会话，文件已读完且没有剩余会话时返回nullptr
+    const CorrelatedSession* peek() {
+        while (!eof_ && (pending_.empty() || pending_.top().trigger_ns + reorder_window_ns_ > max_trigger_ns_)) {
+            read_chunk();
+        }
+        return pending_.empty() ? nullptr : &pending_.top();
+    }
+
+    CorrelatedSession pop() {
+        CorrelatedSession session = pending_.top();
+        pending_.pop();
+        return session;
+    }
+
+    const std::string& path() const { return path_; }
+    const std::string& warning() const { return warning_; }
+    int64_t unaligned() const { return unaligned_; }
+
+private:
+    static constexpr size_t CHUNK_BYTES = 256 * 1024;
+
+    std::string path_;
+    std::string fallback_router_;
+    ClockAligner& clocks_;
+    int64_t reorder_window_ns_;
+    bool drop_lossy_;
+    MappedFile file_;
+    size_t offset_ = 0;
+    bool eof_ = false;
+    std::unique_ptr<BinaryLog::Decoder> decoder_;
+    std::priority_queue<CorrelatedSession, std::vector<CorrelatedSession>, LaterTrigger> pending_;
+    int64_t max_trigger_ns_ = INT64_MIN;
+    JsonObject record_;
+    std::string warning_;
+    int64_t unaligned_ = 0;
+
+    void read_chunk() {
+        size_t remaining = file_.size() - offset_;
+        if (remaining == 0) {
+            if (decoder_ && warning_.empty() && !decoder_->finish()) {
+                warning_ = decoder_->error();
+            }
+            eof_ = true;
+            return;
+        }
+        if (decoder_) {
+            size_t len = std::min(remaining, CHUNK_BYTES);
+            if (!decoder_->feed(file_.data() + offset_, len)) {
+                warning_ = decoder_->error();
+                offset_ = file_.size();
+                return;
+            }
+            offset_ += len;
+            return;
+        }
+        scan_lines(std::min(remaining, CHUNK_BYTES));
+    }
+
+    // 读取至少 min_bytes 字节的完整行，只有会话完成与监听开始记录需要完整解析
+    void scan_lines(size_t min_bytes) {
+        static const char EVENT_TYPE_KEY[] = "\"event_type\":\"";
+        const char* data = file_.data();
+        size_t stop = offset_ + min_bytes;
+        while (offset_ < file_.size() && offset_ < stop) {
+            const char* line = data + offset_;
+            const char* line_end = static_cast<const char*>(memchr(line, '\n', file_.size() - offset_));
+            if (!line_end) {
+                line_end = data + file_.size();
+            }
+            size_t len = static_cast<size_t>(line_end - line);
+            offset_ += len + 1;
+            offset_ = std::min(offset_, file_.size());
+            while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == ' ')) {
+                len--;
+            }
+            if (len == 0) {
+                continue;
+            }
+
+            const char* type;
+            size_t type_len;
+            if (find_plain_string(line, len, EVENT_TYPE_KEY, sizeof(EVENT_TYPE_KEY) - 1, type, type_len) &&
+                !(type_len == 17 && memcmp(type, "session_completed", 17) == 0) &&
+                !(type_len == 18 && memcmp(type, "monitoring_started", 18) == 0)) {
+                continue;
+            }
+            if (LogJson::parse_json(line, len, record_)) {
+                add_record(record_);
+            }
+        }
+    }
+
+    void add_record(const JsonObject& record) {
+        const std::string* type = get_string(record, "event_type");
+        if (!type) {
+            return;
+        }
+        const std::string* name = get_string(record, "router_name");
+        const std::string& router_name = name && !name->empty() ? *name : fallback_router_;
+
+        if (*type == "monitoring_started") {
+            clocks_.add_monitor(router_name, record);
+            return;
+        }
+        if (*type != "session_completed") {
+            return;
+        }
+
+        CorrelatedSession session;
+        session.lossy = is_truthy(record, "lossy");
+        if (drop_lossy_ && session.lossy && !is_truthy(record, "resynced")) {
+            return;
+        }
+        if (!clocks_.align(router_name, record, session.trigger_ns)) {
+            unaligned_++;
+            return;
+        }
+        session.router_name = router_name;
+        if (const std::string* id = get_string(record, "injection_id")) {
+            session.injection_id = *id;
+        }
+        session.route_events = get_int(record, "route_events_count");
+        session.settle_ns = session.trigger_ns;
+        if (record.find("convergence_time_us") != record.end()) {
+            session.converged = true;
+            session.settle_ns += get_int(record, "convergence_time_us") * EventClock::NS_PER_US;
+        } else if (record.find("convergence_time_ms") != record.end()) {
+            session.converged = true;
+            session.settle_ns += get_int(record, "convergence_time_ms") * EventClock::NS_PER_MS;
+        }
+        max_trigger_ns_ = std::max(max_trigger_ns_, session.trigger_ns);
+        pending_.push(std::move(session));
+    }
+};
+
+double ns_to_ms(int64_t ns) {
+    return static_cast<double>(ns / EventClock::NS_PER_US) / 1000.0;
+}
+
+// 按注入分组：带 injection_id 的会话按编号分组，其余归入最近开始的未结束注入（没有时开始新注入）。
+// 注入在时间轴越过其最近活动 + gap 后结束并立即输出，同时打开的注入只有少数几个
+class Correlator {
+public:
+    Correlator(int64_t gap_ns, FILE* summary, FILE* detail) : gap_ns_(gap_ns), summary_(summary), detail_(detail) {
+        std::string header = "injection,injection_id,start_time,routers,sessions,converged_routers,lossy_sessions,"
+                             "first_router,last_router,network_convergence_ms,propagation_p50_ms,propagation_max_ms,"
+                             "router_convergence_p50_ms,router_convergence_max_ms";
+        header += CSV_LINE_END;
+        fwrite(header.data(), 1, header.size(), summary_);
+        if (detail_) {
+            header = "injection,injection_id,router_name,activation_rank,sessions,propagation_ms,since_previous_ms,"
+                     "settle_ms,router_convergence_ms,route_events,lossy_sessions";
+            header += CSV_LINE_END;
+            fwrite(header.data(), 1, header.size(), detail_);
+        }
+    }
+
+    void add(const CorrelatedSession& session) {
+        close_expired(session.trigger_ns);
+        auto it = open_.find(session.injection_id);
+        if (it == open_.end() && session.injection_id.empty()) {
+            // 未配置注入编号的监控器：归入最近开始的未结束注入
+            for (auto candidate = open_.begin(); candidate != open_.end(); ++candidate) {
+                if (it == open_.end() || candidate->second.index > it->second.index) {
+                    it = candidate;
+                }
+            }
+        }
+        if (it == open_.end()) {
+            Injection injection;
+            injection.index = ++injection_count_;
+            injection.id = session.injection_id;
+            injection.start_ns = session.trigger_ns;
+            it = open_.emplace(session.injection_id, std::move(injection)).first;
+        }
+        Injection& injection = it->second;
+        injection.sessions++;
+        injection.last_activity_ns = std::max(injection.last_activity_ns, session.settle_ns);
+        if (session.lossy) {
+            injection.lossy_sessions++;
+        }
+
+        RouterActivity& router = injection.routers.get(session.router_name);
+        if (router.sessions == 0) {
+            router.first_trigger_ns = session.trigger_ns;
+        }
+        router.sessions++;
+        router.last_settle_ns = std::max(router.last_settle_ns, session.settle_ns);
+        router.route_events += session.route_events;
+        router.converged = router.converged || session.converged;
+        router.lossy_sessions += session.lossy ? 1 : 0;
+    }
+
+    void finish() {
+        close_expired(INT64_MAX);
+    }
+
+    const std::vector<double>& network_convergence_ms() const { return network_convergence_ms_; }
+
+private:
+    struct RouterActivity {
+        std::string router_name;
+        int64_t sessions = 0;
+        int64_t first_trigger_ns = 0;
+        int64_t last_settle_ns = INT64_MIN;
+        int64_t route_events = 0;
+        int64_t lossy_sessions = 0;
+        bool converged = false;
+    };
+
+    struct Injection {
+        int64_t index = 0;
+        std::string id;
+        int64_t start_ns = 0;
+        int64_t last_activity_ns = INT64_MIN;
+        int64_t sessions = 0;
+        int64_t lossy_sessions = 0;
+        RouterTable<RouterActivity> routers;
+    };
+
+    int64_t gap_ns_;
+    FILE* summary_;
+    FILE* detail_;
+    std::map<std::string, Injection> open_;
+    int64_t injection_count_ = 0;
+    std::vector<double> network_convergence_ms_;
+
+    void close_expired(int64_t now_ns) {
+        std::vector<std::string> expired;
+        for (const auto& pair : open_) {
+            if (now_ns == INT64_MAX || now_ns > pair.second.last_activity_ns + gap_ns_) {
+                expired.push_back(pair.first);
+            }
+        }
+        // 同时结束的注入按开始顺序输出
+        std::sort(expired.begin(), expired.end(), [this](const std::string& a, const std::string& b) {
+            return open_.at(a).index < open_.at(b).index;
+        });
+        for (const auto& key : expired) {
+            emit(open_.at(key));
+            open_.erase(key);
+        }
+    }
+
+    void emit(const Injection& injection) {
+        // 按首次触发排序即为各路由器的激活顺序
+        std::vector<const RouterActivity*> routers;
+        for (const auto& router : injection.routers.entries()) {
+            routers.push_back(&router);
+        }
+        std::stable_sort(routers.begin(), routers.end(), [](const RouterActivity* a, const RouterActivity* b) {
+            return a->first_trigger_ns < b->first_trigger_ns;
+        });
+
+        const RouterActivity* last = routers.front();
+        std::vector<double> propagation;
+        std::vector<double> router_convergence;
+        int64_t converged_routers = 0;
+        std::string detail;
+        int64_t previous_ns = injection.start_ns;
+        for (size_t rank = 0; rank < routers.size(); ++rank) {
+            const RouterActivity& router = *routers[rank];
+            if (router.last_settle_ns > last->last_settle_ns) {
+                last = &router;
+            }
+            propagation.push_back(ns_to_ms(router.first_trigger_ns - injection.start_ns));
+            router_convergence.push_back(ns_to_ms(router.last_settle_ns - router.first_trigger_ns));
+            converged_routers += router.converged ? 1 : 0;
+
+            if (detail_) {
+                detail += std::to_string(injection.index);
+                detail += ',';
+                append_csv_field(detail, injection.id);
+                detail += ',';
+                append_csv_field(detail, router.router_name);
+                detail += ',';
+                detail += std::to_string(rank + 1);
+                detail += ',';
+                detail += std::to_string(router.sessions);
+                detail += ',';
+                append_float(detail, propagation.back());
+                detail += ',';
+                append_float(detail, ns_to_ms(router.first_trigger_ns - previous_ns));
+                detail += ',';
+                append_float(detail, ns_to_ms(router.last_settle_ns - injection.start_ns));
+                detail += ',';
+                append_float(detail, router_convergence.back());
+                detail += ',';
+                detail += std::to_string(router.route_events);
+                detail += ',';
+                detail += std::to_string(router.lossy_sessions);
+                detail += CSV_LINE_END;
+            }
+            previous_ns = router.first_trigger_ns;
+        }
+        std::sort(propagation.begin(), propagation.end());
+        std::sort(router_convergence.begin(), router_convergence.end());
+        double network_ms = ns_to_ms(injection.last_activity_ns - injection.start_ns);
+        network_convergence_ms_.push_back(network_ms);
+
+        std::string row = std::to_string(injection.index);
+        row += ',';
+        append_csv_field(row, injection.id);
+        row += ',';
+        row += LogJson::format_iso_timestamp(injection.start_ns / EventClock::NS_PER_MS);
+        row += ',';
+        row += std::to_string(routers.size());
+        row += ',';
+        row += std::to_string(injection.sessions);
+        row += ',';
+        row += std::to_string(converged_routers);
+        row += ',';
+        row += std::to_string(injection.lossy_sessions);
+        row += ',';
+        append_csv_field(row, routers.front()->router_name);
+        row += ',';
+        append_csv_field(row, last->router_name);
+        row += ',';
+        append_float(row, network_ms);
+        row += ',';
+        append_float(row, pick_sorted(propagation, 0.5));
+        row += ',';
+        append_float(row, propagation.back());
+        row += ',';
+        append_float(row, pick_sorted(router_convergence, 0.5));
+        row += ',';
+        append_float(row, router_convergence.back());
+        row += CSV_LINE_END;
+        fwrite(row.data(), 1, row.size(), summary_);
+        if (detail_) {
+            fwrite(detail.data(), 1, detail.size(), detail_);
+        }
+    }
+};
+
+struct CorrelateOptions {
+    std::string output_path;
+    std::string detail_path;
+    std::string offsets_path;
+    int64_t gap_ms = 2000;
+    int64_t reorder_window_ms = 60000;
+};
+
+FILE* open_output(const std::string& path) {
+    FILE* file = path == "-" ? stdout : fopen(path.c_str(), "w");
+    if (!file) {
+        std::cerr << "❌ 错误: 无法创建输出文件 " << path << ": " << strerror(errno) << "\n";
+    }
+    return file;
+}
+
+bool close_output(FILE* file) {
+    if (!file) {
+        return true;
+    }
+    if (file == stdout) {
+        return fflush(file) == 0;
+    }
+    return fclose(file) == 0;
+}
+
+int correlate(const std::vector<std::string>& files, const CorrelateOptions& options, bool drop_lossy) {
+    auto start = std::chrono::steady_clock::now();
+    ClockAligner clocks;
+    std::string error;
+    if (!options.offsets_path.empty() && !clocks.load_offsets(options.offsets_path, error)) {
+        std::cerr << "❌ 错误: " << error << "\n";
+        return 1;
+    }
+
+    int exit_code = 0;
+    std::vector<std::unique_ptr<SessionCursor>> cursors;
+    for (const auto& path : files) {
+        auto cursor = std::make_unique<SessionCursor>(path, clocks, options.reorder_window_ms * EventClock::NS_PER_MS,
+                                                      drop_lossy);
+        if (!cursor->open(error)) {
+            std::cerr << "❌ 错误: " << error << "\n";
+            exit_code = 1;
+            continue;
+        }
+        cursors.push_back(std::move(cursor));
+    }
+
+    FILE* summary = open_output(options.output_path);
+    FILE* detail = options.detail_path.empty() ? nullptr : open_output(options.detail_path);
+    if (!summary || (!options.detail_path.empty() && !detail)) {
+        close_output(summary);
+        close_output(detail);
+        return 1;
+    }
+
+    // 各文件的会话流按触发时刻多路归并
+    using HeapItem = std::pair<int64_t, size_t>;
+    std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap;
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        if (const CorrelatedSession* session = cursors[i]->peek()) {
+            heap.emplace(session->trigger_ns, i);
+        }
+    }
+
+    Correlator correlator(options.gap_ms * EventClock::NS_PER_MS, summary, detail);
+    int64_t sessions = 0;
+    while (!heap.empty()) {
+        size_t index = heap.top().second;
+        heap.pop();
+        correlator.add(cursors[index]->pop());
+        sessions++;
+        if (const CorrelatedSession* next = cursors[index]->peek()) {
+            heap.emplace(next->trigger_ns, index);
+        }
+    }
+    correlator.finish();
+
+    int64_t unaligned = 0;
+    for (const auto& cursor : cursors) {
+        if (!cursor->warning().empty()) {
+            std::cerr << "⚠️  " << cursor->path() << ": " << cursor->warning() << "\n";
+        }
+        unaligned += cursor->unaligned();
+    }
+    if (!close_output(summary) || !close_output(detail)) {
+        std::cerr << "❌ 错误: 写入输出文件失败\n";
+        return 1;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::vector<double> network = correlator.network_convergence_ms();
+    std::cerr << "🔗 关联完成: " << files.size() << " 个文件, " << sessions << " 个会话, " << network.size()
+              << " 次注入, 耗时 " << elapsed << " 秒\n";
+    std::cerr << "   时钟对齐: 共享单调时钟 " << clocks.monotonic_aligned() << " 个会话 (" << clocks.host_count()
+              << " 台主机), 墙上时间 " << clocks.wall_aligned() << " 个";
+    if (unaligned > 0) {
+        std::cerr << ", 无法对齐(缺少时间字段) " << unaligned << " 个";
+    }
+    std::cerr << "\n";
+    if (!network.empty()) {
+        std::sort(network.begin(), network.end());
+        std::cerr << "   网络级收敛: P50=" << pick_sorted(network, 0.5) << "ms, P95=" << pick_sorted(network, 0.95)
+                  << "ms, 最大=" << network.back() << "ms\n";
+    }
+    return exit_code;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string output_path;
+    std::string histogram_path;
+    bool drop_lossy = false;
+    int jobs = static_cast<int>(std::thread::hardware_concurrency());
+    CorrelateOptions correlate_options;
+
+    enum {
+        OPT_DROP_LOSSY = 256,
+        OPT_CORRELATE,
+        OPT_CORRELATE_DETAIL,
+        OPT_CORRELATE_GAP,
+        OPT_CLOCK_OFFSETS,
+        OPT_REORDER_WINDOW
+    };
+    static struct option long_options[] = {
+        {"output", required_argument, 0, 'o'},
+        {"histogram-output", required_argument, 0, 'H'},
+        {"jobs", required_argument, 0, 'j'},
+        {"drop-lossy", no_argument, 0, OPT_DROP_LOSSY},
+        {"correlate", required_argument, 0, OPT_CORRELATE},
+        {"correlate-detail", required_argument, 0, OPT_CORRELATE_DETAIL},
+        {"correlate-gap", required_argument, 0, OPT_CORRELATE_GAP},
+        {"clock-offsets", required_argument, 0, OPT_CLOCK_OFFSETS},
+        {"reorder-window", required_argument, 0, OPT_REORDER_WINDOW},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int option_index = 0;
+    int c;
+    while ((c = getopt_long(argc, argv, "o:H:j:h", long_options, &option_index)) != -1) {
+        switch (c) {
+            case 'o':
+                output_path = optarg;
+                break;
+            case 'H':
+                histogram_path = optarg;
+                break;
+            case 'j':
+                jobs = std::atoi(optarg);
+                if (jobs <= 0) {
+                    std::cerr << "❌ 错误: 并行数必须大于0\n";
+                    return 1;
+                }
+                break;
+            case OPT_DROP_LOSSY:
+                drop_lossy = true;
+                break;
+            case OPT_CORRELATE:
+                correlate_options.output_path = optarg;
+                break;
+            case OPT_CORRELATE_DETAIL:
+                correlate_options.detail_path = optarg;
+                break;
+            case OPT_CORRELATE_GAP:
+                correlate_options.gap_ms = std::atoll(optarg);
+                break;
+            case OPT_CLOCK_OFFSETS:
+                correlate_options.offsets_path = optarg;
+                break;
+            case OPT_REORDER_WINDOW:
+                correlate_options.reorder_window_ms = std::atoll(optarg);
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (optind >= argc) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (correlate_options.output_path.empty() &&
+        (!correlate_options.detail_path.empty() || !correlate_options.offsets_path.empty())) {
+        std::cerr << "❌ 错误: --correlate-detail 与 --clock-offsets 需要与 --correlate 一起使用\n";
+        return 1;
+    }
+    if (correlate_options.gap_ms <= 0 || correlate_options.reorder_window_ms < 0) {
+        std::cerr << "❌ 错误: 注入间隔必须大于0，重排窗口不能为负数\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::string> files;
+    for (int i = optind; i < argc; ++i) {
+        size_t before = files.size();
+        collect_files(argv[i], files);
+        if (files.size() == before) {
+            std::cerr << "⚠️  未在 " << argv[i] << " 下找到任何日志文件\n";
+        }
+    }
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+
+    if (!correlate_options.output_path.empty()) {
+        return correlate(files, correlate_options, drop_lossy);
+    }
+
+    // 每个文件一个任务，工作线程按顺序领取；结果按文件顺序输出，与并行度无关
+    std::vector<FileResult> results(files.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < files.size(); i = next.fetch_add(1)) {
+            aggregate_file(files[i], drop_lossy, results[i]);
+        }
+    };
+    size_t thread_count = std::min(files.size(), static_cast<size_t>(jobs));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    int exit_code = 0;
+    std::vector<CsvRow> rows;
+    Histogram merged;
+    for (size_t i = 0; i < files.size(); ++i) {
+        FileResult& result = results[i];
+        if (!result.error.empty()) {
+            std::cerr << "❌ 错误: " << result.error << "\n";
+            exit_code = 1;
+            continue;
+        }
+        if (!result.warning.empty()) {
+            std::cerr << "⚠️  " << files[i] << ": " << result.warning << "\n";
+        }
+        for (auto& row : result.rows) {
+            merge_histogram(merged, row.histogram);
+            rows.push_back(std::move(row));
+        }
+    }
+
+    if (!write_file(output_path, format_rows(rows))) {
+        return 1;
+    }
+    if (!histogram_path.empty() && !write_file(histogram_path, format_histograms(rows, merged))) {
+        return 1;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "✅ 汇总完成: " << files.size() << " 个文件, " << rows.size() << " 行, 耗时 "
+              << elapsed << " 秒 (并行 " << std::max<size_t>(thread_count, 1) << ")\n";
+    int64_t samples = histogram_total(merged);
+    if (samples > 0) {
+        std::cerr << "   全部路由器: " << samples << " 个收敛样本, P50=" << pick_histogram(merged, samples, 0.5)
+                  << "ms, P75=" << pick_histogram(merged, samples, 0.75)
+                  << "ms, P95=" << pick_histogram(merged, samples, 0.95) << "ms\n";
+    }
+    return exit_code;
+}
@@ -0,0 +1,702 @@
+// 合成netlink负载基准：把RTM_NEWROUTE/RTM_DELROUTE/RTM_NEWQDISC突发送入解析器与会话引擎，
+// 报告吞吐、逐事件处理延迟、每事件内存分配次数与日志队列积压。
+//
+//   memory: 不经过套接字，消息在调用线程中经 NetlinkMonitor::inject_datagram 注入（虚拟时钟）
+//   socket: 在临时网络命名空间中创建dummy接口，经内核路由表产生真实通知（需要root）
+#include "convergence_monitor.h"
+#include "histogram.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <iostream>
+#include <new>
+#include <sched.h>
+#include <thread>
+#include <arpa/inet.h>
+#include <linux/if_link.h>
+#include <net/if.h>
+#include <unistd.h>
+
+// 内存分配计数：替换全局 operator new，分别统计全部线程与当前线程。
+// noinline 避免GCC在内联后把 malloc/free 配对误报为 -Wmismatched-new-delete
+namespace {
+std::atomic<int64_t> g_allocations{0};
+thread_local int64_t t_allocations = 0;
+}
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    t_allocations++;
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+__attribute__((noinline)) void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+namespace {
+
+enum class BenchMode {
+    MEMORY,
+    SOCKET
+};
+
+struct BenchOptions {
+    BenchMode mode = BenchMode::MEMORY;
+    int routes = 10000;             // 每次突发的路由数
+    int bursts = 10;
+    int64_t threshold_ms = 200;
+    int spacing_us = 10;            // memory模式下相邻消息的虚拟时间间隔
+    int send_batch = 64;            // socket模式下每次sendmsg携带的请求数
+    bool json = false;
+    std::string log_path = "/tmp/converge_bench.json";
+    MonitorOptions monitor;
+};
+
+constexpr int BENCH_IFINDEX = 2;
+constexpr const char* BENCH_IFNAME = "bench0";
+constexpr uint32_t BENCH_GATEWAY = 0x0aff0002;     // 10.255.0.2
+constexpr uint32_t BENCH_ROUTE_BASE = 0x0b000000;  // 11.0.0.0起的/24
+constexpr int64_t LATENCY_MAX_NS = 10LL * EventClock::NS_PER_SEC;
+constexpr long long LOG_RECORDS_PER_BURST = 16;    // 每次突发除路由事件外的日志记录余量
+
+void print_usage(const char* program_name) {
+    std::cout << "用法: " << program_name << " [选项]\n";
+    std::cout << "合成路由/QDisc突发，测量解析与会话引擎的吞吐、延迟、内存分配和日志积压\n\n";
+    std::cout << "选项:\n";
+    std::cout << "  -m, --mode MODE               memory(默认，绕过套接字), socket(临时命名空间+dummy接口，需要root)\n";
+    std::cout << "  -n, --routes N                每次突发的路由数(默认10000，先全部添加，下一次突发全部删除)\n";
+    std::cout << "  -b, --bursts N                突发次数(默认10)\n";
+    std::cout << "  -t, --threshold MILLISECONDS  收敛阈值(默认200ms)\n";
+    std::cout << "      --spacing-us US           memory模式下相邻消息的虚拟时间间隔(默认10us)\n";
+    std::cout << "      --send-batch N            socket模式下每次发送的路由请求数(默认64)\n";
+    std::cout << "      --batch N                 Netlink recvmmsg批量(socket模式)\n";
+    std::cout << "      --rcvbuf BYTES            Netlink接收缓冲区大小(socket模式)\n";
+    std::cout << "      --log-path PATH           日志文件(默认 /tmp/converge_bench.json)\n";
+    std::cout << "      --log-format FORMAT       json(默认), binary\n";
+    std::cout << "      --log-queue N             日志队列槽位数(默认容纳一次运行的全部记录)\n";
+    std::cout << "      --log-overflow POLICY     block, drop-newest, drop-oldest(默认)\n";
+    std::cout << "      --json                    最后输出一行JSON结果，便于回归比较\n";
+    std::cout << "  -h, --help                    显示此帮助信息\n";
+}
+
+// 构造netlink消息：头部、定长结构体与属性依次追加，每条消息按NLMSG_ALIGN对齐
+class MessageBuilder {
+public:
+    template <typename Payload>
+    void begin(uint16_t type, uint16_t flags, const Payload& payload) {
+        start_ = buffer_.size();
+        struct nlmsghdr nlh;
+        memset(&nlh, 0, sizeof(nlh));
+        nlh.nlmsg_type = type;
+        nlh.nlmsg_flags = flags;
+        nlh.nlmsg_seq = ++seq_;
+        append(&nlh, sizeof(nlh));
+        append(&payload, sizeof(payload));
+    }
+
+    void attr(uint16_t type, const void* data, size_t len) {
+        struct rtattr rta;
+        rta.rta_type = type;
+        rta.rta_len = static_cast<unsigned short>(RTA_LENGTH(len));
+        append(&rta, sizeof(rta));
+        append(data, len);
+    }
+
+    template <typename T>
+    void attr(uint16_t type, T value) {
+        attr(type, &value, sizeof(value));
+    }
+
+    // 嵌套属性：返回起始位置，end_nested 时回填长度
+    size_t begin_nested(uint16_t type) {
+        size_t pos = buffer_.size();
+        attr(type, nullptr, 0);
+        return pos;
+    }
+
+    void end_nested(size_t pos) {
+        struct rtattr* rta = reinterpret_cast<struct rtattr*>(buffer_.data() + pos);
+        rta->rta_len = static_cast<unsigned short>(buffer_.size() - pos);
+    }
+
+    // 结束当前消息，返回消息在缓冲区中的起始位置
+    size_t end() {
+        struct nlmsghdr* nlh = reinterpret_cast<struct nlmsghdr*>(buffer_.data() + start_);
+        nlh->nlmsg_len = static_cast<uint32_t>(buffer_.size() - start_);
+        return start_;
+    }
+
+    const char* data() const { return buffer_.data(); }
+    size_t size() const { return buffer_.size(); }
+    void clear() { buffer_.clear(); }
+
+private:
+    std::vector<char> buffer_;
+    size_t start_{0};
+    uint32_t seq_{0};
+
+    void append(const void* data, size_t len) {
+        const char* bytes = static_cast<const char*>(data);
+        buffer_.insert(buffer_.end(), bytes, bytes + len);
+        buffer_.resize(NLMSG_ALIGN(buffer_.size()), '\0');
+    }
+};
+
+void build_route(MessageBuilder& builder, uint16_t type, uint16_t flags, uint32_t dst, int32_t ifindex) {
+    struct rtmsg rtm;
+    memset(&rtm, 0, sizeof(rtm));
+    rtm.rtm_family = AF_INET;
+    rtm.rtm_dst_len = 24;
+    rtm.rtm_table = RT_TABLE_MAIN;
+    rtm.rtm_protocol = RTPROT_STATIC;
+    rtm.rtm_scope = RT_SCOPE_UNIVERSE;
+    rtm.rtm_type = RTN_UNICAST;
+    builder.begin(type, flags, rtm);
+    builder.attr<uint32_t>(RTA_TABLE, RT_TABLE_MAIN);
+    builder.attr<uint32_t>(RTA_DST, htonl(dst));
+    if (type == RTM_NEWROUTE) {
+        builder.attr<uint32_t>(RTA_GATEWAY, htonl(BENCH_GATEWAY));
+        builder.attr<int32_t>(RTA_OIF, ifindex);
+    }
+    builder.end();
+}
+
+void build_netem_qdisc(MessageBuilder& builder, uint16_t flags, int32_t ifindex) {
+    struct tcmsg tcm;
+    memset(&tcm, 0, sizeof(tcm));
+    tcm.tcm_family = AF_UNSPEC;
+    tcm.tcm_ifindex = ifindex;
+    tcm.tcm_parent = TC_H_ROOT;
+    builder.begin(RTM_NEWQDISC, flags, tcm);
+    builder.attr(TCA_KIND, "netem", sizeof("netem"));
+    struct tc_netem_qopt qopt;
+    memset(&qopt, 0, sizeof(qopt));
+    qopt.limit = 1000;
+    builder.attr(TCA_OPTIONS, &qopt, sizeof(qopt));
+    builder.end();
+}
+
+void build_link(MessageBuilder& builder, int32_t ifindex, const char* name) {
+    struct ifinfomsg ifm;
+    memset(&ifm, 0, sizeof(ifm));
+    ifm.ifi_family = AF_UNSPEC;
+    ifm.ifi_index = ifindex;
+    ifm.ifi_flags = IFF_UP | IFF_RUNNING;
+    builder.begin(RTM_NEWLINK, 0, ifm);
+    builder.attr(IFLA_IFNAME, name, strlen(name) + 1);
+    builder.end();
+}
+
+// 每次突发：一个netem触发，之后 routes 条路由（偶数次突发添加，奇数次删除）
+void build_bursts(const BenchOptions& options, int32_t ifindex, MessageBuilder& builder,
+                  std::vector<std::vector<size_t>>& bursts) {
+    bursts.assign(options.bursts, {});
+    for (int b = 0; b < options.bursts; ++b) {
+        std::vector<size_t>& offsets = bursts[b];
+        offsets.reserve(options.routes + 1);
+        build_netem_qdisc(builder, 0, ifindex);
+        offsets.push_back(builder.end());
+        uint16_t type = (b % 2 == 0) ? RTM_NEWROUTE : RTM_DELROUTE;
+        for (int i = 0; i < options.routes; ++i) {
+            build_route(builder, type, 0, BENCH_ROUTE_BASE + (static_cast<uint32_t>(i) << 8), ifindex);
+            offsets.push_back(builder.end());
+        }
+    }
+}
+
+struct BenchResult {
+    int64_t events = 0;
+    int64_t expected_events = 0;
+    int64_t elapsed_ns = 0;
+    int64_t thread_allocations = -1;    // 仅memory模式（事件在调用线程中处理）
+    int64_t total_allocations = 0;
+    int64_t sessions = 0;
+    int64_t overruns = 0;
+    int64_t lost_messages = 0;
+    int64_t send_errors = 0;
+    size_t peak_log_backlog = 0;
+    size_t log_capacity = 0;
+    int64_t log_dropped = 0;
+    int64_t log_drain_ns = 0;
+    double parse_ns_per_message = 0;
+    HdrHistogram latency{LATENCY_MAX_NS, 3};
+};
+
+// 解析器单独计时：对同一批路由消息反复调用 parse_route_message
+double bench_parser(const MessageBuilder& builder, const std::vector<std::vector<size_t>>& bursts) {
+    std::vector<const struct nlmsghdr*> messages;
+    for (const auto& offsets : bursts) {
+        for (size_t i = 1; i < offsets.size(); ++i) {
+            messages.push_back(reinterpret_cast<const struct nlmsghdr*>(builder.data() + offsets[i]));
+        }
+    }
+    if (messages.empty()) {
+        return 0;
+    }
+
+    RouteRecord record;
+    int64_t parsed = 0;
+    int64_t checksum = 0;
+    int64_t start = EventClock::monotonic_ns();
+    int64_t elapsed = 0;
+    do {
+        for (const struct nlmsghdr* nlh : messages) {
+            if (NetlinkMessageParser::parse_route_message(nlh, record)) {
+                checksum += record.dst_len;
+            }
+        }
+        parsed += static_cast<int64_t>(messages.size());
+        elapsed = EventClock::monotonic_ns() - start;
+    } while (elapsed < 200 * EventClock::NS_PER_MS);
+
+    if (checksum == 0) {
+        std::cerr << "⚠️  解析结果为空\n";
+    }
+    return static_cast<double>(elapsed) / static_cast<double>(parsed);
+}
+
+// 等待日志线程写出队列中的全部记录
+int64_t wait_log_drain(const Logger& logger) {
+    int64_t start = EventClock::monotonic_ns();
+    while (logger.get_queue_depth() > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return EventClock::monotonic_ns() - start;
+}
+
+bool run_memory(const BenchOptions& options, BenchResult& result) {
+    MonitorOptions monitor_options = options.monitor;
+    monitor_options.netlink.inject_only = true;
+    ConvergenceMonitor monitor(options.threshold_ms, "bench", options.log_path, monitor_options);
+    monitor.start_monitoring();
+    NetlinkMonitor& netlink = monitor.netlink_monitor();
+    const Logger& logger = monitor.logger();
+
+    MessageBuilder builder;
+    build_link(builder, BENCH_IFINDEX, BENCH_IFNAME);
+    netlink.inject_datagram(builder.data(), builder.size(), netlink.now_ns());
+    builder.clear();
+
+    std::vector<std::vector<size_t>> bursts;
+    build_bursts(options, BENCH_IFINDEX, builder, bursts);
+    result.parse_ns_per_message = bench_parser(builder, bursts);
+
+    const int64_t spacing_ns = static_cast<int64_t>(options.spacing_us) * EventClock::NS_PER_US;
+    const int64_t quiet_ns = (options.threshold_ms + 1) * EventClock::NS_PER_MS;
+    int64_t virtual_time = netlink.now_ns();
+    int64_t total_allocations_start = g_allocations.load();
+    int64_t thread_allocations_start = t_allocations;
+    int64_t start = EventClock::monotonic_ns();
+
+    for (const auto& offsets : bursts) {
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            const char* data = builder.data() + offsets[i];
+            size_t len = reinterpret_cast<const struct nlmsghdr*>(data)->nlmsg_len;
+            virtual_time += spacing_ns;
+            int64_t before = EventClock::monotonic_ns();
+            netlink.inject_datagram(data, len, virtual_time);
+            result.latency.record(EventClock::monotonic_ns() - before);
+            if ((i & 1023) == 0) {
+                result.peak_log_backlog = std::max(result.peak_log_backlog, logger.get_queue_depth());
+            }
+        }
+        result.events += static_cast<int64_t>(offsets.size());
+        // 虚拟时间跳过静默期，会话在此收敛
+        virtual_time += quiet_ns;
+        netlink.advance_clock(virtual_time);
+    }
+
+    result.elapsed_ns = EventClock::monotonic_ns() - start;
+    result.thread_allocations = t_allocations - thread_allocations_start;
+    result.log_drain_ns = wait_log_drain(logger);
+    result.total_allocations = g_allocations.load() - total_allocations_start;
+    result.expected_events = result.events;
+    result.sessions = monitor.completed_session_count();
+    result.log_dropped = logger.get_dropped_count();
+    result.log_capacity = logger.get_queue_capacity();
+    monitor.stop_monitoring();
+    return true;
+}
+
+// 同步netlink请求（带ACK），返回内核错误码（0为成功）
+int netlink_request(int fd, MessageBuilder& builder) {
+    if (send(fd, builder.data(), builder.size(), 0) < 0) {
+        return -errno;
+    }
+    char buffer[8192];
+    ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+    if (len < 0) {
+        return -errno;
+    }
+    const struct nlmsghdr* nlh = reinterpret_cast<const struct nlmsghdr*>(buffer);
+    if (NLMSG_OK(nlh, static_cast<int>(len)) && nlh->nlmsg_type == NLMSG_ERROR) {
+        return reinterpret_cast<const struct nlmsgerr*>(NLMSG_DATA(nlh))->error;
+    }
+    return 0;
+}
+
+// 在当前（新建的）网络命名空间中创建并启用dummy接口，返回其ifindex（不支持dummy时返回lo）
+int setup_dummy_interface(int fd) {
+    MessageBuilder builder;
+    struct ifinfomsg ifm;
+    memset(&ifm, 0, sizeof(ifm));
+    ifm.ifi_family = AF_UNSPEC;
+    ifm.ifi_index = 1;
+    ifm.ifi_flags = IFF_UP;
+    ifm.ifi_change = IFF_UP;
+    builder.begin(RTM_NEWLINK, NLM_F_REQUEST | NLM_F_ACK, ifm);
+    builder.end();
+    netlink_request(fd, builder);   // lo
+
+    builder.clear();
+    ifm.ifi_index = 0;
+    builder.begin(RTM_NEWLINK, NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE | NLM_F_EXCL, ifm);
+    builder.attr(IFLA_IFNAME, BENCH_IFNAME, strlen(BENCH_IFNAME) + 1);
+    size_t linkinfo = builder.begin_nested(IFLA_LINKINFO);
+    builder.attr(IFLA_INFO_KIND, "dummy", sizeof("dummy") - 1);
+    builder.end_nested(linkinfo);
+    builder.end();
+    int err = netlink_request(fd, builder);
+    int ifindex = 1;
+    if (err == -EOPNOTSUPP) {
+        // 内核没有dummy驱动（如部分容器）：路由改挂在命名空间自己的lo上
+        std::cerr << "⚠️  内核不支持dummy接口，改用临时命名空间中的lo\n";
+    } else if (err != 0) {
+        std::cerr << "❌ 创建dummy接口失败: " << strerror(-err) << "\n";
+        return -1;
+    } else {
+        ifindex = static_cast<int>(if_nametoindex(BENCH_IFNAME));
+    }
+
+    struct ifaddrmsg ifa;
+    memset(&ifa, 0, sizeof(ifa));
+    ifa.ifa_family = AF_INET;
+    ifa.ifa_prefixlen = 24;
+    ifa.ifa_index = static_cast<uint32_t>(ifindex);
+    builder.clear();
+    builder.begin(RTM_NEWADDR, NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE, ifa);
+    builder.attr<uint32_t>(IFA_LOCAL, htonl(BENCH_GATEWAY - 1));
+    builder.attr<uint32_t>(IFA_ADDRESS, htonl(BENCH_GATEWAY - 1));
+    builder.end();
+    err = netlink_request(fd, builder);
+    if (err != 0) {
+        std::cerr << "❌ 配置接口地址失败: " << strerror(-err) << "\n";
+        return -1;
+    }
+    return ifindex;
+}
+
+bool run_socket(const BenchOptions& options, BenchResult& result) {
+    if (unshare(CLONE_NEWNET) < 0) {
+        std::cerr << "❌ 创建临时网络命名空间失败: " << strerror(errno) << " (需要root)\n";
+        return false;
+    }
+    int control_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (control_fd < 0) {
+        std::cerr << "❌ 创建netlink套接字失败: " << strerror(errno) << "\n";
+        return false;
+    }
+    int ifindex = setup_dummy_interface(control_fd);
+    if (ifindex <= 0) {
+        close(control_fd);
+        return false;
+    }
+
+    // 预先构造全部请求；netem不可用时（缺少sch_netem）由第一条路由变化触发会话
+    MessageBuilder netem;
+    build_netem_qdisc(netem, NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE | NLM_F_REPLACE, ifindex);
+    MessageBuilder builder;
+    std::vector<std::vector<size_t>> bursts;
+    bursts.assign(options.bursts, {});
+    for (int b = 0; b < options.bursts; ++b) {
+        uint16_t type = (b % 2 == 0) ? RTM_NEWROUTE : RTM_DELROUTE;
+        uint16_t flags = NLM_F_REQUEST | (type == RTM_NEWROUTE ? NLM_F_CREATE | NLM_F_EXCL : 0);
+        for (int i = 0; i < options.routes; ++i) {
+            build_route(builder, type, flags, BENCH_ROUTE_BASE + (static_cast<uint32_t>(i) << 8), ifindex);
+            bursts[b].push_back(builder.end());
+        }
+    }
+
+    MonitorOptions monitor_options = options.monitor;
+    ConvergenceMonitor monitor(options.threshold_ms, "bench", options.log_path, monitor_options);
+    NetlinkMonitor& netlink = monitor.netlink_monitor();
+    const Logger& logger = monitor.logger();
+
+    // 每条消息处理完成时计时：出队时刻到处理结束（只在监控线程中访问直方图）
+    std::atomic<int64_t> processed{0};
+    std::atomic<int64_t> last_processed_ns{0};
+    netlink.set_unified_callback([&](const void*, NetlinkMessageType type) {
+        if (type == NetlinkMessageType::ROUTE_ADD || type == NetlinkMessageType::ROUTE_DEL ||
+            type == NetlinkMessageType::QDISC_ADD) {
+            int64_t now = EventClock::monotonic_ns();
+            result.latency.record(now - netlink.current_receive_time_ns());
+            last_processed_ns.store(now, std::memory_order_relaxed);
+            processed.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    monitor.start_monitoring();
+
+    bool netem_ok = true;
+    int64_t total_allocations_start = g_allocations.load();
+    int64_t start = EventClock::monotonic_ns();
+
+    for (int b = 0; b < options.bursts; ++b) {
+        if (netem_ok) {
+            int err = netlink_request(control_fd, netem);
+            if (err != 0) {
+                netem_ok = false;
+                std::cerr << "⚠️  添加netem失败: " << strerror(-err) << "，由路由变化触发会话\n";
+            } else {
+                result.expected_events++;
+            }
+        }
+
+        // 不请求ACK，只有失败的请求会返回错误消息
+        const std::vector<size_t>& offsets = bursts[b];
+        for (size_t i = 0; i < offsets.size(); i += options.send_batch) {
+            size_t last = std::min(offsets.size(), i + options.send_batch);
+            size_t begin = offsets[i];
+            size_t end = last < offsets.size() ? offsets[last] : (b + 1 < options.bursts ? bursts[b + 1][0] : builder.size());
+            if (send(control_fd, builder.data() + begin, end - begin, 0) < 0) {
+                result.send_errors++;
+            }
+        }
+        result.expected_events += static_cast<int64_t>(offsets.size());
+
+        // 等待通知处理完并收敛
+        int64_t deadline = EventClock::monotonic_ns() + 10 * EventClock::NS_PER_SEC;
+        while (processed.load() < result.expected_events && EventClock::monotonic_ns() < deadline) {
+            result.peak_log_backlog = std::max(result.peak_log_backlog, logger.get_queue_depth());
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.threshold_ms + 50));
+
+        // 丢弃失败请求的错误应答
+        char drain[8192];
+        while (recv(control_fd, drain, sizeof(drain), MSG_DONTWAIT) > 0) {
+            result.send_errors++;
+        }
+    }
+
+    result.events = processed.load();
+    result.elapsed_ns = last_processed_ns.load() - start -
+                        static_cast<int64_t>(options.bursts - 1) * (options.threshold_ms + 50) * EventClock::NS_PER_MS;
+    result.log_drain_ns = wait_log_drain(logger);
+    result.total_allocations = g_allocations.load() - total_allocations_start;
+    result.sessions = monitor.completed_session_count();
+    result.overruns = netlink.get_overrun_count();
+    result.lost_messages = netlink.get_lost_message_count();
+    result.log_dropped = logger.get_dropped_count();
+    result.log_capacity = logger.get_queue_capacity();
+    monitor.stop_monitoring();
+    close(control_fd);
+    return true;
+}
+
+void print_result(const BenchOptions& options, const BenchResult& result) {
+    const char* mode = options.mode == BenchMode::MEMORY ? "memory" : "socket";
+    double seconds = static_cast<double>(std::max<int64_t>(result.elapsed_ns, 1)) / EventClock::NS_PER_SEC;
+    double events_per_sec = static_cast<double>(result.events) / seconds;
+    double events = static_cast<double>(std::max<int64_t>(result.events, 1));
+    double total_allocs = static_cast<double>(result.total_allocations) / events;
+    double thread_allocs = result.thread_allocations >= 0 ? static_cast<double>(result.thread_allocations) / events : -1;
+
+    std::cout << "\n📈 基准结果 (" << mode << ", " << options.bursts << " 次突发 × " << options.routes
+              << " 条路由, 阈值 " << options.threshold_ms << "ms)\n";
+    std::cout << "   事件: " << result.events << " / " << result.expected_events << ", 会话: " << result.sessions
+              << ", 吞吐: " << static_cast<int64_t>(events_per_sec) << " 事件/秒\n";
+    std::cout << "   单事件处理延迟" << (options.mode == BenchMode::MEMORY ? "" : "(出队到处理完成)") << ": P50="
+              << result.latency.value_at_percentile(50) << "ns, P99=" << result.latency.value_at_percentile(99)
+              << "ns, P99.9=" << result.latency.value_at_percentile(99.9) << "ns, 最大=" << result.latency.max()
+              << "ns\n";
+    std::cout << "   内存分配: " << total_allocs << " 次/事件(全部线程)";
+    if (thread_allocs >= 0) {
+        std::cout << ", " << thread_allocs << " 次/事件(事件处理线程)";
+    }
+    std::cout << "\n";
+    std::cout << "   日志队列: 峰值积压 " << result.peak_log_backlog << " / " << result.log_capacity << ", 丢弃 "
+              << result.log_dropped << ", 清空耗时 " << result.log_drain_ns / EventClock::NS_PER_MS << "ms\n";
+    if (options.mode == BenchMode::MEMORY) {
+        std::cout << "   解析: parse_route_message " << result.parse_ns_per_message << "ns/条\n";
+    } else {
+        std::cout << "   接收溢出: " << result.overruns << " 次, 丢失 " << result.lost_messages
+                  << " 条, 发送失败/错误应答: " << result.send_errors << "\n";
+    }
+
+    if (options.json) {
+        JsonObject json;
+        json["mode"] = std::string(mode);
+        json["routes"] = static_cast<int64_t>(options.routes);
+        json["bursts"] = static_cast<int64_t>(options.bursts);
+        json["threshold_ms"] = options.threshold_ms;
+        json["events"] = result.events;
+        json["expected_events"] = result.expected_events;
+        json["sessions"] = result.sessions;
+        json["events_per_sec"] = events_per_sec;
+        json["latency_p50_ns"] = result.latency.value_at_percentile(50);
+        json["latency_p99_ns"] = result.latency.value_at_percentile(99);
+        json["latency_p999_ns"] = result.latency.value_at_percentile(99.9);
+        json["latency_max_ns"] = result.latency.max();
+        json["allocations_per_event"] = total_allocs;
+        json["thread_allocations_per_event"] = thread_allocs;
+        json["peak_log_backlog"] = static_cast<int64_t>(result.peak_log_backlog);
+        json["log_dropped"] = result.log_dropped;
+        json["log_drain_ms"] = static_cast<double>(result.log_drain_ns) / EventClock::NS_PER_MS;
+        json["parse_ns_per_message"] = result.parse_ns_per_message;
+        json["overruns"] = result.overruns;
+        json["lost_messages"] = result.lost_messages;
+        json["send_errors"] = result.send_errors;
+        std::string out;
+        LogJson::append_json(out, json);
+        std::cout << out << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    long long log_queue_capacity = 0;     // 0：按路由数与突发次数确定
+
+    enum {
+        OPT_SPACING = 1000,
+        OPT_SEND_BATCH,
+        OPT_BATCH,
+        OPT_RCVBUF,
+        OPT_LOG_PATH,
+        OPT_LOG_FORMAT,
+        OPT_LOG_QUEUE,
+        OPT_LOG_OVERFLOW,
+        OPT_JSON,
+    };
+    static struct option long_options[] = {
+        {"mode", required_argument, 0, 'm'},
+        {"routes", required_argument, 0, 'n'},
+        {"bursts", required_argument, 0, 'b'},
+        {"threshold", required_argument, 0, 't'},
+        {"spacing-us", required_argument, 0, OPT_SPACING},
+        {"send-batch", required_argument, 0, OPT_SEND_BATCH},
+        {"batch", required_argument, 0, OPT_BATCH},
+        {"rcvbuf", required_argument, 0, OPT_RCVBUF},
+        {"log-path", required_argument, 0, OPT_LOG_PATH},
+        {"log-format", required_argument, 0, OPT_LOG_FORMAT},
+        {"log-queue", required_argument, 0, OPT_LOG_QUEUE},
+        {"log-overflow", required_argument, 0, OPT_LOG_OVERFLOW},
+        {"json", no_argument, 0, OPT_JSON},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int option_index = 0;
+    int c;
+    while ((c = getopt_long(argc, argv, "m:n:b:t:h", long_options, &option_index)) != -1) {
+        switch (c) {
+            case 'm':
+                if (strcmp(optarg, "memory") == 0) {
+                    options.mode = BenchMode::MEMORY;
+                } else if (strcmp(optarg, "socket") == 0) {
+                    options.mode = BenchMode::SOCKET;
+                } else {
+                    std::cerr << "❌ 错误: 未知的模式 '" << optarg << "'，可选 memory, socket\n";
+                    return 1;
+                }
+                break;
+            case 'n':
+                options.routes = std::stoi(optarg);
+                break;
+            case 'b':
+                options.bursts = std::stoi(optarg);
+                break;
+            case 't':
+                options.threshold_ms = std::stoll(optarg);
+                break;
+            case OPT_SPACING:
+                options.spacing_us = std::stoi(optarg);
+                break;
+            case OPT_SEND_BATCH:
+                options.send_batch = std::stoi(optarg);
+                break;
+            case OPT_BATCH:
+                options.monitor.netlink.batch_size = static_cast<unsigned int>(std::stoul(optarg));
+                break;
+            case OPT_RCVBUF:
+                options.monitor.netlink.rcvbuf_bytes = std::stoi(optarg);
+                break;
+            case OPT_LOG_PATH:
+                options.log_path = optarg;
+                break;
+            case OPT_LOG_FORMAT:
+                if (!LoggerOptions::parse_format(optarg, options.monitor.logger.format)) {
+                    std::cerr << "❌ 错误: 未知的日志格式 '" << optarg << "'，可选 json, binary\n";
+                    return 1;
+                }
+                break;
+            case OPT_LOG_QUEUE:
+                log_queue_capacity = std::stoll(optarg);
+                break;
+            case OPT_LOG_OVERFLOW:
+                if (!LoggerOptions::parse_overflow_policy(optarg, options.monitor.logger.overflow_policy)) {
+                    std::cerr << "❌ 错误: 未知的日志溢出策略 '" << optarg
+                              << "'，可选 block, drop-newest, drop-oldest\n";
+                    return 1;
+                }
+                break;
+            case OPT_JSON:
+                options.json = true;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (options.routes <= 0 || options.bursts <= 0 || options.threshold_ms <= 0 || options.spacing_us < 0 ||
+        options.send_batch <= 0 || log_queue_capacity < 0) {
+        std::cerr << "❌ 错误: 路由数、突发次数、阈值、发送批量与日志队列必须为正数\n";
+        return 1;
+    }
+    if (log_queue_capacity == 0) {
+        // 默认队列容纳全部记录（每条路由一条事件，另加每次突发的会话与触发记录），
+        // 日志线程落后时只积压不丢弃，丢弃即表示流水线跟不上
+        log_queue_capacity = (static_cast<long long>(options.routes) + LOG_RECORDS_PER_BURST) * options.bursts;
+    }
+    options.monitor.logger.queue_capacity = static_cast<size_t>(log_queue_capacity);
+    // 只保留会话汇总，基准测量的是事件路径而不是长期保留的内存
+    options.monitor.retain_events = EventRetention::NONE;
+
+    BenchResult result;
+    try {
+        bool ok = options.mode == BenchMode::MEMORY ? run_memory(options, result) : run_socket(options, result);
+        if (!ok) {
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "❌ 基准运行出错: " << e.what() << "\n";
+        return 1;
+    }
+
+    print_result(options, result);
+    if (result.log_dropped > 0) {
+        std::cerr << "❌ 错误: 日志队列丢弃了 " << result.log_dropped << " 条记录，日志流水线没有跟上负载"
+                  << "（增大 --log-queue 或使用 --log-overflow block）\n";
+        return 1;
+    }
+    return 0;
+}
@@ -1,12 +1,17 @@
 #include "convergence_monitor.h"
+#include "low_jitter.h"
 #include <chrono>
 #include <iostream>
 #include <iomanip>
 #include <ratio>
 #include <sstream>
 #include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
 #include <cmath>
 #include <pwd.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <uuid/uuid.h>
 #include <numeric>
@@ -22,31 +27,132 @@
     #define HAS_SHARED_MUTEX 0
 #endif
 
+namespace {
+
+// monitoring_completed 中输出的百分位
+struct PercentileField {
+    double percentile;
+    const char* suffix;
+};
+
+constexpr PercentileField SUMMARY_PERCENTILES[] = {
+    {50.0, "p50"}, {75.0, "p75"}, {90.0, "p90"}, {95.0, "p95"}, {99.0, "p99"}, {99.9, "p999"}
+};
+
+// 以 <prefix>_<pNN><unit_suffix> 写入百分位；scale 为直方图单位到输出单位的除数
+void append_percentiles(JsonObject& log, const std::string& prefix, const std::string& unit_suffix,
+                        const HdrHistogram& hist, double scale) {
+    for (const auto& field : SUMMARY_PERCENTILES) {
+        int64_t value = hist.value_at_percentile(field.percentile);
+        std::string key = prefix + "_" + field.suffix + unit_suffix;
+        if (scale == 1.0) {
+            log[key] = value;
+        } else {
+            log[key] = static_cast<double>(value) / scale;
+        }
+    }
+}
+
+// 两个前缀在较短者长度内是否一致：一致时返回较短前缀长度，否则返回-1
+int prefix_overlap(const RouteRecord& a, const RouteRecord& b) {
+    if (a.family != b.family || !a.has(RouteRecord::HAS_DST) || !b.has(RouteRecord::HAS_DST)) {
+        return -1;
+    }
+    int bits = std::min(a.dst_len, b.dst_len);
+    const uint8_t* x = a.dst.s6_addr;
+    const uint8_t* y = b.dst.s6_addr;
+    int full_bytes = bits / 8;
+    if (memcmp(x, y, full_bytes) != 0) {
+        return -1;
+    }
+    int rest = bits % 8;
+    if (rest > 0) {
+        uint8_t mask = static_cast<uint8_t>(0xff << (8 - rest));
+        if ((x[full_bytes] & mask) != (y[full_bytes] & mask)) {
+            return -1;
+        }
+    }
+    return bits;
+}
+
+// 触发键：netem与链路触发按接口区分，路由触发按路由表与目标前缀区分，下一跳触发按对象编号区分
+bool same_trigger_key(const TriggerRecord& a, const TriggerRecord& b) {
+    if (a.source != b.source) {
+        return false;
+    }
+    if (a.source == TriggerRecord::NEXTHOP) {
+        return a.event.nexthop.id == b.event.nexthop.id;
+    }
+    if (a.source != TriggerRecord::ROUTE) {
+        return a.event.ifindex() == b.event.ifindex();
+    }
+    const RouteRecord& x = a.event.route;
+    const RouteRecord& y = b.event.route;
+    if (x.table != y.table || x.family != y.family || x.dst_len != y.dst_len ||
+        x.has(RouteRecord::HAS_DST) != y.has(RouteRecord::HAS_DST)) {
+        return false;
+    }
+    return !x.has(RouteRecord::HAS_DST) || memcmp(&x.dst, &y.dst, sizeof(x.dst)) == 0;
+}
+
+} // namespace
+
 // ConvergenceSession 实现
-ConvergenceSession::ConvergenceSession(int id, int64_t netem_time, 
-                                     const std::unordered_map<std::string, std::string>& netem_info_map)
-    : session_id(id), netem_event_time(netem_time), netem_info(netem_info_map) {
+ConvergenceSession::ConvergenceSession(int id, int64_t netem_time, const TriggerRecord& trigger_record,
+                                       EventSlabPool* pool, bool track_prefixes)
+    : session_id(id), netem_event_time(netem_time), trigger(trigger_record), route_events(pool),
+      track_prefixes_(track_prefixes) {
 }
 
-void ConvergenceSession::add_route_event(int64_t timestamp, const std::string& event_type,
-                                        const std::unordered_map<std::string, std::string>& route_info) {
+int ConvergenceSession::add_route_event(int64_t timestamp, const EventRecord& record, uint32_t interface_id,
+                                        bool quiet_reset) {
     std::lock_guard<std::mutex> lock(mutex_);
 
     int64_t offset = timestamp - netem_event_time;
-    route_events.emplace_back(timestamp, event_type, route_info, offset);
+    route_events.emplace_back(timestamp, record, offset);
+    if ((record.cls == EventRecord::ROUTE && record.route.change == RouteRecord::CHANGE_NOOP) ||
+        (record.cls == EventRecord::NEXTHOP && record.nexthop.change == RouteRecord::CHANGE_NOOP)) {
+        noop_route_count_++;
+    }
+    if (!quiet_reset) {
+        return ++route_event_count_;
+    }
+
+    if (!first_route_event_time.has_value()) {
+        first_route_event_time = timestamp;
+    }
     last_route_event_time = timestamp;
+
+    if (track_prefixes_ && record.cls == EventRecord::ROUTE) {
+        prefixes.update(record.route);
+    }
+
+    if (interface_id != 0) {
+        auto it = std::lower_bound(interface_ids.begin(), interface_ids.end(), interface_id);
+        if (it == interface_ids.end() || *it != interface_id) {
+            interface_ids.insert(it, interface_id);
+        }
+    }
+    return ++route_event_count_;
+}
+
+void ConvergenceSession::release_events() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    route_events.clear();
+    prefixes.clear();
+}
+
+bool ConvergenceSession::check_convergence(int64_t quiet_period_ns) {
+    return check_convergence(quiet_period_ns, EventClock::monotonic_ns());
 }
 
-bool ConvergenceSession::check_convergence(int64_t quiet_period_ms) {
+bool ConvergenceSession::check_convergence(int64_t quiet_period_ns, int64_t current_time) {
     std::lock_guard<std::mutex> lock(mutex_);
 
     if (is_converged.load()) {
         return true;
     }
 
-    auto current_time = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
-
     int64_t quiet_time;
     if (!last_route_event_time.has_value()) {
         quiet_time = current_time - netem_event_time;
@@ -56,7 +162,7 @@ bool ConvergenceSession::check_convergence(int64_t quiet_period_ms) {
 
     convergence_check_count_.fetch_add(1);
 
-    if (quiet_time >= quiet_period_ms) {
+    if (quiet_time >= quiet_period_ns) {
         is_converged.store(true);
         convergence_detected_time = current_time;
 
@@ -72,9 +178,40 @@ bool ConvergenceSession::check_convergence(int64_t quiet_period_ms) {
     return false;
 }
 
+int64_t ConvergenceSession::quiet_deadline(int64_t quiet_period_ns) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t last_event = last_route_event_time.has_value() ? last_route_event_time.value() : netem_event_time;
+    return last_event + quiet_period_ns;
+}
+
+void ConvergenceSession::mark_lossy(int64_t timestamp, int64_t lost) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    lossy = true;
+    lost_messages += lost;
+    resync_pending = true;
+    if (!last_route_event_time.has_value() || last_route_event_time.value() < timestamp) {
+        last_route_event_time = timestamp;
+    }
+}
+
+void ConvergenceSession::mark_resynced(bool success) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (resync_pending) {
+        resync_pending = false;
+        resynced = success;
+    }
+}
+
 int ConvergenceSession::get_route_event_count() const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return route_events.size();
+    return route_event_count_;
+}
+
+int ConvergenceSession::get_noop_route_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return noop_route_count_;
 }
 
 int64_t ConvergenceSession::get_session_duration() const {
@@ -84,18 +221,67 @@ int64_t ConvergenceSession::get_session_duration() const {
         return convergence_detected_time.value() - netem_event_time;
     }
 
-    auto current_time = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
-    return current_time - netem_event_time;
+    return EventClock::monotonic_ns() - netem_event_time;
+}
+
+bool MonitorOptions::parse_retention(const std::string& name, EventRetention& retention) {
+    if (name == "none") {
+        retention = EventRetention::NONE;
+    } else if (name == "summary") {
+        retention = EventRetention::SUMMARY;
+    } else if (name == "full") {
+        retention = EventRetention::FULL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* MonitorOptions::retention_name(EventRetention retention) {
+    switch (retention) {
+        case EventRetention::NONE: return "none";
+        case EventRetention::SUMMARY: return "summary";
+        case EventRetention::FULL: return "full";
+    }
+    return "unknown";
+}
+
+bool MonitorOptions::parse_attribution(const std::string& name, SessionAttribution& attribution) {
+    if (name == "all-open") {
+        attribution = SessionAttribution::ALL_OPEN;
+    } else if (name == "latest") {
+        attribution = SessionAttribution::LATEST;
+    } else if (name == "nearest-prefix") {
+        attribution = SessionAttribution::NEAREST_PREFIX;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* MonitorOptions::attribution_name(SessionAttribution attribution) {
+    switch (attribution) {
+        case SessionAttribution::ALL_OPEN: return "all-open";
+        case SessionAttribution::LATEST: return "latest";
+        case SessionAttribution::NEAREST_PREFIX: return "nearest-prefix";
+    }
+    return "unknown";
 }
 
 // ConvergenceMonitor 实现
+std::string ConvergenceMonitor::current_user() {
+    struct passwd* pw = getpwuid(getuid());
+    return pw ? std::string(pw->pw_name) : "unknown";
+}
+
 ConvergenceMonitor::ConvergenceMonitor(int64_t convergence_threshold_ms,
                                      const std::string& router_name,
-                                     const std::string& log_path)
+                                     const std::string& log_path,
+                                     const MonitorOptions& options)
     : router_name_(router_name),
       convergence_threshold_ms_(convergence_threshold_ms),
-      monitoring_start_time_(get_current_timestamp_ms()) {
+      options_(options),
+      monitoring_start_time_(EventClock::monotonic_ns()) {
     
     // 生成监控器ID
     uuid_t uuid;
@@ -105,21 +291,93 @@ ConvergenceMonitor::ConvergenceMonitor(int64_t convergence_threshold_ms,
     monitor_id_ = std::string(uuid_str);
     
     // 创建日志记录器
-    logger_ = std::make_unique<Logger>(log_path);
+    logger_ = std::make_shared<Logger>(log_path, options_.logger);
     log_file_path_ = logger_->get_log_file_path();
     
     // 创建netlink监控器
+    options_.netlink.initial_route_dump = options_.fib_mirror;
     netlink_monitor_ = std::make_unique<NetlinkMonitor>();
-    
+    netlink_monitor_->set_options(options_.netlink);
+    setup_netlink_callbacks();
+    session_targets_.reserve(static_cast<size_t>(std::max(options_.max_sessions, 1)));
+
+    // 回放：事件时间与统计时长都以抓包中的虚拟时钟为准
+    if (!options_.netlink.replay_path.empty()) {
+        std::string error;
+        if (!netlink_monitor_->open_replay(error)) {
+            throw std::runtime_error(error);
+        }
+        monitoring_start_time_ = netlink_monitor_->replay_start_ns();
+    }
+}
+
+ConvergenceMonitor::ConvergenceMonitor(int64_t convergence_threshold_ms,
+                                     const std::string& router_name,
+                                     std::shared_ptr<Logger> shared_logger,
+                                     const MonitorOptions& options)
+    : logger_(std::move(shared_logger)),
+      owns_logger_(false),
+      router_name_(router_name),
+      convergence_threshold_ms_(convergence_threshold_ms),
+      options_(options),
+      monitoring_start_time_(EventClock::monotonic_ns()),
+      interfaces_(std::make_unique<InterfaceCache>()),
+      external_loop_(true),
+      console_tag_("[" + router_name + "] ") {
+
+    uuid_t uuid;
+    uuid_generate(uuid);
+    char uuid_str[37];
+    uuid_unparse(uuid, uuid_str);
+    monitor_id_ = std::string(uuid_str);
+    log_file_path_ = logger_->get_log_file_path();
+
+    options_.netlink.initial_route_dump = options_.fib_mirror;
+    netlink_monitor_ = std::make_unique<NetlinkMonitor>();
+    netlink_monitor_->set_options(options_.netlink);
+    netlink_monitor_->set_interface_cache(interfaces_.get());
+    setup_netlink_callbacks();
+    session_targets_.reserve(static_cast<size_t>(std::max(options_.max_sessions, 1)));
+}
+
+void ConvergenceMonitor::setup_netlink_callbacks() {
     // 设置回调函数
     netlink_monitor_->set_route_callback(
-        [this](const void* data, const std::string& type) {
-            this->on_route_event(data, type);
+        [this](const RouteRecord& route) {
+            this->on_route_event(route);
         });
     
     netlink_monitor_->set_qdisc_callback(
-        [this](const void* data, const std::string& type) {
-            this->on_qdisc_event(data, type);
+        [this](const QdiscRecord& qdisc) {
+            this->on_qdisc_event(qdisc);
+        });
+
+    netlink_monitor_->set_link_callback(
+        [this](const LinkRecord& link) {
+            this->on_link_event(link);
+        });
+
+    netlink_monitor_->set_nexthop_callback(
+        [this](const NexthopRecord& nexthop) {
+            this->on_nexthop_event(nexthop);
+        });
+
+    netlink_monitor_->set_timer_callback(
+        [this]() {
+            this->on_convergence_timer();
+        });
+
+    netlink_monitor_->set_overrun_callback(
+        [this](int64_t lost) {
+            this->on_netlink_overrun(lost);
+        });
+
+    netlink_monitor_->set_dump_callbacks(
+        [this](const void* data) {
+            this->on_route_dump_entry(data);
+        },
+        [this](bool success) {
+            this->on_route_dump_done(success);
         });
 }
 
@@ -134,28 +392,67 @@ void ConvergenceMonitor::start_monitoring() {
     
     running_.store(true);
     
-    // 启动日志记录器
-    logger_->start();
+    // 启动日志记录器（共享时由调用者启动）
+    if (owns_logger_) {
+        logger_->start();
+    }
+
+    // 日志线程已按普通优先级创建；此后创建的netlink监控线程继承实时调度（多命名空间时由事件线程池设置）
+    LowJitter::RealtimeSpawnScope realtime(options_.low_jitter && !external_loop_ ? options_.realtime_priority : 0);
+    if (options_.low_jitter) {
+        open_sessions_.reserve(static_cast<size_t>(options_.max_sessions));
+        if (options_.retain_events != EventRetention::NONE) {
+            prefaulted_bytes_ = static_cast<int64_t>(event_pool_.prefill(LowJitter::PREFILL_SLABS));
+        }
+    }
     
     // 记录监控开始日志
-    std::string user = []() {
-        struct passwd* pw = getpwuid(getuid());
-        return pw ? std::string(pw->pw_name) : "unknown";
-    }();
-    
-    auto start_log = Logger::create_monitoring_start_log(
-        router_name_, user, convergence_threshold_ms_, 
+    auto start_log = LogJson::create_monitoring_start_log(
+        router_name_, user_, convergence_threshold_ms_, 
         log_file_path_, monitor_id_);
+    if (options_.netlink.replay_path.empty()) {
+        // 时钟锚点与来源标识：离线关联各路由器的会话时用于对齐时间轴（回放使用录制时的虚拟时钟，不记录）
+        std::string boot_id;
+        int64_t timens_offset_ns = 0;
+        int64_t anchor_realtime_ns = 0;
+        int64_t anchor_monotonic_ns = 0;
+        EventClock::wall_anchor(anchor_realtime_ns, anchor_monotonic_ns);
+        start_log["clock_realtime_ns"] = anchor_realtime_ns;
+        start_log["clock_monotonic_ns"] = anchor_monotonic_ns;
+        if (EventClock::host_clock_identity(boot_id, timens_offset_ns)) {
+            start_log["clock_boot_id"] = boot_id;
+            start_log["clock_timens_offset_ns"] = timens_offset_ns;
+        }
+    }
+    if (options_.netlink.route_source != RouteEventSource::NETLINK) {
+        start_log["route_source"] = NetlinkMonitor::route_source_name(options_.netlink.route_source);
+    }
+    LowJitter::append_monitoring_fields(start_log, prefaulted_bytes_);
     logger_->log_async(start_log);
+
+    // 路由事件日志只携带来源编号，身份信息在输出阶段补全
+    log_source_id_ = logger_->register_source(router_name_, user_, interfaces_.get());
+    open_status_page();
     
-    // 启动netlink监控
-    if (!netlink_monitor_->start_monitoring()) {
+    // 启动netlink监控（FIB镜像在套接字创建后、监控线程启动前由转储填充）
+    fib_loading_ = options_.fib_mirror;
+    bool started = external_loop_ ? netlink_monitor_->start_external()
+                                  : netlink_monitor_->start_monitoring();
+    if (!started) {
         throw std::runtime_error("Failed to start netlink monitoring");
     }
+    if (external_loop_) {
+        return;
+    }
     
-    // 启动收敛检查线程
-    convergence_checker_thread_ = std::thread(&ConvergenceMonitor::convergence_checker_loop, this);
-    
+    if (netlink_monitor_->is_replaying()) {
+        std::cout << "⏯️  回放抓包: " << options_.netlink.replay_path << " - 路由器: " << router_name_ << "\n";
+        std::cout << "   收敛阈值: " << convergence_threshold_ms_ << "ms\n";
+        return;
+    }
+    if (!options_.netlink.record_path.empty()) {
+        std::cout << "📼 录制原始netlink流量: " << options_.netlink.record_path << "\n";
+    }
     std::cout << "🎯 监控开始 - 路由器: " << router_name_ << "\n";
     std::cout << "   收敛阈值: " << convergence_threshold_ms_ << "ms\n";
     std::cout << "   等待触发事件...\n";
@@ -173,42 +470,187 @@ void ConvergenceMonitor::stop_monitoring() {
         netlink_monitor_->stop_monitoring();
     }
     
-    // 停止收敛检查线程
-    if (convergence_checker_thread_.joinable()) {
-        convergence_cv_.notify_all();
-        convergence_checker_thread_.join();
+    // 打印统计信息（会话收尾时按本命名空间的接口缓存格式化）
+    {
+        InterfaceCache::Scope interface_scope(interfaces_.get());
+        print_statistics();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(session_mutex_);
+        publish_status();
+        status_page_.update([](StatusPage::Data& data) { data.state = StatusPage::STOPPED; });
+        status_page_.close();
     }
-    
-    // 打印统计信息
-    print_statistics();
     
     // 停止日志记录器
-    if (logger_) {
+    if (logger_ && owns_logger_) {
         logger_->stop();
     }
 }
 
-void ConvergenceMonitor::on_route_event(const void* route_data, const std::string& event_type) {
-    int64_t timestamp = get_current_timestamp_ms();
-    auto route_info = parse_route_info(route_data);
-    handle_route_event(timestamp, event_type, route_info);
+void ConvergenceMonitor::on_route_event(const RouteRecord& route) {
+    RouteRecord record = route;
+    record.timestamp = netlink_monitor_->current_receive_time_ns();
+    if (options_.fib_mirror) {
+        record.change = fib_.apply(record);
+    }
+    route_change_counts_[record.change]++;
+    handle_route_event(record);
+}
+
+void ConvergenceMonitor::on_qdisc_event(const QdiscRecord& qdisc) {
+    QdiscRecord record = qdisc;
+    record.timestamp = netlink_monitor_->current_receive_time_ns();
+    handle_qdisc_event(record);
+}
+
+void ConvergenceMonitor::on_link_event(const LinkRecord& link) {
+    LinkRecord record = link;
+    record.timestamp = netlink_monitor_->current_receive_time_ns();
+    handle_link_event(record);
+}
+
+void ConvergenceMonitor::on_nexthop_event(const NexthopRecord& nexthop) {
+    NexthopRecord record = nexthop;
+    record.timestamp = netlink_monitor_->current_receive_time_ns();
+    if (options_.fib_mirror) {
+        record.change = fib_.apply_nexthop(record);
+    }
+    total_nexthop_events_.fetch_add(1);
+    handle_nexthop_event(record);
+}
+
+void ConvergenceMonitor::open_status_page() {
+    if (options_.status_dir.empty()) {
+        return;
+    }
+    if (mkdir(options_.status_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("无法创建状态页目录 " + options_.status_dir + ": " + strerror(errno));
+    }
+    std::string path = options_.status_dir + "/" + router_name_ + ".status";
+    std::string error;
+    if (!status_page_.open(path, router_name_, monitor_id_, error)) {
+        throw std::runtime_error(error);
+    }
+    std::cout << console_tag_ << "📟 实时状态页: " << path << "\n";
 }
 
-void ConvergenceMonitor::on_qdisc_event(const void* qdisc_data, const std::string& event_type) {
-    auto qdisc_info = parse_qdisc_info(qdisc_data);
-    handle_qdisc_event(qdisc_info, event_type);
+void ConvergenceMonitor::publish_status() {
+    int32_t current_session = open_sessions_.empty() ? 0 : open_sessions_.back()->session_id;
+    uint32_t open_sessions = static_cast<uint32_t>(open_sessions_.size());
+    int64_t triggers = total_netem_triggers_.load() + total_route_triggers_.load() +
+                       total_link_triggers_.load() + total_nexthop_triggers_.load();
+    StatusPage::State state = state_.load() == MonitorState::MONITORING ? StatusPage::MONITORING
+                                                                        : StatusPage::IDLE;
+    status_page_.update([&](StatusPage::Data& data) {
+        data.state = state;
+        data.open_sessions = open_sessions;
+        data.current_session_id = current_session;
+        data.total_route_events = total_route_events_.load();
+        data.total_triggers = triggers;
+        data.completed_sessions = completed_session_count_;
+        data.overruns = total_overruns_.load();
+        data.lost_messages = total_lost_messages_.load();
+    });
+}
+
+void ConvergenceMonitor::publish_session_result(const ConvergenceSession& session) {
+    StatusPage::SessionResult result{};
+    result.session_id = session.session_id;
+    result.trigger_source = session.trigger.source;
+    result.converged = session.convergence_time.has_value();
+    result.lossy = session.lossy;
+    result.resynced = session.resynced;
+    result.route_events = session.get_route_event_count();
+    result.trigger_wall_ms = EventClock::to_wall_ms(session.netem_event_time);
+    result.convergence_us = session.convergence_time.has_value()
+                                ? session.convergence_time.value() / EventClock::NS_PER_US : -1;
+    status_page_.update([&](StatusPage::Data& data) {
+        data.results[data.result_count % StatusPage::RECENT_RESULTS] = result;
+        data.result_count++;
+        data.last_completed_session_id = session.session_id;
+    });
+}
+
+void ConvergenceMonitor::on_netlink_overrun(int64_t lost) {
+    total_overruns_.fetch_add(1);
+    total_lost_messages_.fetch_add(lost);
+
+    int64_t timestamp = now_ns();
+    std::lock_guard<std::mutex> lock(session_mutex_);
+    // 无法得知丢失的消息属于哪个会话，所有进行中的会话都标记为有损
+    for (const auto& session : open_sessions_) {
+        if (!session->is_converged.load()) {
+            session->mark_lossy(timestamp, lost);
+            std::cout << console_tag_ << "⚠️  会话 #" << session->session_id
+                      << " 标记为有损 (丢失 " << lost << " 条消息)\n";
+        }
+    }
+    publish_status();
+}
+
+void ConvergenceMonitor::on_route_dump_entry(const void* route_data) {
+    const struct nlmsghdr* nlh = static_cast<const struct nlmsghdr*>(route_data);
+    if (nlh->nlmsg_type == RTM_NEWNEXTHOP) {
+        NexthopRecord nexthop;
+        if (options_.fib_mirror && NetlinkMessageParser::parse_nexthop_message(nlh, nexthop)) {
+            fib_.sync_nexthop(nexthop);
+        }
+        return;
+    }
+
+    resync_route_count_++;
+    if (!options_.fib_mirror) {
+        return;
+    }
+    RouteRecord route;
+    if (NetlinkMessageParser::parse_route_message(nlh, route)) {
+        fib_.sync_entry(route);
+    }
+}
+
+void ConvergenceMonitor::on_route_dump_done(bool success) {
+    size_t stale = options_.fib_mirror ? fib_.end_sync(success) : 0;
+    if (fib_loading_) {
+        // 启动转储：此时监控线程尚未开始分发事件
+        fib_loading_ = false;
+        resync_route_count_ = 0;
+        std::cout << console_tag_ << "📚 FIB镜像: " << fib_.size() << " 条路由, "
+                  << fib_.nexthop_count() << " 个下一跳对象 (" << (fib_.memory_bytes() + 1023) / 1024 << " KB)\n";
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(session_mutex_);
+    for (const auto& session : open_sessions_) {
+        session->mark_resynced(success);
+    }
+
+    if (success) {
+        std::cout << console_tag_ << "🔄 RIB重新同步完成，转储路由: " << resync_route_count_;
+        if (stale > 0) {
+            std::cout << ", 镜像中移除已不存在的路由: " << stale;
+        }
+        std::cout << "\n";
+    } else {
+        std::cout << console_tag_ << "⚠️  RIB重新同步失败\n";
+    }
+    resync_route_count_ = 0;
 }
 
 void ConvergenceMonitor::cleanup_old_events() {
-    int64_t current_time = get_current_timestamp_ms();
-    int64_t cutoff_time = current_time - 300000; // 5分钟前
+    int64_t current_time = now_ns();
+    int64_t cutoff_time = current_time - 300 * EventClock::NS_PER_SEC; // 5分钟前
     
     std::lock_guard<std::mutex> lock(qdisc_events_mutex_);
     
-    // 清理过期的qdisc事件
-    while (!recent_qdisc_events_.empty() && 
-           recent_qdisc_events_.front().timestamp < cutoff_time) {
-        recent_qdisc_events_.pop();
+    // 清理过期的qdisc事件（从最旧的一条开始）
+    while (qdisc_events_count_ > 0) {
+        size_t oldest = (qdisc_events_head_ + MAX_QDISC_EVENTS - qdisc_events_count_) % MAX_QDISC_EVENTS;
+        if (recent_qdisc_events_[oldest].timestamp >= cutoff_time) {
+            break;
+        }
+        qdisc_events_count_--;
     }
 }
 
@@ -224,109 +666,104 @@ std::string ConvergenceMonitor::format_timestamp(int64_t timestamp_ms) const {
 }
 
 std::string ConvergenceMonitor::get_interface_name(int ifindex) const {
-    // 这里应该实现获取接口名称的逻辑
-    // 可以通过读取 /sys/class/net/ 或使用 if_indextoname
-    char ifname[IF_NAMESIZE];
-    if (if_indextoname(ifindex, ifname)) {
-        return std::string(ifname);
-    }
-    return "if" + std::to_string(ifindex);
+    // 由RTM_NEWLINK/RTM_DELLINK维护的接口缓存解析，不在热路径上发起系统调用
+    return EventFormat::interface_name(ifindex);
 }
 
-void ConvergenceMonitor::convergence_checker_loop() {
-    while (running_.load()) {
-        std::unique_lock<std::mutex> lock(convergence_mutex_);
-
-        // 等待1秒或直到被通知停止
-        if (convergence_cv_.wait_for(lock, std::chrono::milliseconds(500),
-                                   [this] { return !running_.load(); })) {
-            break;
-        }
+int64_t ConvergenceMonitor::completed_session_count() {
+    std::lock_guard<std::mutex> lock(session_mutex_);
+    return completed_session_count_;
+}
 
-        // 检查当前会话是否需要收敛检查
-        ConvergenceSession* session = nullptr;
-        {
-            std::lock_guard<std::mutex> session_lock(session_mutex_);
-            if (state_.load() == MonitorState::MONITORING &&
-                current_session_ &&
-                !current_session_->is_converged.load()) {
-                session = current_session_.get();
-            }
-        }
+void ConvergenceMonitor::report_pipeline_stats(bool print_console) {
+    PipelineStats::Report report;
+    netlink_monitor_->append_pipeline_stats(report);
+    report.add_stage(PipelineStats::PARSE, session_stages_.parse);
+    report.add_stage(PipelineStats::LOCK_WAIT, session_stages_.lock_wait);
+    report.add_stage(PipelineStats::SESSION, session_stages_.session);
+    logger_->append_pipeline_stats(report);
 
-        if (session) {
-            // 检查收敛（不需要持有session_mutex_）
-            if (session->check_convergence(convergence_threshold_ms_)) {
-                // 获取写锁来完成会话
-                std::lock_guard<std::mutex> write_lock(session_mutex_);
-                if (state_.load() == MonitorState::MONITORING &&
-                    current_session_.get() == session &&
-                    current_session_->is_converged.load()) {
-
-                    std::cout << "✅ 会话 #" << current_session_->session_id << " 收敛完成\n";
-                    finish_current_session();
-                }
-            }
-        }
+    size_t open_sessions;
+    {
+        std::lock_guard<std::mutex> lock(session_mutex_);
+        open_sessions = open_sessions_.size();
+    }
+    report.add_counter("route_events", total_route_events_.load());
+    report.add_counter("open_sessions", static_cast<int64_t>(open_sessions));
+
+    auto stats_log = LogJson::create_event_log("monitor_stats", router_name_, user_);
+    stats_log["monitor_id"] = monitor_id_;
+    stats_log["uptime_ms"] = (now_ns() - monitoring_start_time_) / EventClock::NS_PER_MS;
+    stats_log["stage_sample_interval"] = static_cast<int64_t>(PipelineStats::sample_interval());
+    report.append_to(stats_log);
+    logger_->log_async(stats_log);
+
+    if (print_console) {
+        std::cout << console_tag_ << "📟 流水线统计 (自启动以来, 每 " << PipelineStats::sample_interval()
+                  << " 条消息采样一次)\n";
+        report.print(std::cout, "   ");
     }
 }
 
-std::unordered_map<std::string, std::string> ConvergenceMonitor::parse_route_info(const void* route_data) const {
-    const struct nlmsghdr* nlh = static_cast<const struct nlmsghdr*>(route_data);
-    const struct rtmsg* rtm = static_cast<const struct rtmsg*>(NLMSG_DATA(nlh));
+void ConvergenceMonitor::on_convergence_timer() {
+    std::lock_guard<std::mutex> lock(session_mutex_);
+    if (state_.load() != MonitorState::MONITORING) {
+        return;
+    }
 
-    // 计算属性数据的起始位置和长度
-    int attrlen = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*rtm));
-    const struct rtattr* rta = reinterpret_cast<const struct rtattr*>(
-        reinterpret_cast<const char*>(rtm) + NLMSG_ALIGN(sizeof(*rtm)));
+    // 事件到达时不重设定时器：到期后逐个检查会话，其余会话按最早的截止时间重新设置
+    int64_t current_time = now_ns();
+    for (size_t i = 0; i < open_sessions_.size();) {
+        ConvergenceSession* session = open_sessions_[i].get();
+        if (session->check_convergence(threshold_ns(), current_time)) {
+            std::cout << console_tag_ << "✅ 会话 #" << session->session_id << " 收敛完成\n";
+            finish_session(i);
+        } else {
+            ++i;
+        }
+    }
 
-    // 使用NetlinkMessageParser解析消息
-    return NetlinkMessageParser::parse_route_message(rtm, rta, attrlen);
+    arm_next_deadline();
 }
 
-std::unordered_map<std::string, std::string> ConvergenceMonitor::parse_qdisc_info(const void* qdisc_data) const {
-    const struct nlmsghdr* nlh = static_cast<const struct nlmsghdr*>(qdisc_data);
-    const struct tcmsg* tcm = static_cast<const struct tcmsg*>(NLMSG_DATA(nlh));
-
-    // 计算属性数据的起始位置和长度
-    int attrlen = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*tcm));
-    const struct rtattr* rta = reinterpret_cast<const struct rtattr*>(
-        reinterpret_cast<const char*>(tcm) + NLMSG_ALIGN(sizeof(*tcm)));
+void ConvergenceMonitor::arm_next_deadline() {
+    if (open_sessions_.empty()) {
+        return;
+    }
+    int64_t deadline = open_sessions_.front()->quiet_deadline(threshold_ns());
+    for (const auto& session : open_sessions_) {
+        deadline = std::min(deadline, session->quiet_deadline(threshold_ns()));
+    }
+    netlink_monitor_->arm_deadline(deadline);
+}
 
-    // 使用NetlinkMessageParser解析消息
-    return NetlinkMessageParser::parse_qdisc_message(tcm, rta, attrlen);
+bool ConvergenceMonitor::can_start_session(const TriggerRecord& trigger) const {
+    if (open_sessions_.size() >= static_cast<size_t>(options_.max_sessions)) {
+        return false;
+    }
+    for (const auto& session : open_sessions_) {
+        if (same_trigger_key(session->trigger, trigger)) {
+            return false;
+        }
+    }
+    return true;
 }
 
-bool ConvergenceMonitor::is_netem_related_event(const std::unordered_map<std::string, std::string>& qdisc_info,
-                                               const std::string& event_type) const {
+bool ConvergenceMonitor::is_netem_related_event(const QdiscRecord& qdisc) const {
     // 检查是否为netem类型
-    auto it = qdisc_info.find("is_netem");
-    if (it != qdisc_info.end() && it->second == "true") {
+    if (qdisc.is_netem()) {
         return true;
     }
 
-    // 对于删除事件，检查最近的事件
-    if (event_type == "QDISC_DEL") {
-        auto iface_it = qdisc_info.find("interface");
-        if (iface_it != qdisc_info.end()) {
-            std::string interface_name = iface_it->second;
-
-            std::lock_guard<std::mutex> lock(qdisc_events_mutex_);
-
-            // 创建临时队列来遍历
-            std::queue<QdiscEvent> temp_queue = recent_qdisc_events_;
-            while (!temp_queue.empty()) {
-                const auto& event = temp_queue.front();
-                auto event_iface_it = event.info.find("interface");
-                if (event_iface_it != event.info.end() &&
-                    event_iface_it->second == interface_name) {
-                    auto event_netem_it = event.info.find("is_netem");
-                    if (event_netem_it != event.info.end() &&
-                        event_netem_it->second == "true") {
-                        return true;
-                    }
-                }
-                temp_queue.pop();
+    // 对于删除事件，检查同一接口最近的事件
+    if (qdisc.nlmsg_type == RTM_DELQDISC) {
+        std::lock_guard<std::mutex> lock(qdisc_events_mutex_);
+
+        for (size_t i = 0; i < qdisc_events_count_; ++i) {
+            size_t index = (qdisc_events_head_ + MAX_QDISC_EVENTS - 1 - i) % MAX_QDISC_EVENTS;
+            const QdiscRecord& event = recent_qdisc_events_[index];
+            if (event.ifindex == qdisc.ifindex && event.is_netem()) {
+                return true;
             }
         }
     }
@@ -334,299 +771,583 @@ bool ConvergenceMonitor::is_netem_related_event(const std::unordered_map<std::st
     return false;
 }
 
-void ConvergenceMonitor::handle_trigger_event(int64_t timestamp, const std::string& event_type,
-                                             const std::unordered_map<std::string, std::string>& trigger_info,
-                                             const std::string& trigger_source) {
-    std::lock_guard<std::mutex> lock(session_mutex_);
-
-    // 如果当前有会话在进行且未收敛，不强制终止
-    if (current_session_ && !current_session_->is_converged.load()) {
-        std::cout << "⚠️  忽略新" << event_type << "事件，会话 #"
-                  << current_session_->session_id << " 仍在进行中\n";
-        return;
+std::string ConvergenceMonitor::read_injection_id() const {
+    // 每个会话只读取一次（几微秒），注入脚本在注入前覆盖写入新编号
+    int fd = open(options_.injection_id_file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::string();
+    }
+    char buffer[128];
+    ssize_t len = read(fd, buffer, sizeof(buffer));
+    close(fd);
+    if (len <= 0) {
+        return std::string();
     }
+    std::string id(buffer, static_cast<size_t>(len));
+    id = id.substr(0, id.find('\n'));
+    size_t end = id.find_last_not_of(" \t\r");
+    size_t start = id.find_first_not_of(" \t\r");
+    return start == std::string::npos ? std::string() : id.substr(start, end - start + 1);
+}
 
-    // 开始新会话
+void ConvergenceMonitor::handle_trigger_event(int64_t timestamp, const TriggerRecord& trigger) {
+    // 开始新会话（调用者已通过 can_start_session 检查）
     int session_id = session_counter_.fetch_add(1) + 1;
-    current_session_ = std::make_unique<ConvergenceSession>(session_id, timestamp, trigger_info);
+    EventSlabPool* pool = options_.retain_events == EventRetention::NONE ? nullptr : &event_pool_;
+    open_sessions_.push_back(std::make_unique<ConvergenceSession>(session_id, timestamp, trigger, pool,
+                                                                  options_.prefix_report > 0));
+    if (options_.prefix_report > 0 && trigger.source == TriggerRecord::ROUTE) {
+        // 触发路由本身也是变化过的前缀
+        open_sessions_.back()->prefixes.update(trigger.event.route);
+    }
+    if (!options_.injection_id_file.empty()) {
+        open_sessions_.back()->injection_id = read_injection_id();
+    }
+    peak_open_sessions_ = std::max(peak_open_sessions_, open_sessions_.size());
     state_.store(MonitorState::MONITORING);
 
+    // 静默期截止时间定时器：已有会话的截止时间可能更早
+    arm_next_deadline();
+
     // 更新统计
-    if (trigger_source == "netem") {
+    if (trigger.source == TriggerRecord::NETEM) {
         total_netem_triggers_.fetch_add(1);
+    } else if (trigger.source == TriggerRecord::LINK) {
+        total_link_triggers_.fetch_add(1);
+    } else if (trigger.source == TriggerRecord::NEXTHOP) {
+        total_nexthop_triggers_.fetch_add(1);
     } else {
         total_route_triggers_.fetch_add(1);
     }
 
-    // 记录会话开始日志
-    std::string user = []() {
-        struct passwd* pw = getpwuid(getuid());
-        return pw ? std::string(pw->pw_name) : "unknown";
-    }();
+    // 记录会话开始日志（事件类型标签只在这里生成）
+    std::string event_type = EventFormat::trigger_event_type(trigger.event);
 
-    auto session_start_log = Logger::create_session_start_log(
-        router_name_, session_id, trigger_source, event_type, trigger_info, user);
+    auto session_start_log = LogJson::create_session_start_log(
+        router_name_, session_id, trigger.source_name(), event_type, trigger, user_);
+    session_start_log["concurrent_sessions"] = static_cast<int64_t>(open_sessions_.size());
+    if (!open_sessions_.back()->injection_id.empty()) {
+        session_start_log["injection_id"] = open_sessions_.back()->injection_id;
+    }
     logger_->log_async(session_start_log);
 
     // 控制台输出
-    if (trigger_source == "netem") {
-        std::cout << "🚀 开始会话 #" << session_id << " (Netem触发: " << event_type << ")\n";
-        auto iface_it = trigger_info.find("interface");
-        if (iface_it != trigger_info.end()) {
-            std::cout << "   接口: " << iface_it->second << "\n";
+    if (trigger.source == TriggerRecord::NETEM) {
+        std::cout << console_tag_ << "🚀 开始会话 #" << session_id << " (Netem触发: " << event_type << ")\n";
+        std::cout << "   接口: " << EventFormat::interface_name(trigger.event) << "\n";
+    } else if (trigger.source == TriggerRecord::LINK) {
+        std::cout << console_tag_ << "🚀 开始会话 #" << session_id << " (链路触发: " << event_type << ")\n";
+        std::cout << "   接口: " << EventFormat::interface_name(trigger.event) << "\n";
+    } else if (trigger.source == TriggerRecord::NEXTHOP) {
+        const NexthopRecord& nexthop = trigger.event.nexthop;
+        std::cout << console_tag_ << "🚀 开始会话 #" << session_id << " (下一跳触发: " << event_type << ")\n";
+        std::cout << "   下一跳对象: " << nexthop.id;
+        if (nexthop.has(NexthopRecord::IS_GROUP)) {
+            std::cout << " (组, " << nexthop.group_size << " 个成员)";
         }
+        std::cout << "\n";
     } else {
-        std::cout << "🚀 开始会话 #" << session_id << " (路由触发: " << event_type << ")\n";
-        auto dst_it = trigger_info.find("dst");
-        if (dst_it != trigger_info.end()) {
-            std::cout << "   目标: " << dst_it->second << "\n";
-        }
+        std::cout << console_tag_ << "🚀 开始会话 #" << session_id << " (路由触发: " << event_type << ")\n";
+        const RouteRecord& route = trigger.event.route;
+        std::cout << "   目标: "
+                  << (route.has(RouteRecord::HAS_DST) ? EventFormat::address(route.dst, route.family) : "default")
+                  << "\n";
     }
+    if (open_sessions_.size() > 1) {
+        std::cout << "   并发会话: " << open_sessions_.size() << "\n";
+    }
+    publish_status();
 }
 
-void ConvergenceMonitor::handle_qdisc_event(const std::unordered_map<std::string, std::string>& qdisc_info,
-                                           const std::string& event_type) {
-    int64_t current_time = get_current_timestamp_ms();
+void ConvergenceMonitor::handle_qdisc_event(const QdiscRecord& qdisc) {
+    int64_t current_time = qdisc.timestamp;
 
     // 缓存qdisc事件
     {
         std::lock_guard<std::mutex> lock(qdisc_events_mutex_);
-        recent_qdisc_events_.emplace(current_time, event_type, qdisc_info);
-        if (recent_qdisc_events_.size() > MAX_QDISC_EVENTS) {
-            recent_qdisc_events_.pop();
+        recent_qdisc_events_[qdisc_events_head_] = qdisc;
+        qdisc_events_head_ = (qdisc_events_head_ + 1) % MAX_QDISC_EVENTS;
+        if (qdisc_events_count_ < MAX_QDISC_EVENTS) {
+            qdisc_events_count_++;
         }
     }
 
     // 检查是否为netem相关事件
-    if (is_netem_related_event(qdisc_info, event_type)) {
+    if (is_netem_related_event(qdisc)) {
+        EventRecord record(qdisc);
+
         // 记录netem事件日志
-        std::string user = []() {
-            struct passwd* pw = getpwuid(getuid());
-            return pw ? std::string(pw->pw_name) : "unknown";
-        }();
-
-        auto netem_log = Logger::create_event_log("netem_detected", router_name_, user);
-        netem_log["netem_event_type"] = event_type;
-        netem_log["qdisc_info"] = ""; // 这里需要序列化qdisc_info
+        auto netem_log = LogJson::create_event_log("netem_detected", router_name_, user_);
+        netem_log["netem_event_type"] = EventFormat::trigger_event_type(record);
+        std::string qdisc_info;
+        EventFormat::append_event_info(qdisc_info, record);
+        netem_log["qdisc_info"] = qdisc_info;
         logger_->log_async(netem_log);
+        total_netem_detected_.fetch_add(1);
 
-        // 检查当前状态
-        MonitorState current_state;
-        bool is_monitoring;
-        ConvergenceSession* session = nullptr;
-        {
-            std::lock_guard<std::mutex> lock(session_mutex_);
-            current_state = state_.load();
-            is_monitoring = (current_state == MonitorState::MONITORING &&
-                           current_session_ &&
-                           !current_session_->is_converged.load());
-            if (is_monitoring) {
-                session = current_session_.get();
+        TriggerRecord trigger(TriggerRecord::NETEM, record);
+        SessionLock lock(session_mutex_, session_stages_, netlink_monitor_->current_message_start_ns());
+        if (can_start_session(trigger)) {
+            // 新接口上的netem变化开始新会话（可与其他接口的会话并存）
+            handle_trigger_event(current_time, trigger);
+        } else {
+            // 同一接口已有会话或达到并发上限：作为会话内事件处理
+            if (open_sessions_.size() >= static_cast<size_t>(options_.max_sessions) &&
+                options_.max_sessions > 1) {
+                std::cout << console_tag_ << "⚠️  并发会话已达上限 (" << options_.max_sessions << ")，"
+                          << EventFormat::trigger_event_type(record) << "计为会话内事件\n";
             }
+            attribute_event(current_time, record);
         }
+    }
+}
 
-        if (is_monitoring) {
-            // 当前有活跃会话，将netem事件作为普通路由事件处理
-            session->add_route_event(current_time, "Netem事件(" + event_type + ")", qdisc_info);
-
-            int64_t total_events = total_route_events_.fetch_add(1) + 1;
-            int64_t offset = current_time - session->netem_event_time;
-            int session_event_count = session->get_route_event_count();
+void ConvergenceMonitor::handle_link_event(const LinkRecord& link) {
+    int64_t timestamp = link.timestamp;
+    EventRecord record(link);
+    TriggerRecord trigger(TriggerRecord::LINK, record);
+    SessionLock lock(session_mutex_, session_stages_, netlink_monitor_->current_message_start_ns());
 
-            // 记录路由事件日志
-            auto route_log = Logger::create_route_event_log(
-                router_name_, session->session_id, "Netem事件(" + event_type + ")",
-                total_events, session_event_count, offset, qdisc_info, user);
-            logger_->log_async(route_log);
-        } else {
-            // 没有活跃会话，作为触发事件处理
-            handle_trigger_event(current_time, event_type, qdisc_info, "netem");
-        }
+    // 链路变化作为触发事件，与netem、路由触发并列
+    if (options_.link_triggers && can_start_session(trigger)) {
+        handle_trigger_event(timestamp, trigger);
+        return;
     }
+
+    // 会话进行中：记录为会话内事件
+    attribute_event(timestamp, record);
 }
 
-void ConvergenceMonitor::handle_route_event(int64_t timestamp, const std::string& event_type,
-                                           const std::unordered_map<std::string, std::string>& route_info) {
-    // 检查是否应该作为触发事件
-    MonitorState current_state;
-    {
-        std::lock_guard<std::mutex> lock(session_mutex_);
-        current_state = state_.load();
+void ConvergenceMonitor::handle_route_event(const RouteRecord& route) {
+    int64_t timestamp = route.timestamp;
+    EventRecord record(route);
+    bool ignored = is_ignored_noop(record);
+
+    SessionLock lock(session_mutex_, session_stages_, netlink_monitor_->current_message_start_ns());
+
+    // 路由变化只在空闲时作为触发事件：会话进行中的路由变化通常是收敛过程本身，
+    // 若逐条开始新会话，一次路由风暴就会占满并发上限。重复通知不是路由变化，不触发会话
+    if (open_sessions_.empty() && !ignored) {
+        handle_trigger_event(timestamp, TriggerRecord(TriggerRecord::ROUTE, record));
+        return;
     }
 
-    if ((event_type == "路由添加" || event_type == "路由删除") &&
-        current_state == MonitorState::IDLE) {
-        // 作为触发事件处理
-        std::string trigger_type = (event_type == "路由添加") ? "route_add" : "route_del";
+    // 添加路由事件到会话中（不在监控状态时忽略）
+    attribute_event(timestamp, record);
+}
 
-        std::unordered_map<std::string, std::string> trigger_info;
-        trigger_info["type"] = trigger_type;
+void ConvergenceMonitor::handle_nexthop_event(const NexthopRecord& nexthop) {
+    EventRecord record(nexthop);
+    TriggerRecord trigger(TriggerRecord::NEXTHOP, record);
 
-        auto dst_it = route_info.find("dst");
-        trigger_info["dst"] = (dst_it != route_info.end()) ? dst_it->second : "N/A";
+    SessionLock lock(session_mutex_, session_stages_, netlink_monitor_->current_message_start_ns());
 
-        auto iface_it = route_info.find("interface");
-        trigger_info["interface"] = (iface_it != route_info.end()) ? iface_it->second : "N/A";
+    // 与路由变化相同：只在空闲时触发。一个组的更新替代了引用它的所有路由的逐条通知
+    if (open_sessions_.empty() && !is_ignored_noop(record) && can_start_session(trigger)) {
+        handle_trigger_event(nexthop.timestamp, trigger);
+        return;
+    }
 
-        auto gw_it = route_info.find("gateway");
-        trigger_info["gateway"] = (gw_it != route_info.end()) ? gw_it->second : "N/A";
+    attribute_event(nexthop.timestamp, record);
+}
 
-        handle_trigger_event(timestamp, event_type, trigger_info, "route");
+bool ConvergenceMonitor::is_ignored_noop(const EventRecord& record) const {
+    if (!options_.ignore_noop_routes) {
+        return false;
+    }
+    if (record.cls == EventRecord::ROUTE) {
+        return record.route.change == RouteRecord::CHANGE_NOOP;
+    }
+    if (record.cls == EventRecord::NEXTHOP) {
+        return record.nexthop.change == RouteRecord::CHANGE_NOOP;
+    }
+    return false;
+}
+
+void ConvergenceMonitor::select_sessions(const EventRecord& record,
+                                         std::vector<ConvergenceSession*>& targets) const {
+    targets.clear();
+    if (open_sessions_.empty()) {
         return;
     }
 
-    // 普通路由事件处理
-    ConvergenceSession* session = nullptr;
-    {
-        std::lock_guard<std::mutex> lock(session_mutex_);
-        if (current_state != MonitorState::MONITORING || !current_session_) {
-            return; // 不在监控状态，忽略路由事件
+    switch (options_.attribution) {
+        case SessionAttribution::ALL_OPEN:
+            for (const auto& session : open_sessions_) {
+                targets.push_back(session.get());
+            }
+            return;
+
+        case SessionAttribution::LATEST:
+            break;
+
+        case SessionAttribution::NEAREST_PREFIX: {
+            // 路由事件：与路由触发前缀重叠且匹配最长的会话
+            ConvergenceSession* best = nullptr;
+            int best_length = -1;
+            if (record.cls == EventRecord::ROUTE) {
+                for (const auto& session : open_sessions_) {
+                    if (session->trigger.source != TriggerRecord::ROUTE) {
+                        continue;
+                    }
+                    int length = prefix_overlap(session->trigger.event.route, record.route);
+                    if (length > best_length) {
+                        best_length = length;
+                        best = session.get();
+                    }
+                }
+            }
+            // 其次：触发接口与事件接口相同的会话（取最近开始的）
+            if (!best && record.ifindex() > 0) {
+                for (auto it = open_sessions_.rbegin(); it != open_sessions_.rend(); ++it) {
+                    if ((*it)->trigger.event.ifindex() == record.ifindex()) {
+                        best = it->get();
+                        break;
+                    }
+                }
+            }
+            if (best) {
+                targets.push_back(best);
+                return;
+            }
+            break;
         }
-        session = current_session_.get();
     }
 
-    // 添加路由事件到会话中
-    session->add_route_event(timestamp, event_type, route_info);
+    targets.push_back(open_sessions_.back().get());
+}
 
-    // 更新统计信息
-    int64_t total_events = total_route_events_.fetch_add(1) + 1;
-    int64_t offset = timestamp - session->netem_event_time;
-    int session_event_count = session->get_route_event_count();
+void ConvergenceMonitor::attribute_event(int64_t timestamp, const EventRecord& record) {
+    session_targets_.clear();
+    select_sessions(record, session_targets_);
+    if (session_targets_.empty()) {
+        return;
+    }
 
-    // 记录路由事件日志
-    std::string user = []() {
-        struct passwd* pw = getpwuid(getuid());
-        return pw ? std::string(pw->pw_name) : "unknown";
-    }();
+    // 全局事件编号每个事件只分配一次，计入多个会话时共用
+    int64_t total_events = total_route_events_.fetch_add(1) + 1;
+    for (ConvergenceSession* session : session_targets_) {
+        record_session_event(session, timestamp, record, total_events);
+    }
 
-    auto route_log = Logger::create_route_event_log(
-        router_name_, session->session_id, event_type,
-        total_events, session_event_count, offset, route_info, user);
-    logger_->log_async(route_log);
+    if (status_page_.is_open()) {
+        int64_t wall_ms = EventClock::to_wall_ms(timestamp);
+        status_page_.update([&](StatusPage::Data& data) {
+            data.last_event_wall_ms = wall_ms;
+            data.total_route_events = total_events;
+        });
+    }
 }
 
-void ConvergenceMonitor::finish_current_session() {
-    if (!current_session_) {
-        return;
+uint32_t ConvergenceMonitor::intern_interface(const EventRecord& record) {
+    int32_t ifindex = record.ifindex();
+    if (ifindex <= 0) {
+        return 0;
     }
 
-    auto session = std::move(current_session_);
-    completed_sessions_.push_back(std::move(session));
+    auto it = interface_ids_.find(ifindex);
+    if (it != interface_ids_.end()) {
+        return it->second;
+    }
 
-    // 记录会话完成日志
-    std::string user = []() {
-        struct passwd* pw = getpwuid(getuid());
-        return pw ? std::string(pw->pw_name) : "unknown";
-    }();
+    // 编号从1开始，0表示无接口
+    interface_names_.push_back(EventFormat::interface_name(record));
+    uint32_t id = static_cast<uint32_t>(interface_names_.size());
+    interface_ids_.emplace(ifindex, id);
+    return id;
+}
+
+void ConvergenceMonitor::record_session_event(ConvergenceSession* session, int64_t timestamp,
+                                              const EventRecord& record, int64_t total_events) {
+    uint32_t interface_id = options_.retain_events == EventRetention::NONE ? 0 : intern_interface(record);
+    int session_event_count = session->add_route_event(timestamp, record, interface_id, !is_ignored_noop(record));
 
-    auto completed_session = completed_sessions_.back().get();
-    auto session_log = Logger::create_session_completed_log(
+    int64_t offset = timestamp - session->netem_event_time;
+
+    // 记录路由事件日志（定长结构入队，JSON在日志线程中生成）
+    logger_->log_route_event(RouteEventLog{
+        log_source_id_, session->session_id, total_events,
+        session_event_count, offset, record});
+}
+
+void ConvergenceMonitor::finish_session(size_t index) {
+    std::unique_ptr<ConvergenceSession> session = std::move(open_sessions_[index]);
+    open_sessions_.erase(open_sessions_.begin() + static_cast<std::ptrdiff_t>(index));
+    completed_session_count_++;
+
+    // 记录会话完成日志
+    ConvergenceSession* completed_session = session.get();
+    std::optional<int64_t> convergence_time_ms;
+    if (completed_session->convergence_time.has_value()) {
+        convergence_time_ms = completed_session->convergence_time.value() / EventClock::NS_PER_MS;
+    }
+    int64_t session_duration_ns = completed_session->get_session_duration();
+    auto session_log = LogJson::create_session_completed_log(
         router_name_, completed_session->session_id,
-        completed_session->convergence_time,
+        convergence_time_ms,
         completed_session->get_route_event_count(),
-        completed_session->get_session_duration(),
+        session_duration_ns / EventClock::NS_PER_MS,
         convergence_threshold_ms_,
-        completed_session->netem_info,
-        user);
+        completed_session->trigger,
+        user_);
+    if (completed_session->convergence_time.has_value()) {
+        session_log["convergence_time_us"] = completed_session->convergence_time.value() / EventClock::NS_PER_US;
+    }
+    session_log["session_duration_us"] = session_duration_ns / EventClock::NS_PER_US;
+    session_log["lossy"] = completed_session->lossy;
+    session_log["lost_messages"] = completed_session->lost_messages;
+    session_log["resynced"] = completed_session->resynced;
+    // 触发时刻：单调时钟原值与换算后的墙上时间，converge_aggregate --correlate 据此对齐各路由器
+    session_log["trigger_mono_ns"] = completed_session->netem_event_time;
+    session_log["trigger_wall_us"] = EventClock::to_wall_us(completed_session->netem_event_time);
+    if (!completed_session->injection_id.empty()) {
+        session_log["injection_id"] = completed_session->injection_id;
+    }
+    if (options_.fib_mirror) {
+        session_log["noop_route_events"] = static_cast<int64_t>(completed_session->get_noop_route_count());
+    }
+    append_prefix_summary(session_log, *completed_session);
     logger_->log_async(session_log);
 
+    // 增量更新统计直方图
+    if (completed_session->convergence_time.has_value()) {
+        int64_t convergence_us = completed_session->convergence_time.value() / EventClock::NS_PER_US;
+        convergence_time_hist_.record(convergence_us);
+        if (convergence_us < 100 * 1000) {
+            fast_convergence_count_++;
+        } else if (convergence_us < 1000 * 1000) {
+            medium_convergence_count_++;
+        } else {
+            slow_convergence_count_++;
+        }
+    }
+    session_duration_hist_.record(session_duration_ns / EventClock::NS_PER_US);
+    route_count_hist_.record(completed_session->get_route_event_count());
+    if (completed_session->lossy) {
+        lossy_sessions_++;
+    }
+
     // 控制台输出
     if (completed_session->convergence_time.has_value()) {
-        std::cout << "   收敛时间: " << completed_session->convergence_time.value()
-                  << "ms, 路由事件: " << completed_session->get_route_event_count() << "\n";
+        std::cout << "   收敛时间: " << format_duration_ms(completed_session->convergence_time.value())
+                  << "ms, 路由事件: " << completed_session->get_route_event_count();
+        if (completed_session->lossy) {
+            std::cout << " (有损: 丢失 " << completed_session->lost_messages << " 条消息"
+                      << (completed_session->resynced ? ", 已重新同步" : "") << ")";
+        }
+        std::cout << "\n";
     } else {
         std::cout << "   路由事件: " << completed_session->get_route_event_count() << "\n";
     }
 
-    // 重置状态
-    current_session_.reset();
-    state_.store(MonitorState::IDLE);
+    if (options_.prefix_report > 0 && !completed_session->prefixes.empty()) {
+        std::vector<const PrefixState*> slowest;
+        completed_session->prefixes.slowest(1, slowest);
+        std::cout << "   前缀: " << completed_session->prefixes.size() << " 个变化, 最慢 "
+                  << PrefixTable::prefix_string(slowest.front()->key) << " ("
+                  << format_duration_ms(slowest.front()->last_change - completed_session->netem_event_time)
+                  << "ms)\n";
+    }
+
+    publish_session_result(*completed_session);
+
+    // 按保留策略处理已完成会话：事件存储整块归还内存池
+    if (options_.retain_events != EventRetention::NONE) {
+        SessionSummary summary;
+        summary.session_id = completed_session->session_id;
+        summary.trigger_source = completed_session->trigger.source;
+        summary.trigger_time = completed_session->netem_event_time;
+        summary.first_event_time = completed_session->first_route_event_time.value_or(0);
+        summary.last_event_time = completed_session->last_route_event_time.value_or(0);
+        summary.route_event_count = completed_session->get_route_event_count();
+        summary.convergence_time = completed_session->convergence_time;
+        summary.session_duration = session_duration_ns;
+        summary.lossy = completed_session->lossy;
+        summary.lost_messages = completed_session->lost_messages;
+        summary.resynced = completed_session->resynced;
+        summary.interface_ids = completed_session->interface_ids;
+        session_summaries_.push_back(std::move(summary));
+    }
+    if (options_.retain_events == EventRetention::FULL) {
+        completed_sessions_.push_back(std::move(session));
+    } else {
+        session.reset();
+    }
+
+    // 所有会话结束后回到空闲状态
+    if (open_sessions_.empty()) {
+        state_.store(MonitorState::IDLE);
+    }
+    publish_status();
+}
+
+void ConvergenceMonitor::append_prefix_summary(JsonObject& log, const ConvergenceSession& session) const {
+    const PrefixTable& prefixes = session.prefixes;
+    if (options_.prefix_report <= 0 || prefixes.empty()) {
+        return;
+    }
+
+    // 前缀稳定时间：最后一次变化相对触发时刻（微秒）
+    HdrHistogram settle_hist(HISTOGRAM_MAX_US, HISTOGRAM_DIGITS);
+    int64_t flapped = 0;
+    int64_t withdrawn = 0;
+    uint32_t max_changes = 0;
+    for (const auto& entry : prefixes.entries()) {
+        settle_hist.record((entry.last_change - session.netem_event_time) / EventClock::NS_PER_US);
+        if (entry.change_count > 1) {
+            flapped++;
+        }
+        if (entry.withdrawn) {
+            withdrawn++;
+        }
+        max_changes = std::max(max_changes, entry.change_count);
+    }
+
+    log["prefixes_changed"] = static_cast<int64_t>(prefixes.size());
+    log["prefixes_flapped"] = flapped;
+    log["prefixes_withdrawn"] = withdrawn;
+    log["prefix_changes_max"] = static_cast<int64_t>(max_changes);
+    append_percentiles(log, "prefix_settle", "_ms", settle_hist, 1000.0);
+    log["prefix_settle_us_histogram"] = settle_hist.serialize();
+
+    // 最慢的N个前缀，与trigger_info一样以JSON文本保存
+    std::vector<const PrefixState*> slowest;
+    prefixes.slowest(static_cast<size_t>(options_.prefix_report), slowest);
+    std::string slowest_info = "[";
+    for (size_t i = 0; i < slowest.size(); ++i) {
+        const PrefixState& entry = *slowest[i];
+        if (i > 0) {
+            slowest_info += ',';
+        }
+        slowest_info += "{\"prefix\":\"" + PrefixTable::prefix_string(entry.key) + "\"";
+        slowest_info += ",\"settle_ms\":\"" + format_duration_ms(entry.last_change - session.netem_event_time) + "\"";
+        slowest_info += ",\"changes\":\"" + std::to_string(entry.change_count) + "\"";
+        slowest_info += ",\"withdrawn\":\"" + std::string(entry.withdrawn ? "true" : "false") + "\"";
+        slowest_info += ",\"gateway\":\"" +
+                        (entry.has_gateway ? EventFormat::address(entry.gateway, entry.key.family) : "direct") + "\"";
+        slowest_info += ",\"interface\":\"" +
+                        (entry.oif > 0 ? EventFormat::interface_name(entry.oif) : "N/A") + "\"}";
+    }
+    slowest_info += "]";
+    log["slowest_prefixes"] = slowest_info;
 }
 
 void ConvergenceMonitor::force_finish_session(const std::string& reason) {
     std::lock_guard<std::mutex> lock(session_mutex_);
-    if (current_session_) {
-        current_session_->check_convergence(0); // 强制收敛
-        std::cout << "📋 强制结束会话 #" << current_session_->session_id
+    while (!open_sessions_.empty()) {
+        ConvergenceSession* session = open_sessions_.front().get();
+        session->check_convergence(0, now_ns()); // 强制收敛
+        std::cout << console_tag_ << "📋 强制结束会话 #" << session->session_id
                   << ": " << reason << "\n";
-        finish_current_session();
+        finish_session(0);
     }
 }
 
+std::string ConvergenceMonitor::format_duration_ms(int64_t duration_ns) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.3f", static_cast<double>(duration_ns) / EventClock::NS_PER_MS);
+    return std::string(buffer);
+}
+
 void ConvergenceMonitor::print_statistics() {
-    // 强制结束当前会话
+    // 强制结束进行中的会话（force_finish_session内部加锁）
+    bool has_active_session = false;
     {
         std::lock_guard<std::mutex> lock(session_mutex_);
-        if (current_session_ && !current_session_->is_converged.load()) {
-            force_finish_session("监听结束");
-        }
+        has_active_session = !open_sessions_.empty();
     }
+    if (has_active_session) {
+        force_finish_session("监听结束");
+    }
+
+    // 最后一条流水线统计，与监控完成记录相邻
+    report_pipeline_stats(false);
 
-    int64_t current_time = get_current_timestamp_ms();
-    int64_t total_time = current_time - monitoring_start_time_;
+    int64_t current_time = now_ns();
+    int64_t total_time = (current_time - monitoring_start_time_) / EventClock::NS_PER_MS;
 
     // 读取统计计数器
     int64_t total_route_events = total_route_events_.load();
     int64_t total_netem_triggers = total_netem_triggers_.load();
     int64_t total_route_triggers = total_route_triggers_.load();
+    int64_t total_link_triggers = total_link_triggers_.load();
+    int64_t total_nexthop_triggers = total_nexthop_triggers_.load();
 
-    // 计算统计数据
-    std::vector<int64_t> convergence_times;
-    std::vector<int> route_counts;
-    std::vector<int64_t> session_durations;
-    std::unordered_set<std::string> interface_set;
-
-    for (const auto& session : completed_sessions_) {
-        if (session->convergence_time.has_value()) {
-            convergence_times.push_back(session->convergence_time.value());
-        }
-        route_counts.push_back(session->get_route_event_count());
-        session_durations.push_back(session->get_session_duration());
+    // 记录最终统计日志
+    int64_t total_triggers = total_netem_triggers + total_route_triggers + total_link_triggers + total_nexthop_triggers;
+    auto final_log = LogJson::create_monitoring_completed_log(
+        router_name_, log_file_path_, user_, total_time, convergence_threshold_ms_,
+        total_triggers, total_netem_triggers, total_route_triggers,
+        total_route_events, static_cast<int>(completed_session_count_), monitor_id_);
+
+    final_log["link_triggers_count"] = total_link_triggers;
+    final_log["nexthop_triggers_count"] = total_nexthop_triggers;
+    final_log["nexthop_events_count"] = total_nexthop_events_.load();
+    final_log["netlink_overruns"] = total_overruns_.load();
+    final_log["lost_messages"] = total_lost_messages_.load();
+    final_log["log_dropped_records"] = logger_->get_dropped_count();
+
+    final_log["lossy_sessions_count"] = lossy_sessions_;
+    final_log["netem_detected_count"] = total_netem_detected_.load();
+    final_log["retain_events"] = MonitorOptions::retention_name(options_.retain_events);
+    final_log["max_sessions"] = static_cast<int64_t>(options_.max_sessions);
+    final_log["session_attribution"] = MonitorOptions::attribution_name(options_.attribution);
+    final_log["peak_concurrent_sessions"] = static_cast<int64_t>(peak_open_sessions_);
+    final_log["prefix_report"] = static_cast<int64_t>(options_.prefix_report);
+    final_log["fib_mirror"] = options_.fib_mirror;
+    final_log["ignore_noop_routes"] = options_.ignore_noop_routes;
+    if (options_.fib_mirror) {
+        final_log["fib_mirror_routes"] = static_cast<int64_t>(fib_.size());
+        final_log["route_changes_new"] = route_change_counts_[RouteRecord::CHANGE_NEW];
+        final_log["route_changes_changed"] = route_change_counts_[RouteRecord::CHANGE_MODIFIED];
+        final_log["route_changes_noop"] = route_change_counts_[RouteRecord::CHANGE_NOOP];
+        final_log["route_changes_removed"] = route_change_counts_[RouteRecord::CHANGE_REMOVED];
+    }
 
-        // 收集接口信息
-        auto iface_it = session->netem_info.find("interface");
-        if (iface_it != session->netem_info.end()) {
-            interface_set.insert(iface_it->second);
+    // 涉及的接口：由会话汇总中的接口编号合并（--retain-events=none 时不统计）
+    std::string interfaces_involved;
+    size_t interfaces_count = 0;
+    if (options_.retain_events != EventRetention::NONE) {
+        std::vector<bool> seen(interface_names_.size() + 1, false);
+        for (const auto& summary : session_summaries_) {
+            for (uint32_t id : summary.interface_ids) {
+                seen[id] = true;
+            }
         }
-
-        for (const auto& route_event : session->route_events) {
-            auto route_iface_it = route_event.info.find("interface");
-            if (route_iface_it != route_event.info.end()) {
-                interface_set.insert(route_iface_it->second);
+        for (uint32_t id = 1; id < seen.size(); ++id) {
+            if (!seen[id]) {
+                continue;
+            }
+            if (!interfaces_involved.empty()) {
+                interfaces_involved += ',';
             }
+            interfaces_involved += interface_names_[id - 1];
+            interfaces_count++;
         }
+        final_log["interfaces_involved"] = interfaces_involved;
+        final_log["interfaces_count"] = static_cast<int64_t>(interfaces_count);
     }
 
-    // 收敛时间分布
-    int fast_convergence = 0, medium_convergence = 0, slow_convergence = 0;
-    for (int64_t t : convergence_times) {
-        if (t < 100) fast_convergence++;
-        else if (t < 1000) medium_convergence++;
-        else slow_convergence++;
-    }
-
-    // 记录最终统计日志
-    std::string user = []() {
-        struct passwd* pw = getpwuid(getuid());
-        return pw ? std::string(pw->pw_name) : "unknown";
-    }();
-
-    int64_t total_triggers = total_netem_triggers + total_route_triggers;
-    auto final_log = Logger::create_monitoring_completed_log(
-        router_name_, log_file_path_, user, total_time, convergence_threshold_ms_,
-        total_triggers, total_netem_triggers, total_route_triggers,
-        total_route_events, completed_sessions_.size(), monitor_id_);
-
     // 添加详细统计信息
-    if (!convergence_times.empty()) {
-        std::sort(convergence_times.begin(), convergence_times.end());
-        final_log["fastest_convergence_ms"] = convergence_times.front();
-        final_log["slowest_convergence_ms"] = convergence_times.back();
-
-        double sum = std::accumulate(convergence_times.begin(), convergence_times.end(), 0.0);
-        final_log["avg_convergence_time_ms"] = sum / convergence_times.size();
+    if (convergence_time_hist_.total_count() > 0) {
+        final_log["fastest_convergence_ms"] = convergence_time_hist_.min() / 1000;
+        final_log["slowest_convergence_ms"] = convergence_time_hist_.max() / 1000;
+        final_log["avg_convergence_time_ms"] = convergence_time_hist_.mean() / 1000.0;
+        // 离线由直方图计算百分位时把区间上界截断到这两个值
+        final_log["convergence_min_us"] = convergence_time_hist_.min();
+        final_log["convergence_max_us"] = convergence_time_hist_.max();
     }
 
+    // 百分位摘要与序列化直方图（离线按区间下界相加即可合并多台路由器）
+    final_log["histogram_significant_digits"] = static_cast<int64_t>(HISTOGRAM_DIGITS);
+    final_log["convergence_samples"] = convergence_time_hist_.total_count();
+    append_percentiles(final_log, "convergence", "_ms", convergence_time_hist_, 1000.0);
+    append_percentiles(final_log, "session_duration", "_ms", session_duration_hist_, 1000.0);
+    append_percentiles(final_log, "route_events_per_session", "", route_count_hist_, 1.0);
+    final_log["convergence_time_us_histogram"] = convergence_time_hist_.serialize();
+    final_log["session_duration_us_histogram"] = session_duration_hist_.serialize();
+    final_log["route_events_per_session_histogram"] = route_count_hist_.serialize();
+
     logger_->log_sync(final_log);
 
     // 控制台输出统计摘要
@@ -635,16 +1356,52 @@ void ConvergenceMonitor::print_statistics() {
     std::cout << "   监听时长: " << (total_time / 1000.0) << "秒\n";
     std::cout << "   触发事件: " << total_triggers
               << ", 路由事件: " << total_route_events
-              << ", 完成会话: " << completed_sessions_.size() << "\n";
-
-    if (!convergence_times.empty()) {
-        double avg = std::accumulate(convergence_times.begin(), convergence_times.end(), 0.0) / convergence_times.size();
-        std::cout << "   收敛时间: 最快=" << convergence_times.front()
-                  << "ms, 最慢=" << convergence_times.back()
-                  << "ms, 平均=" << std::fixed << std::setprecision(1) << avg << "ms\n";
-        std::cout << "   分布: 快速(<100ms)=" << fast_convergence
-                  << ", 中等(100-1000ms)=" << medium_convergence
-                  << ", 慢速(>1000ms)=" << slow_convergence << "\n";
+              << ", 完成会话: " << completed_session_count_ << "\n";
+
+    if (options_.max_sessions > 1) {
+        std::cout << "   并发会话: 峰值 " << peak_open_sessions_ << " / 上限 " << options_.max_sessions
+                  << " (归属: " << MonitorOptions::attribution_name(options_.attribution) << ")\n";
+    }
+
+    if (total_nexthop_events_.load() > 0) {
+        std::cout << "   下一跳对象事件: " << total_nexthop_events_.load()
+                  << " (触发会话 " << total_nexthop_triggers << ")\n";
+    }
+
+    if (options_.fib_mirror) {
+        std::cout << "   路由通知: 新增 " << route_change_counts_[RouteRecord::CHANGE_NEW]
+                  << ", 变更 " << route_change_counts_[RouteRecord::CHANGE_MODIFIED]
+                  << ", 重复 " << route_change_counts_[RouteRecord::CHANGE_NOOP]
+                  << (options_.ignore_noop_routes ? " (已忽略)" : "")
+                  << ", 删除 " << route_change_counts_[RouteRecord::CHANGE_REMOVED] << "\n";
+    }
+
+    if (interfaces_count > 0) {
+        std::cout << "   涉及接口: " << interfaces_count << " (" << interfaces_involved << ")\n";
+    }
+
+    if (convergence_time_hist_.total_count() > 0) {
+        const HdrHistogram& hist = convergence_time_hist_;
+        std::cout << "   收敛时间: 最快=" << format_duration_ms(hist.min() * EventClock::NS_PER_US)
+                  << "ms, 最慢=" << format_duration_ms(hist.max() * EventClock::NS_PER_US)
+                  << "ms, 平均=" << format_duration_ms(static_cast<int64_t>(hist.mean() * EventClock::NS_PER_US)) << "ms\n";
+        std::cout << "   百分位: P50=" << format_duration_ms(hist.value_at_percentile(50.0) * EventClock::NS_PER_US)
+                  << "ms, P95=" << format_duration_ms(hist.value_at_percentile(95.0) * EventClock::NS_PER_US)
+                  << "ms, P99=" << format_duration_ms(hist.value_at_percentile(99.0) * EventClock::NS_PER_US)
+                  << "ms, P99.9=" << format_duration_ms(hist.value_at_percentile(99.9) * EventClock::NS_PER_US) << "ms\n";
+        std::cout << "   分布: 快速(<100ms)=" << fast_convergence_count_
+                  << ", 中等(100-1000ms)=" << medium_convergence_count_
+                  << ", 慢速(>1000ms)=" << slow_convergence_count_ << "\n";
+    }
+
+    if (logger_->get_dropped_count() > 0) {
+        std::cout << "   日志队列溢出: 丢弃 " << logger_->get_dropped_count() << " 条记录 (策略: "
+                  << LoggerOptions::overflow_policy_name(logger_->get_options().overflow_policy) << ")\n";
+    }
+
+    if (total_overruns_.load() > 0) {
+        std::cout << "   接收溢出: " << total_overruns_.load()
+                  << " 次, 丢失消息: " << total_lost_messages_.load() << "\n";
     }
 
     std::cout << "   JSON日志已保存到: " << log_file_path_ << "\n";
@@ -13,6 +13,7 @@
 #include <unordered_set>
 #include <functional>
 #include <net/if.h>
+#include <array>
 
 // C++17兼容性检查
 #if __cplusplus >= 201703L
@@ -61,33 +62,24 @@
 
 #include "logger.h"
 #include "netlink_monitor.h"
+#include "histogram.h"
+#include "event_arena.h"
+#include "prefix_table.h"
+#include "fib_mirror.h"
+#include "status_page.h"
 
 // 前向声明
 class NetlinkMonitor;
 class Logger;
 
-// 路由事件结构
+// 路由事件结构（定长，不持有堆内存）；时间均为单调时钟纳秒
 struct RouteEvent {
     int64_t timestamp;
-    std::string type;
-    std::unordered_map<std::string, std::string> info;
     int64_t offset_from_netem;
+    EventRecord record;
     
-    RouteEvent(int64_t ts, const std::string& t, 
-               const std::unordered_map<std::string, std::string>& i, 
-               int64_t offset)
-        : timestamp(ts), type(t), info(i), offset_from_netem(offset) {}
-};
-
-// QDisc事件结构
-struct QdiscEvent {
-    int64_t timestamp;
-    std::string type;
-    std::unordered_map<std::string, std::string> info;
-    
-    QdiscEvent(int64_t ts, const std::string& t, 
-               const std::unordered_map<std::string, std::string>& i)
-        : timestamp(ts), type(t), info(i) {}
+    RouteEvent(int64_t ts, const EventRecord& r, int64_t offset)
+        : timestamp(ts), offset_from_netem(offset), record(r) {}
 };
 
 // 收敛会话类
@@ -97,26 +89,130 @@ private:
     std::atomic<int> convergence_check_count_{0};
 
 public:
+    // 以下时间均为单调时钟纳秒（EventClock），只在日志输出时换算为墙上时间
     int session_id;
     int64_t netem_event_time;
-    std::unordered_map<std::string, std::string> netem_info;
-    std::vector<RouteEvent> route_events;
+    TriggerRecord trigger;
+    // 会话内事件：存放在池分配的内存块中，会话结束后整体释放（streaming模式下不存储）
+    EventArena<RouteEvent> route_events;
+    std::optional<int64_t> first_route_event_time;
     std::optional<int64_t> last_route_event_time;
     std::optional<int64_t> convergence_time;
     std::atomic<bool> is_converged{false};
     std::optional<int64_t> convergence_detected_time;
 
-    ConvergenceSession(int id, int64_t netem_time, 
-                      const std::unordered_map<std::string, std::string>& netem_info);
+    // 接收溢出信息：会话期间丢失的消息导致测量结果不可信
+    bool lossy{false};
+    int64_t lost_messages{0};
+    bool resync_pending{false};
+    bool resynced{false};
+
+    // 涉及的接口（ConvergenceMonitor 中的接口编号，有序去重）
+    std::vector<uint32_t> interface_ids;
+
+    // 会话期间变化过的前缀（关闭前缀跟踪时为空）
+    PrefixTable prefixes;
 
-    void add_route_event(int64_t timestamp, const std::string& event_type, 
-                        const std::unordered_map<std::string, std::string>& route_info);
+    // 会话开始时读取的注入编号（未配置 --injection-id-file 时为空）
+    std::string injection_id;
+
+    ConvergenceSession(int id, int64_t netem_time, const TriggerRecord& trigger, EventSlabPool* pool,
+                       bool track_prefixes);
+
+    // 记录会话内事件，返回会话内序号（从1开始）；quiet_reset 为false的事件（被忽略的重复路由通知）
+    // 照常记录但不重新开始静默期，也不计入前缀变化
+    int add_route_event(int64_t timestamp, const EventRecord& record, uint32_t interface_id,
+                        bool quiet_reset = true);
     
-    bool check_convergence(int64_t quiet_period_ms);
+    bool check_convergence(int64_t quiet_period_ns);
+    bool check_convergence(int64_t quiet_period_ns, int64_t current_time);
+
+    // 静默期截止时间：最后一个事件（无事件时为触发时刻）加上静默期
+    int64_t quiet_deadline(int64_t quiet_period_ns) const;
+
+    // 记录一次接收溢出：丢失的消息视为发生在溢出时刻，静默期从此重新计算
+    void mark_lossy(int64_t timestamp, int64_t lost);
+    void mark_resynced(bool success);
     
     int get_route_event_count() const;
+    // FIB镜像判定为重复通知的路由事件数
+    int get_noop_route_count() const;
     
     int64_t get_session_duration() const;
+
+    // 释放事件存储与前缀表（汇总信息保留）
+    void release_events();
+
+private:
+    int route_event_count_{0};
+    int noop_route_count_{0};
+    bool track_prefixes_;
+};
+
+// 已完成会话的汇总：--retain-events=summary 时只保留这些字段
+struct SessionSummary {
+    int session_id;
+    TriggerRecord::Source trigger_source;
+    int64_t trigger_time;
+    int64_t first_event_time;       // 无会话内事件时为0
+    int64_t last_event_time;
+    int route_event_count;
+    std::optional<int64_t> convergence_time;
+    int64_t session_duration;
+    bool lossy;
+    int64_t lost_messages;
+    bool resynced;
+    std::vector<uint32_t> interface_ids;
+};
+
+// 已完成会话的保留策略
+enum class EventRetention {
+    NONE,       // 不保留已完成会话，会话内事件也不存储（只写日志）
+    SUMMARY,    // 保留会话汇总，事件随会话结束释放
+    FULL        // 保留会话及其全部事件
+};
+
+// 并发会话时会话内事件的归属策略
+enum class SessionAttribution {
+    ALL_OPEN,       // 计入所有进行中的会话（各自独立计算静默期）
+    LATEST,         // 只计入最近开始的会话
+    NEAREST_PREFIX  // 按触发前缀最长匹配，其次按触发接口匹配，都不匹配时计入最近开始的会话
+};
+
+// 监控器配置选项
+struct MonitorOptions {
+    // netlink接收配置（接收缓冲区、批量大小）
+    NetlinkMonitorOptions netlink;
+    // 链路UP/DOWN是否作为触发事件（关闭时仍记录为会话内事件）
+    bool link_triggers = true;
+    // 日志队列容量与溢出策略
+    LoggerOptions logger;
+    // 已完成会话的保留策略
+    EventRetention retain_events = EventRetention::SUMMARY;
+    // 同时进行的会话数上限，1 表示会话进行中忽略新触发（与单会话行为一致）
+    int max_sessions = 1;
+    // 会话内事件的归属策略（仅在多个会话同时进行时有区别）
+    SessionAttribution attribution = SessionAttribution::ALL_OPEN;
+    // 会话结束时报告的最慢前缀数，0 表示关闭逐前缀跟踪
+    int prefix_report = 10;
+    // 启动时转储路由表建立FIB镜像，按镜像把路由通知分为 新增/变更/重复/删除
+    bool fib_mirror = true;
+    // 重复的路由通知（属性与镜像相同）不重新开始静默期、不触发会话（需要FIB镜像）
+    bool ignore_noop_routes = false;
+    // 实时状态页目录（如 /dev/shm/converge），每个监控器写入 <目录>/<路由器名称>.status，空表示关闭
+    std::string status_dir;
+    // 注入编号文件：每个会话开始时读取其内容作为 injection_id 写入会话日志，供 converge_aggregate --correlate
+    // 把各路由器的会话归入同一次故障注入（注入脚本在注入前写入新编号），空表示关闭
+    std::string injection_id_file;
+    // 低抖动测量模式（--low-jitter，见 low_jitter.h）：预先触及会话事件内存，事件线程以
+    // SCHED_FIFO realtime_priority 运行；进程级的 mlockall 与CPU划分由 main 完成
+    bool low_jitter = false;
+    int realtime_priority = 50;
+
+    static bool parse_retention(const std::string& name, EventRetention& retention);
+    static const char* retention_name(EventRetention retention);
+    static bool parse_attribution(const std::string& name, SessionAttribution& attribution);
+    static const char* attribution_name(SessionAttribution attribution);
 };
 
 // 监控状态枚举
@@ -128,75 +224,178 @@ enum class MonitorState {
 // 主监控器类
 class ConvergenceMonitor {
 private:
-    // 基本配置
-    std::unique_ptr<Logger> logger_;
+    // 基本配置（多命名空间模式下日志记录器由所有监控器共享）
+    std::shared_ptr<Logger> logger_;
+    bool owns_logger_{true};
     std::string log_file_path_;
     std::string router_name_;
+    // 运行用户名：构造时查询一次，所有日志记录复用
+    std::string user_{current_user()};
     std::string monitor_id_;
     int64_t convergence_threshold_ms_;
+    MonitorOptions options_;
+
+    static std::string current_user();
     
     // 状态管理
     std::atomic<MonitorState> state_{MonitorState::IDLE};
     std::mutex session_mutex_;
-    std::unique_ptr<ConvergenceSession> current_session_;
-    std::vector<std::unique_ptr<ConvergenceSession>> completed_sessions_;
+    // 会话事件内存块池，会话之间复用（须先于会话构造、后于会话析构）
+    EventSlabPool event_pool_;
+    // 进行中的会话，按开始顺序排列；非空即处于 MONITORING 状态
+    std::vector<std::unique_ptr<ConvergenceSession>> open_sessions_;
+    size_t peak_open_sessions_{0};
+    // attribute_event 的会话选择结果：构造时按 max_sessions 预留，事件路径上只清空不分配
+    std::vector<ConvergenceSession*> session_targets_;
+    std::vector<std::unique_ptr<ConvergenceSession>> completed_sessions_;   // 仅 FULL
+    std::vector<SessionSummary> session_summaries_;                         // SUMMARY / FULL
+    int64_t completed_session_count_{0};
     std::atomic<int> session_counter_{0};
+
+    // 接口编号表：ifindex → 编号 → 首次出现时的接口名称（仅在netlink监控线程中访问）
+    std::unordered_map<int32_t, uint32_t> interface_ids_;
+    std::vector<std::string> interface_names_;
+    uint32_t intern_interface(const EventRecord& record);
     
     // 统计计数器 (原子操作)
     std::atomic<int64_t> total_route_events_{0};
     std::atomic<int64_t> total_netem_triggers_{0};
     std::atomic<int64_t> total_route_triggers_{0};
+    std::atomic<int64_t> total_link_triggers_{0};
+    std::atomic<int64_t> total_nexthop_triggers_{0};
+    std::atomic<int64_t> total_nexthop_events_{0};
+    std::atomic<int64_t> total_netem_detected_{0};
+    std::atomic<int64_t> total_overruns_{0};
+    std::atomic<int64_t> total_lost_messages_{0};
+    int64_t resync_route_count_{0};
     int64_t monitoring_start_time_;
+
+    // FIB镜像（仅在netlink监控线程中访问）；启动转储完成前 fib_loading_ 为true
+    FibMirror fib_;
+    bool fib_loading_{false};
+    std::array<int64_t, RouteRecord::CHANGE_REMOVED + 1> route_change_counts_{};
+
+    // 会话统计直方图（session_mutex_ 保护，在会话结束时增量更新）；时间单位为微秒
+    static constexpr int HISTOGRAM_DIGITS = 3;
+    static constexpr int64_t HISTOGRAM_MAX_US = 3600LL * 1000000;
+    static constexpr int64_t HISTOGRAM_MAX_ROUTES = 100000000;
+    HdrHistogram convergence_time_hist_{HISTOGRAM_MAX_US, HISTOGRAM_DIGITS};
+    HdrHistogram session_duration_hist_{HISTOGRAM_MAX_US, HISTOGRAM_DIGITS};
+    HdrHistogram route_count_hist_{HISTOGRAM_MAX_ROUTES, HISTOGRAM_DIGITS};
+    int64_t lossy_sessions_{0};
+    // 收敛时间分布（<100ms、100-1000ms、>=1000ms）按实际值计数：直方图区间跨越边界时无法精确划分
+    int64_t fast_convergence_count_{0};
+    int64_t medium_convergence_count_{0};
+    int64_t slow_convergence_count_{0};
+
+    // 会话引擎的流水线阶段统计（解析、等锁、持锁），按netlink监控器的采样决定是否计时
+    PipelineStats::SessionStages session_stages_;
+    using SessionLock = PipelineStats::TimedLock<std::mutex>;
     
-    // 事件缓存
+    // 事件缓存：最近的QDisc事件（定长环形缓冲区）
     mutable std::mutex qdisc_events_mutex_;
-    std::queue<QdiscEvent> recent_qdisc_events_;
     static constexpr size_t MAX_QDISC_EVENTS = 20;
+    std::array<QdiscRecord, MAX_QDISC_EVENTS> recent_qdisc_events_{};
+    size_t qdisc_events_head_{0};
+    size_t qdisc_events_count_{0};
+
+    // 日志来源编号（Logger::register_source）
+    int log_source_id_{-1};
+    // --low-jitter 时启动阶段预先触及的字节数（写入 monitoring_started）
+    int64_t prefaulted_bytes_{0};
     
     // 线程管理
     std::atomic<bool> running_{false};
     std::vector<std::thread> worker_threads_;
     std::unique_ptr<NetlinkMonitor> netlink_monitor_;
-    
-    // 收敛检查线程
-    std::thread convergence_checker_thread_;
-    std::condition_variable convergence_cv_;
-    std::mutex convergence_mutex_;
 
+    // 多命名空间模式：本命名空间的接口缓存；netlink事件由外部事件循环分发
+    std::unique_ptr<InterfaceCache> interfaces_;
+    bool external_loop_{false};
+    std::string console_tag_;
+
+    void setup_netlink_callbacks();
+
+    // 实时状态页（session_mutex_ 保护，写入端只有持锁线程）
+    StatusPage::Writer status_page_;
+    void open_status_page();
+    // 刷新状态、会话与计数字段；调用者持有 session_mutex_
+    void publish_status();
+    void publish_session_result(const ConvergenceSession& session);
+
+    // 读取 --injection-id-file 的当前内容（首行，去除空白），文件不存在时为空
+    std::string read_injection_id() const;
+    
     // 内部方法
     void cleanup_old_events();
     std::string format_timestamp(int64_t timestamp_ms) const;
     std::string get_interface_name(int ifindex) const;
-    std::unordered_map<std::string, std::string> parse_route_info(const void* route_data) const;
-    std::unordered_map<std::string, std::string> parse_qdisc_info(const void* qdisc_data) const;
-    bool is_netem_related_event(const std::unordered_map<std::string, std::string>& qdisc_info, 
-                               const std::string& event_type) const;
+    bool is_netem_related_event(const QdiscRecord& qdisc) const;
     
-    void handle_trigger_event(int64_t timestamp, const std::string& event_type, 
-                             const std::unordered_map<std::string, std::string>& trigger_info, 
-                             const std::string& trigger_source);
+    // 以下会话相关方法要求调用者持有 session_mutex_
+    void handle_trigger_event(int64_t timestamp, const TriggerRecord& trigger);
+
+    // 触发是否可以开始新会话：未达到并发上限且没有相同触发键（接口 / 路由前缀）的会话
+    bool can_start_session(const TriggerRecord& trigger) const;
     
-    void handle_qdisc_event(const std::unordered_map<std::string, std::string>& qdisc_info, 
-                           const std::string& event_type);
+    void handle_qdisc_event(const QdiscRecord& qdisc);
     
-    void handle_route_event(int64_t timestamp, const std::string& event_type, 
-                           const std::unordered_map<std::string, std::string>& route_info);
+    void handle_route_event(const RouteRecord& route);
+
+    void handle_link_event(const LinkRecord& link);
+
+    // 下一跳对象变化：一个组的更新作为一个事件，与路由变化一样可以在空闲时触发会话
+    void handle_nexthop_event(const NexthopRecord& nexthop);
+
+    // --ignore-noop-routes 时被忽略的重复通知（路由或下一跳对象）
+    bool is_ignored_noop(const EventRecord& record) const;
+
+    // 会话内事件：按归属策略选择会话，存入会话并写日志
+    void attribute_event(int64_t timestamp, const EventRecord& record);
+    void select_sessions(const EventRecord& record, std::vector<ConvergenceSession*>& targets) const;
+    void record_session_event(ConvergenceSession* session, int64_t timestamp, const EventRecord& record,
+                              int64_t total_events);
     
-    void convergence_checker_loop();
-    void finish_current_session();
+    // 接收溢出与RIB重新同步
+    void on_netlink_overrun(int64_t lost);
+    void on_route_dump_entry(const void* route_data);
+    void on_route_dump_done(bool success);
+
+    // 收敛定时器到期（在netlink监控线程中调用）
+    void on_convergence_timer();
+    void finish_session(size_t index);
+    // 逐前缀收敛摘要，写入会话完成日志
+    void append_prefix_summary(JsonObject& log, const ConvergenceSession& session) const;
+    // 按进行中会话中最早的静默期截止时间设置定时器
+    void arm_next_deadline();
     void force_finish_session(const std::string& reason);
     void print_statistics();
     
-    // 获取当前时间戳（毫秒）
-    static int64_t get_current_timestamp_ms() {
-        return std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
+    // 当前时间（单调时钟纳秒）；回放抓包时为虚拟时钟
+    int64_t now_ns() const {
+        return netlink_monitor_->now_ns();
+    }
+
+    int64_t threshold_ns() const {
+        return convergence_threshold_ms_ * EventClock::NS_PER_MS;
     }
 
+    // 纳秒时长格式化为毫秒（保留3位小数），用于控制台输出
+    static std::string format_duration_ms(int64_t duration_ns);
+
 public:
     ConvergenceMonitor(int64_t convergence_threshold_ms, 
                       const std::string& router_name, 
-                      const std::string& log_path = "");
+                      const std::string& log_path = "",
+                      const MonitorOptions& options = MonitorOptions());
+
+    // 多命名空间模式：共享日志记录器（由调用者启动和停止），使用独立的接口缓存，
+    // netlink套接字在调用 start_monitoring() 时线程所在的命名空间中创建，事件由调用者
+    // 通过 netlink_monitor().dispatch_ready() 分发
+    ConvergenceMonitor(int64_t convergence_threshold_ms,
+                      const std::string& router_name,
+                      std::shared_ptr<Logger> shared_logger,
+                      const MonitorOptions& options);
     
     ~ConvergenceMonitor();
     
@@ -209,7 +408,22 @@ public:
     void start_monitoring();
     void stop_monitoring();
     
+    // 统计计数（供基准测试读取）
+    int64_t total_route_events() const { return total_route_events_.load(); }
+    int64_t completed_session_count();
+
     // 事件处理回调 (由NetlinkMonitor调用)
-    void on_route_event(const void* route_data, const std::string& event_type);
-    void on_qdisc_event(const void* qdisc_data, const std::string& event_type);
+    void on_route_event(const RouteRecord& route);
+    void on_qdisc_event(const QdiscRecord& qdisc);
+    void on_link_event(const LinkRecord& link);
+    void on_nexthop_event(const NexthopRecord& nexthop);
+
+    // 流水线阶段统计：写入一条 monitor_stats 日志，print_console 时同时输出到控制台（SIGUSR1）
+    void report_pipeline_stats(bool print_console);
+
+    NetlinkMonitor& netlink_monitor() { return *netlink_monitor_; }
+    const Logger& logger() const { return *logger_; }
+    // 回放模式下抓包已处理完毕
+    bool replay_finished() const { return netlink_monitor_->replay_finished(); }
+    const std::string& router_name() const { return router_name_; }
 };
@@ -0,0 +1,75 @@
+#include "cpu_affinity.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+
+bool CpuAffinity::parse_cpu_list(const std::string& list, std::vector<int>& out, std::string& error) {
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        size_t dash = item.find('-');
+        std::string first_text = item.substr(0, dash);
+        std::string last_text = dash == std::string::npos ? first_text : item.substr(dash + 1);
+
+        char* end1 = nullptr;
+        char* end2 = nullptr;
+        long first = strtol(first_text.c_str(), &end1, 10);
+        long last = strtol(last_text.c_str(), &end2, 10);
+        if (first_text.empty() || last_text.empty() || *end1 != '\0' || *end2 != '\0' ||
+            first < 0 || last < first || last >= CPU_SETSIZE) {
+            error = "无效的CPU列表项: " + item;
+            return false;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            out.push_back(static_cast<int>(cpu));
+        }
+    }
+    if (out.empty()) {
+        error = "CPU列表为空";
+        return false;
+    }
+    return true;
+}
+
+bool CpuAffinity::pin_current_thread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        std::cerr << "⚠️  绑定CPU " << cpu << " 失败: " << strerror(rc) << "\n";
+        return false;
+    }
+    return true;
+}
+
+std::string CpuAffinity::describe(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return "不绑定";
+    }
+    std::string out;
+    size_t i = 0;
+    while (i < cpus.size()) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            ++j;
+        }
+        if (!out.empty()) {
+            out += ',';
+        }
+        out += std::to_string(cpus[i]);
+        if (j > i) {
+            out += '-';
+            out += std::to_string(cpus[j]);
+        }
+        i = j + 1;
+    }
+    return out;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// 事件线程的CPU绑定
+class CpuAffinity {
+public:
+    // 解析CPU列表（"0-3,6,8-9"），失败时返回false并设置error
+    static bool parse_cpu_list(const std::string& list, std::vector<int>& out, std::string& error);
+
+    // 将调用线程绑定到指定CPU，失败时输出警告并返回false
+    static bool pin_current_thread(int cpu);
+
+    // 可读描述（"0-3,6"），空列表为"不绑定"
+    static std::string describe(const std::vector<int>& cpus);
+};
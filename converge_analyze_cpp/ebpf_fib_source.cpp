@@ -0,0 +1,870 @@
+#include "ebpf_fib_source.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/bpf.h>
+#include <linux/btf.h>
+#include <linux/rtnetlink.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+int sys_bpf(int cmd, union bpf_attr& attr) {
+    return static_cast<int>(syscall(__NR_bpf, cmd, &attr, sizeof(attr)));
+}
+
+// 内核BTF（/sys/kernel/btf/vmlinux）：按名称查找函数与结构体成员偏移
+class KernelBtf {
+public:
+    bool load(const char* path, std::string& error) {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            error = std::string("无法读取内核BTF ") + path + ": " + strerror(errno);
+            return false;
+        }
+        char chunk[65536];
+        ssize_t n;
+        while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+            data_.insert(data_.end(), chunk, chunk + n);
+        }
+        close(fd);
+
+        struct btf_header header;
+        if (data_.size() < sizeof(header)) {
+            error = std::string("内核BTF格式错误: ") + path;
+            return false;
+        }
+        memcpy(&header, data_.data(), sizeof(header));
+        if (header.magic != BTF_MAGIC ||
+            static_cast<size_t>(header.hdr_len) + header.str_off + header.str_len > data_.size() ||
+            static_cast<size_t>(header.hdr_len) + header.type_off + header.type_len > data_.size()) {
+            error = std::string("内核BTF格式错误: ") + path;
+            return false;
+        }
+        strings_ = data_.data() + header.hdr_len + header.str_off;
+        strings_len_ = header.str_len;
+
+        // 类型编号从1开始
+        types_.push_back(nullptr);
+        const char* cursor = data_.data() + header.hdr_len + header.type_off;
+        const char* end = cursor + header.type_len;
+        while (cursor + sizeof(struct btf_type) <= end) {
+            const struct btf_type* type = reinterpret_cast<const struct btf_type*>(cursor);
+            types_.push_back(type);
+            cursor += sizeof(struct btf_type) + extra_size(type);
+        }
+        return true;
+    }
+
+    // 函数的BTF编号与参数个数（fexit上下文中返回值紧随参数之后）
+    bool find_function(const char* function, uint32_t& id, int& params) const {
+        for (uint32_t i = 1; i < types_.size(); ++i) {
+            if (kind(types_[i]) != BTF_KIND_FUNC || strcmp(function, name(types_[i]->name_off)) != 0) {
+                continue;
+            }
+            uint32_t proto = types_[i]->type;
+            if (proto >= types_.size() || kind(types_[proto]) != BTF_KIND_FUNC_PROTO) {
+                return false;
+            }
+            id = i;
+            params = static_cast<int>(vlen(types_[proto]));
+            return true;
+        }
+        return false;
+    }
+
+    // 成员路径（如 "ns.inum"、"fib6_dst.addr"）相对结构体起始的字节偏移。匿名结构/联合中的成员直接可见，
+    // 数组成员取第一个元素，位域成员视为不存在
+    bool member_offset(const char* struct_name, const std::string& path, uint32_t& offset) const {
+        uint32_t type_id = find_struct(struct_name);
+        if (type_id == 0) {
+            return false;
+        }
+        uint32_t total_bits = 0;
+        size_t start = 0;
+        while (true) {
+            size_t dot = path.find('.', start);
+            std::string member = path.substr(start, dot == std::string::npos ? std::string::npos : dot - start);
+            uint32_t bits = 0;
+            uint32_t member_type = 0;
+            if (!find_member(type_id, member, bits, member_type)) {
+                return false;
+            }
+            total_bits += bits;
+            type_id = resolve(member_type);
+            if (type_id > 0 && type_id < types_.size() && kind(types_[type_id]) == BTF_KIND_ARRAY) {
+                const struct btf_array* array = reinterpret_cast<const struct btf_array*>(types_[type_id] + 1);
+                type_id = resolve(array->type);
+            }
+            if (dot == std::string::npos) {
+                break;
+            }
+            start = dot + 1;
+        }
+        if (total_bits % 8 != 0) {
+            return false;
+        }
+        offset = total_bits / 8;
+        return true;
+    }
+
+private:
+    std::vector<char> data_;
+    const char* strings_{nullptr};
+    size_t strings_len_{0};
+    std::vector<const struct btf_type*> types_;
+
+    static uint32_t kind(const struct btf_type* type) { return BTF_INFO_KIND(type->info); }
+    static uint32_t vlen(const struct btf_type* type) { return BTF_INFO_VLEN(type->info); }
+
+    static size_t extra_size(const struct btf_type* type) {
+        switch (kind(type)) {
+            case BTF_KIND_INT: return sizeof(uint32_t);
+            case BTF_KIND_ARRAY: return sizeof(struct btf_array);
+            case BTF_KIND_STRUCT:
+            case BTF_KIND_UNION: return vlen(type) * sizeof(struct btf_member);
+            case BTF_KIND_ENUM: return vlen(type) * sizeof(struct btf_enum);
+            case BTF_KIND_FUNC_PROTO: return vlen(type) * sizeof(struct btf_param);
+            case BTF_KIND_VAR: return sizeof(struct btf_var);
+            case BTF_KIND_DATASEC: return vlen(type) * sizeof(struct btf_var_secinfo);
+            case BTF_KIND_DECL_TAG: return sizeof(struct btf_decl_tag);
+            case BTF_KIND_ENUM64: return vlen(type) * 3 * sizeof(uint32_t);
+            default: return 0;
+        }
+    }
+
+    const char* name(uint32_t offset) const {
+        return offset < strings_len_ ? strings_ + offset : "";
+    }
+
+    // 跳过 typedef / const / volatile / restrict / type_tag
+    uint32_t resolve(uint32_t id) const {
+        while (id > 0 && id < types_.size()) {
+            uint32_t k = kind(types_[id]);
+            if (k != BTF_KIND_TYPEDEF && k != BTF_KIND_VOLATILE && k != BTF_KIND_CONST &&
+                k != BTF_KIND_RESTRICT && k != BTF_KIND_TYPE_TAG) {
+                break;
+            }
+            id = types_[id]->type;
+        }
+        return id;
+    }
+
+    uint32_t find_struct(const char* struct_name) const {
+        for (uint32_t i = 1; i < types_.size(); ++i) {
+            if (kind(types_[i]) == BTF_KIND_STRUCT && vlen(types_[i]) > 0 &&
+                strcmp(struct_name, name(types_[i]->name_off)) == 0) {
+                return i;
+            }
+        }
+        return 0;
+    }
+
+    bool find_member(uint32_t type_id, const std::string& member, uint32_t& bit_offset,
+                     uint32_t& member_type) const {
+        if (type_id == 0 || type_id >= types_.size()) {
+            return false;
+        }
+        const struct btf_type* type = types_[type_id];
+        if (kind(type) != BTF_KIND_STRUCT && kind(type) != BTF_KIND_UNION) {
+            return false;
+        }
+        bool bitfields = BTF_INFO_KFLAG(type->info) != 0;
+        const struct btf_member* members = reinterpret_cast<const struct btf_member*>(type + 1);
+        for (uint32_t i = 0; i < vlen(type); ++i) {
+            uint32_t offset = bitfields ? BTF_MEMBER_BIT_OFFSET(members[i].offset) : members[i].offset;
+            uint32_t bitfield_size = bitfields ? BTF_MEMBER_BITFIELD_SIZE(members[i].offset) : 0;
+            const char* member_name = name(members[i].name_off);
+            if (member_name[0] == '\0') {
+                uint32_t nested_bits = 0;
+                if (find_member(resolve(members[i].type), member, nested_bits, member_type)) {
+                    bit_offset = offset + nested_bits;
+                    return true;
+                }
+                continue;
+            }
+            if (member == member_name) {
+                if (bitfield_size != 0) {
+                    return false;
+                }
+                bit_offset = offset;
+                member_type = members[i].type;
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// eBPF汇编器：带符号标签，跳转偏移在 finish 时解析
+class EbpfAssembler {
+public:
+    int new_label() {
+        label_pos_.push_back(-1);
+        return static_cast<int>(label_pos_.size()) - 1;
+    }
+
+    void bind(int label) { label_pos_[label] = static_cast<int>(insns_.size()); }
+
+    void mov_reg(uint8_t dst, uint8_t src) { emit(BPF_ALU64 | BPF_MOV | BPF_X, dst, src, 0, 0); }
+    void mov_imm(uint8_t dst, int32_t imm) { emit(BPF_ALU64 | BPF_MOV | BPF_K, dst, 0, 0, imm); }
+    void add_imm(uint8_t dst, int32_t imm) { emit(BPF_ALU64 | BPF_ADD | BPF_K, dst, 0, 0, imm); }
+    void load(uint8_t size, uint8_t dst, uint8_t src, int16_t off) { emit(BPF_LDX | size | BPF_MEM, dst, src, off, 0); }
+    void store(uint8_t size, uint8_t dst, int16_t off, uint8_t src) { emit(BPF_STX | size | BPF_MEM, dst, src, off, 0); }
+    void store_imm(uint8_t size, uint8_t dst, int16_t off, int32_t imm) { emit(BPF_ST | size | BPF_MEM, dst, 0, off, imm); }
+    void atomic_add(uint8_t dst, int16_t off, uint8_t src) { emit(BPF_STX | BPF_DW | BPF_ATOMIC, dst, src, off, BPF_ADD); }
+    void call(int32_t helper) { emit(BPF_JMP | BPF_CALL, 0, 0, 0, helper); }
+    void exit() { emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0); }
+
+    void jump(int label) { jump_to(BPF_JMP | BPF_JA, 0, label); }
+    void jump_if_zero(uint8_t reg, int label) { jump_to(BPF_JMP | BPF_JEQ | BPF_K, reg, label); }
+    // 只比较低32位（int返回值）
+    void jump32_if_nonzero(uint8_t reg, int label) { jump_to(BPF_JMP32 | BPF_JNE | BPF_K, reg, label); }
+
+    // 64位立即数形式的map引用（占两条指令）
+    void load_map_fd(uint8_t dst, int fd) {
+        emit(BPF_LD | BPF_DW | BPF_IMM, dst, BPF_PSEUDO_MAP_FD, 0, fd);
+        emit(0, 0, 0, 0, 0);
+    }
+
+    std::vector<struct bpf_insn> finish() const {
+        std::vector<struct bpf_insn> program = insns_;
+        for (const auto& fixup : fixups_) {
+            program[fixup.first].off = static_cast<int16_t>(label_pos_[fixup.second] - fixup.first - 1);
+        }
+        return program;
+    }
+
+private:
+    std::vector<struct bpf_insn> insns_;
+    std::vector<int> label_pos_;
+    std::vector<std::pair<int, int>> fixups_;   // 跳转指令位置 → 标签
+
+    void emit(uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm) {
+        struct bpf_insn insn;
+        memset(&insn, 0, sizeof(insn));
+        insn.code = code;
+        insn.dst_reg = dst & 0x0f;
+        insn.src_reg = src & 0x0f;
+        insn.off = off;
+        insn.imm = imm;
+        insns_.push_back(insn);
+    }
+
+    void jump_to(uint8_t code, uint8_t reg, int label) {
+        fixups_.emplace_back(static_cast<int>(insns_.size()), label);
+        emit(code, reg, 0, 0, 0);
+    }
+};
+
+// 寄存器：r6 上下文，r7/r8/r9 为读取字段的结构体指针（跨helper调用保留）
+constexpr uint8_t R0 = 0, R1 = 1, R2 = 2, R3 = 3, R4 = 4, R6 = 6, R7 = 7, R8 = 8, R9 = 9, R10 = 10;
+
+// 栈布局：记录在 r10-96，指针临时区在其下方8字节
+constexpr int16_t STACK_RECORD = -static_cast<int16_t>(sizeof(EbpfFibRecord));
+constexpr int16_t STACK_POINTER = STACK_RECORD - 8;
+
+constexpr int16_t record_off(size_t field) {
+    return static_cast<int16_t>(STACK_RECORD + static_cast<int>(field));
+}
+
+// 一个fexit程序的公共部分：返回值检查、记录初始化与按命名空间输出
+class ProgramBuilder {
+public:
+    ProgramBuilder(int rings_map_fd, int drops_map_fd) : rings_map_fd_(rings_map_fd), drops_map_fd_(drops_map_fd) {}
+
+    // 返回值非0（修改失败）时直接退出；清零记录并写入时间戳、操作类型与地址族
+    void prologue(int ret_index, uint8_t op, uint8_t family) {
+        out_ = a_.new_label();
+        a_.mov_reg(R6, R1);
+        a_.load(BPF_DW, R0, R6, static_cast<int16_t>(8 * ret_index));
+        a_.jump32_if_nonzero(R0, out_);
+        for (size_t off = 0; off < sizeof(EbpfFibRecord); off += 8) {
+            a_.store_imm(BPF_DW, R10, record_off(off), 0);
+        }
+        a_.call(BPF_FUNC_ktime_get_ns);
+        a_.store(BPF_DW, R10, record_off(offsetof(EbpfFibRecord, timestamp_ns)), R0);
+        a_.store_imm(BPF_B, R10, record_off(offsetof(EbpfFibRecord, op)), op);
+        a_.store_imm(BPF_B, R10, record_off(offsetof(EbpfFibRecord, family)), family);
+    }
+
+    // reg ← 上下文中第 index 个参数
+    void load_arg(uint8_t reg, int index) { a_.load(BPF_DW, reg, R6, static_cast<int16_t>(8 * index)); }
+
+    // 记录字段 ← *(base + offset) 的 size 字节（bpf_probe_read_kernel，读取失败时保持为0）
+    void copy(size_t record_field, uint32_t size, uint8_t base, uint32_t offset) {
+        a_.mov_reg(R1, R10);
+        a_.add_imm(R1, record_off(record_field));
+        a_.mov_imm(R2, static_cast<int32_t>(size));
+        a_.mov_reg(R3, base);
+        a_.add_imm(R3, static_cast<int32_t>(offset));
+        a_.call(BPF_FUNC_probe_read_kernel);
+    }
+
+    // reg ← *(void**)(base + offset)，读取失败时为0
+    void load_pointer(uint8_t reg, uint8_t base, uint32_t offset) {
+        a_.store_imm(BPF_DW, R10, STACK_POINTER, 0);
+        a_.mov_reg(R1, R10);
+        a_.add_imm(R1, STACK_POINTER);
+        a_.mov_imm(R2, 8);
+        a_.mov_reg(R3, base);
+        a_.add_imm(R3, static_cast<int32_t>(offset));
+        a_.call(BPF_FUNC_probe_read_kernel);
+        a_.load(BPF_DW, reg, R10, STACK_POINTER);
+    }
+
+    EbpfAssembler& assembler() { return a_; }
+    int out_label() const { return out_; }
+
+    // 按命名空间查找环形缓冲区并输出记录；环满时累加该命名空间的丢弃计数
+    std::vector<struct bpf_insn> finish() {
+        int16_t key = record_off(offsetof(EbpfFibRecord, netns));
+        a_.load_map_fd(R1, rings_map_fd_);
+        a_.mov_reg(R2, R10);
+        a_.add_imm(R2, key);
+        a_.call(BPF_FUNC_map_lookup_elem);
+        a_.jump_if_zero(R0, out_);
+        a_.mov_reg(R1, R0);
+        a_.mov_reg(R2, R10);
+        a_.add_imm(R2, STACK_RECORD);
+        a_.mov_imm(R3, static_cast<int32_t>(sizeof(EbpfFibRecord)));
+        a_.mov_imm(R4, 0);
+        a_.call(BPF_FUNC_ringbuf_output);
+        a_.jump_if_zero(R0, out_);
+        a_.load_map_fd(R1, drops_map_fd_);
+        a_.mov_reg(R2, R10);
+        a_.add_imm(R2, key);
+        a_.call(BPF_FUNC_map_lookup_elem);
+        a_.jump_if_zero(R0, out_);
+        a_.mov_imm(R1, 1);
+        a_.atomic_add(R0, 0, R1);
+        a_.bind(out_);
+        a_.mov_imm(R0, 0);
+        a_.exit();
+        return a_.finish();
+    }
+
+private:
+    EbpfAssembler a_;
+    int rings_map_fd_;
+    int drops_map_fd_;
+    int out_{-1};
+};
+
+// 程序读取的内核结构体字段偏移（加载时从BTF解析），has_* 为 false 的字段在该内核上不存在
+struct FieldOffsets {
+    uint32_t net_inum = 0;
+    // IPv4: fib_table_insert / fib_table_delete(struct net*, struct fib_table*, struct fib_config*, ...)
+    uint32_t tb_id = 0;
+    uint32_t fc_dst_len = 0, fc_protocol = 0, fc_scope = 0, fc_type = 0;
+    uint32_t fc_dst = 0, fc_gw = 0, fc_prefsrc = 0, fc_oif = 0, fc_priority = 0, fc_mp_len = 0;
+    uint32_t fc_gw_size = 16;               // 5.2 以前只有4字节的 fc_gw
+    bool has_fc_gw_family = false;
+    uint32_t fc_gw_family = 0;
+    bool has_fc_nh_id = false;
+    uint32_t fc_nh_id = 0;
+    // IPv6: fib6_add(struct fib6_node*, struct fib6_info*, struct nl_info*, ...) / fib6_del(struct fib6_info*, struct nl_info*)
+    uint32_t nl_net = 0;
+    uint32_t f6_table = 0, tb6_id = 0, f6_dst_addr = 0, f6_dst_plen = 0, f6_prefsrc_addr = 0;
+    uint32_t f6_metric = 0, f6_protocol = 0, f6_type = 0, f6_nsiblings = 0;
+    uint32_t f6_nh_oif = 0, f6_nh_gw = 0, f6_nh_gw_family = 0;
+    bool has_f6_nh = false;
+    uint32_t f6_nh = 0, nexthop_id = 0;
+};
+
+bool resolve_offsets(const KernelBtf& btf, FieldOffsets& o, std::string& error) {
+    struct Required {
+        const char* type;
+        const char* path;
+        uint32_t* out;
+    };
+    const Required required[] = {
+        {"net", "ns.inum", &o.net_inum},
+        {"fib_table", "tb_id", &o.tb_id},
+        {"fib_config", "fc_dst_len", &o.fc_dst_len},
+        {"fib_config", "fc_protocol", &o.fc_protocol},
+        {"fib_config", "fc_scope", &o.fc_scope},
+        {"fib_config", "fc_type", &o.fc_type},
+        {"fib_config", "fc_dst", &o.fc_dst},
+        {"fib_config", "fc_prefsrc", &o.fc_prefsrc},
+        {"fib_config", "fc_oif", &o.fc_oif},
+        {"fib_config", "fc_priority", &o.fc_priority},
+        {"fib_config", "fc_mp_len", &o.fc_mp_len},
+        {"nl_info", "nl_net", &o.nl_net},
+        {"fib6_info", "fib6_table", &o.f6_table},
+        {"fib6_table", "tb6_id", &o.tb6_id},
+        {"fib6_info", "fib6_dst.addr", &o.f6_dst_addr},
+        {"fib6_info", "fib6_dst.plen", &o.f6_dst_plen},
+        {"fib6_info", "fib6_prefsrc.addr", &o.f6_prefsrc_addr},
+        {"fib6_info", "fib6_metric", &o.f6_metric},
+        {"fib6_info", "fib6_protocol", &o.f6_protocol},
+        {"fib6_info", "fib6_type", &o.f6_type},
+        {"fib6_info", "fib6_nsiblings", &o.f6_nsiblings},
+        {"fib6_info", "fib6_nh.nh_common.nhc_oif", &o.f6_nh_oif},
+        {"fib6_info", "fib6_nh.nh_common.nhc_gw", &o.f6_nh_gw},
+        {"fib6_info", "fib6_nh.nh_common.nhc_gw_family", &o.f6_nh_gw_family},
+    };
+    for (const auto& field : required) {
+        if (!btf.member_offset(field.type, field.path, *field.out)) {
+            error = std::string("内核BTF中找不到 ") + field.type + "." + field.path;
+            return false;
+        }
+    }
+
+    if (!btf.member_offset("fib_config", "fc_gw6", o.fc_gw)) {
+        o.fc_gw_size = 4;
+        if (!btf.member_offset("fib_config", "fc_gw", o.fc_gw)) {
+            error = "内核BTF中找不到 fib_config.fc_gw6";
+            return false;
+        }
+    }
+    o.has_fc_gw_family = btf.member_offset("fib_config", "fc_gw_family", o.fc_gw_family);
+    o.has_fc_nh_id = btf.member_offset("fib_config", "fc_nh_id", o.fc_nh_id);
+    o.has_f6_nh = btf.member_offset("fib6_info", "nh", o.f6_nh) && btf.member_offset("nexthop", "id", o.nexthop_id);
+    return true;
+}
+
+// IPv4：属性取自修改请求 fib_config（与 RTM_NEWROUTE/RTM_DELROUTE 请求中的属性一致）
+std::vector<struct bpf_insn> build_ipv4_program(const FieldOffsets& o, int ret_index, uint8_t op,
+                                                int rings_map_fd, int drops_map_fd) {
+    ProgramBuilder p(rings_map_fd, drops_map_fd);
+    p.prologue(ret_index, op, AF_INET);
+    p.load_arg(R8, 0);
+    p.load_arg(R9, 1);
+    p.load_arg(R7, 2);
+    p.copy(offsetof(EbpfFibRecord, netns), 4, R8, o.net_inum);
+    p.copy(offsetof(EbpfFibRecord, table), 4, R9, o.tb_id);
+    p.copy(offsetof(EbpfFibRecord, oif), 4, R7, o.fc_oif);
+    p.copy(offsetof(EbpfFibRecord, priority), 4, R7, o.fc_priority);
+    p.copy(offsetof(EbpfFibRecord, dst_len), 1, R7, o.fc_dst_len);
+    p.copy(offsetof(EbpfFibRecord, protocol), 1, R7, o.fc_protocol);
+    p.copy(offsetof(EbpfFibRecord, scope), 1, R7, o.fc_scope);
+    p.copy(offsetof(EbpfFibRecord, type), 1, R7, o.fc_type);
+    p.copy(offsetof(EbpfFibRecord, dst), 4, R7, o.fc_dst);
+    p.copy(offsetof(EbpfFibRecord, gateway), o.fc_gw_size, R7, o.fc_gw);
+    p.copy(offsetof(EbpfFibRecord, prefsrc), 4, R7, o.fc_prefsrc);
+    p.copy(offsetof(EbpfFibRecord, multipath), 4, R7, o.fc_mp_len);
+    if (o.has_fc_gw_family) {
+        p.copy(offsetof(EbpfFibRecord, gateway_family), 1, R7, o.fc_gw_family);
+    }
+    if (o.has_fc_nh_id) {
+        p.copy(offsetof(EbpfFibRecord, nh_id), 4, R7, o.fc_nh_id);
+    }
+    return p.finish();
+}
+
+// IPv6：属性取自插入/删除的 fib6_info（出接口与网关为内核解析后的结果）
+std::vector<struct bpf_insn> build_ipv6_program(const FieldOffsets& o, int rt_arg, int info_arg, int ret_index,
+                                                uint8_t op, int rings_map_fd, int drops_map_fd) {
+    ProgramBuilder p(rings_map_fd, drops_map_fd);
+    EbpfAssembler& a = p.assembler();
+    p.prologue(ret_index, op, AF_INET6);
+    p.load_arg(R7, rt_arg);
+    p.load_arg(R8, info_arg);
+
+    p.load_pointer(R9, R8, o.nl_net);
+    a.jump_if_zero(R9, p.out_label());
+    p.copy(offsetof(EbpfFibRecord, netns), 4, R9, o.net_inum);
+
+    int no_table = a.new_label();
+    p.load_pointer(R9, R7, o.f6_table);
+    a.jump_if_zero(R9, no_table);
+    p.copy(offsetof(EbpfFibRecord, table), 4, R9, o.tb6_id);
+    a.bind(no_table);
+
+    p.copy(offsetof(EbpfFibRecord, dst), 16, R7, o.f6_dst_addr);
+    p.copy(offsetof(EbpfFibRecord, prefix_len), 4, R7, o.f6_dst_plen);
+    p.copy(offsetof(EbpfFibRecord, prefsrc), 16, R7, o.f6_prefsrc_addr);
+    p.copy(offsetof(EbpfFibRecord, priority), 4, R7, o.f6_metric);
+    p.copy(offsetof(EbpfFibRecord, protocol), 1, R7, o.f6_protocol);
+    p.copy(offsetof(EbpfFibRecord, type), 1, R7, o.f6_type);
+    p.copy(offsetof(EbpfFibRecord, multipath), 4, R7, o.f6_nsiblings);
+
+    // 使用下一跳对象的路由只记录对象编号，否则记录内嵌的 fib6_nh
+    int inline_nh = a.new_label();
+    int done = a.new_label();
+    if (o.has_f6_nh) {
+        p.load_pointer(R9, R7, o.f6_nh);
+        a.jump_if_zero(R9, inline_nh);
+        p.copy(offsetof(EbpfFibRecord, nh_id), 4, R9, o.nexthop_id);
+        a.jump(done);
+    }
+    a.bind(inline_nh);
+    p.copy(offsetof(EbpfFibRecord, oif), 4, R7, o.f6_nh_oif);
+    p.copy(offsetof(EbpfFibRecord, gateway), 16, R7, o.f6_nh_gw);
+    p.copy(offsetof(EbpfFibRecord, gateway_family), 1, R7, o.f6_nh_gw_family);
+    a.bind(done);
+    return p.finish();
+}
+
+int create_map(uint32_t type, uint32_t key_size, uint32_t value_size, uint32_t max_entries,
+               int inner_map_fd, const char* name) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = type;
+    attr.key_size = key_size;
+    attr.value_size = value_size;
+    attr.max_entries = max_entries;
+    if (inner_map_fd >= 0) {
+        attr.inner_map_fd = static_cast<uint32_t>(inner_map_fd);
+    }
+    strncpy(attr.map_name, name, sizeof(attr.map_name) - 1);
+    return sys_bpf(BPF_MAP_CREATE, attr);
+}
+
+int create_ring() {
+    return create_map(BPF_MAP_TYPE_RINGBUF, 0, 0, static_cast<uint32_t>(EbpfFibSource::RING_BYTES), -1,
+                      "converge_ring");
+}
+
+// 加载fexit程序；校验失败时 error 中附带校验器日志的最后部分
+int load_program(const std::vector<struct bpf_insn>& insns, uint32_t btf_id, const char* name, std::string& error) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_TRACING;
+    attr.expected_attach_type = BPF_TRACE_FEXIT;
+    attr.attach_btf_id = btf_id;
+    attr.insns = reinterpret_cast<uint64_t>(insns.data());
+    attr.insn_cnt = static_cast<uint32_t>(insns.size());
+    attr.license = reinterpret_cast<uint64_t>("GPL");
+    strncpy(attr.prog_name, name, sizeof(attr.prog_name) - 1);
+    int fd = sys_bpf(BPF_PROG_LOAD, attr);
+    if (fd >= 0) {
+        return fd;
+    }
+    int saved = errno;
+
+    std::vector<char> verifier_log(65536, '\0');
+    attr.log_buf = reinterpret_cast<uint64_t>(verifier_log.data());
+    attr.log_size = static_cast<uint32_t>(verifier_log.size());
+    attr.log_level = 1;
+    fd = sys_bpf(BPF_PROG_LOAD, attr);
+    if (fd >= 0) {
+        return fd;
+    }
+    std::string log(verifier_log.data());
+    if (log.size() > 512) {
+        log = "..." + log.substr(log.size() - 512);
+    }
+    error = std::string("加载 fexit/") + name + " 失败: " + strerror(saved) + (log.empty() ? "" : "\n" + log);
+    return -1;
+}
+
+int attach_program(int prog_fd) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.raw_tracepoint.prog_fd = static_cast<uint32_t>(prog_fd);
+    return sys_bpf(BPF_RAW_TRACEPOINT_OPEN, attr);
+}
+
+bool is_zero(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if (data[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::mutex g_source_mutex;
+std::weak_ptr<EbpfFibSource> g_source;
+
+} // namespace
+
+EbpfRouteRing::EbpfRouteRing(std::shared_ptr<EbpfFibSource> source, uint32_t netns, int ring_fd,
+                             void* consumer, void* producer, size_t size)
+    : source_(std::move(source)), netns_(netns), ring_fd_(ring_fd), consumer_page_(consumer),
+      producer_pages_(producer), size_(size),
+      data_(static_cast<const char*>(producer) + sysconf(_SC_PAGESIZE)) {}
+
+EbpfRouteRing::~EbpfRouteRing() {
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    munmap(consumer_page_, page);
+    munmap(producer_pages_, page + 2 * size_);
+    source_->close_ring(netns_);
+    close(ring_fd_);
+}
+
+bool EbpfRouteRing::next(EbpfFibRecord& record) {
+    uint64_t* consumer = static_cast<uint64_t*>(consumer_page_);
+    const uint64_t* producer = static_cast<const uint64_t*>(producer_pages_);
+    uint64_t consumer_pos = __atomic_load_n(consumer, __ATOMIC_ACQUIRE);
+    uint64_t producer_pos = __atomic_load_n(producer, __ATOMIC_ACQUIRE);
+
+    while (consumer_pos < producer_pos) {
+        // 数据区映射了两遍，记录不会在末尾折断
+        const uint32_t* header = reinterpret_cast<const uint32_t*>(data_ + (consumer_pos & (size_ - 1)));
+        uint32_t len = __atomic_load_n(header, __ATOMIC_ACQUIRE);
+        if (len & BPF_RINGBUF_BUSY_BIT) {
+            return false;
+        }
+        bool discarded = (len & BPF_RINGBUF_DISCARD_BIT) != 0;
+        len &= ~static_cast<uint32_t>(BPF_RINGBUF_BUSY_BIT | BPF_RINGBUF_DISCARD_BIT);
+        bool valid = !discarded && len >= sizeof(record);
+        if (valid) {
+            memcpy(&record, reinterpret_cast<const char*>(header) + BPF_RINGBUF_HDR_SZ, sizeof(record));
+        }
+        consumer_pos += (len + BPF_RINGBUF_HDR_SZ + 7) & ~static_cast<uint64_t>(7);
+        __atomic_store_n(consumer, consumer_pos, __ATOMIC_RELEASE);
+        if (valid) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int64_t EbpfRouteRing::dropped() const {
+    return source_->read_drops(netns_);
+}
+
+void EbpfRouteRing::to_route_record(const EbpfFibRecord& record, RouteRecord& route) {
+    memset(&route, 0, sizeof(route));
+    route.timestamp = static_cast<int64_t>(record.timestamp_ns);
+    route.nlmsg_type = record.op == EbpfFibRecord::OP_DEL ? RTM_DELROUTE : RTM_NEWROUTE;
+    route.family = record.family;
+    route.protocol = record.protocol;
+    route.scope = record.scope;
+    route.type = record.type;
+    route.table = record.table;
+    route.priority = record.priority;
+
+    bool ipv6 = record.family == AF_INET6;
+    size_t addr_len = ipv6 ? 16 : 4;
+    route.dst_len = ipv6 ? static_cast<uint8_t>(record.prefix_len) : record.dst_len;
+    if (route.dst_len > 0) {
+        memcpy(&route.dst, record.dst, addr_len);
+        route.flags |= RouteRecord::HAS_DST;
+    }
+    // 与rtnetlink通知一致：IPv6 总是带 RTA_PRIORITY，IPv4 只在非0时带
+    if (ipv6 || record.priority != 0) {
+        route.flags |= RouteRecord::HAS_PRIORITY;
+    }
+    if (!is_zero(record.prefsrc, addr_len)) {
+        memcpy(&route.prefsrc, record.prefsrc, addr_len);
+        route.flags |= RouteRecord::HAS_PREFSRC;
+    }
+    if (record.nh_id != 0) {
+        route.nh_id = record.nh_id;
+        route.flags |= RouteRecord::HAS_NH_ID;
+        return;
+    }
+
+    // IPv4 网关族为 AF_INET6 时是 RFC 5549 的IPv6下一跳（RTA_VIA），这里只记录同族网关
+    bool same_family_gateway = record.gateway_family == 0 || record.gateway_family == record.family;
+    if (same_family_gateway && !is_zero(record.gateway, addr_len)) {
+        memcpy(&route.gateway, record.gateway, addr_len);
+        route.flags |= RouteRecord::HAS_GATEWAY;
+    }
+    if (record.oif > 0) {
+        route.ifindex = record.oif;
+        route.flags |= RouteRecord::HAS_OIF;
+    }
+    if (record.multipath != 0) {
+        route.flags |= RouteRecord::HAS_MULTIPATH;
+        if (ipv6) {
+            route.nexthop_count = static_cast<uint16_t>(record.multipath + 1);
+        }
+    }
+}
+
+EbpfFibSource::~EbpfFibSource() {
+    for (int i = 0; i < 4; ++i) {
+        if (link_fds_[i] >= 0) {
+            close(link_fds_[i]);
+        }
+        if (prog_fds_[i] >= 0) {
+            close(prog_fds_[i]);
+        }
+    }
+    if (rings_map_fd_ >= 0) {
+        close(rings_map_fd_);
+    }
+    if (drops_map_fd_ >= 0) {
+        close(drops_map_fd_);
+    }
+}
+
+std::shared_ptr<EbpfFibSource> EbpfFibSource::acquire(std::string& error) {
+    std::lock_guard<std::mutex> lock(g_source_mutex);
+    std::shared_ptr<EbpfFibSource> source = g_source.lock();
+    if (source) {
+        return source;
+    }
+    source.reset(new EbpfFibSource());
+    if (!source->load(error)) {
+        return nullptr;
+    }
+    g_source = source;
+    return source;
+}
+
+bool EbpfFibSource::load(std::string& error) {
+    KernelBtf btf;
+    if (!btf.load("/sys/kernel/btf/vmlinux", error)) {
+        return false;
+    }
+    FieldOffsets offsets;
+    if (!resolve_offsets(btf, offsets, error)) {
+        return false;
+    }
+
+    // 外层表的值类型由模板环决定，模板本身不接收记录
+    int template_ring = create_ring();
+    if (template_ring < 0) {
+        error = std::string("创建BPF环形缓冲区失败: ") + strerror(errno) + "（需要 CAP_BPF 与 5.8+ 内核）";
+        return false;
+    }
+    rings_map_fd_ = create_map(BPF_MAP_TYPE_HASH_OF_MAPS, sizeof(uint32_t), sizeof(uint32_t), MAX_NAMESPACES,
+                               template_ring, "converge_rings");
+    int saved = errno;
+    close(template_ring);
+    if (rings_map_fd_ < 0) {
+        error = std::string("创建命名空间环形缓冲区表失败: ") + strerror(saved);
+        return false;
+    }
+    drops_map_fd_ = create_map(BPF_MAP_TYPE_HASH, sizeof(uint32_t), sizeof(uint64_t), MAX_NAMESPACES, -1,
+                               "converge_drops");
+    if (drops_map_fd_ < 0) {
+        error = std::string("创建丢弃计数表失败: ") + strerror(errno);
+        return false;
+    }
+
+    struct Target {
+        const char* function;
+        int params;         // 期望的参数个数，参数位置按此签名硬编码
+        bool ipv6;
+        uint8_t op;
+        int rt_arg;
+        int info_arg;
+    };
+    const Target targets[4] = {
+        {"fib_table_insert", 4, false, EbpfFibRecord::OP_ADD, 0, 0},
+        {"fib_table_delete", 4, false, EbpfFibRecord::OP_DEL, 0, 0},
+        {"fib6_add", 4, true, EbpfFibRecord::OP_ADD, 1, 2},
+        {"fib6_del", 2, true, EbpfFibRecord::OP_DEL, 0, 1},
+    };
+    for (int i = 0; i < 4; ++i) {
+        const Target& target = targets[i];
+        uint32_t btf_id = 0;
+        int params = 0;
+        if (!btf.find_function(target.function, btf_id, params)) {
+            error = std::string("内核BTF中找不到函数 ") + target.function;
+            return false;
+        }
+        if (params != target.params) {
+            error = std::string(target.function) + " 的参数个数为 " + std::to_string(params) +
+                    "（期望 " + std::to_string(target.params) + "），不支持此内核版本";
+            return false;
+        }
+        std::vector<struct bpf_insn> program =
+            target.ipv6 ? build_ipv6_program(offsets, target.rt_arg, target.info_arg, params, target.op,
+                                             rings_map_fd_, drops_map_fd_)
+                        : build_ipv4_program(offsets, params, target.op, rings_map_fd_, drops_map_fd_);
+        prog_fds_[i] = load_program(program, btf_id, target.function, error);
+        if (prog_fds_[i] < 0) {
+            return false;
+        }
+        link_fds_[i] = attach_program(prog_fds_[i]);
+        if (link_fds_[i] < 0) {
+            error = std::string("附加 fexit/") + target.function + " 失败: " + strerror(errno) +
+                    "（需要BPF trampoline支持）";
+            return false;
+        }
+        attached_++;
+    }
+    return true;
+}
+
+std::unique_ptr<EbpfRouteRing> EbpfFibSource::open_ring(std::string& error) {
+    struct stat st;
+    if (stat("/proc/thread-self/ns/net", &st) != 0) {
+        error = std::string("无法确定当前网络命名空间: ") + strerror(errno);
+        return nullptr;
+    }
+    uint32_t netns = static_cast<uint32_t>(st.st_ino);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    int ring_fd = create_ring();
+    if (ring_fd < 0) {
+        error = std::string("创建BPF环形缓冲区失败: ") + strerror(errno);
+        return nullptr;
+    }
+
+    union bpf_attr attr;
+    uint64_t zero = 0;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = static_cast<uint32_t>(drops_map_fd_);
+    attr.key = reinterpret_cast<uint64_t>(&netns);
+    attr.value = reinterpret_cast<uint64_t>(&zero);
+    attr.flags = BPF_ANY;
+    if (sys_bpf(BPF_MAP_UPDATE_ELEM, attr) != 0) {
+        error = std::string("注册命名空间丢弃计数失败: ") + strerror(errno);
+        close(ring_fd);
+        return nullptr;
+    }
+
+    uint32_t value = static_cast<uint32_t>(ring_fd);
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = static_cast<uint32_t>(rings_map_fd_);
+    attr.key = reinterpret_cast<uint64_t>(&netns);
+    attr.value = reinterpret_cast<uint64_t>(&value);
+    attr.flags = BPF_NOEXIST;
+    if (sys_bpf(BPF_MAP_UPDATE_ELEM, attr) != 0) {
+        error = errno == EEXIST ? std::string("该网络命名空间已有eBPF路由来源")
+                                : std::string("注册命名空间环形缓冲区失败: ") + strerror(errno);
+        close(ring_fd);
+        return nullptr;
+    }
+
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    void* consumer = mmap(nullptr, page, PROT_READ | PROT_WRITE, MAP_SHARED, ring_fd, 0);
+    void* producer = consumer == MAP_FAILED
+                         ? MAP_FAILED
+                         : mmap(nullptr, page + 2 * RING_BYTES, PROT_READ, MAP_SHARED, ring_fd,
+                                static_cast<off_t>(page));
+    if (producer == MAP_FAILED) {
+        error = std::string("映射BPF环形缓冲区失败: ") + strerror(errno);
+        if (consumer != MAP_FAILED) {
+            munmap(consumer, page);
+        }
+        close_ring_locked(netns);
+        close(ring_fd);
+        return nullptr;
+    }
+    return std::unique_ptr<EbpfRouteRing>(
+        new EbpfRouteRing(shared_from_this(), netns, ring_fd, consumer, producer, RING_BYTES));
+}
+
+void EbpfFibSource::close_ring(uint32_t netns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    close_ring_locked(netns);
+}
+
+void EbpfFibSource::close_ring_locked(uint32_t netns) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = static_cast<uint32_t>(rings_map_fd_);
+    attr.key = reinterpret_cast<uint64_t>(&netns);
+    sys_bpf(BPF_MAP_DELETE_ELEM, attr);
+    attr.map_fd = static_cast<uint32_t>(drops_map_fd_);
+    sys_bpf(BPF_MAP_DELETE_ELEM, attr);
+}
+
+int64_t EbpfFibSource::read_drops(uint32_t netns) const {
+    uint64_t value = 0;
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = static_cast<uint32_t>(drops_map_fd_);
+    attr.key = reinterpret_cast<uint64_t>(&netns);
+    attr.value = reinterpret_cast<uint64_t>(&value);
+    if (sys_bpf(BPF_MAP_LOOKUP_ELEM, attr) != 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(value);
+}
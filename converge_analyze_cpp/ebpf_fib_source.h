@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "event_records.h"
+
+// eBPF路由事件来源（--source ebpf）
+//
+// rtnetlink通知是异步投递的，路由风暴中可能因接收队列溢出而丢失（只能整表重新同步）。
+// 本来源在内核FIB插入/删除函数返回时（fexit: fib_table_insert、fib_table_delete、fib6_add、fib6_del，
+// 仅成功的修改）取得路由属性与内核单调时钟时间戳，以定长记录经BPF环形缓冲区交给监控线程，
+// 转换为 RouteRecord 后走与netlink通知相同的处理流程。
+//
+// 进程只加载一套程序，覆盖主机上的所有网络命名空间：程序按命名空间inode在 HASH_OF_MAPS 中
+// 查找该命名空间的环形缓冲区（每个监控器一个），没有监控器的命名空间直接返回。
+// 程序由用户态逐条汇编（不依赖libbpf和clang），结构体字段偏移在加载时从
+// /sys/kernel/btf/vmlinux 读取，不同内核版本无需重新编译。
+//
+// 需要 CAP_BPF/CAP_PERFMON（或root）、内核BTF与BPF trampoline（5.5+，环形缓冲区5.8+）。
+// QDisc、链路与下一跳对象事件仍来自rtnetlink（内核没有对应的tracepoint）。
+//
+// 与内核内容一致的定长记录（BPF程序在栈上按此布局填写）
+struct EbpfFibRecord {
+    uint64_t timestamp_ns;      // bpf_ktime_get_ns()，即 CLOCK_MONOTONIC
+    uint64_t multipath;         // IPv4: RTA_MULTIPATH 长度 fib_config.fc_mp_len；IPv6: 同级路由数 fib6_nsiblings
+    uint32_t netns;             // 网络命名空间inode
+    uint32_t table;
+    int32_t oif;
+    uint32_t priority;
+    uint32_t nh_id;
+    uint8_t op;                 // OP_ADD / OP_DEL
+    uint8_t family;
+    uint8_t dst_len;            // IPv4
+    uint8_t protocol;
+    uint8_t scope;
+    uint8_t type;
+    uint8_t gateway_family;
+    uint8_t reserved;
+    uint32_t prefix_len;        // IPv6（rt6key.plen）
+    uint8_t dst[16];
+    uint8_t gateway[16];
+    uint8_t prefsrc[16];
+
+    static constexpr uint8_t OP_ADD = 1;
+    static constexpr uint8_t OP_DEL = 2;
+};
+static_assert(sizeof(EbpfFibRecord) == 96, "EbpfFibRecord 与BPF程序的栈布局不一致");
+
+class EbpfFibSource;
+
+// 一个网络命名空间的接收环（监控线程独占）
+class EbpfRouteRing {
+public:
+    ~EbpfRouteRing();
+
+    EbpfRouteRing(const EbpfRouteRing&) = delete;
+    EbpfRouteRing& operator=(const EbpfRouteRing&) = delete;
+
+    // 可读时就绪的描述符，加入监控线程的epoll
+    int fd() const { return ring_fd_; }
+    uint32_t netns() const { return netns_; }
+
+    // 取出环中全部记录，逐条转换为 RouteRecord 回调；返回处理的记录数
+    template <typename F>
+    size_t drain(F&& fn) {
+        size_t count = 0;
+        EbpfFibRecord record;
+        while (next(record)) {
+            RouteRecord route;
+            to_route_record(record, route);
+            fn(route);
+            count++;
+        }
+        return count;
+    }
+
+    // 环满时内核丢弃的记录数（累计）
+    int64_t dropped() const;
+
+    static void to_route_record(const EbpfFibRecord& record, RouteRecord& route);
+
+private:
+    friend class EbpfFibSource;
+    EbpfRouteRing(std::shared_ptr<EbpfFibSource> source, uint32_t netns, int ring_fd,
+                  void* consumer, void* producer, size_t size);
+
+    bool next(EbpfFibRecord& record);
+
+    std::shared_ptr<EbpfFibSource> source_;
+    uint32_t netns_;
+    int ring_fd_;
+    void* consumer_page_;
+    void* producer_pages_;
+    size_t size_;
+    const char* data_;
+};
+
+class EbpfFibSource : public std::enable_shared_from_this<EbpfFibSource> {
+public:
+    // 每个命名空间的环形缓冲区大小
+    static constexpr size_t RING_BYTES = 1 << 20;
+    // 可同时注册的命名空间数
+    static constexpr uint32_t MAX_NAMESPACES = 4096;
+
+    ~EbpfFibSource();
+
+    EbpfFibSource(const EbpfFibSource&) = delete;
+    EbpfFibSource& operator=(const EbpfFibSource&) = delete;
+
+    // 进程共享的实例：第一次调用时加载并附加程序，之后的监控器复用；失败时返回nullptr并设置error
+    static std::shared_ptr<EbpfFibSource> acquire(std::string& error);
+
+    // 为调用线程当前所在的网络命名空间创建接收环（多命名空间模式在 setns 之后调用）
+    std::unique_ptr<EbpfRouteRing> open_ring(std::string& error);
+
+    // 已附加的程序数（IPv4/IPv6 插入与删除）
+    int attached_programs() const { return attached_; }
+
+private:
+    friend class EbpfRouteRing;
+    EbpfFibSource() = default;
+
+    bool load(std::string& error);
+    void close_ring(uint32_t netns);
+    void close_ring_locked(uint32_t netns);
+    int64_t read_drops(uint32_t netns) const;
+
+    int rings_map_fd_{-1};
+    int drops_map_fd_{-1};
+    int prog_fds_[4]{-1, -1, -1, -1};
+    int link_fds_[4]{-1, -1, -1, -1};
+    int attached_{0};
+    std::mutex mutex_;
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 定长内存块池：会话事件按块分配，会话结束时整体归还，下一会话直接复用，
+// 避免路由风暴中 vector 反复扩容拷贝以及长时间运行后的堆碎片。
+// 池中保留的空闲块数有上限，超过部分立即释放给系统。
+class EventSlabPool {
+public:
+    static constexpr size_t SLAB_BYTES = 64 * 1024;
+
+    explicit EventSlabPool(size_t max_free_slabs = 64) : max_free_slabs_(max_free_slabs) {}
+
+    ~EventSlabPool() {
+        for (void* slab : free_slabs_) {
+            ::operator delete(slab);
+        }
+    }
+
+    EventSlabPool(const EventSlabPool&) = delete;
+    EventSlabPool& operator=(const EventSlabPool&) = delete;
+
+    void* acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            in_use_++;
+            if (!free_slabs_.empty()) {
+                void* slab = free_slabs_.back();
+                free_slabs_.pop_back();
+                return slab;
+            }
+        }
+        return ::operator new(SLAB_BYTES);
+    }
+
+    // 预先分配并写入 count 个空闲块（不超过空闲块上限），首次使用时不再缺页；返回新分配的字节数
+    size_t prefill(size_t count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t target = std::min(count, max_free_slabs_);
+        free_slabs_.reserve(max_free_slabs_);
+        size_t bytes = 0;
+        while (free_slabs_.size() < target) {
+            void* slab = ::operator new(SLAB_BYTES);
+            memset(slab, 0, SLAB_BYTES);
+            free_slabs_.push_back(slab);
+            bytes += SLAB_BYTES;
+        }
+        return bytes;
+    }
+
+    void release(void* slab) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            in_use_--;
+            if (free_slabs_.size() < max_free_slabs_) {
+                free_slabs_.push_back(slab);
+                return;
+            }
+        }
+        ::operator delete(slab);
+    }
+
+    // 正在使用的块数与池中空闲块数
+    size_t slabs_in_use() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return in_use_;
+    }
+    size_t free_slab_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return free_slabs_.size();
+    }
+
+private:
+    size_t max_free_slabs_;
+    std::vector<void*> free_slabs_;
+    size_t in_use_{0};
+    mutable std::mutex mutex_;
+};
+
+// 追加式事件存储：元素放在池分配的块中，不移动、不逐个释放，clear() 时整块归还。
+// 只支持可平凡析构的定长记录。
+template <typename T>
+class EventArena {
+    static_assert(std::is_trivially_destructible<T>::value, "EventArena 只存放定长POD记录");
+    static_assert(sizeof(T) <= EventSlabPool::SLAB_BYTES, "记录大于内存块");
+
+public:
+    static constexpr size_t PER_SLAB = EventSlabPool::SLAB_BYTES / sizeof(T);
+
+    explicit EventArena(EventSlabPool* pool) : pool_(pool) {}
+    ~EventArena() { clear(); }
+
+    EventArena(const EventArena&) = delete;
+    EventArena& operator=(const EventArena&) = delete;
+
+    // 池为空时不存储（只计数）
+    bool enabled() const { return pool_ != nullptr; }
+
+    template <typename... Args>
+    void emplace_back(Args&&... args) {
+        if (!pool_) {
+            return;
+        }
+        if (size_ % PER_SLAB == 0) {
+            slabs_.push_back(static_cast<T*>(pool_->acquire()));
+        }
+        new (slabs_.back() + size_ % PER_SLAB) T(std::forward<Args>(args)...);
+        size_++;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    const T& operator[](size_t index) const { return slabs_[index / PER_SLAB][index % PER_SLAB]; }
+
+    template <typename F>
+    void for_each(F&& fn) const {
+        for (size_t i = 0; i < size_; ++i) {
+            fn((*this)[i]);
+        }
+    }
+
+    // 归还全部内存块
+    void clear() {
+        for (T* slab : slabs_) {
+            pool_->release(slab);
+        }
+        slabs_.clear();
+        slabs_.shrink_to_fit();
+        size_ = 0;
+    }
+
+    size_t memory_bytes() const { return slabs_.size() * EventSlabPool::SLAB_BYTES; }
+
+private:
+    EventSlabPool* pool_;
+    std::vector<T*> slabs_;
+    size_t size_{0};
+};
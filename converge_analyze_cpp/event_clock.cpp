@@ -0,0 +1,90 @@
+#include "event_clock.h"
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+struct WallClockAnchor {
+    int64_t monotonic_ns;
+    int64_t realtime_ns;
+
+    WallClockAnchor() {
+        struct timespec mono, real;
+        clock_gettime(CLOCK_MONOTONIC, &mono);
+        clock_gettime(CLOCK_REALTIME, &real);
+        monotonic_ns = EventClock::to_ns(mono);
+        realtime_ns = EventClock::to_ns(real);
+    }
+};
+
+WallClockAnchor& anchor() {
+    static WallClockAnchor instance;
+    return instance;
+}
+
+// 静态初始化阶段即记录锚点
+[[maybe_unused]] const WallClockAnchor& startup_anchor = anchor();
+
+} // namespace
+
+namespace EventClock {
+
+int64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return to_ns(ts);
+}
+
+int64_t to_wall_ms(int64_t mono_ns) {
+    const WallClockAnchor& a = anchor();
+    return (a.realtime_ns + (mono_ns - a.monotonic_ns)) / NS_PER_MS;
+}
+
+int64_t to_wall_us(int64_t mono_ns) {
+    const WallClockAnchor& a = anchor();
+    return (a.realtime_ns + (mono_ns - a.monotonic_ns)) / NS_PER_US;
+}
+
+void wall_anchor(int64_t& realtime_ns, int64_t& monotonic_ns) {
+    const WallClockAnchor& a = anchor();
+    realtime_ns = a.realtime_ns;
+    monotonic_ns = a.monotonic_ns;
+}
+
+void set_wall_anchor(int64_t realtime_ns, int64_t monotonic_ns) {
+    WallClockAnchor& a = anchor();
+    a.realtime_ns = realtime_ns;
+    a.monotonic_ns = monotonic_ns;
+}
+
+bool host_clock_identity(std::string& boot_id, int64_t& timens_offset_ns) {
+    std::ifstream boot_file("/proc/sys/kernel/random/boot_id");
+    if (!std::getline(boot_file, boot_id) || boot_id.empty()) {
+        return false;
+    }
+
+    // 不支持时间命名空间的内核没有该文件，偏移为0
+    timens_offset_ns = 0;
+    std::ifstream offsets_file("/proc/self/timens_offsets");
+    std::string line;
+    while (std::getline(offsets_file, line)) {
+        std::istringstream fields(line);
+        std::string clock;
+        int64_t seconds = 0;
+        int64_t nanoseconds = 0;
+        if (fields >> clock >> seconds >> nanoseconds && clock == "monotonic") {
+            timens_offset_ns = seconds * NS_PER_SEC + nanoseconds;
+        }
+    }
+    return true;
+}
+
+int64_t realtime_to_monotonic_ns(const struct timespec& realtime) {
+    // 使用当前两个时钟的差值换算，转换发生在接收后立即进行
+    struct timespec mono, real;
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    clock_gettime(CLOCK_REALTIME, &real);
+    return to_ns(realtime) - (to_ns(real) - to_ns(mono));
+}
+
+} // namespace EventClock
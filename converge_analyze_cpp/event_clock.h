@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+// 测量时钟：会话与事件的时间一律使用 CLOCK_MONOTONIC 纳秒，不受NTP步进影响。
+// 墙上时间只用于日志输出，由进程启动时记录的锚点换算得到。
+namespace EventClock {
+    constexpr int64_t NS_PER_US = 1000;
+    constexpr int64_t NS_PER_MS = 1000000;
+    constexpr int64_t NS_PER_SEC = 1000000000;
+
+    // 当前单调时间（纳秒）
+    int64_t monotonic_ns();
+
+    // 单调时间换算为墙上时间（Unix毫秒），基于启动时的锚点
+    int64_t to_wall_ms(int64_t monotonic_ns);
+
+    // 单调时间换算为墙上时间（Unix微秒），用于跨路由器关联
+    int64_t to_wall_us(int64_t monotonic_ns);
+
+    // 启动时记录的时钟锚点（二进制日志头中保存，供离线换算墙上时间）
+    void wall_anchor(int64_t& realtime_ns, int64_t& monotonic_ns);
+
+    // 回放抓包时改用录制时的锚点，日志中的事件墙上时间与原始运行一致（须在其他线程启动前调用）
+    void set_wall_anchor(int64_t realtime_ns, int64_t monotonic_ns);
+
+    // 单调时钟的来源标识：同一内核（boot_id相同）上的进程共享 CLOCK_MONOTONIC，
+    // 时间命名空间中的进程另有偏移（/proc/self/timens_offsets，宿主单调时间 = 本地 - 偏移）。
+    // 离线关联时据此把同一主机上各路由器的事件放到同一条单调时间轴上，不受各自墙上时钟的误差影响
+    bool host_clock_identity(std::string& boot_id, int64_t& timens_offset_ns);
+
+    // 内核 CLOCK_REALTIME 时间戳（如SCM_TIMESTAMPNS）换算为单调时间
+    int64_t realtime_to_monotonic_ns(const struct timespec& realtime);
+
+    inline int64_t to_ns(const struct timespec& ts) {
+        return static_cast<int64_t>(ts.tv_sec) * NS_PER_SEC + ts.tv_nsec;
+    }
+}
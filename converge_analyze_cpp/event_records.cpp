@@ -0,0 +1,307 @@
+#include "event_records.h"
+#include "interface_cache.h"
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/rtnetlink.h>
+#include <linux/if.h>
+
+namespace {
+
+void append_pair(std::string& out, bool& first, const char* key, const std::string& value) {
+    if (!first) {
+        out += ',';
+    }
+    first = false;
+    out += '"';
+    out += key;
+    out += "\":\"";
+    out += value;
+    out += '"';
+}
+
+const char* qdisc_message_name(uint16_t nlmsg_type) {
+    switch (nlmsg_type) {
+        case RTM_NEWQDISC: return "QDISC_ADD";
+        case RTM_DELQDISC: return "QDISC_DEL";
+        case RTM_GETQDISC: return "QDISC_GET";
+        default: return "UNKNOWN";
+    }
+}
+
+const char* link_operstate_name(uint8_t operstate) {
+    switch (operstate) {
+        case IF_OPER_NOTPRESENT: return "notpresent";
+        case IF_OPER_DOWN: return "down";
+        case IF_OPER_LOWERLAYERDOWN: return "lowerlayerdown";
+        case IF_OPER_TESTING: return "testing";
+        case IF_OPER_DORMANT: return "dormant";
+        case IF_OPER_UP: return "up";
+        default: return "unknown";
+    }
+}
+
+struct ProtocolName {
+    const char* name;
+    int value;
+};
+
+// 常用路由协议，编号与 linux/rtnetlink.h 中的 RTPROT_* 一致
+constexpr ProtocolName PROTOCOL_NAMES[] = {
+    {"unspec", 0},
+    {"redirect", 1},
+    {"kernel", 2},
+    {"boot", 3},
+    {"static", 4},
+    {"ra", 9},
+    {"zebra", 11},
+    {"bird", 12},
+    {"dhcp", 16},
+    {"keepalived", 18},
+    {"babel", 42},
+    {"openr", 99},
+    {"bgp", 186},
+    {"isis", 187},
+    {"ospf", 188},
+    {"rip", 189},
+    {"eigrp", 192},
+};
+
+} // namespace
+
+namespace EventFormat {
+
+std::string address(const struct in6_addr& addr, int family) {
+    char str[INET6_ADDRSTRLEN];
+    if ((family == AF_INET || family == AF_INET6) && inet_ntop(family, &addr, str, sizeof(str))) {
+        return std::string(str);
+    }
+    return "N/A";
+}
+
+std::string interface_name(int ifindex) {
+    char ifname[IF_NAMESIZE];
+    const InterfaceCache& cache = InterfaceCache::current();
+    if (cache.lookup(ifindex, ifname)) {
+        return std::string(ifname);
+    }
+
+    // 缓存未填充（例如未启动监控的工具）或接口未知时回退到系统调用；
+    // 其他命名空间的接口不能按本命名空间的 ifindex 查询
+    if (&cache == &InterfaceCache::instance() && if_indextoname(ifindex, ifname)) {
+        return std::string(ifname);
+    }
+    return "if" + std::to_string(ifindex);
+}
+
+std::string route_table_name(int table) {
+    switch (table) {
+        case RT_TABLE_UNSPEC: return "unspec";
+        case RT_TABLE_COMPAT: return "compat";
+        case RT_TABLE_DEFAULT: return "default";
+        case RT_TABLE_MAIN: return "main";
+        case RT_TABLE_LOCAL: return "local";
+        default: return std::to_string(table);
+    }
+}
+
+std::string route_protocol_name(int protocol) {
+    const char* name = protocol_to_name(protocol);
+    return name ? std::string(name) : std::to_string(protocol);
+}
+
+std::string route_scope_name(int scope) {
+    switch (scope) {
+        case RT_SCOPE_UNIVERSE: return "universe";
+        case RT_SCOPE_SITE: return "site";
+        case RT_SCOPE_LINK: return "link";
+        case RT_SCOPE_HOST: return "host";
+        case RT_SCOPE_NOWHERE: return "nowhere";
+        default: return std::to_string(scope);
+    }
+}
+
+std::string route_type_name(int type) {
+    switch (type) {
+        case RTN_UNSPEC: return "unspec";
+        case RTN_UNICAST: return "unicast";
+        case RTN_LOCAL: return "local";
+        case RTN_BROADCAST: return "broadcast";
+        case RTN_ANYCAST: return "anycast";
+        case RTN_MULTICAST: return "multicast";
+        case RTN_BLACKHOLE: return "blackhole";
+        case RTN_UNREACHABLE: return "unreachable";
+        case RTN_PROHIBIT: return "prohibit";
+        default: return std::to_string(type);
+    }
+}
+
+int protocol_from_name(const std::string& name) {
+    for (const auto& entry : PROTOCOL_NAMES) {
+        if (name == entry.name) {
+            return entry.value;
+        }
+    }
+    return -1;
+}
+
+const char* protocol_to_name(int protocol) {
+    for (const auto& entry : PROTOCOL_NAMES) {
+        if (protocol == entry.value) {
+            return entry.name;
+        }
+    }
+    return nullptr;
+}
+
+std::string event_label(const EventRecord& event) {
+    if (event.cls == EventRecord::QDISC) {
+        return std::string("Netem事件(") + qdisc_message_name(event.qdisc.nlmsg_type) + ")";
+    }
+    if (event.cls == EventRecord::LINK) {
+        return event.link.up ? "链路UP" : "链路DOWN";
+    }
+    if (event.cls == EventRecord::NEXTHOP) {
+        return event.nexthop.nlmsg_type == RTM_DELNEXTHOP ? "下一跳删除" : "下一跳更新";
+    }
+    return event.route.nlmsg_type == RTM_DELROUTE ? "路由删除" : "路由添加";
+}
+
+std::string trigger_event_type(const EventRecord& event) {
+    if (event.cls == EventRecord::QDISC) {
+        return qdisc_message_name(event.qdisc.nlmsg_type);
+    }
+    return event_label(event);
+}
+
+const char* route_change_name(uint8_t change) {
+    switch (change) {
+        case RouteRecord::CHANGE_NEW: return "new";
+        case RouteRecord::CHANGE_MODIFIED: return "changed";
+        case RouteRecord::CHANGE_NOOP: return "noop";
+        case RouteRecord::CHANGE_REMOVED: return "removed";
+        default: return nullptr;
+    }
+}
+
+std::string interface_name(const EventRecord& event) {
+    if (event.cls == EventRecord::ROUTE && !event.route.has(RouteRecord::HAS_OIF)) {
+        return "N/A";
+    }
+    if (event.cls == EventRecord::NEXTHOP && !event.nexthop.has(NexthopRecord::HAS_OIF)) {
+        return "N/A";
+    }
+    if (event.cls == EventRecord::LINK && event.link.name[0]) {
+        return std::string(event.link.name);
+    }
+    return interface_name(event.ifindex());
+}
+
+void append_event_info(std::string& out, const EventRecord& event) {
+    append_event_info(out, event, interface_name(event));
+}
+
+void append_event_info(std::string& out, const EventRecord& event, const std::string& interface) {
+    bool first = true;
+    out += '{';
+
+    if (event.cls == EventRecord::QDISC) {
+        const QdiscRecord& q = event.qdisc;
+        append_pair(out, first, "ifindex", std::to_string(q.ifindex));
+        append_pair(out, first, "interface", interface);
+        append_pair(out, first, "handle", std::to_string(q.handle));
+        append_pair(out, first, "parent", std::to_string(q.parent));
+        append_pair(out, first, "family", std::to_string(q.family));
+        append_pair(out, first, "kind", q.kind[0] ? std::string(q.kind) : "unknown");
+        append_pair(out, first, "is_netem", q.is_netem() ? "true" : "false");
+    } else if (event.cls == EventRecord::LINK) {
+        const LinkRecord& l = event.link;
+        append_pair(out, first, "ifindex", std::to_string(l.ifindex));
+        append_pair(out, first, "interface", interface);
+        append_pair(out, first, "state", l.up ? "up" : "down");
+        append_pair(out, first, "operstate", link_operstate_name(l.operstate));
+        append_pair(out, first, "flags", std::to_string(l.flags));
+        append_pair(out, first, "deleted", l.nlmsg_type == RTM_DELLINK ? "true" : "false");
+    } else if (event.cls == EventRecord::NEXTHOP) {
+        const NexthopRecord& n = event.nexthop;
+        append_pair(out, first, "nh_id", std::to_string(n.id));
+        append_pair(out, first, "family", std::to_string(n.family));
+        append_pair(out, first, "protocol", route_protocol_name(n.protocol));
+        if (n.has(NexthopRecord::IS_GROUP)) {
+            append_pair(out, first, "kind", "group");
+            append_pair(out, first, "group_size", std::to_string(n.group_size));
+        } else {
+            append_pair(out, first, "kind", n.has(NexthopRecord::BLACKHOLE) ? "blackhole" : "single");
+            append_pair(out, first, "gateway",
+                        n.has(NexthopRecord::HAS_GATEWAY) ? address(n.gateway, n.family) : "N/A");
+            append_pair(out, first, "interface", interface);
+        }
+        append_pair(out, first, "deleted", n.nlmsg_type == RTM_DELNEXTHOP ? "true" : "false");
+        if (const char* change = route_change_name(n.change)) {
+            append_pair(out, first, "change", change);
+        }
+    } else {
+        const RouteRecord& r = event.route;
+        append_pair(out, first, "family", std::to_string(r.family));
+        append_pair(out, first, "table", std::to_string(r.table));
+        append_pair(out, first, "protocol", route_protocol_name(r.protocol));
+        append_pair(out, first, "scope", route_scope_name(r.scope));
+        append_pair(out, first, "type", route_type_name(r.type));
+        append_pair(out, first, "dst", r.has(RouteRecord::HAS_DST) ? address(r.dst, r.family) : "default");
+        append_pair(out, first, "dst_len", std::to_string(r.dst_len));
+        append_pair(out, first, "gateway",
+                    r.has(RouteRecord::HAS_GATEWAY) ? address(r.gateway, r.family) : "N/A");
+        append_pair(out, first, "interface", interface);
+        if (r.has(RouteRecord::HAS_OIF)) {
+            append_pair(out, first, "ifindex", std::to_string(r.ifindex));
+        }
+        if (r.has(RouteRecord::HAS_PREFSRC)) {
+            append_pair(out, first, "prefsrc", address(r.prefsrc, r.family));
+        }
+        if (r.has(RouteRecord::HAS_PRIORITY)) {
+            append_pair(out, first, "priority", std::to_string(r.priority));
+        }
+        if (r.has(RouteRecord::HAS_MULTIPATH)) {
+            append_pair(out, first, "nexthops", std::to_string(r.nexthop_count));
+        }
+        if (r.has(RouteRecord::HAS_NH_ID)) {
+            append_pair(out, first, "nh_id", std::to_string(r.nh_id));
+        }
+        if (const char* change = route_change_name(r.change)) {
+            append_pair(out, first, "change", change);
+        }
+    }
+
+    out += '}';
+}
+
+void append_trigger_info(std::string& out, const TriggerRecord& trigger) {
+    if (trigger.event.cls == EventRecord::LINK) {
+        // 链路触发只记录关键字段
+        const LinkRecord& l = trigger.event.link;
+        bool first = true;
+        out += '{';
+        append_pair(out, first, "type", l.up ? "link_up" : "link_down");
+        append_pair(out, first, "interface", interface_name(trigger.event));
+        append_pair(out, first, "ifindex", std::to_string(l.ifindex));
+        out += '}';
+        return;
+    }
+
+    if (trigger.source == TriggerRecord::NETEM || trigger.event.cls != EventRecord::ROUTE) {
+        append_event_info(out, trigger.event);
+        return;
+    }
+
+    // 路由触发只记录关键字段
+    const RouteRecord& r = trigger.event.route;
+    bool first = true;
+    out += '{';
+    append_pair(out, first, "type", r.nlmsg_type == RTM_DELROUTE ? "route_del" : "route_add");
+    append_pair(out, first, "dst", r.has(RouteRecord::HAS_DST) ? address(r.dst, r.family) : "default");
+    append_pair(out, first, "dst_len", std::to_string(r.dst_len));
+    append_pair(out, first, "interface", interface_name(trigger.event));
+    append_pair(out, first, "gateway", r.has(RouteRecord::HAS_GATEWAY) ? address(r.gateway, r.family) : "N/A");
+    out += '}';
+}
+
+} // namespace EventFormat
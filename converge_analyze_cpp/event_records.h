@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <netinet/in.h>
+
+// 紧凑的定长事件记录：热路径上只传递这些POD结构，不做任何堆分配。
+// 地址以二进制形式保存，字符串转换只在日志输出阶段进行。
+
+// 路由记录（RTM_NEWROUTE / RTM_DELROUTE）
+struct RouteRecord {
+    enum Flags : uint8_t {
+        HAS_DST = 1 << 0,
+        HAS_GATEWAY = 1 << 1,
+        HAS_PREFSRC = 1 << 2,
+        HAS_OIF = 1 << 3,
+        HAS_PRIORITY = 1 << 4,
+        HAS_MULTIPATH = 1 << 5,     // RTA_MULTIPATH：gateway/ifindex 为第一个下一跳
+        HAS_NH_ID = 1 << 6,         // RTA_NH_ID：转发由下一跳对象决定
+    };
+
+    // 与FIB镜像比较的结果（未启用镜像时为 CHANGE_UNKNOWN）
+    enum Change : uint8_t {
+        CHANGE_UNKNOWN,
+        CHANGE_NEW,         // 镜像中不存在的路由
+        CHANGE_MODIFIED,    // 下一跳、出接口等属性发生变化
+        CHANGE_NOOP,        // 属性完全相同的重复通知（替换或刷新）
+        CHANGE_REMOVED      // 删除
+    };
+
+    int64_t timestamp;
+    uint16_t nlmsg_type;
+    uint8_t family;
+    uint8_t dst_len;
+    uint8_t protocol;
+    uint8_t scope;
+    uint8_t type;
+    uint8_t flags;
+    uint8_t change;
+    uint16_t nexthop_count;     // RTA_MULTIPATH 中的下一跳数（单路径为0）
+    uint32_t table;
+    int32_t ifindex;
+    uint32_t priority;
+    uint32_t nh_id;             // RTA_NH_ID
+    uint32_t nexthop_hash;      // 全部下一跳（网关、接口、权重）的摘要，用于判断多路径是否变化
+    struct in6_addr dst;
+    struct in6_addr gateway;
+    struct in6_addr prefsrc;
+
+    bool has(Flags flag) const { return (flags & flag) != 0; }
+};
+
+// QDisc记录（RTM_NEWQDISC / RTM_DELQDISC / RTM_GETQDISC）
+struct QdiscRecord {
+    static constexpr size_t KIND_SIZE = 16;
+
+    int64_t timestamp;
+    uint16_t nlmsg_type;
+    uint8_t family;
+    int32_t ifindex;
+    uint32_t handle;
+    uint32_t parent;
+    char kind[KIND_SIZE];
+
+    bool is_netem() const { return strcmp(kind, "netem") == 0; }
+    bool is_noqueue() const { return strcmp(kind, "noqueue") == 0; }
+};
+
+// 链路状态变化记录（RTM_NEWLINK / RTM_DELLINK 中 IFF_UP|IFF_RUNNING 的变化）
+struct LinkRecord {
+    static constexpr size_t NAME_SIZE = 16;
+
+    int64_t timestamp;
+    uint16_t nlmsg_type;
+    uint8_t up;             // 变化后的状态：管理UP且运行中
+    uint8_t operstate;      // IFLA_OPERSTATE
+    int32_t ifindex;
+    uint32_t flags;         // ifi_flags
+    char name[NAME_SIZE];
+};
+
+// 下一跳对象记录（RTM_NEWNEXTHOP / RTM_DELNEXTHOP）：一个下一跳组的更新对引用它的所有路由生效，
+// 内核不再为这些路由逐条发送路由通知
+struct NexthopRecord {
+    enum Flags : uint8_t {
+        HAS_GATEWAY = 1 << 0,
+        HAS_OIF = 1 << 1,
+        IS_GROUP = 1 << 2,          // NHA_GROUP：引用其他下一跳对象的组
+        BLACKHOLE = 1 << 3,
+    };
+
+    int64_t timestamp;
+    uint16_t nlmsg_type;
+    uint8_t family;
+    uint8_t flags;
+    uint8_t protocol;
+    uint8_t change;             // 与FIB镜像比较的结果（RouteRecord::Change）
+    uint16_t group_size;        // 组内成员数
+    uint32_t id;
+    int32_t ifindex;
+    uint32_t group_hash;        // 组成员（编号、权重）的摘要
+    struct in6_addr gateway;
+
+    bool has(Flags flag) const { return (flags & flag) != 0; }
+};
+
+// 会话内事件：路由消息、QDisc消息、链路状态变化或下一跳对象变化
+struct EventRecord {
+    enum Class : uint8_t {
+        ROUTE,
+        QDISC,
+        LINK,
+        NEXTHOP
+    };
+
+    Class cls;
+    union {
+        RouteRecord route;
+        QdiscRecord qdisc;
+        LinkRecord link;
+        NexthopRecord nexthop;
+    };
+
+    EventRecord() : cls(ROUTE) { memset(&route, 0, sizeof(route)); }
+    explicit EventRecord(const RouteRecord& r) : cls(ROUTE), route(r) {}
+    explicit EventRecord(const QdiscRecord& q) : cls(QDISC), qdisc(q) {}
+    explicit EventRecord(const LinkRecord& l) : cls(LINK), link(l) {}
+    explicit EventRecord(const NexthopRecord& n) : cls(NEXTHOP), nexthop(n) {}
+
+    int64_t timestamp() const {
+        switch (cls) {
+            case QDISC: return qdisc.timestamp;
+            case LINK: return link.timestamp;
+            case NEXTHOP: return nexthop.timestamp;
+            default: return route.timestamp;
+        }
+    }
+    int32_t ifindex() const {
+        switch (cls) {
+            case QDISC: return qdisc.ifindex;
+            case LINK: return link.ifindex;
+            case NEXTHOP: return nexthop.ifindex;
+            default: return route.ifindex;
+        }
+    }
+};
+
+// 会话触发记录：trigger_source 为 "netem" 时使用qdisc，"route" 时使用route，"link" 时使用link，
+// "nexthop" 时使用nexthop
+struct TriggerRecord {
+    enum Source : uint8_t {
+        NETEM,
+        ROUTE,
+        LINK,
+        NEXTHOP
+    };
+
+    Source source;
+    EventRecord event;
+
+    TriggerRecord() : source(ROUTE) {}
+    TriggerRecord(Source s, const EventRecord& e) : source(s), event(e) {}
+
+    const char* source_name() const {
+        switch (source) {
+            case NETEM: return "netem";
+            case LINK: return "link";
+            case NEXTHOP: return "nexthop";
+            default: return "route";
+        }
+    }
+};
+
+// 输出阶段的格式化辅助函数
+namespace EventFormat {
+    // 地址转换为文本，family为AF_INET或AF_INET6
+    std::string address(const struct in6_addr& addr, int family);
+
+    // 事件类型的可读标签（"路由添加"、"Netem事件(QDISC_ADD)"、"链路DOWN" 等）
+    std::string event_label(const EventRecord& event);
+
+    // 触发事件类型（session_started 的 trigger_event_type）：QDisc为消息类型名 "QDISC_ADD" 等，
+    // 其余与 event_label 相同
+    std::string trigger_event_type(const EventRecord& event);
+
+    // 以 {"key":"value",...} 形式追加事件信息，与历史日志中的route_info格式一致
+    void append_event_info(std::string& out, const EventRecord& event);
+
+    // 同上，接口名称由调用者给出（二进制日志解码时不查询本机接口）
+    void append_event_info(std::string& out, const EventRecord& event, const std::string& interface);
+
+    // 触发信息，与历史日志中的trigger_info / netem_info格式一致
+    void append_trigger_info(std::string& out, const TriggerRecord& trigger);
+
+    // FIB镜像分类的名称："new"、"changed"、"noop"、"removed"（未分类时返回nullptr）
+    const char* route_change_name(uint8_t change);
+
+    // 事件关联的接口名称（无接口时返回"N/A"）
+    std::string interface_name(const EventRecord& event);
+
+    // 按 ifindex 查询接口名称：优先查询接口缓存，未命中时回退到 if_indextoname
+    std::string interface_name(int ifindex);
+
+    // 路由属性的可读名称（未知取值输出数字）
+    std::string route_table_name(int table);
+    std::string route_protocol_name(int protocol);
+    std::string route_scope_name(int scope);
+    std::string route_type_name(int type);
+
+    // 路由协议名称与编号的互相转换（未知名称返回-1，未知编号返回nullptr）
+    int protocol_from_name(const std::string& name);
+    const char* protocol_to_name(int protocol);
+}
@@ -0,0 +1,399 @@
+#include "exporter.h"
+#include "event_clock.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <netdb.h>
+#include <stdexcept>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int64_t RECONNECT_MIN_NS = 100 * EventClock::NS_PER_MS;
+constexpr int64_t RECONNECT_MAX_NS = 5 * EventClock::NS_PER_SEC;
+// 超过UDP负载上限的单条记录无法发送
+constexpr size_t DATAGRAM_MAX = 65507;
+
+int64_t count_records(const char* begin, const char* end) {
+    return std::count(begin, end, '\n');
+}
+
+bool parse_host_port(const std::string& rest, std::string& host, std::string& port) {
+    size_t colon;
+    if (!rest.empty() && rest[0] == '[') {
+        size_t close = rest.find(']');
+        if (close == std::string::npos || close + 1 >= rest.size() || rest[close + 1] != ':') {
+            return false;
+        }
+        host = rest.substr(1, close - 1);
+        colon = close + 1;
+    } else {
+        colon = rest.rfind(':');
+        if (colon == std::string::npos) {
+            return false;
+        }
+        host = rest.substr(0, colon);
+    }
+    port = rest.substr(colon + 1);
+    if (host.empty() || port.empty() || port.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    int value = std::stoi(port);
+    return value > 0 && value <= 65535;
+}
+
+} // namespace
+
+bool ExportEndpoint::parse(const std::string& address, ExportEndpoint& endpoint, std::string& error) {
+    endpoint = ExportEndpoint();
+    endpoint.description = address;
+
+    if (address.compare(0, 5, "unix:") == 0) {
+        std::string path = address.substr(5);
+        if (path.compare(0, 2, "//") == 0) {
+            path = path.substr(2);
+        }
+        sockaddr_un un{};
+        if (path.empty() || path.size() >= sizeof(un.sun_path)) {
+            error = "无效的Unix套接字路径: " + address;
+            return false;
+        }
+        un.sun_family = AF_UNIX;
+        memcpy(un.sun_path, path.data(), path.size());
+        endpoint.addr_len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size());
+        if (path[0] == '@') {
+            // 抽象命名空间
+            un.sun_path[0] = '\0';
+        } else {
+            endpoint.addr_len += 1;
+        }
+        memcpy(&endpoint.addr, &un, sizeof(un));
+        endpoint.transport = ExportTransport::UNIX_STREAM;
+        return true;
+    }
+
+    std::string rest;
+    if (address.compare(0, 6, "udp://") == 0) {
+        endpoint.transport = ExportTransport::UDP;
+        rest = address.substr(6);
+    } else if (address.compare(0, 6, "tcp://") == 0) {
+        endpoint.transport = ExportTransport::TCP;
+        rest = address.substr(6);
+    } else {
+        error = "未知的导出地址 '" + address + "'，可选 udp://HOST:PORT, tcp://HOST:PORT, unix:PATH";
+        return false;
+    }
+
+    std::string host;
+    std::string port;
+    if (!parse_host_port(rest, host, port)) {
+        error = "无效的导出地址 '" + address + "'，应为 HOST:PORT（IPv6写作 [ADDR]:PORT）";
+        return false;
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = endpoint.transport == ExportTransport::UDP ? SOCK_DGRAM : SOCK_STREAM;
+    addrinfo* result = nullptr;
+    int ret = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+    if (ret != 0 || result == nullptr) {
+        error = "无法解析导出地址 " + host + ": " + gai_strerror(ret);
+        return false;
+    }
+    memcpy(&endpoint.addr, result->ai_addr, result->ai_addrlen);
+    endpoint.addr_len = result->ai_addrlen;
+    freeaddrinfo(result);
+    return true;
+}
+
+const char* ExportEndpoint::transport_name(ExportTransport transport) {
+    switch (transport) {
+        case ExportTransport::UDP: return "udp";
+        case ExportTransport::TCP: return "tcp";
+        case ExportTransport::UNIX_STREAM: return "unix";
+    }
+    return "unknown";
+}
+
+Exporter::Exporter(const ExportOptions& options) : options_(options) {
+    std::string error;
+    if (!ExportEndpoint::parse(options_.address, endpoint_, error)) {
+        throw std::runtime_error(error);
+    }
+}
+
+Exporter::~Exporter() {
+    stop();
+}
+
+void Exporter::start() {
+    if (sender_thread_.joinable()) {
+        return;
+    }
+    pending_.reserve(std::min(options_.buffer_bytes, STREAM_BATCH_BYTES));
+    std::cout << "📡 结果导出: " << endpoint_.description << " ("
+              << (options_.route_events ? "会话记录与路由事件" : "会话记录") << ", 缓冲区上限="
+              << options_.buffer_bytes << " 字节, 间隔=" << options_.interval_ms << "ms)\n";
+    sender_thread_ = std::thread(&Exporter::sender_loop, this);
+}
+
+void Exporter::stop() {
+    if (!sender_thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        drain_deadline_ns_ = EventClock::monotonic_ns() + DRAIN_TIMEOUT_MS * EventClock::NS_PER_MS;
+    }
+    cv_.notify_all();
+    sender_thread_.join();
+    disconnect();
+
+    std::cout << "📡 结果导出: 已发送 " << sent_records_.load() << " 条记录 (" << sent_bytes_.load()
+              << " 字节), 丢弃 " << dropped_records_.load() << " 条, 发送失败 " << send_errors_.load()
+              << " 次, 重连 " << reconnects_.load() << " 次\n";
+}
+
+bool Exporter::wants(const std::string& event_type) const {
+    return event_type == "session_started" || event_type == "session_completed" ||
+           event_type == "monitoring_started" || event_type == "monitoring_completed";
+}
+
+void Exporter::submit(const char* data, size_t len) {
+    bool notify;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 上限同时计入发送中的一批：发送线程交换缓冲区后 pending_ 会重新积累
+        if (stopping_ || pending_.size() + sending_bytes_ + len + 1 > options_.buffer_bytes) {
+            dropped_records_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        bool was_empty = pending_.empty();
+        pending_.append(data, len);
+        pending_ += '\n';
+        int64_t buffered = static_cast<int64_t>(pending_.size() + sending_bytes_);
+        if (buffered > buffer_peak_.load(std::memory_order_relaxed)) {
+            buffer_peak_.store(buffered, std::memory_order_relaxed);
+        }
+        size_t batch = endpoint_.transport == ExportTransport::UDP ? DATAGRAM_LIMIT : STREAM_BATCH_BYTES;
+        notify = was_empty || pending_.size() >= batch;
+    }
+    if (notify) {
+        cv_.notify_one();
+    }
+}
+
+void Exporter::sender_loop() {
+    const size_t batch = endpoint_.transport == ExportTransport::UDP ? DATAGRAM_LIMIT : STREAM_BATCH_BYTES;
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        if (sending_offset_ >= sending_.size()) {
+            // 上一批已发完：等待第一条记录，再等待一个批量间隔（或攒满一批）
+            sending_.clear();
+            sending_offset_ = 0;
+            sending_bytes_ = 0;
+            // 积压时的大批次发完后释放其内存，交换后不会让两个缓冲区都保留上限大小的容量
+            if (sending_.capacity() > STREAM_BATCH_BYTES) {
+                std::string().swap(sending_);
+            }
+            cv_.wait(lock, [&] { return stopping_ || !pending_.empty(); });
+            if (!stopping_ && options_.interval_ms > 0) {
+                cv_.wait_for(lock, std::chrono::milliseconds(options_.interval_ms),
+                             [&] { return stopping_ || pending_.size() >= batch; });
+            }
+            if (pending_.empty()) {
+                break;
+            }
+            pending_.swap(sending_);
+            sending_bytes_ = sending_.size();
+        }
+
+        lock.unlock();
+        bool ok = true;
+        if (endpoint_.transport == ExportTransport::UDP) {
+            send_datagrams();
+        } else {
+            ok = send_stream();
+        }
+        lock.lock();
+
+        if (stopping_ && EventClock::monotonic_ns() >= drain_deadline_ns_) {
+            break;
+        }
+        if (!ok) {
+            // 收集端不可达：等到下一次重连时刻，期间新记录在 pending_ 中积累直至上限
+            int64_t wait_ns = std::max<int64_t>(next_connect_ns_ - EventClock::monotonic_ns(), 0);
+            if (stopping_) {
+                wait_ns = std::min(wait_ns, std::max<int64_t>(drain_deadline_ns_ - EventClock::monotonic_ns(), 0));
+            }
+            cv_.wait_for(lock, std::chrono::nanoseconds(wait_ns));
+        }
+    }
+
+    // 超时未能发出的记录计为丢弃
+    drop_sending();
+    sending_bytes_ = 0;
+    dropped_records_.fetch_add(count_records(pending_.data(), pending_.data() + pending_.size()),
+                               std::memory_order_relaxed);
+    pending_.clear();
+}
+
+bool Exporter::ensure_connected() {
+    if (fd_ >= 0) {
+        return true;
+    }
+    int64_t now = EventClock::monotonic_ns();
+    if (now < next_connect_ns_) {
+        return false;
+    }
+
+    int type = endpoint_.transport == ExportTransport::UDP ? SOCK_DGRAM : SOCK_STREAM;
+    int fd = socket(endpoint_.addr.ss_family, type | SOCK_CLOEXEC, 0);
+    if (fd >= 0) {
+        // 发送超时同时限制connect：收集端卡住时发送线程仍能定期检查停止请求
+        timeval timeout{1, 0};
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        if (connect(fd, reinterpret_cast<const sockaddr*>(&endpoint_.addr), endpoint_.addr_len) == 0) {
+            if (reconnect_backoff_ns_ > 0 || next_connect_ns_ > 0) {
+                reconnects_.fetch_add(1, std::memory_order_relaxed);
+                std::cout << "📡 结果导出已重新连接: " << endpoint_.description << "\n";
+            }
+            fd_ = fd;
+            reconnect_backoff_ns_ = 0;
+            return true;
+        }
+    }
+
+    int err = errno;
+    if (fd >= 0) {
+        close(fd);
+    }
+    send_errors_.fetch_add(1, std::memory_order_relaxed);
+    if (reconnect_backoff_ns_ == 0) {
+        std::cerr << "⚠️  结果导出连接失败 " << endpoint_.description << ": " << strerror(err)
+                  << "，将在后台重试\n";
+    }
+    reconnect_backoff_ns_ = std::min(std::max(reconnect_backoff_ns_ * 2, RECONNECT_MIN_NS), RECONNECT_MAX_NS);
+    next_connect_ns_ = now + reconnect_backoff_ns_;
+    return false;
+}
+
+void Exporter::disconnect() {
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool Exporter::send_stream() {
+    if (!ensure_connected()) {
+        return false;
+    }
+
+    while (sending_offset_ < sending_.size()) {
+        const char* data = sending_.data() + sending_offset_;
+        ssize_t sent = send(fd_, data, sending_.size() - sending_offset_, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // 收集端接收慢：保留剩余数据，由发送循环继续（期间新记录受缓冲区上限约束）
+                return true;
+            }
+            send_errors_.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "⚠️  结果导出连接断开 " << endpoint_.description << ": " << strerror(errno) << "\n";
+            disconnect();
+            // 重连后从未发完的那条记录开头重发，收集端丢弃旧连接末尾不完整的行
+            if (sending_offset_ > 0 && sending_[sending_offset_ - 1] != '\n') {
+                size_t line_start = sending_.rfind('\n', sending_offset_ - 1);
+                sending_offset_ = line_start == std::string::npos ? 0 : line_start + 1;
+            }
+            reconnect_backoff_ns_ = RECONNECT_MIN_NS;
+            next_connect_ns_ = EventClock::monotonic_ns() + reconnect_backoff_ns_;
+            return false;
+        }
+        sending_offset_ += static_cast<size_t>(sent);
+    }
+
+    // 整批写完才计数：断开重连后从行首重发的部分不会重复计入
+    sent_records_.fetch_add(count_records(sending_.data(), sending_.data() + sending_.size()),
+                            std::memory_order_relaxed);
+    sent_bytes_.fetch_add(static_cast<int64_t>(sending_.size()), std::memory_order_relaxed);
+    return true;
+}
+
+void Exporter::send_datagrams() {
+    if (!ensure_connected()) {
+        // UDP套接字创建失败（极少见）：本批直接丢弃，不积压
+        drop_sending();
+        return;
+    }
+
+    // 按整条记录打包：每个数据报包含若干完整的行
+    while (sending_offset_ < sending_.size()) {
+        size_t start = sending_offset_;
+        size_t end = start;
+        while (end < sending_.size()) {
+            size_t line_end = sending_.find('\n', end) + 1;
+            if (end > start && line_end - start > DATAGRAM_LIMIT) {
+                break;
+            }
+            end = line_end;
+            if (end - start >= DATAGRAM_LIMIT) {
+                break;
+            }
+        }
+        sending_offset_ = end;
+
+        int64_t records = count_records(sending_.data() + start, sending_.data() + end);
+        if (end - start > DATAGRAM_MAX) {
+            dropped_records_.fetch_add(records, std::memory_order_relaxed);
+            continue;
+        }
+        ssize_t sent;
+        do {
+            sent = send(fd_, sending_.data() + start, end - start, 0);
+        } while (sent < 0 && errno == EINTR);
+        if (sent < 0) {
+            // 收集端未监听（ECONNREFUSED）或发送缓冲区满：本数据报丢弃
+            send_errors_.fetch_add(1, std::memory_order_relaxed);
+            dropped_records_.fetch_add(records, std::memory_order_relaxed);
+            continue;
+        }
+        sent_records_.fetch_add(records, std::memory_order_relaxed);
+        sent_bytes_.fetch_add(sent, std::memory_order_relaxed);
+    }
+}
+
+void Exporter::drop_sending() {
+    // 数据报在发出时已逐个计数；流式连接只在整批写完时计数，这里补记已写出的完整记录
+    if (endpoint_.transport != ExportTransport::UDP && sending_offset_ > 0) {
+        sent_records_.fetch_add(count_records(sending_.data(), sending_.data() + sending_offset_),
+                                std::memory_order_relaxed);
+        sent_bytes_.fetch_add(static_cast<int64_t>(sending_offset_), std::memory_order_relaxed);
+    }
+    if (sending_offset_ < sending_.size()) {
+        dropped_records_.fetch_add(count_records(sending_.data() + sending_offset_,
+                                                 sending_.data() + sending_.size()),
+                                   std::memory_order_relaxed);
+    }
+    sending_.clear();
+    sending_offset_ = 0;
+}
+
+void Exporter::append_pipeline_stats(PipelineStats::Report& report) const {
+    report.add_counter("export_sent_records", sent_records_.load(std::memory_order_relaxed));
+    report.add_counter("export_sent_bytes", sent_bytes_.load(std::memory_order_relaxed));
+    report.add_counter("export_dropped_records", dropped_records_.load(std::memory_order_relaxed));
+    report.add_counter("export_send_errors", send_errors_.load(std::memory_order_relaxed));
+    report.add_counter("export_reconnects", reconnects_.load(std::memory_order_relaxed));
+    report.add_counter("export_buffer_peak_bytes", buffer_peak_.load(std::memory_order_relaxed));
+    std::lock_guard<std::mutex> lock(mutex_);
+    report.add_counter("export_buffer_bytes", static_cast<int64_t>(pending_.size() + sending_bytes_));
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+
+#include "pipeline_stats.h"
+
+// 结果导出（--export）：把会话结果实时发送到中心收集端，实验结束后无需再逐个容器拷回日志。
+//
+// 记录由日志线程在写文件的同时交给导出器（事件线程没有额外开销），格式与JSON日志相同，
+// 每行一个JSON对象，收集端直接追加到文件即可用 converge_aggregate 汇总。
+//   udp://HOST:PORT     多条记录打包为一个数据报（不超过 DATAGRAM_LIMIT 字节，不拆分记录）
+//   tcp://HOST:PORT     长连接字节流，断开后按退避间隔自动重连
+//   unix:PATH           Unix域字节流套接字，行为同 tcp
+//
+// 内存有界：待发送与发送中的数据合计超过 buffer_bytes 时新记录被丢弃并计数（收集端跟不上或不可达时的背压），
+// 从不阻塞日志线程。发送在独立线程中进行，每 interval_ms 或缓冲区积累到一批时发送一次。
+enum class ExportTransport {
+    UDP,
+    TCP,
+    UNIX_STREAM
+};
+
+struct ExportOptions {
+    std::string address;                // 空表示不导出
+    bool route_events = false;          // 同时导出逐条路由事件（默认只导出会话与监控起止记录）
+    size_t buffer_bytes = 4 << 20;      // 待发送缓冲区上限（含发送中的一批）
+    int interval_ms = 100;              // 批量发送间隔
+
+    bool enabled() const { return !address.empty(); }
+};
+
+// 解析后的收集端地址
+struct ExportEndpoint {
+    ExportTransport transport = ExportTransport::UDP;
+    sockaddr_storage addr{};
+    socklen_t addr_len = 0;
+    std::string description;            // 用于控制台输出
+
+    // 解析 udp://HOST:PORT、tcp://HOST:PORT（IPv6写作 [::1]:PORT）与 unix:PATH，主机名在此解析
+    static bool parse(const std::string& address, ExportEndpoint& endpoint, std::string& error);
+    static const char* transport_name(ExportTransport transport);
+};
+
+class Exporter {
+public:
+    static constexpr size_t DATAGRAM_LIMIT = 1400;
+    static constexpr size_t STREAM_BATCH_BYTES = 64 * 1024;
+    // 停止时等待缓冲区发送完毕的最长时间
+    static constexpr int DRAIN_TIMEOUT_MS = 2000;
+
+    // 地址无法解析时抛出 std::runtime_error
+    explicit Exporter(const ExportOptions& options);
+    ~Exporter();
+
+    Exporter(const Exporter&) = delete;
+    Exporter& operator=(const Exporter&) = delete;
+
+    void start();
+    // 尽量发送剩余记录（最多 DRAIN_TIMEOUT_MS），随后关闭连接并输出统计
+    void stop();
+
+    // 日志线程调用：追加一条记录（不含换行），缓冲区已满时丢弃并计数
+    void submit(const char* data, size_t len);
+
+    // 只导出会话与监控起止记录；route_event 为逐条路由事件
+    bool wants(const std::string& event_type) const;
+    bool wants_route_events() const { return options_.route_events; }
+
+    const ExportEndpoint& endpoint() const { return endpoint_; }
+
+    // 已发送/丢弃的记录数、发送字节数、发送失败与重连次数、缓冲区峰值
+    void append_pipeline_stats(PipelineStats::Report& report) const;
+
+private:
+    ExportOptions options_;
+    ExportEndpoint endpoint_;
+
+    // 日志线程追加到 pending_，发送线程整体交换到 sending_ 后在锁外发送
+    std::string pending_;
+    std::string sending_;
+    size_t sending_offset_{0};
+    size_t sending_bytes_{0};           // sending_ 的大小：受 mutex_ 保护，日志线程据此计算缓冲区上限
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_{false};
+    int64_t drain_deadline_ns_{0};
+    std::thread sender_thread_;
+
+    int fd_{-1};
+    int64_t next_connect_ns_{0};
+    int64_t reconnect_backoff_ns_{0};
+
+    std::atomic<int64_t> sent_records_{0};
+    std::atomic<int64_t> sent_bytes_{0};
+    std::atomic<int64_t> dropped_records_{0};
+    std::atomic<int64_t> send_errors_{0};
+    std::atomic<int64_t> reconnects_{0};
+    std::atomic<int64_t> buffer_peak_{0};
+
+    void sender_loop();
+    bool ensure_connected();
+    void disconnect();
+    // 发送 sending_ 中剩余的数据，整批写完后才计入已发送；连接不可用时返回false，未发送部分保留待重试
+    bool send_stream();
+    void send_datagrams();
+    // 放弃 sending_ 中未发送的记录；流式连接已写出的完整记录此时计入已发送
+    void drop_sending();
+};
@@ -0,0 +1,157 @@
+#include "fib_mirror.h"
+#include <cstring>
+#include <linux/rtnetlink.h>
+
+namespace {
+
+// 属于转发属性的标志位（目标前缀与优先级是键的一部分）
+constexpr uint8_t FORWARDING_FLAGS = RouteRecord::HAS_GATEWAY | RouteRecord::HAS_PREFSRC | RouteRecord::HAS_OIF |
+                                     RouteRecord::HAS_MULTIPATH | RouteRecord::HAS_NH_ID;
+
+} // namespace
+
+FibMirror::Key FibMirror::make_key(const RouteRecord& route) {
+    Key key;
+    key.prefix = PrefixTable::make_key(route);
+    key.priority = route.has(RouteRecord::HAS_PRIORITY) ? route.priority : 0;
+    return key;
+}
+
+FibMirror::Entry FibMirror::make_entry(const RouteRecord& route) {
+    Entry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.flags = route.flags & FORWARDING_FLAGS;
+    if (route.has(RouteRecord::HAS_GATEWAY)) {
+        entry.gateway = route.gateway;
+    }
+    if (route.has(RouteRecord::HAS_PREFSRC)) {
+        entry.prefsrc = route.prefsrc;
+    }
+    entry.ifindex = route.has(RouteRecord::HAS_OIF) ? route.ifindex : 0;
+    entry.nh_id = route.has(RouteRecord::HAS_NH_ID) ? route.nh_id : 0;
+    if (route.has(RouteRecord::HAS_MULTIPATH)) {
+        entry.nexthop_hash = route.nexthop_hash;
+        entry.nexthop_count = route.nexthop_count;
+    }
+    entry.protocol = route.protocol;
+    entry.scope = route.scope;
+    entry.type = route.type;
+    return entry;
+}
+
+bool FibMirror::same_forwarding(const Entry& a, const Entry& b) {
+    return a.flags == b.flags && a.ifindex == b.ifindex && a.protocol == b.protocol &&
+           a.scope == b.scope && a.type == b.type && a.nh_id == b.nh_id &&
+           a.nexthop_hash == b.nexthop_hash && a.nexthop_count == b.nexthop_count &&
+           memcmp(&a.gateway, &b.gateway, sizeof(a.gateway)) == 0 &&
+           memcmp(&a.prefsrc, &b.prefsrc, sizeof(a.prefsrc)) == 0;
+}
+
+RouteRecord::Change FibMirror::apply(const RouteRecord& route) {
+    Key key = make_key(route);
+
+    if (route.nlmsg_type == RTM_DELROUTE) {
+        // 镜像中没有的路由被删除同样视为变化：镜像可能因接收溢出而不完整
+        routes_.erase(key);
+        return RouteRecord::CHANGE_REMOVED;
+    }
+
+    Entry entry = make_entry(route);
+    entry.generation = generation_;
+    // try_emplace 先查找：已有路由的刷新/重复通知不构造节点，原地比较与覆盖
+    auto result = routes_.try_emplace(key, entry);
+    if (result.second) {
+        return RouteRecord::CHANGE_NEW;
+    }
+
+    Entry& existing = result.first->second;
+    bool same = same_forwarding(existing, entry);
+    existing = entry;
+    return same ? RouteRecord::CHANGE_NOOP : RouteRecord::CHANGE_MODIFIED;
+}
+
+FibMirror::NexthopEntry FibMirror::make_nexthop_entry(const NexthopRecord& nexthop) {
+    NexthopEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.family = nexthop.family;
+    entry.flags = nexthop.flags;
+    entry.protocol = nexthop.protocol;
+    entry.ifindex = nexthop.has(NexthopRecord::HAS_OIF) ? nexthop.ifindex : 0;
+    if (nexthop.has(NexthopRecord::HAS_GATEWAY)) {
+        entry.gateway = nexthop.gateway;
+    }
+    entry.group_hash = nexthop.group_hash;
+    entry.group_size = nexthop.group_size;
+    return entry;
+}
+
+bool FibMirror::same_nexthop(const NexthopEntry& a, const NexthopEntry& b) {
+    return a.family == b.family && a.flags == b.flags && a.protocol == b.protocol && a.ifindex == b.ifindex &&
+           a.group_hash == b.group_hash && a.group_size == b.group_size &&
+           memcmp(&a.gateway, &b.gateway, sizeof(a.gateway)) == 0;
+}
+
+RouteRecord::Change FibMirror::apply_nexthop(const NexthopRecord& nexthop) {
+    if (nexthop.nlmsg_type == RTM_DELNEXTHOP) {
+        nexthops_.erase(nexthop.id);
+        return RouteRecord::CHANGE_REMOVED;
+    }
+
+    NexthopEntry entry = make_nexthop_entry(nexthop);
+    auto result = nexthops_.try_emplace(nexthop.id, entry);
+    if (result.second) {
+        return RouteRecord::CHANGE_NEW;
+    }
+
+    bool same = same_nexthop(result.first->second, entry);
+    result.first->second = entry;
+    return same ? RouteRecord::CHANGE_NOOP : RouteRecord::CHANGE_MODIFIED;
+}
+
+void FibMirror::sync_nexthop(const NexthopRecord& nexthop) {
+    nexthops_[nexthop.id] = make_nexthop_entry(nexthop);
+}
+
+void FibMirror::begin_sync() {
+    generation_++;
+    syncing_ = true;
+}
+
+void FibMirror::sync_entry(const RouteRecord& route) {
+    if (!syncing_) {
+        begin_sync();
+    }
+    Entry entry = make_entry(route);
+    entry.generation = generation_;
+    routes_[make_key(route)] = entry;
+}
+
+size_t FibMirror::end_sync(bool success) {
+    if (!syncing_) {
+        // 空转储：所有旧路由都已不存在
+        begin_sync();
+    }
+    syncing_ = false;
+    if (!success) {
+        return 0;
+    }
+
+    size_t removed = 0;
+    for (auto it = routes_.begin(); it != routes_.end();) {
+        if (it->second.generation != generation_) {
+            it = routes_.erase(it);
+            removed++;
+        } else {
+            ++it;
+        }
+    }
+    return removed;
+}
+
+size_t FibMirror::memory_bytes() const {
+    // 每个节点额外包含next指针与缓存的哈希值
+    size_t node = sizeof(Key) + sizeof(Entry) + 2 * sizeof(void*);
+    size_t nexthop_node = sizeof(uint32_t) + sizeof(NexthopEntry) + 2 * sizeof(void*);
+    return routes_.size() * node + routes_.bucket_count() * sizeof(void*) +
+           nexthops_.size() * nexthop_node + nexthops_.bucket_count() * sizeof(void*);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include "event_records.h"
+#include "prefix_table.h"
+
+// 内核路由表与下一跳对象的内存镜像：启动时由RTM_GETROUTE / RTM_GETNEXTHOP转储填充，之后随通知更新，
+// 用于区分真正的下一跳变化与属性相同的替换/刷新（如zebra重新下发）。
+// 只在netlink监控线程中访问，不加锁。
+class FibMirror {
+public:
+    // 按通知更新镜像，返回该通知相对镜像的变化类别
+    RouteRecord::Change apply(const RouteRecord& route);
+    // 下一跳对象：按编号保存，组按成员摘要比较
+    RouteRecord::Change apply_nexthop(const NexthopRecord& nexthop);
+
+    // 转储同步：sync_entry 逐条写入转储到的路由，end_sync 在转储成功时删除本次转储中
+    // 未出现的路由（转储期间收到的通知视为已同步）。首次 sync_entry 自动开始新一轮同步。
+    void sync_entry(const RouteRecord& route);
+    // 启动转储中的下一跳对象（只在启动时转储，不参与过期清理）
+    void sync_nexthop(const NexthopRecord& nexthop);
+    // 返回删除的过期路由数
+    size_t end_sync(bool success);
+
+    size_t size() const { return routes_.size(); }
+    size_t nexthop_count() const { return nexthops_.size(); }
+
+    // 估算的内存占用（节点 + 桶数组）
+    size_t memory_bytes() const;
+
+private:
+    // 内核路由的唯一键：路由表 + 目标前缀 + 优先级（metric）
+    struct Key {
+        PrefixKey prefix;
+        uint32_t priority;
+
+        bool operator==(const Key& other) const {
+            return priority == other.priority && prefix == other.prefix;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return static_cast<size_t>(PrefixTable::hash(key.prefix) ^ (key.priority * 0x9e3779b97f4a7c15ULL));
+        }
+    };
+
+    // 参与比较的转发属性；多路径路由比较下一跳摘要，下一跳对象路由比较对象编号
+    struct Entry {
+        struct in6_addr gateway;
+        struct in6_addr prefsrc;
+        int32_t ifindex;
+        uint32_t nh_id;
+        uint32_t nexthop_hash;
+        uint16_t nexthop_count;
+        uint8_t protocol;
+        uint8_t scope;
+        uint8_t type;
+        uint8_t flags;
+        uint32_t generation;    // 最近一次同步或通知时的同步轮次
+    };
+
+    struct NexthopEntry {
+        struct in6_addr gateway;
+        int32_t ifindex;
+        uint32_t group_hash;
+        uint16_t group_size;
+        uint8_t family;
+        uint8_t flags;
+        uint8_t protocol;
+    };
+
+    std::unordered_map<Key, Entry, KeyHash> routes_;
+    std::unordered_map<uint32_t, NexthopEntry> nexthops_;
+    uint32_t generation_{0};
+    bool syncing_{false};
+
+    static Key make_key(const RouteRecord& route);
+    static Entry make_entry(const RouteRecord& route);
+    static bool same_forwarding(const Entry& a, const Entry& b);
+    static NexthopEntry make_nexthop_entry(const NexthopRecord& nexthop);
+    static bool same_nexthop(const NexthopEntry& a, const NexthopEntry& b);
+    void begin_sync();
+};
@@ -0,0 +1,117 @@
+#include "histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+HdrHistogram::HdrHistogram(int64_t highest_trackable_value, int significant_digits)
+    : highest_trackable_value_(std::max<int64_t>(highest_trackable_value, 2)),
+      significant_digits_(std::clamp(significant_digits, 1, 5)) {
+    // 每个区段内的细分数需达到 2*10^digits，才能保证该精度
+    int64_t largest_single_unit = 2;
+    for (int i = 0; i < significant_digits_; ++i) {
+        largest_single_unit *= 10;
+    }
+    int sub_bucket_count_magnitude = static_cast<int>(std::ceil(std::log2(static_cast<double>(largest_single_unit))));
+    sub_bucket_half_count_magnitude_ = sub_bucket_count_magnitude - 1;
+    sub_bucket_count_ = int64_t{1} << sub_bucket_count_magnitude;
+    sub_bucket_half_count_ = sub_bucket_count_ / 2;
+    sub_bucket_mask_ = sub_bucket_count_ - 1;
+
+    // 覆盖上限所需的区段数
+    int64_t smallest_untrackable = sub_bucket_count_;
+    bucket_count_ = 1;
+    while (smallest_untrackable <= highest_trackable_value_) {
+        if (smallest_untrackable > std::numeric_limits<int64_t>::max() / 2) {
+            ++bucket_count_;
+            break;
+        }
+        smallest_untrackable <<= 1;
+        ++bucket_count_;
+    }
+
+    counts_.assign(static_cast<size_t>(bucket_count_ + 1) * static_cast<size_t>(sub_bucket_half_count_), 0);
+}
+
+size_t HdrHistogram::counts_index(int64_t value) const {
+    int pow2_ceiling = 64 - __builtin_clzll(static_cast<uint64_t>(value | sub_bucket_mask_));
+    int bucket_index = pow2_ceiling - (sub_bucket_half_count_magnitude_ + 1);
+    int64_t sub_bucket_index = value >> bucket_index;
+    int64_t bucket_base_index = static_cast<int64_t>(bucket_index + 1) << sub_bucket_half_count_magnitude_;
+    return static_cast<size_t>(bucket_base_index + sub_bucket_index - sub_bucket_half_count_);
+}
+
+int64_t HdrHistogram::value_at_index(size_t index) const {
+    int bucket_index = static_cast<int>(index >> sub_bucket_half_count_magnitude_) - 1;
+    int64_t sub_bucket_index = static_cast<int64_t>(index & static_cast<size_t>(sub_bucket_half_count_ - 1)) +
+                               sub_bucket_half_count_;
+    if (bucket_index < 0) {
+        sub_bucket_index -= sub_bucket_half_count_;
+        bucket_index = 0;
+    }
+    return sub_bucket_index << bucket_index;
+}
+
+int64_t HdrHistogram::highest_equivalent_value(int64_t value) const {
+    int pow2_ceiling = 64 - __builtin_clzll(static_cast<uint64_t>(value | sub_bucket_mask_));
+    int bucket_index = pow2_ceiling - (sub_bucket_half_count_magnitude_ + 1);
+    int64_t sub_bucket_index = value >> bucket_index;
+    int adjusted_bucket = sub_bucket_index >= sub_bucket_count_ ? bucket_index + 1 : bucket_index;
+    int64_t lowest = sub_bucket_index << bucket_index;
+    return lowest + (int64_t{1} << adjusted_bucket) - 1;
+}
+
+void HdrHistogram::record(int64_t value) {
+    if (value < 0) {
+        value = 0;
+    }
+    if (value > highest_trackable_value_) {
+        value = highest_trackable_value_;
+        ++overflow_count_;
+    }
+
+    ++counts_[counts_index(value)];
+    if (total_count_ == 0 || value < min_) {
+        min_ = value;
+    }
+    if (value > max_) {
+        max_ = value;
+    }
+    sum_ += value;
+    ++total_count_;
+}
+
+int64_t HdrHistogram::value_at_percentile(double percentile) const {
+    if (total_count_ == 0) {
+        return 0;
+    }
+
+    double requested = std::clamp(percentile, 0.0, 100.0);
+    int64_t count_at_percentile = static_cast<int64_t>(std::ceil(requested / 100.0 * total_count_));
+    count_at_percentile = std::clamp<int64_t>(count_at_percentile, 1, total_count_);
+
+    int64_t cumulative = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        cumulative += counts_[i];
+        if (cumulative >= count_at_percentile) {
+            // 区间上界截断到实际的最小/最大值
+            return std::clamp(highest_equivalent_value(value_at_index(i)), min_, max_);
+        }
+    }
+    return max_;
+}
+
+std::string HdrHistogram::serialize() const {
+    std::string out;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        if (counts_[i] == 0) {
+            continue;
+        }
+        if (!out.empty()) {
+            out += ',';
+        }
+        out += std::to_string(value_at_index(i));
+        out += ':';
+        out += std::to_string(counts_[i]);
+    }
+    return out;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// HDR风格直方图：固定内存、O(1)记录，任意值的相对误差不超过 10^-significant_digits
+//
+// 值域 [0, highest_trackable_value] 被划分为按2的幂递增的区段，每个区段内再线性细分，
+// 因此小值精确、大值保持固定的有效数字。超出上限的值记录为上限并计入 overflow_count。
+// 只在会话结束时更新，调用者负责加锁。
+class HdrHistogram {
+public:
+    HdrHistogram(int64_t highest_trackable_value, int significant_digits);
+
+    void record(int64_t value);
+
+    // 百分位（0-100]：返回至少覆盖该比例样本的最小区间的上界，截断到实际最小/最大值，无样本时返回0。
+    // 离线工具由序列化的直方图计算百分位时使用同一规则（highest_equivalent_value + 记录的最小/最大值）
+    int64_t value_at_percentile(double percentile) const;
+
+    // value 所在区间的上界（含）
+    int64_t highest_equivalent_value(int64_t value) const;
+
+    int64_t total_count() const { return total_count_; }
+    int64_t overflow_count() const { return overflow_count_; }
+    int64_t min() const { return total_count_ > 0 ? min_ : 0; }
+    int64_t max() const { return max_; }
+    double mean() const { return total_count_ > 0 ? static_cast<double>(sum_) / total_count_ : 0.0; }
+    int significant_digits() const { return significant_digits_; }
+
+    // 稀疏序列化："区间下界:计数,区间下界:计数,..."，只包含非零区间。
+    // 相同有效数字的直方图可按区间下界直接相加合并。
+    std::string serialize() const;
+
+private:
+    int64_t highest_trackable_value_;
+    int significant_digits_;
+    int sub_bucket_half_count_magnitude_;
+    int64_t sub_bucket_count_;
+    int64_t sub_bucket_half_count_;
+    int64_t sub_bucket_mask_;
+    int bucket_count_;
+
+    std::vector<int64_t> counts_;
+    int64_t total_count_{0};
+    int64_t overflow_count_{0};
+    int64_t min_{0};
+    int64_t max_{0};
+    int64_t sum_{0};
+
+    size_t counts_index(int64_t value) const;
+    int64_t value_at_index(size_t index) const;
+};
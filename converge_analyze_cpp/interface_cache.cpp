@@ -0,0 +1,163 @@
+#include "interface_cache.h"
+#include <cstring>
+
+namespace {
+thread_local const InterfaceCache* current_cache = nullptr;
+}
+
+InterfaceCache& InterfaceCache::instance() {
+    static InterfaceCache cache;
+    return cache;
+}
+
+const InterfaceCache& InterfaceCache::current() {
+    return current_cache ? *current_cache : instance();
+}
+
+InterfaceCache::Scope::Scope(const InterfaceCache* cache) : previous_(current_cache) {
+    if (cache) {
+        current_cache = cache;
+    }
+}
+
+InterfaceCache::Scope::~Scope() {
+    current_cache = previous_;
+}
+
+InterfaceCache::Slot* InterfaceCache::find_slot_locked(int32_t ifindex) {
+    for (size_t probe = 0; probe < MAX_PROBE; ++probe) {
+        Slot& slot = slots_[slot_index(ifindex, probe)];
+        int32_t key = slot.ifindex.load(std::memory_order_relaxed);
+        if (key == ifindex) {
+            return &slot;
+        }
+        if (key == 0) {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+void InterfaceCache::write_slot(Slot& slot, int32_t ifindex, const char* name, uint32_t flags, bool alive) {
+    uint64_t words[NAME_WORDS] = {};
+    if (name) {
+        strncpy(reinterpret_cast<char*>(words), name, IF_NAMESIZE - 1);
+    }
+
+    uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.ifindex.store(ifindex, std::memory_order_relaxed);
+    slot.flags.store(flags, std::memory_order_relaxed);
+    slot.alive.store(alive, std::memory_order_relaxed);
+    if (name) {
+        for (size_t i = 0; i < NAME_WORDS; ++i) {
+            slot.name[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+bool InterfaceCache::update(int32_t ifindex, const char* name, uint32_t flags) {
+    if (ifindex <= 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+
+    // 已存在：原地更新；否则优先使用空槽位，其次复用已删除接口的槽位
+    Slot* target = nullptr;
+    Slot* reusable = nullptr;
+    for (size_t probe = 0; probe < MAX_PROBE; ++probe) {
+        Slot& slot = slots_[slot_index(ifindex, probe)];
+        int32_t key = slot.ifindex.load(std::memory_order_relaxed);
+        if (key == ifindex) {
+            target = &slot;
+            break;
+        }
+        if (key == 0) {
+            target = reusable ? reusable : &slot;
+            break;
+        }
+        if (!reusable && !slot.alive.load(std::memory_order_relaxed)) {
+            reusable = &slot;
+        }
+    }
+    if (!target) {
+        target = reusable;
+    }
+    if (!target) {
+        return false;
+    }
+
+    bool was_alive = target->ifindex.load(std::memory_order_relaxed) == ifindex &&
+                     target->alive.load(std::memory_order_relaxed);
+    write_slot(*target, ifindex, name, flags, true);
+    if (!was_alive) {
+        live_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void InterfaceCache::remove(int32_t ifindex) {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+
+    Slot* slot = find_slot_locked(ifindex);
+    if (!slot || !slot->alive.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    write_slot(*slot, ifindex, nullptr, slot->flags.load(std::memory_order_relaxed), false);
+    live_count_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool InterfaceCache::lookup(int32_t ifindex, char (&name)[IF_NAMESIZE],
+                            uint32_t* flags, bool* alive) const {
+    if (ifindex <= 0) {
+        return false;
+    }
+
+    for (size_t probe = 0; probe < MAX_PROBE; ++probe) {
+        const Slot& slot = slots_[slot_index(ifindex, probe)];
+
+        while (true) {
+            uint32_t seq_before = slot.seq.load(std::memory_order_acquire);
+            if (seq_before & 1) {
+                continue; // 写入中，重试
+            }
+
+            int32_t key = slot.ifindex.load(std::memory_order_relaxed);
+            uint32_t slot_flags = slot.flags.load(std::memory_order_relaxed);
+            bool slot_alive = slot.alive.load(std::memory_order_relaxed);
+            uint64_t words[NAME_WORDS];
+            for (size_t i = 0; i < NAME_WORDS; ++i) {
+                words[i] = slot.name[i].load(std::memory_order_relaxed);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != seq_before) {
+                continue; // 读取期间被修改
+            }
+
+            if (key == 0) {
+                return false;
+            }
+            if (key != ifindex) {
+                break; // 探测下一个槽位
+            }
+
+            memcpy(name, words, IF_NAMESIZE);
+            name[IF_NAMESIZE - 1] = '\0';
+            if (flags) {
+                *flags = slot_flags;
+            }
+            if (alive) {
+                *alive = slot_alive;
+            }
+            return true;
+        }
+    }
+    return false;
+}
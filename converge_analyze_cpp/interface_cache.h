@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <net/if.h>
+
+// ifindex → 接口名称缓存
+//
+// 由netlink线程根据 RTM_NEWLINK / RTM_DELLINK 维护，初始内容来自 RTM_GETLINK 转储。
+// 读取端（日志线程、统计输出）无锁：每个槽位使用顺序锁(seqlock)，读者在版本号
+// 变化时重试。写入很少发生，写者之间用互斥锁串行化。
+//
+// 接口删除后条目只标记为失效并保留名称，使稍后格式化的事件仍能显示原名称；
+// 失效槽位在表满时被新接口复用。
+//
+// 监控多个网络命名空间时 ifindex 只在命名空间内唯一，每个命名空间使用独立的实例；
+// 格式化事件的线程通过 Scope 指定当前命名空间的缓存。
+class InterfaceCache {
+public:
+    static constexpr size_t CAPACITY = 4096;   // 必须为2的幂
+    static constexpr size_t MAX_PROBE = 64;    // 线性探测的最大长度
+
+    // 进程内共享的缓存实例（本命名空间）
+    static InterfaceCache& instance();
+
+    // 当前线程用于查询接口名称的缓存：未设置 Scope 时为 instance()
+    static const InterfaceCache& current();
+
+    // 在作用域内把当前线程的查询缓存切换为指定实例（nullptr 表示保持不变）
+    class Scope {
+    public:
+        explicit Scope(const InterfaceCache* cache);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        const InterfaceCache* previous_;
+    };
+
+    // 新增或更新接口（名称变化、标志变化），表满时返回false
+    bool update(int32_t ifindex, const char* name, uint32_t flags);
+
+    // 标记接口已删除（保留名称）
+    void remove(int32_t ifindex);
+
+    // 查询接口名称，未找到返回false；flags/alive 可为空
+    bool lookup(int32_t ifindex, char (&name)[IF_NAMESIZE],
+                uint32_t* flags = nullptr, bool* alive = nullptr) const;
+
+    // 当前存活的接口数量
+    size_t size() const { return live_count_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t NAME_WORDS = IF_NAMESIZE / sizeof(uint64_t);
+
+    struct Slot {
+        std::atomic<uint32_t> seq{0};          // 奇数表示写入中
+        std::atomic<int32_t> ifindex{0};       // 0 表示空槽位
+        std::atomic<uint32_t> flags{0};
+        std::atomic<bool> alive{false};
+        std::atomic<uint64_t> name[NAME_WORDS]{};
+    };
+
+    std::array<Slot, CAPACITY> slots_;
+    std::atomic<size_t> live_count_{0};
+    std::mutex writer_mutex_;
+
+    static size_t slot_index(int32_t ifindex, size_t probe) {
+        return (static_cast<uint32_t>(ifindex) * 2654435761u + probe) & (CAPACITY - 1);
+    }
+
+    Slot* find_slot_locked(int32_t ifindex);
+    void write_slot(Slot& slot, int32_t ifindex, const char* name, uint32_t flags, bool alive);
+};
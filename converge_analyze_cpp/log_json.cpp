@@ -0,0 +1,520 @@
+#include "log_json.h"
+#include "event_clock.h"
+#include <charconv>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+void LogJson::append_json(std::string& out, const JsonObject& json) {
+    out += '{';
+
+    bool first = true;
+    for (const auto& pair : json) {
+        if (!first) {
+            out += ',';
+        }
+        first = false;
+
+        out += '"';
+        append_escaped(out, pair.first);
+        out += "\":";
+        append_json_value(out, pair.second);
+    }
+
+    out += '}';
+}
+
+void LogJson::append_json_value(std::string& out, const JsonValue& value) {
+    char buffer[64];
+    switch (value.get_type()) {
+        case JsonValue::STRING:
+            out += '"';
+            append_escaped(out, value.as_string());
+            out += '"';
+            break;
+        case JsonValue::INT64: {
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value.as_int64());
+            out.append(buffer, result.ptr);
+            break;
+        }
+        case JsonValue::DOUBLE: {
+            // 固定3位小数，与历史日志格式一致
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value.as_double(),
+                                        std::chars_format::fixed, 3);
+            out.append(buffer, result.ptr);
+            break;
+        }
+        case JsonValue::BOOL:
+            out += value.as_bool() ? "true" : "false";
+            break;
+        default:
+            out += "null";
+            break;
+    }
+}
+
+namespace {
+
+// 转义表：0 表示原样输出，'u' 表示 \u00XX，其余为反斜杠后的字符
+struct JsonEscapeTable {
+    char table[256];
+
+    constexpr JsonEscapeTable() : table() {
+        for (int c = 0; c < 0x20; ++c) {
+            table[c] = 'u';
+        }
+        table[static_cast<unsigned char>('"')] = '"';
+        table[static_cast<unsigned char>('\\')] = '\\';
+        table[static_cast<unsigned char>('\b')] = 'b';
+        table[static_cast<unsigned char>('\f')] = 'f';
+        table[static_cast<unsigned char>('\n')] = 'n';
+        table[static_cast<unsigned char>('\r')] = 'r';
+        table[static_cast<unsigned char>('\t')] = 't';
+    }
+};
+
+constexpr JsonEscapeTable JSON_ESCAPE;
+
+} // namespace
+
+void LogJson::append_escaped(std::string& out, const std::string& str) {
+    static const char HEX[] = "0123456789abcdef";
+
+    // 连续无需转义的字节整段追加；UTF-8多字节字符原样输出
+    size_t run_start = 0;
+    for (size_t i = 0; i < str.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(str[i]);
+        char escape = JSON_ESCAPE.table[c];
+        if (escape == 0) {
+            continue;
+        }
+
+        out.append(str, run_start, i - run_start);
+        out += '\\';
+        if (escape == 'u') {
+            out += "u00";
+            out += HEX[c >> 4];
+            out += HEX[c & 0x0f];
+        } else {
+            out += escape;
+        }
+        run_start = i + 1;
+    }
+    out.append(str, run_start, str.size() - run_start);
+}
+
+namespace {
+
+// 扁平JSON对象的逐字节解析器，只服务于本工具写出的日志行
+class JsonLineParser {
+public:
+    JsonLineParser(const char* data, size_t len) : pos_(data), end_(data + len) {}
+
+    bool parse(JsonObject& out) {
+        skip_space();
+        if (!consume('{')) {
+            return false;
+        }
+        skip_space();
+        if (consume('}')) {
+            return trailing_space_only();
+        }
+        std::string key;
+        while (true) {
+            skip_space();
+            if (!parse_string(key)) {
+                return false;
+            }
+            skip_space();
+            if (!consume(':')) {
+                return false;
+            }
+            skip_space();
+            JsonValue value;
+            bool present = true;
+            if (!parse_value(value, present)) {
+                return false;
+            }
+            if (present) {
+                out[key] = std::move(value);
+            }
+            skip_space();
+            if (consume(',')) {
+                continue;
+            }
+            if (consume('}')) {
+                return trailing_space_only();
+            }
+            return false;
+        }
+    }
+
+private:
+    const char* pos_;
+    const char* end_;
+
+    void skip_space() {
+        while (pos_ < end_ && (*pos_ == ' ' || *pos_ == '\t' || *pos_ == '\r' || *pos_ == '\n')) {
+            ++pos_;
+        }
+    }
+
+    bool consume(char c) {
+        if (pos_ < end_ && *pos_ == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    bool consume_word(const char* word, size_t len) {
+        if (static_cast<size_t>(end_ - pos_) < len || memcmp(pos_, word, len) != 0) {
+            return false;
+        }
+        pos_ += len;
+        return true;
+    }
+
+    bool trailing_space_only() {
+        skip_space();
+        return pos_ == end_;
+    }
+
+    bool parse_value(JsonValue& value, bool& present) {
+        if (pos_ >= end_) {
+            return false;
+        }
+        switch (*pos_) {
+            case '"': {
+                std::string str;
+                if (!parse_string(str)) {
+                    return false;
+                }
+                value = JsonValue(str);
+                return true;
+            }
+            case 't':
+                value = JsonValue(true);
+                return consume_word("true", 4);
+            case 'f':
+                value = JsonValue(false);
+                return consume_word("false", 5);
+            case 'n':
+                present = false;
+                return consume_word("null", 4);
+            default:
+                return parse_number(value);
+        }
+    }
+
+    bool parse_number(JsonValue& value) {
+        const char* start = pos_;
+        bool integral = true;
+        while (pos_ < end_ && (isdigit(static_cast<unsigned char>(*pos_)) || *pos_ == '-' || *pos_ == '+' ||
+                               *pos_ == '.' || *pos_ == 'e' || *pos_ == 'E')) {
+            if (*pos_ == '.' || *pos_ == 'e' || *pos_ == 'E') {
+                integral = false;
+            }
+            ++pos_;
+        }
+        if (pos_ == start) {
+            return false;
+        }
+        if (integral) {
+            int64_t number = 0;
+            auto result = std::from_chars(start, pos_, number);
+            if (result.ec == std::errc() && result.ptr == pos_) {
+                value = JsonValue(number);
+                return true;
+            }
+            // 超出int64范围时按浮点数处理
+        }
+        double number = 0.0;
+        auto result = std::from_chars(start, pos_, number);
+        if (result.ec != std::errc() || result.ptr != pos_) {
+            return false;
+        }
+        value = JsonValue(number);
+        return true;
+    }
+
+    static int hex_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    bool parse_hex4(uint32_t& code) {
+        if (end_ - pos_ < 4) {
+            return false;
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            int digit = hex_value(pos_[i]);
+            if (digit < 0) {
+                return false;
+            }
+            code = (code << 4) | static_cast<uint32_t>(digit);
+        }
+        pos_ += 4;
+        return true;
+    }
+
+    static void append_utf8(std::string& out, uint32_t code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xc0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3f));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xe0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (code & 0x3f));
+        } else {
+            out += static_cast<char>(0xf0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (code & 0x3f));
+        }
+    }
+
+    bool parse_string(std::string& out) {
+        if (!consume('"')) {
+            return false;
+        }
+        out.clear();
+        while (pos_ < end_) {
+            // 无转义的连续字节整段追加
+            const char* run = pos_;
+            while (pos_ < end_ && *pos_ != '"' && *pos_ != '\\') {
+                ++pos_;
+            }
+            out.append(run, pos_);
+            if (pos_ >= end_) {
+                return false;
+            }
+            if (*pos_++ == '"') {
+                return true;
+            }
+            if (pos_ >= end_) {
+                return false;
+            }
+            char escape = *pos_++;
+            switch (escape) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t code;
+                    if (!parse_hex4(code)) {
+                        return false;
+                    }
+                    if (code >= 0xd800 && code < 0xdc00 && consume_word("\\u", 2)) {
+                        uint32_t low;
+                        if (!parse_hex4(low) || low < 0xdc00 || low >= 0xe000) {
+                            return false;
+                        }
+                        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                    }
+                    append_utf8(out, code);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+};
+
+} // namespace
+
+bool LogJson::parse_json(const char* data, size_t len, JsonObject& out) {
+    out.clear();
+    return JsonLineParser(data, len).parse(out);
+}
+
+// 静态辅助方法实现
+JsonObject LogJson::create_event_log(const std::string& event_type,
+                                   const std::string& router_name,
+                                   const std::string& user) {
+    JsonObject log;
+    log["event_type"] = event_type;
+    log["router_name"] = router_name;
+    log["user"] = user;
+
+    // 添加时间戳
+    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    log["timestamp"] = format_iso_timestamp(now_ms);
+
+    return log;
+}
+
+std::string LogJson::format_iso_timestamp(int64_t timestamp_ms) {
+    time_t seconds = static_cast<time_t>(timestamp_ms / 1000);
+    struct tm tm_utc;
+    gmtime_r(&seconds, &tm_utc);
+
+    char buffer[32];
+    size_t len = strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &tm_utc);
+    snprintf(buffer + len, sizeof(buffer) - len, ".%03dZ", static_cast<int>(timestamp_ms % 1000));
+    return std::string(buffer);
+}
+
+JsonObject LogJson::create_session_start_log(const std::string& router_name,
+                                           int session_id,
+                                           const std::string& trigger_source,
+                                           const std::string& trigger_event_type,
+                                           const TriggerRecord& trigger,
+                                           const std::string& user) {
+    auto log = create_event_log("session_started", router_name, user);
+    log["session_id"] = static_cast<int64_t>(session_id);
+    log["trigger_source"] = trigger_source;
+    log["trigger_event_type"] = trigger_event_type;
+
+    // 序列化trigger_info (简化版本)
+    std::string trigger_info;
+    EventFormat::append_trigger_info(trigger_info, trigger);
+    log["trigger_info"] = trigger_info;
+
+    return log;
+}
+
+JsonObject LogJson::create_route_event_log(const std::string& router_name,
+                                         const RouteEventLog& event,
+                                         const std::string& user) {
+    return create_route_event_log(router_name, event, user,
+                                  EventClock::to_wall_ms(event.event.timestamp()),
+                                  EventFormat::interface_name(event.event));
+}
+
+JsonObject LogJson::create_route_event_log(const std::string& router_name,
+                                         const RouteEventLog& event,
+                                         const std::string& user,
+                                         int64_t wall_time_ms,
+                                         const std::string& interface) {
+    auto log = create_event_log("route_event", router_name, user);
+    log["timestamp"] = format_iso_timestamp(wall_time_ms);
+    log["session_id"] = static_cast<int64_t>(event.session_id);
+    log["route_event_type"] = EventFormat::event_label(event.event);
+    log["route_event_number"] = event.route_event_number;
+    log["session_event_number"] = static_cast<int64_t>(event.session_event_number);
+    log["offset_from_trigger_ms"] = event.offset_from_trigger_ns / EventClock::NS_PER_MS;
+    log["offset_from_trigger_us"] = event.offset_from_trigger_ns / EventClock::NS_PER_US;
+
+    // 序列化route_info
+    std::string route_info;
+    EventFormat::append_event_info(route_info, event.event, interface);
+    log["route_info"] = route_info;
+
+    return log;
+}
+
+#if HAS_OPTIONAL
+JsonObject LogJson::create_session_completed_log(const std::string& router_name,
+                                               int session_id,
+                                               const std::optional<int64_t>& convergence_time_ms,
+                                               int route_events_count,
+                                               int64_t session_duration_ms,
+                                               int64_t convergence_threshold_ms,
+                                               const TriggerRecord& trigger,
+                                               const std::string& user) {
+#else
+JsonObject LogJson::create_session_completed_log(const std::string& router_name,
+                                               int session_id,
+                                               const optional<int64_t>& convergence_time_ms,
+                                               int route_events_count,
+                                               int64_t session_duration_ms,
+                                               int64_t convergence_threshold_ms,
+                                               const TriggerRecord& trigger,
+                                               const std::string& user) {
+#endif
+    auto log = create_event_log("session_completed", router_name, user);
+    log["session_id"] = static_cast<int64_t>(session_id);
+
+    if (convergence_time_ms.has_value()) {
+        log["convergence_time_ms"] = convergence_time_ms.value();
+    }
+
+    log["route_events_count"] = static_cast<int64_t>(route_events_count);
+    log["session_duration_ms"] = session_duration_ms;
+    log["convergence_threshold_ms"] = convergence_threshold_ms;
+
+    // 序列化netem_info（触发信息）
+    std::string netem_info;
+    EventFormat::append_trigger_info(netem_info, trigger);
+    log["netem_info"] = netem_info;
+
+    return log;
+}
+
+JsonObject LogJson::create_monitoring_start_log(const std::string& router_name,
+                                              const std::string& user,
+                                              int64_t convergence_threshold_ms,
+                                              const std::string& log_file_path,
+                                              const std::string& monitor_id) {
+    auto log = create_event_log("monitoring_started", router_name, user);
+    log["convergence_threshold_ms"] = convergence_threshold_ms;
+    log["log_file_path"] = log_file_path;
+    log["monitor_id"] = monitor_id;
+
+    // 添加UTC时间
+    auto now = std::chrono::system_clock::now();
+    auto time_t = std::chrono::system_clock::to_time_t(now);
+    std::ostringstream oss;
+    oss << std::put_time(std::gmtime(&time_t), "%Y-%m-%dT%H:%M:%S");
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now.time_since_epoch()) % 1000;
+    oss << "." << std::setfill('0') << std::setw(3) << ms.count() << "Z";
+    log["utc_time"] = oss.str();
+    log["listen_start_time"] = oss.str();
+
+    return log;
+}
+
+JsonObject LogJson::create_monitoring_completed_log(const std::string& router_name,
+                                                  const std::string& log_file_path,
+                                                  const std::string& user,
+                                                  int64_t total_listen_duration_ms,
+                                                  int64_t convergence_threshold_ms,
+                                                  int64_t total_trigger_events,
+                                                  int64_t netem_events_count,
+                                                  int64_t route_events_in_trigger,
+                                                  int64_t total_route_events,
+                                                  int completed_sessions_count,
+                                                  const std::string& monitor_id) {
+    auto log = create_event_log("monitoring_completed", router_name, user);
+    log["log_file_path"] = log_file_path;
+    log["total_listen_duration_ms"] = total_listen_duration_ms;
+    log["total_listen_duration_seconds"] = static_cast<double>(total_listen_duration_ms) / 1000.0;
+    log["convergence_threshold_ms"] = convergence_threshold_ms;
+    log["total_trigger_events"] = total_trigger_events;
+    log["netem_events_count"] = netem_events_count;
+    log["route_events_in_trigger"] = route_events_in_trigger;
+    log["total_route_events"] = total_route_events;
+    log["completed_sessions_count"] = static_cast<int64_t>(completed_sessions_count);
+    log["monitor_id"] = monitor_id;
+
+    // 添加时间信息
+    auto now = std::chrono::system_clock::now();
+    auto time_t = std::chrono::system_clock::to_time_t(now);
+    std::ostringstream oss;
+    oss << std::put_time(std::gmtime(&time_t), "%Y-%m-%dT%H:%M:%S");
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now.time_since_epoch()) % 1000;
+    oss << "." << std::setfill('0') << std::setw(3) << ms.count() << "Z";
+    log["utc_time"] = oss.str();
+    log["listen_end_time"] = oss.str();
+    log["extraction_timestamp"] = oss.str();
+    log["extracted_by"] = "async_event_monitor_cpp_v1.0_" + monitor_id;
+
+    return log;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "event_records.h"
+
+// C++17兼容性检查
+#if __cplusplus >= 201703L
+    #include <optional>
+    #define HAS_OPTIONAL 1
+#else
+    #define HAS_OPTIONAL 0
+    // 简单的optional替代实现
+    template<typename T>
+    class optional {
+    private:
+        bool has_value_;
+        T value_;
+    public:
+        optional() : has_value_(false) {}
+        optional(const T& val) : has_value_(true), value_(val) {}
+
+        bool has_value() const { return has_value_; }
+        const T& value() const { return value_; }
+        T& value() { return value_; }
+
+        explicit operator bool() const { return has_value_; }
+    };
+#endif
+
+// 简化的JSON值类型实现，避免variant依赖
+class JsonValue {
+public:
+    enum Type { STRING, INT64, DOUBLE, BOOL };
+
+private:
+    Type type_;
+    std::string str_val_;
+    int64_t int_val_;
+    double double_val_;
+    bool bool_val_;
+
+public:
+    // 默认构造函数，创建空字符串类型
+    JsonValue() : type_(STRING), str_val_(), int_val_(0), double_val_(0.0), bool_val_(false) {}
+    JsonValue(const std::string& s) : type_(STRING), str_val_(s), int_val_(0), double_val_(0.0), bool_val_(false) {}
+    JsonValue(const char* s) : type_(STRING), str_val_(s), int_val_(0), double_val_(0.0), bool_val_(false) {}
+    JsonValue(int64_t i) : type_(INT64), int_val_(i), double_val_(0.0), bool_val_(false) {}
+    JsonValue(int i) : type_(INT64), int_val_(i), double_val_(0.0), bool_val_(false) {}
+    JsonValue(double d) : type_(DOUBLE), str_val_(), int_val_(0), double_val_(d), bool_val_(false) {}
+    JsonValue(bool b) : type_(BOOL), str_val_(), int_val_(0), double_val_(0.0), bool_val_(b) {}
+
+    Type get_type() const { return type_; }
+    const std::string& as_string() const { return str_val_; }
+    int64_t as_int64() const { return int_val_; }
+    double as_double() const { return double_val_; }
+    bool as_bool() const { return bool_val_; }
+};
+
+using JsonObject = std::unordered_map<std::string, JsonValue>;
+
+// 路由事件日志：热路径上以定长结构入队，在日志线程中才转换为JSON
+struct RouteEventLog {
+    int source_id;                  // Logger::register_source 返回的来源编号
+    int session_id;
+    int64_t route_event_number;
+    int session_event_number;
+    int64_t offset_from_trigger_ns;    // 相对触发事件的偏移（单调时钟纳秒）
+    EventRecord event;                 // 事件时间戳为单调时钟纳秒
+};
+
+// 日志记录的JSON格式：记录构造、逐行序列化与解析（监控进程与离线工具共用）
+namespace LogJson {
+    // 直接序列化到输出缓冲区，不创建临时字符串（不含换行）
+    void append_json(std::string& out, const JsonObject& json);
+
+    // append_json 的逆过程：解析一行扁平JSON对象（值为字符串、数字、布尔，null字段忽略），
+    // 不含小数点和指数的数字解析为INT64。遇到嵌套对象/数组或格式错误时返回false
+    bool parse_json(const char* data, size_t len, JsonObject& out);
+
+    // 创建常用的JSON对象
+    JsonObject create_event_log(const std::string& event_type,
+                                const std::string& router_name,
+                                const std::string& user);
+
+    JsonObject create_session_start_log(const std::string& router_name,
+                                        int session_id,
+                                        const std::string& trigger_source,
+                                        const std::string& trigger_event_type,
+                                        const TriggerRecord& trigger,
+                                        const std::string& user);
+
+    JsonObject create_route_event_log(const std::string& router_name,
+                                      const RouteEventLog& event,
+                                      const std::string& user);
+
+    // 同上，墙上时间与接口名称由调用者给出（二进制日志解码）
+    JsonObject create_route_event_log(const std::string& router_name,
+                                      const RouteEventLog& event,
+                                      const std::string& user,
+                                      int64_t wall_time_ms,
+                                      const std::string& interface);
+
+    // 以毫秒时间戳格式化ISO 8601 UTC时间
+    std::string format_iso_timestamp(int64_t timestamp_ms);
+
+#if HAS_OPTIONAL
+    JsonObject create_session_completed_log(const std::string& router_name,
+                                            int session_id,
+                                            const std::optional<int64_t>& convergence_time_ms,
+                                            int route_events_count,
+                                            int64_t session_duration_ms,
+                                            int64_t convergence_threshold_ms,
+                                            const TriggerRecord& trigger,
+                                            const std::string& user);
+#else
+    JsonObject create_session_completed_log(const std::string& router_name,
+                                            int session_id,
+                                            const optional<int64_t>& convergence_time_ms,
+                                            int route_events_count,
+                                            int64_t session_duration_ms,
+                                            int64_t convergence_threshold_ms,
+                                            const TriggerRecord& trigger,
+                                            const std::string& user);
+#endif
+
+    JsonObject create_monitoring_start_log(const std::string& router_name,
+                                           const std::string& user,
+                                           int64_t convergence_threshold_ms,
+                                           const std::string& log_file_path,
+                                           const std::string& monitor_id);
+
+    JsonObject create_monitoring_completed_log(const std::string& router_name,
+                                               const std::string& log_file_path,
+                                               const std::string& user,
+                                               int64_t total_listen_duration_ms,
+                                               int64_t convergence_threshold_ms,
+                                               int64_t total_trigger_events,
+                                               int64_t netem_events_count,
+                                               int64_t route_events_in_trigger,
+                                               int64_t total_route_events,
+                                               int completed_sessions_count,
+                                               const std::string& monitor_id);
+
+    void append_json_value(std::string& out, const JsonValue& value);
+    // 字符串值的转义（不含两侧引号）
+    void append_escaped(std::string& out, const std::string& str);
+} // namespace LogJson
@@ -0,0 +1,403 @@
+#include "log_rotation.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+constexpr int ZSTD_LEVEL = 3;
+constexpr const char* ZSTD_SUFFIX = ".zst";
+
+// ioprio_set 常量（glibc未导出）
+constexpr int IOPRIO_WHO_PROCESS = 1;
+constexpr int IOPRIO_CLASS_IDLE = 3;
+constexpr int IOPRIO_CLASS_SHIFT = 13;
+
+// 日志路径拆分为 目录/、文件名主干、扩展名
+void split_log_path(const std::string& log_path, std::string& dir, std::string& stem, std::string& ext) {
+    size_t slash = log_path.rfind('/');
+    dir = slash == std::string::npos ? std::string() : log_path.substr(0, slash + 1);
+    std::string name = slash == std::string::npos ? log_path : log_path.substr(slash + 1);
+    size_t dot = name.rfind('.');
+    if (dot == std::string::npos || dot == 0) {
+        stem = name;
+        ext.clear();
+    } else {
+        stem = name.substr(0, dot);
+        ext = name.substr(dot);
+    }
+}
+
+#ifdef HAVE_ZSTD
+bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        len -= static_cast<size_t>(written);
+    }
+    return true;
+}
+#endif
+
+// 后台线程使用最低的CPU与IO优先级，压缩不与事件线程和日志线程争用
+void lower_thread_priority() {
+    pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    setpriority(PRIO_PROCESS, static_cast<id_t>(tid), 19);
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+}
+
+} // namespace
+
+namespace LogRotation {
+
+bool compression_available() {
+#ifdef HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool parse_size(const std::string& text, uint64_t& bytes) {
+    if (text.empty()) {
+        return false;
+    }
+    size_t digits = 0;
+    while (digits < text.size() && isdigit(static_cast<unsigned char>(text[digits]))) {
+        digits++;
+    }
+    if (digits == 0 || digits > 15) {
+        return false;
+    }
+    uint64_t value = std::stoull(text.substr(0, digits));
+    std::string suffix = text.substr(digits);
+    if (suffix.empty()) {
+        bytes = value;
+    } else if (suffix == "K" || suffix == "k") {
+        bytes = value << 10;
+    } else if (suffix == "M" || suffix == "m") {
+        bytes = value << 20;
+    } else if (suffix == "G" || suffix == "g") {
+        bytes = value << 30;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parse_compression(const std::string& name, LogCompression& compression) {
+    if (name == "none") {
+        compression = LogCompression::NONE;
+    } else if (name == "zstd") {
+        compression = LogCompression::ZSTD;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* compression_name(LogCompression compression) {
+    switch (compression) {
+        case LogCompression::NONE: return "none";
+        case LogCompression::ZSTD: return "zstd";
+    }
+    return "unknown";
+}
+
+std::string segment_path(const std::string& log_path, uint64_t sequence) {
+    std::string dir, stem, ext;
+    split_log_path(log_path, dir, stem, ext);
+    char number[32];
+    snprintf(number, sizeof(number), ".%06llu", static_cast<unsigned long long>(sequence));
+    return dir + stem + number + ext;
+}
+
+void list_segments(const std::string& log_path, std::vector<Segment>& segments) {
+    std::string dir, stem, ext;
+    split_log_path(log_path, dir, stem, ext);
+    DIR* handle = opendir(dir.empty() ? "." : dir.c_str());
+    if (!handle) {
+        return;
+    }
+    std::string prefix = stem + ".";
+    while (struct dirent* entry = readdir(handle)) {
+        std::string name = entry->d_name;
+        if (name.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        size_t pos = prefix.size();
+        size_t digits_end = pos;
+        while (digits_end < name.size() && isdigit(static_cast<unsigned char>(name[digits_end]))) {
+            digits_end++;
+        }
+        if (digits_end - pos < 6 || digits_end - pos > 18) {
+            continue;
+        }
+        std::string rest = name.substr(digits_end);
+        if (rest != ext && rest != ext + ZSTD_SUFFIX) {
+            continue;
+        }
+        segments.push_back(Segment{std::stoull(name.substr(pos, digits_end - pos)), dir + name});
+    }
+    closedir(handle);
+    std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+        return a.sequence != b.sequence ? a.sequence < b.sequence : a.path < b.path;
+    });
+}
+
+bool decompress_file(const std::string& path, std::string& out, std::string& error) {
+#ifdef HAVE_ZSTD
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "无法打开 " + path + ": " + strerror(errno);
+        return false;
+    }
+    ZSTD_DCtx* dctx = ZSTD_createDCtx();
+    std::vector<char> input(ZSTD_DStreamInSize());
+    std::vector<char> output(ZSTD_DStreamOutSize());
+    bool ok = true;
+    size_t last_ret = 0;
+    while (ok) {
+        ssize_t n = read(fd, input.data(), input.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = "无法读取 " + path + ": " + strerror(errno);
+            ok = false;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        ZSTD_inBuffer in{input.data(), static_cast<size_t>(n), 0};
+        while (in.pos < in.size) {
+            ZSTD_outBuffer chunk{output.data(), output.size(), 0};
+            last_ret = ZSTD_decompressStream(dctx, &chunk, &in);
+            if (ZSTD_isError(last_ret)) {
+                error = path + ": " + ZSTD_getErrorName(last_ret);
+                ok = false;
+                break;
+            }
+            out.append(output.data(), chunk.pos);
+        }
+    }
+    ZSTD_freeDCtx(dctx);
+    close(fd);
+    if (ok && last_ret != 0) {
+        error = path + ": 压缩数据不完整";
+        ok = false;
+    }
+    return ok;
+#else
+    error = "本版本编译时未启用zstd，无法读取 " + path;
+    (void)out;
+    return false;
+#endif
+}
+
+} // namespace LogRotation
+
+SegmentArchiver::SegmentArchiver(const std::string& log_path, LogCompression compression, int keep)
+    : log_path_(log_path), compression_(compression), keep_(keep) {}
+
+SegmentArchiver::~SegmentArchiver() {
+    stop();
+}
+
+void SegmentArchiver::start() {
+    if (worker_.joinable()) {
+        return;
+    }
+    std::vector<LogRotation::Segment> segments;
+    LogRotation::list_segments(log_path_, segments);
+    if (!segments.empty()) {
+        next_sequence_.store(segments.back().sequence + 1);
+    }
+    if (compression_ != LogCompression::NONE) {
+        // 上次运行结束时尚未压缩的分段
+        for (const auto& segment : segments) {
+            if (segment.path.size() < 4 || segment.path.compare(segment.path.size() - 4, 4, ZSTD_SUFFIX) != 0) {
+                queue_.push_back(segment.path);
+            }
+        }
+    }
+    worker_ = std::thread(&SegmentArchiver::worker_loop, this);
+}
+
+void SegmentArchiver::stop() {
+    if (!worker_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    worker_.join();
+}
+
+std::string SegmentArchiver::next_segment_path() const {
+    return LogRotation::segment_path(log_path_, next_sequence_.load());
+}
+
+void SegmentArchiver::submit(const std::string& segment_path) {
+    next_sequence_.fetch_add(1);
+    rotations_.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(segment_path);
+    }
+    cv_.notify_one();
+}
+
+void SegmentArchiver::worker_loop() {
+    lower_thread_priority();
+    enforce_retention();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            break;
+        }
+        std::string path = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        if (compression_ == LogCompression::ZSTD) {
+            compress(path);
+        }
+        enforce_retention();
+
+        lock.lock();
+    }
+}
+
+void SegmentArchiver::compress(const std::string& path) {
+#ifdef HAVE_ZSTD
+    int in_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in_fd < 0) {
+        // 已被保留策略删除
+        return;
+    }
+    std::string target = path + ZSTD_SUFFIX;
+    std::string temp = target + ".tmp";
+    int out_fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (out_fd < 0) {
+        std::cerr << "⚠️  无法创建压缩分段 " << temp << ": " << strerror(errno) << "\n";
+        failures_.fetch_add(1, std::memory_order_relaxed);
+        close(in_fd);
+        return;
+    }
+
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, ZSTD_LEVEL);
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1);
+    std::vector<char> input(ZSTD_CStreamInSize());
+    std::vector<char> output(ZSTD_CStreamOutSize());
+    int64_t bytes_in = 0;
+    int64_t bytes_out = 0;
+    bool ok = true;
+    while (ok) {
+        ssize_t n = read(in_fd, input.data(), input.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ok = false;
+            break;
+        }
+        bool last = n == 0;
+        bytes_in += n;
+        ZSTD_inBuffer in{input.data(), static_cast<size_t>(n), 0};
+        ZSTD_EndDirective mode = last ? ZSTD_e_end : ZSTD_e_continue;
+        bool finished = false;
+        while (ok && !finished) {
+            ZSTD_outBuffer chunk{output.data(), output.size(), 0};
+            size_t remaining = ZSTD_compressStream2(cctx, &chunk, &in, mode);
+            if (ZSTD_isError(remaining) || !write_all(out_fd, output.data(), chunk.pos)) {
+                ok = false;
+                break;
+            }
+            bytes_out += static_cast<int64_t>(chunk.pos);
+            finished = last ? remaining == 0 : in.pos == in.size;
+        }
+        if (last) {
+            break;
+        }
+    }
+    ZSTD_freeCCtx(cctx);
+    close(in_fd);
+
+    // 压缩结果落盘后才替换原分段，中途崩溃时原分段仍完整
+    ok = ok && fdatasync(out_fd) == 0;
+    close(out_fd);
+    if (ok && rename(temp.c_str(), target.c_str()) == 0) {
+        chmod(target.c_str(), 0666);
+        unlink(path.c_str());
+        compressed_.fetch_add(1, std::memory_order_relaxed);
+        bytes_in_.fetch_add(bytes_in, std::memory_order_relaxed);
+        bytes_out_.fetch_add(bytes_out, std::memory_order_relaxed);
+        return;
+    }
+    std::cerr << "⚠️  日志分段压缩失败 " << path << ": " << strerror(errno) << "，保留未压缩分段\n";
+    failures_.fetch_add(1, std::memory_order_relaxed);
+    unlink(temp.c_str());
+#else
+    (void)path;
+#endif
+}
+
+void SegmentArchiver::enforce_retention() {
+    if (keep_ <= 0) {
+        return;
+    }
+    std::vector<LogRotation::Segment> segments;
+    LogRotation::list_segments(log_path_, segments);
+    // 同一序号可能同时存在未压缩与压缩文件（压缩中途），按序号计数
+    std::vector<uint64_t> sequences;
+    for (const auto& segment : segments) {
+        if (sequences.empty() || sequences.back() != segment.sequence) {
+            sequences.push_back(segment.sequence);
+        }
+    }
+    if (sequences.size() <= static_cast<size_t>(keep_)) {
+        return;
+    }
+    uint64_t oldest_kept = sequences[sequences.size() - static_cast<size_t>(keep_)];
+    for (const auto& segment : segments) {
+        if (segment.sequence < oldest_kept && unlink(segment.path.c_str()) == 0) {
+            deleted_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void SegmentArchiver::append_pipeline_stats(PipelineStats::Report& report) const {
+    report.add_counter("log_rotations", rotations_.load(std::memory_order_relaxed));
+    report.add_counter("log_segments_compressed", compressed_.load(std::memory_order_relaxed));
+    report.add_counter("log_compress_bytes_in", bytes_in_.load(std::memory_order_relaxed));
+    report.add_counter("log_compress_bytes_out", bytes_out_.load(std::memory_order_relaxed));
+    report.add_counter("log_segments_deleted", deleted_.load(std::memory_order_relaxed));
+    report.add_counter("log_compress_failures", failures_.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pipeline_stats.h"
+
+// 日志分段（--log-max-size / --log-keep）
+//
+// 日志线程在一次批量写入后发现文件超过上限时，把当前文件改名为下一个分段
+//   <目录>/<文件名主干>.<6位序号><扩展名>       （如 convergence.000003.json）
+// 再重新创建原文件继续写入。改名是原子操作，记录不会跨分段，读取端看到的每个分段都是完整的日志。
+// 关闭的分段交给后台线程（最低CPU与IO优先级）流式压缩为 <分段>.zst，日志线程只做一次入队，
+// log_async 完全不受影响。分段总数超过 keep 时删除最旧的分段（含已压缩的）。
+enum class LogCompression {
+    NONE,
+    ZSTD            // 需要编译时找到 libzstd（HAVE_ZSTD）
+};
+
+namespace LogRotation {
+
+// 编译时是否启用了zstd
+bool compression_available();
+
+// 解析 64M / 512K / 2G / 1048576 形式的大小
+bool parse_size(const std::string& text, uint64_t& bytes);
+
+// 解析命令行中的压缩方式名称（none / zstd）
+bool parse_compression(const std::string& name, LogCompression& compression);
+const char* compression_name(LogCompression compression);
+
+// 日志文件 log_path 的第 sequence 个分段（未压缩）
+std::string segment_path(const std::string& log_path, uint64_t sequence);
+
+// 目录中 log_path 已有的分段（含已压缩），按序号升序
+struct Segment {
+    uint64_t sequence = 0;
+    std::string path;
+};
+void list_segments(const std::string& log_path, std::vector<Segment>& segments);
+
+// 整个 .zst 文件解压到内存（分段大小受 --log-max-size 限制），未启用zstd时返回false
+bool decompress_file(const std::string& path, std::string& out, std::string& error);
+
+} // namespace LogRotation
+
+// 分段的后台压缩与保留策略
+class SegmentArchiver {
+public:
+    SegmentArchiver(const std::string& log_path, LogCompression compression, int keep);
+    ~SegmentArchiver();
+
+    SegmentArchiver(const SegmentArchiver&) = delete;
+    SegmentArchiver& operator=(const SegmentArchiver&) = delete;
+
+    // 扫描已有分段（确定下一个序号），压缩上次运行遗留的未压缩分段，启动后台线程
+    void start();
+    // 处理完队列中的分段后退出
+    void stop();
+
+    // 日志线程调用：下一个分段的路径，submit 之后序号递增
+    std::string next_segment_path() const;
+    // 日志线程调用：分段已改名完成，交给后台线程（只加锁入队）
+    void submit(const std::string& segment_path);
+
+    // 分段次数、已压缩分段数、压缩前后字节数、删除的旧分段数、压缩失败次数
+    void append_pipeline_stats(PipelineStats::Report& report) const;
+
+private:
+    std::string log_path_;
+    LogCompression compression_;
+    int keep_;
+    std::atomic<uint64_t> next_sequence_{1};
+
+    std::deque<std::string> queue_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_{false};
+    std::thread worker_;
+
+    std::atomic<int64_t> rotations_{0};
+    std::atomic<int64_t> compressed_{0};
+    std::atomic<int64_t> bytes_in_{0};
+    std::atomic<int64_t> bytes_out_{0};
+    std::atomic<int64_t> deleted_{0};
+    std::atomic<int64_t> failures_{0};
+
+    void worker_loop();
+    void compress(const std::string& path);
+    void enforce_retention();
+};
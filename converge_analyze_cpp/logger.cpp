@@ -1,4 +1,6 @@
 #include "logger.h"
+#include "binary_log_format.h"
+#include "interface_cache.h"
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -8,6 +10,10 @@
 #include <libgen.h>
 #include <cstring>
 #include <fcntl.h>
+#include <cctype>
+#include <charconv>
+#include <poll.h>
+#include <sys/eventfd.h>
 
 // C++17兼容性检查
 #if __cplusplus >= 201703L
@@ -17,7 +23,78 @@
     #define HAS_FILESYSTEM 0
 #endif
 
-Logger::Logger(const std::string& log_path) {
+bool LoggerOptions::parse_overflow_policy(const std::string& name, LogOverflowPolicy& policy) {
+    if (name == "block") {
+        policy = LogOverflowPolicy::BLOCK;
+    } else if (name == "drop-newest") {
+        policy = LogOverflowPolicy::DROP_NEWEST;
+    } else if (name == "drop-oldest") {
+        policy = LogOverflowPolicy::DROP_OLDEST;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* LoggerOptions::overflow_policy_name(LogOverflowPolicy policy) {
+    switch (policy) {
+        case LogOverflowPolicy::BLOCK: return "block";
+        case LogOverflowPolicy::DROP_NEWEST: return "drop-newest";
+        case LogOverflowPolicy::DROP_OLDEST: return "drop-oldest";
+    }
+    return "unknown";
+}
+
+bool LoggerOptions::parse_fsync_policy(const std::string& name, LogFsyncPolicy& policy) {
+    if (name == "never") {
+        policy = LogFsyncPolicy::NEVER;
+    } else if (name == "batch") {
+        policy = LogFsyncPolicy::BATCH;
+    } else if (name == "close") {
+        policy = LogFsyncPolicy::CLOSE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* LoggerOptions::fsync_policy_name(LogFsyncPolicy policy) {
+    switch (policy) {
+        case LogFsyncPolicy::NEVER: return "never";
+        case LogFsyncPolicy::BATCH: return "batch";
+        case LogFsyncPolicy::CLOSE: return "close";
+    }
+    return "unknown";
+}
+
+bool LoggerOptions::parse_format(const std::string& name, LogFormat& format) {
+    if (name == "json") {
+        format = LogFormat::JSON;
+    } else if (name == "binary") {
+        format = LogFormat::BINARY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* LoggerOptions::format_name(LogFormat format) {
+    switch (format) {
+        case LogFormat::JSON: return "json";
+        case LogFormat::BINARY: return "binary";
+    }
+    return "unknown";
+}
+
+Logger::Logger(const std::string& log_path, const LoggerOptions& options)
+    : options_(options), log_queue_(options.queue_capacity) {
+    if (options_.format == LogFormat::BINARY) {
+        binary_encoder_ = std::make_unique<BinaryLog::Encoder>();
+    }
+    if (options_.exporter.enabled()) {
+        exporter_ = std::make_unique<Exporter>(options_.exporter);
+    }
+
     if (log_path.empty()) {
         log_file_path_ = setup_default_log_path();
     } else {
@@ -47,6 +124,10 @@ Logger::Logger(const std::string& log_path) {
             std::cout << "✅ 日志文件将创建在: " << log_file_path_ << "\n";
         }
     }
+
+    if (options_.max_size_bytes > 0) {
+        archiver_ = std::make_unique<SegmentArchiver>(log_file_path_, options_.compression, options_.keep_segments);
+    }
 }
 
 Logger::~Logger() {
@@ -63,17 +144,42 @@ void Logger::start() {
     // 确保日志文件以正确的权限创建（666权限，与Go版本一致）
     ensure_log_file_permissions(log_file_path_);
 
-    // 尝试打开日志文件
-    log_file_.open(log_file_path_, std::ios::out | std::ios::app);
-    if (!log_file_.is_open()) {
+    // 尝试打开日志文件（O_APPEND：多个监控器写同一文件时每次write整体追加）
+    log_fd_ = open(log_file_path_.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0666);
+    if (log_fd_ < 0) {
         std::cerr << "❌ 错误: 无法打开日志文件 " << log_file_path_ << "\n";
         std::cerr << "   请检查文件路径和权限，程序退出\n";
         running_.store(false);
         throw std::runtime_error("无法打开日志文件，程序退出");
+    } else if (binary_encoder_) {
+        std::cout << "✅ 二进制日志文件已配置: " << log_file_path_ << " (使用 converge_decode 解码)\n";
     } else {
         std::cout << "✅ JSON结构化日志文件已配置: " << log_file_path_ << "\n";
     }
 
+    struct stat st;
+    file_size_ = fstat(log_fd_, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+    if (archiver_) {
+        archiver_->start();
+    }
+
+    wakeup_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeup_fd_ < 0) {
+        running_.store(false);
+        throw std::runtime_error("无法创建日志线程唤醒描述符: " + std::string(strerror(errno)));
+    }
+
+    if (options_.preallocate) {
+        write_buffer_.assign(2 * WRITE_BUFFER_LIMIT, '\0');
+        write_buffer_.clear();
+    } else {
+        write_buffer_.reserve(64 * 1024);
+    }
+
+    if (exporter_) {
+        exporter_->start();
+    }
+
     // 启动日志处理线程
     log_thread_ = std::thread(&Logger::log_processor_loop, this);
 }
@@ -85,151 +191,440 @@ void Logger::stop() {
     
     running_.store(false);
     
-    // 通知日志处理线程
-    queue_cv_.notify_all();
+    // 通知日志处理线程（线程退出前会写完队列中剩余的记录）
+    wake_consumer();
     
     // 等待线程结束
     if (log_thread_.joinable()) {
         log_thread_.join();
     }
+
+    if (wakeup_fd_ >= 0) {
+        close(wakeup_fd_);
+        wakeup_fd_ = -1;
+    }
     
     // 关闭文件
-    if (log_file_.is_open()) {
-        log_file_.close();
+    if (log_fd_ >= 0) {
+        write_buffer();
+        if (options_.fsync_policy != LogFsyncPolicy::NEVER) {
+            fsync(log_fd_);
+        }
+        close(log_fd_);
+        log_fd_ = -1;
+    }
+
+    // 压缩完已关闭的分段后退出
+    if (archiver_) {
+        archiver_->stop();
+    }
+
+    // 日志线程已退出，不再有新记录交给导出器
+    if (exporter_) {
+        exporter_->stop();
     }
 }
 
+void Logger::fill_json_entry(LogEntry& entry, const JsonObject& data) const {
+    thread_local std::string scratch;
+    scratch.clear();
+    LogJson::append_json(scratch, data);
+    entry.kind = LogEntry::JSON;
+    entry.exported = should_export(data);
+    entry.text.assign(scratch);
+    entry.timestamp = std::chrono::system_clock::now();
+}
+
+template <typename Fill>
+void Logger::enqueue(Fill&& fill, LogOverflowPolicy policy) {
+    int64_t start = PipelineStats::sample(PipelineStats::LOG_ENQUEUE) ? EventClock::monotonic_ns() : 0;
+    while (!log_queue_.try_push_with(fill)) {
+        switch (policy) {
+            case LogOverflowPolicy::DROP_NEWEST:
+                dropped_count_.fetch_add(1, std::memory_order_relaxed);
+                if (start > 0) {
+                    enqueue_latency_.record(EventClock::monotonic_ns() - start);
+                }
+                return;
+            case LogOverflowPolicy::DROP_OLDEST: {
+                // 生产者自行取出最旧的一条丢弃，然后重试
+                if (log_queue_.try_pop_with([](LogEntry&) {})) {
+                    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+                }
+                break;
+            }
+            case LogOverflowPolicy::BLOCK:
+                wake_consumer();
+                std::this_thread::yield();
+                break;
+        }
+    }
+
+    // 与日志线程的 consumer_waiting_ 检查构成 Dekker 式配对，不会丢失唤醒
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumer_waiting_.load(std::memory_order_relaxed)) {
+        wake_consumer();
+    }
+    if (start > 0) {
+        enqueue_latency_.record(EventClock::monotonic_ns() - start);
+    }
+}
+
+void Logger::wake_consumer() {
+    if (wakeup_fd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t ret = write(wakeup_fd_, &one, sizeof(one));
+        (void)ret;
+    }
+}
+
+void Logger::wait_for_entries(int timeout_ms) {
+    consumer_waiting_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // 设置等待标志后再次检查，避免与生产者的竞争
+    if (log_queue_.empty() && running_.load() &&
+        flush_requested_.load() == flush_completed_.load()) {
+        struct pollfd pfd;
+        pfd.fd = wakeup_fd_;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        poll(&pfd, 1, timeout_ms);
+    }
+
+    consumer_waiting_.store(false, std::memory_order_relaxed);
+
+    uint64_t counter;
+    ssize_t ret = read(wakeup_fd_, &counter, sizeof(counter));
+    (void)ret;
+}
+
+int Logger::register_source(const std::string& router_name, const std::string& user,
+                            const InterfaceCache* interfaces) {
+    std::string prefix = "{\"event_type\":\"route_event\",\"router_name\":\"";
+    LogJson::append_escaped(prefix, router_name);
+    prefix += "\",\"user\":\"";
+    LogJson::append_escaped(prefix, user);
+    prefix += '"';
+
+    std::lock_guard<std::mutex> lock(sources_mutex_);
+    sources_.push_back(LogSource{router_name, user, interfaces, std::move(prefix)});
+    return static_cast<int>(sources_.size()) - 1;
+}
+
 void Logger::log_async(const JsonObject& data) {
-    std::unique_lock<std::mutex> lock(queue_mutex_);
-    
-    // 如果队列满了，丢弃最旧的条目
-    if (log_queue_.size() >= MAX_QUEUE_SIZE) {
-        log_queue_.pop();
-        std::cout << "⚠️  日志队列满，丢弃一条日志\n";
+    enqueue([&](LogEntry& entry) { fill_json_entry(entry, data); }, options_.overflow_policy);
+}
+
+void Logger::log_route_event(const RouteEventLog& event) {
+    enqueue([&](LogEntry& entry) {
+        entry.kind = LogEntry::ROUTE_EVENT;
+        entry.route_event = event;
+        entry.timestamp = std::chrono::system_clock::now();
+    }, options_.overflow_policy);
+}
+
+const Logger::LogSource& Logger::lookup_source(int source_id) const {
+    static const LogSource UNKNOWN_SOURCE{"", "", nullptr,
+                                          "{\"event_type\":\"route_event\",\"router_name\":\"\",\"user\":\"\""};
+    std::lock_guard<std::mutex> lock(sources_mutex_);
+    if (source_id >= 0 && source_id < static_cast<int>(sources_.size())) {
+        return sources_[source_id];
     }
-    
-    log_queue_.emplace(data);
-    lock.unlock();
-    
-    queue_cv_.notify_one();
+    return UNKNOWN_SOURCE;
 }
 
-void Logger::log_sync(const JsonObject& data) {
-    std::string json_str = json_to_string(data);
-    
-    if (log_file_.is_open()) {
-        log_file_ << json_str << "\n";
-        log_file_.flush();
-    } else {
-        std::cout << json_str << "\n";
+void Logger::append_wall_timestamp(std::string& out, int64_t wall_time_ms) {
+    int64_t second = wall_time_ms / 1000;
+    int millis = static_cast<int>(wall_time_ms % 1000);
+    if (millis < 0) {
+        second--;
+        millis += 1000;
+    }
+    if (second != cached_timestamp_second_) {
+        time_t seconds = static_cast<time_t>(second);
+        struct tm tm_utc;
+        gmtime_r(&seconds, &tm_utc);
+        cached_timestamp_len_ = strftime(cached_timestamp_, sizeof(cached_timestamp_),
+                                         "%Y-%m-%dT%H:%M:%S", &tm_utc);
+        cached_timestamp_second_ = second;
     }
+    out.append(cached_timestamp_, cached_timestamp_len_);
+    char fraction[6] = {'.', static_cast<char>('0' + millis / 100), static_cast<char>('0' + millis / 10 % 10),
+                        static_cast<char>('0' + millis % 10), 'Z', 0};
+    out.append(fraction, 5);
 }
 
-void Logger::log_processor_loop() {
-    while (running_.load() || !log_queue_.empty()) {
-        std::unique_lock<std::mutex> lock(queue_mutex_);
-        
-        // 等待有日志条目或停止信号
-        queue_cv_.wait(lock, [this] { 
-            return !log_queue_.empty() || !running_.load(); 
-        });
-        
-        // 处理所有待处理的日志条目
-        while (!log_queue_.empty()) {
-            LogEntry entry = std::move(log_queue_.front());
-            log_queue_.pop();
-            lock.unlock();
-            
-            // 生成JSON字符串并写入
-            std::string json_str = json_to_string(entry.data);
-            
-            if (log_file_.is_open()) {
-                log_file_ << json_str << "\n";
-                log_file_.flush();
+void Logger::append_route_event_json(std::string& out, const LogSource& source, const RouteEventLog& event) {
+    // 字段与 create_route_event_log 一致
+    char buffer[24];
+    auto append_int = [&](const char* key, int64_t value) {
+        out += key;
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    };
+
+    out += source.route_event_prefix;
+    out += ",\"timestamp\":\"";
+    append_wall_timestamp(out, EventClock::to_wall_ms(event.event.timestamp()));
+    out += '"';
+    append_int(",\"session_id\":", event.session_id);
+    out += ",\"route_event_type\":\"";
+    LogJson::append_escaped(out, EventFormat::event_label(event.event));
+    out += '"';
+    append_int(",\"route_event_number\":", event.route_event_number);
+    append_int(",\"session_event_number\":", event.session_event_number);
+    append_int(",\"offset_from_trigger_ms\":", event.offset_from_trigger_ns / EventClock::NS_PER_MS);
+    append_int(",\"offset_from_trigger_us\":", event.offset_from_trigger_ns / EventClock::NS_PER_US);
+
+    // route_info 是嵌套JSON文本，作为字符串值需要再转义一次
+    route_info_scratch_.clear();
+    {
+        InterfaceCache::Scope interface_scope(source.interfaces);
+        EventFormat::append_event_info(route_info_scratch_, event.event);
+    }
+    out += ",\"route_info\":\"";
+    LogJson::append_escaped(out, route_info_scratch_);
+    out += "\"}";
+}
+
+bool Logger::should_export(const LogEntry& entry) const {
+    if (!exporter_) {
+        return false;
+    }
+    if (entry.kind == LogEntry::ROUTE_EVENT) {
+        return exporter_->wants_route_events();
+    }
+    return entry.exported;
+}
+
+bool Logger::should_export(const JsonObject& data) const {
+    if (!exporter_) {
+        return false;
+    }
+    auto it = data.find("event_type");
+    return it != data.end() && exporter_->wants(it->second.as_string());
+}
+
+void Logger::write_entry(const LogEntry& entry) {
+    if (write_buffer_.empty()) {
+        buffer_start_ns_ = EventClock::monotonic_ns();
+    }
+    bool exported = should_export(entry);
+
+    if (binary_encoder_) {
+        if (entry.kind == LogEntry::JSON) {
+            binary_scratch_.clear();
+            LogJson::parse_json(entry.text.data(), entry.text.size(), binary_scratch_);
+            binary_encoder_->append_object(write_buffer_, binary_scratch_);
+        } else {
+            const LogSource& source = lookup_source(entry.route_event.source_id);
+            InterfaceCache::Scope interface_scope(source.interfaces);
+            binary_encoder_->append_route_event(write_buffer_, entry.route_event,
+                                                source.router_name, source.user,
+                                                EventFormat::interface_name(entry.route_event.event));
+        }
+        if (exported) {
+            // 导出始终使用JSON行：收集端无需二进制日志的字符串表
+            if (entry.kind == LogEntry::JSON) {
+                exporter_->submit(entry.text.data(), entry.text.size());
             } else {
-                std::cout << json_str << "\n";
+                export_buffer_.clear();
+                append_route_event_json(export_buffer_, lookup_source(entry.route_event.source_id),
+                                        entry.route_event);
+                exporter_->submit(export_buffer_.data(), export_buffer_.size());
             }
-            
-            lock.lock();
         }
+        return;
+    }
+
+    size_t start = write_buffer_.size();
+    if (entry.kind == LogEntry::JSON) {
+        write_buffer_ += entry.text;
+    } else {
+        append_route_event_json(write_buffer_, lookup_source(entry.route_event.source_id), entry.route_event);
+    }
+    if (exported) {
+        // 直接复用刚写入文件缓冲区的JSON文本
+        exporter_->submit(write_buffer_.data() + start, write_buffer_.size() - start);
     }
+    write_buffer_ += '\n';
 }
 
-std::string Logger::json_to_string(const JsonObject& json) const {
-    std::ostringstream oss;
-    oss << "{";
+void Logger::write_buffer() {
+    if (write_buffer_.empty()) {
+        return;
+    }
 
-    bool first = true;
-    for (const auto& pair : json) {
-        if (!first) {
-            oss << ",";
+    int64_t start = EventClock::monotonic_ns();
+    int fd = log_fd_ >= 0 ? log_fd_ : STDOUT_FILENO;
+    const char* data = write_buffer_.data();
+    size_t remaining = write_buffer_.size();
+    while (remaining > 0) {
+        ssize_t written = write(fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "❌ 日志写入失败: " << strerror(errno) << "\n";
+            break;
         }
-        first = false;
+        data += written;
+        remaining -= static_cast<size_t>(written);
+        file_size_ += static_cast<uint64_t>(written);
+    }
 
-        oss << "\"" << escape_json_string(pair.first) << "\":";
-        oss << json_value_to_string(pair.second);
+    if (options_.fsync_policy == LogFsyncPolicy::BATCH && log_fd_ >= 0) {
+        fdatasync(log_fd_);
     }
+    write_latency_.record(EventClock::monotonic_ns() - start);
 
-    oss << "}";
-    return oss.str();
+    write_buffer_.clear();
+    if (write_buffer_.capacity() > 4 * WRITE_BUFFER_LIMIT) {
+        write_buffer_.shrink_to_fit();
+    }
+
+    // 整批写出后再分段，记录不会被截断在两个分段之间；退出时的最后几批留在当前文件
+    if (archiver_ && log_fd_ >= 0 && running_.load() && file_size_ >= options_.max_size_bytes) {
+        rotate();
+    }
 }
 
-std::string Logger::json_value_to_string(const JsonValue& value) const {
-    switch (value.get_type()) {
-        case JsonValue::STRING:
-            return "\"" + escape_json_string(value.as_string()) + "\"";
-        case JsonValue::INT64:
-            return std::to_string(value.as_int64());
-        case JsonValue::DOUBLE: {
-            std::ostringstream oss;
-            oss << std::fixed << std::setprecision(3) << value.as_double();
-            return oss.str();
-        }
-        case JsonValue::BOOL:
-            return value.as_bool() ? "true" : "false";
-        default:
-            return "null";
+void Logger::rotate() {
+    // 先改名再创建新文件：任何时刻读取端都能看到完整的当前文件
+    std::string segment = archiver_->next_segment_path();
+    if (rename(log_file_path_.c_str(), segment.c_str()) != 0) {
+        std::cerr << "⚠️  日志分段失败 " << segment << ": " << strerror(errno) << "，继续写入当前文件\n";
+        file_size_ = 0;
+        return;
+    }
+    int fd = open(log_file_path_.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        std::cerr << "⚠️  无法创建新的日志文件 " << log_file_path_ << ": " << strerror(errno) << "，继续写入当前文件\n";
+        rename(segment.c_str(), log_file_path_.c_str());
+        file_size_ = 0;
+        return;
+    }
+    // 分段视同关闭日志，按落盘策略处理
+    if (options_.fsync_policy != LogFsyncPolicy::NEVER) {
+        fsync(log_fd_);
     }
+    close(log_fd_);
+    log_fd_ = fd;
+    ensure_log_file_permissions(log_file_path_);
+    file_size_ = 0;
+
+    // 每个分段自带流头与字符串表，可单独解码
+    if (binary_encoder_) {
+        binary_encoder_->reset();
+    }
+    archiver_->submit(segment);
 }
 
-std::string Logger::escape_json_string(const std::string& str) const {
-    std::string escaped;
-    escaped.reserve(str.length() + 10); // 预留一些空间给转义字符
-    
-    for (char c : str) {
-        switch (c) {
-            case '"':  escaped += "\\\""; break;
-            case '\\': escaped += "\\\\"; break;
-            case '\b': escaped += "\\b"; break;
-            case '\f': escaped += "\\f"; break;
-            case '\n': escaped += "\\n"; break;
-            case '\r': escaped += "\\r"; break;
-            case '\t': escaped += "\\t"; break;
-            default:
-                if (c < 0x20) {
-                    // 控制字符
-                    std::ostringstream oss;
-                    oss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
-                    escaped += oss.str();
-                } else {
-                    escaped += c;
-                }
+void Logger::append_pipeline_stats(PipelineStats::Report& report) const {
+    report.add_stage(PipelineStats::LOG_ENQUEUE, enqueue_latency_);
+    report.add_stage(PipelineStats::LOG_QUEUE, queue_latency_);
+    report.add_stage(PipelineStats::LOG_WRITE, write_latency_);
+    report.add_counter("log_queue_depth", static_cast<int64_t>(get_queue_depth()));
+    report.add_counter("log_queue_capacity", static_cast<int64_t>(get_queue_capacity()));
+    report.add_counter("log_dropped_records", get_dropped_count());
+    if (exporter_) {
+        exporter_->append_pipeline_stats(report);
+    }
+    if (archiver_) {
+        archiver_->append_pipeline_stats(report);
+    }
+}
+
+void Logger::log_sync(const JsonObject& data) {
+    if (!running_.load() || !log_thread_.joinable()) {
+        // 日志线程未运行，直接写入
+        LogEntry entry;
+        fill_json_entry(entry, data);
+        write_entry(entry);
+        write_buffer();
+        return;
+    }
+
+    // 同步记录始终等待槽位，不受溢出策略影响；写入顺序与异步记录一致
+    enqueue([&](LogEntry& entry) { fill_json_entry(entry, data); }, LogOverflowPolicy::BLOCK);
+    flush();
+}
+
+void Logger::flush() {
+    // 请求日志线程写出缓冲区（包括刷新间隔未到的记录），等待其完成
+    uint64_t ticket = flush_requested_.fetch_add(1) + 1;
+    while (running_.load() && flush_completed_.load() < ticket) {
+        wake_consumer();
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+void Logger::log_processor_loop() {
+    const int64_t interval_ns = static_cast<int64_t>(options_.flush_interval_ms) * EventClock::NS_PER_MS;
+
+    while (true) {
+        // 先读取刷新请求：请求之前入队的记录都会在本周期内被取出
+        uint64_t requested = flush_requested_.load();
+
+        // 处理所有待处理的日志条目：在槽位中原地序列化，槽位保留文本容量供生产者复用
+        auto consume = [this](const LogEntry& entry) {
+            if (PipelineStats::sample(PipelineStats::LOG_QUEUE)) {
+                queue_latency_.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now() - entry.timestamp).count());
+            }
+            write_entry(entry);
+        };
+        while (log_queue_.try_pop_with(consume)) {
+            if (write_buffer_.size() >= WRITE_BUFFER_LIMIT) {
+                write_buffer();
+            }
+        }
+
+        // 整个周期的记录合并为一次write
+        bool stopping = !running_.load();
+        if (!write_buffer_.empty() &&
+            (interval_ns == 0 || stopping || requested != flush_completed_.load() ||
+             EventClock::monotonic_ns() - buffer_start_ns_ >= interval_ns)) {
+            write_buffer();
+        }
+        flush_completed_.store(requested);
+
+        if (stopping) {
+            // 停止前再次清空队列
+            if (log_queue_.empty()) {
                 break;
+            }
+            continue;
+        }
+
+        // 缓冲区中有未到期的记录时，等待到刷新时刻
+        int timeout_ms = -1;
+        if (!write_buffer_.empty()) {
+            int64_t remaining_ns = buffer_start_ns_ + interval_ns - EventClock::monotonic_ns();
+            timeout_ms = remaining_ns > 0 ? static_cast<int>((remaining_ns + EventClock::NS_PER_MS - 1) / EventClock::NS_PER_MS) : 0;
         }
+        wait_for_entries(timeout_ms);
     }
-    
-    return escaped;
+
+    write_buffer();
+}
+
+std::string Logger::json_to_string(const JsonObject& json) const {
+    std::string out;
+    LogJson::append_json(out, json);
+    return out;
 }
 
 std::string Logger::setup_default_log_path() const {
-    std::string log_dir = "/var/log/frr";
+    const char* log_dir = "/var/log/frr";
     std::string log_file_path;
 
     // 检查目录是否存在，如果不存在尝试创建
     struct stat st;
-    if (stat(log_dir.c_str(), &st) != 0) {
+    if (stat(log_dir, &st) != 0) {
         // 目录不存在，尝试创建
-        if (mkdir(log_dir.c_str(), 0755) != 0) {
+        if (mkdir(log_dir, 0755) != 0) {
             std::cout << "⚠️  无法创建 /var/log/frr 目录，使用当前目录\n";
             log_dir = ".";
         } else {
@@ -237,7 +632,7 @@ std::string Logger::setup_default_log_path() const {
         }
     }
 
-    log_file_path = log_dir + "/async_route_convergence_cpp.json";
+    log_file_path = std::string(log_dir) + "/async_route_convergence_cpp.json";
 
     // 验证日志文件路径是否可用
     if (!test_file_creation(log_file_path)) {
@@ -340,189 +735,3 @@ void Logger::ensure_log_file_permissions(const std::string& path) const {
         chmod(path.c_str(), 0666);
     }
 }
-
-// 静态辅助方法实现
-JsonObject Logger::create_event_log(const std::string& event_type,
-                                   const std::string& router_name,
-                                   const std::string& user) {
-    JsonObject log;
-    log["event_type"] = event_type;
-    log["router_name"] = router_name;
-    log["user"] = user;
-
-    // 添加时间戳
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    std::ostringstream oss;
-    oss << std::put_time(std::gmtime(&time_t), "%Y-%m-%dT%H:%M:%S");
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-    oss << "." << std::setfill('0') << std::setw(3) << ms.count() << "Z";
-    log["timestamp"] = oss.str();
-
-    return log;
-}
-
-JsonObject Logger::create_session_start_log(const std::string& router_name,
-                                           int session_id,
-                                           const std::string& trigger_source,
-                                           const std::string& trigger_event_type,
-                                           const std::unordered_map<std::string, std::string>& trigger_info,
-                                           const std::string& user) {
-    auto log = create_event_log("session_started", router_name, user);
-    log["session_id"] = static_cast<int64_t>(session_id);
-    log["trigger_source"] = trigger_source;
-    log["trigger_event_type"] = trigger_event_type;
-
-    // 序列化trigger_info (简化版本)
-    std::ostringstream trigger_oss;
-    trigger_oss << "{";
-    bool first = true;
-    for (const auto& pair : trigger_info) {
-        if (!first) trigger_oss << ",";
-        first = false;
-        trigger_oss << "\"" << pair.first << "\":\"" << pair.second << "\"";
-    }
-    trigger_oss << "}";
-    log["trigger_info"] = trigger_oss.str();
-
-    return log;
-}
-
-JsonObject Logger::create_route_event_log(const std::string& router_name,
-                                         int session_id,
-                                         const std::string& route_event_type,
-                                         int64_t route_event_number,
-                                         int session_event_number,
-                                         int64_t offset_from_trigger_ms,
-                                         const std::unordered_map<std::string, std::string>& route_info,
-                                         const std::string& user) {
-    auto log = create_event_log("route_event", router_name, user);
-    log["session_id"] = static_cast<int64_t>(session_id);
-    log["route_event_type"] = route_event_type;
-    log["route_event_number"] = route_event_number;
-    log["session_event_number"] = static_cast<int64_t>(session_event_number);
-    log["offset_from_trigger_ms"] = offset_from_trigger_ms;
-
-    // 序列化route_info
-    std::ostringstream route_oss;
-    route_oss << "{";
-    bool first = true;
-    for (const auto& pair : route_info) {
-        if (!first) route_oss << ",";
-        first = false;
-        route_oss << "\"" << pair.first << "\":\"" << pair.second << "\"";
-    }
-    route_oss << "}";
-    log["route_info"] = route_oss.str();
-
-    return log;
-}
-
-#if HAS_OPTIONAL
-JsonObject Logger::create_session_completed_log(const std::string& router_name,
-                                               int session_id,
-                                               const std::optional<int64_t>& convergence_time_ms,
-                                               int route_events_count,
-                                               int64_t session_duration_ms,
-                                               int64_t convergence_threshold_ms,
-                                               const std::unordered_map<std::string, std::string>& netem_info,
-                                               const std::string& user) {
-#else
-JsonObject Logger::create_session_completed_log(const std::string& router_name,
-                                               int session_id,
-                                               const optional<int64_t>& convergence_time_ms,
-                                               int route_events_count,
-                                               int64_t session_duration_ms,
-                                               int64_t convergence_threshold_ms,
-                                               const std::unordered_map<std::string, std::string>& netem_info,
-                                               const std::string& user) {
-#endif
-    auto log = create_event_log("session_completed", router_name, user);
-    log["session_id"] = static_cast<int64_t>(session_id);
-
-    if (convergence_time_ms.has_value()) {
-        log["convergence_time_ms"] = convergence_time_ms.value();
-    }
-
-    log["route_events_count"] = static_cast<int64_t>(route_events_count);
-    log["session_duration_ms"] = session_duration_ms;
-    log["convergence_threshold_ms"] = convergence_threshold_ms;
-
-    // 序列化netem_info
-    std::ostringstream netem_oss;
-    netem_oss << "{";
-    bool first = true;
-    for (const auto& pair : netem_info) {
-        if (!first) netem_oss << ",";
-        first = false;
-        netem_oss << "\"" << pair.first << "\":\"" << pair.second << "\"";
-    }
-    netem_oss << "}";
-    log["netem_info"] = netem_oss.str();
-
-    return log;
-}
-
-JsonObject Logger::create_monitoring_start_log(const std::string& router_name,
-                                              const std::string& user,
-                                              int64_t convergence_threshold_ms,
-                                              const std::string& log_file_path,
-                                              const std::string& monitor_id) {
-    auto log = create_event_log("monitoring_started", router_name, user);
-    log["convergence_threshold_ms"] = convergence_threshold_ms;
-    log["log_file_path"] = log_file_path;
-    log["monitor_id"] = monitor_id;
-
-    // 添加UTC时间
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    std::ostringstream oss;
-    oss << std::put_time(std::gmtime(&time_t), "%Y-%m-%dT%H:%M:%S");
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-    oss << "." << std::setfill('0') << std::setw(3) << ms.count() << "Z";
-    log["utc_time"] = oss.str();
-    log["listen_start_time"] = oss.str();
-
-    return log;
-}
-
-JsonObject Logger::create_monitoring_completed_log(const std::string& router_name,
-                                                  const std::string& log_file_path,
-                                                  const std::string& user,
-                                                  int64_t total_listen_duration_ms,
-                                                  int64_t convergence_threshold_ms,
-                                                  int64_t total_trigger_events,
-                                                  int64_t netem_events_count,
-                                                  int64_t route_events_in_trigger,
-                                                  int64_t total_route_events,
-                                                  int completed_sessions_count,
-                                                  const std::string& monitor_id) {
-    auto log = create_event_log("monitoring_completed", router_name, user);
-    log["log_file_path"] = log_file_path;
-    log["total_listen_duration_ms"] = total_listen_duration_ms;
-    log["total_listen_duration_seconds"] = static_cast<double>(total_listen_duration_ms) / 1000.0;
-    log["convergence_threshold_ms"] = convergence_threshold_ms;
-    log["total_trigger_events"] = total_trigger_events;
-    log["netem_events_count"] = netem_events_count;
-    log["route_events_in_trigger"] = route_events_in_trigger;
-    log["total_route_events"] = total_route_events;
-    log["completed_sessions_count"] = static_cast<int64_t>(completed_sessions_count);
-    log["monitor_id"] = monitor_id;
-
-    // 添加时间信息
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    std::ostringstream oss;
-    oss << std::put_time(std::gmtime(&time_t), "%Y-%m-%dT%H:%M:%S");
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-    oss << "." << std::setfill('0') << std::setw(3) << ms.count() << "Z";
-    log["utc_time"] = oss.str();
-    log["listen_end_time"] = oss.str();
-    log["extraction_timestamp"] = oss.str();
-    log["extracted_by"] = "async_event_monitor_cpp_v1.0_" + monitor_id;
-
-    return log;
-}
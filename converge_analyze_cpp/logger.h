@@ -4,102 +4,186 @@
 #include <fstream>
 #include <memory>
 #include <queue>
+#include <deque>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
 #include <unordered_map>
-
-// C++17兼容性检查
-#if __cplusplus >= 201703L
-    #include <optional>
-    #define HAS_OPTIONAL 1
-#else
-    #define HAS_OPTIONAL 0
-    // 简单的optional替代实现
-    template<typename T>
-    class optional {
-    private:
-        bool has_value_;
-        T value_;
-    public:
-        optional() : has_value_(false) {}
-        optional(const T& val) : has_value_(true), value_(val) {}
-
-        bool has_value() const { return has_value_; }
-        const T& value() const { return value_; }
-        T& value() { return value_; }
-
-        explicit operator bool() const { return has_value_; }
+#include <vector>
+#include <chrono>
+
+#include "event_records.h"
+#include "event_clock.h"
+#include "ring_buffer.h"
+#include "pipeline_stats.h"
+#include "exporter.h"
+#include "log_rotation.h"
+#include "log_json.h"
+
+class InterfaceCache;
+
+// 日志条目结构：环形队列的槽位，入队与出队都在槽位中原地读写
+//   JSON        生产者渲染好的一行JSON文本（不含换行），字符串容量随槽位复用，不再携带JsonObject
+//   ROUTE_EVENT 定长路由事件，JSON在日志线程中生成
+struct LogEntry {
+    enum Kind {
+        JSON,
+        ROUTE_EVENT
     };
-#endif
 
-// 简化的JSON值类型实现，避免variant依赖
-class JsonValue {
-public:
-    enum Type { STRING, INT64, DOUBLE, BOOL };
+    Kind kind{JSON};
+    bool exported{false};           // JSON：入队时按 event_type 判断是否交给导出器
+    std::string text;
+    RouteEventLog route_event{};
+    std::chrono::system_clock::time_point timestamp{};
+};
 
-private:
-    Type type_;
-    std::string str_val_;
-    int64_t int_val_;
-    double double_val_;
-    bool bool_val_;
+// 日志队列满时的处理策略
+enum class LogOverflowPolicy {
+    BLOCK,          // 等待日志线程腾出槽位
+    DROP_NEWEST,    // 丢弃新记录
+    DROP_OLDEST     // 丢弃队列中最旧的记录
+};
 
-public:
-    // 默认构造函数，创建空字符串类型
-    JsonValue() : type_(STRING), str_val_(), int_val_(0), double_val_(0.0), bool_val_(false) {}
-    JsonValue(const std::string& s) : type_(STRING), str_val_(s), int_val_(0), double_val_(0.0), bool_val_(false) {}
-    JsonValue(const char* s) : type_(STRING), str_val_(s), int_val_(0), double_val_(0.0), bool_val_(false) {}
-    JsonValue(int64_t i) : type_(INT64), int_val_(i), double_val_(0.0), bool_val_(false) {}
-    JsonValue(int i) : type_(INT64), int_val_(i), double_val_(0.0), bool_val_(false) {}
-    JsonValue(double d) : type_(DOUBLE), str_val_(), int_val_(0), double_val_(d), bool_val_(false) {}
-    JsonValue(bool b) : type_(BOOL), str_val_(), int_val_(0), double_val_(0.0), bool_val_(b) {}
-
-    Type get_type() const { return type_; }
-    const std::string& as_string() const { return str_val_; }
-    int64_t as_int64() const { return int_val_; }
-    double as_double() const { return double_val_; }
-    bool as_bool() const { return bool_val_; }
+// 日志文件格式
+enum class LogFormat {
+    JSON,           // 每行一个JSON对象
+    BINARY          // 带字符串表的定长二进制记录（见 binary_log_format.h）
 };
 
-using JsonObject = std::unordered_map<std::string, JsonValue>;
+// 日志文件落盘策略
+enum class LogFsyncPolicy {
+    NEVER,          // 只调用write，由内核决定何时回写
+    BATCH,          // 每次批量写入后 fdatasync
+    CLOSE           // 仅在关闭日志时 fsync
+};
 
-// 日志条目结构
-struct LogEntry {
-    JsonObject data;
-    std::chrono::system_clock::time_point timestamp;
-    
-    LogEntry(const JsonObject& d) 
-        : data(d), timestamp(std::chrono::system_clock::now()) {}
+// 日志记录器配置
+struct LoggerOptions {
+    // 队列槽位数（向上取整为2的幂）
+    size_t queue_capacity = 8192;
+    LogOverflowPolicy overflow_policy = LogOverflowPolicy::DROP_OLDEST;
+    // 批量写入间隔（毫秒）：0 表示每个处理周期清空队列后立即写入
+    int flush_interval_ms = 0;
+    LogFsyncPolicy fsync_policy = LogFsyncPolicy::NEVER;
+    LogFormat format = LogFormat::JSON;
+    // 结果导出（--export）：会话记录同时发送到收集端，地址为空时关闭
+    ExportOptions exporter;
+    // 日志分段（--log-max-size）：文件超过该字节数后改名为分段并重新创建，0 表示不分段。
+    // 文件大小只统计本进程的写入，分段时假定日志文件只有一个写入进程
+    uint64_t max_size_bytes = 0;
+    // 保留的分段数（含已压缩），0 表示不删除
+    int keep_segments = 10;
+    // 关闭的分段在后台压缩（编译时未找到libzstd则默认不压缩）
+    LogCompression compression = LogRotation::compression_available() ? LogCompression::ZSTD : LogCompression::NONE;
+    // 启动时按上限分配并写入输出缓冲区（--low-jitter），批量写入时不再扩容缺页
+    bool preallocate = false;
+
+    // 解析命令行中的策略名称（block / drop-newest / drop-oldest）
+    static bool parse_overflow_policy(const std::string& name, LogOverflowPolicy& policy);
+    static const char* overflow_policy_name(LogOverflowPolicy policy);
+
+    // 解析命令行中的落盘策略名称（never / batch / close）
+    static bool parse_fsync_policy(const std::string& name, LogFsyncPolicy& policy);
+    static const char* fsync_policy_name(LogFsyncPolicy policy);
+
+    // 解析命令行中的日志格式名称（json / binary）
+    static bool parse_format(const std::string& name, LogFormat& format);
+    static const char* format_name(LogFormat format);
 };
 
+namespace BinaryLog {
+class Encoder;
+}
+
 // 异步日志记录器类
 class Logger {
 private:
     std::string log_file_path_;
-    std::ofstream log_file_;
+    int log_fd_{-1};
+    LoggerOptions options_;
+
+    // 输出缓冲区：一个处理周期内的所有记录序列化到这里，再以一次write写出
+    std::string write_buffer_;
+    int64_t buffer_start_ns_{0};
+    static constexpr size_t WRITE_BUFFER_LIMIT = 1 << 20;
+
+    // 二进制格式编码器（仅 LogFormat::BINARY，日志线程独占）
+    std::unique_ptr<BinaryLog::Encoder> binary_encoder_;
+
+    // 结果导出器（仅配置了 --export 时创建），由日志线程在写文件的同时交给它
+    std::unique_ptr<Exporter> exporter_;
+    std::string export_buffer_;
+
+    // 日志分段（仅配置了 max_size_bytes 时创建）：当前文件已写入的字节数由日志线程维护
+    std::unique_ptr<SegmentArchiver> archiver_;
+    uint64_t file_size_{0};
+
+    // log_sync 的刷新请求与完成计数
+    std::atomic<uint64_t> flush_requested_{0};
+    std::atomic<uint64_t> flush_completed_{0};
     
-    // 异步日志队列
-    std::queue<LogEntry> log_queue_;
-    mutable std::mutex queue_mutex_;
-    std::condition_variable queue_cv_;
+    // 异步日志队列：预分配槽位的无锁环形队列，生产者不加锁
+    BoundedRingBuffer<LogEntry> log_queue_;
+    std::atomic<int64_t> dropped_count_{0};
+
+    // 流水线阶段统计：入队（采样）、队列等待（日志线程采样）、批量写入
+    PipelineStats::StageLatency enqueue_latency_;
+    PipelineStats::StageLatency queue_latency_;
+    PipelineStats::StageLatency write_latency_;
+
+    // 日志线程空闲时阻塞在eventfd上；生产者只在其空闲时写eventfd唤醒
+    int wakeup_fd_{-1};
+    std::atomic<bool> consumer_waiting_{false};
     
     // 日志处理线程
     std::thread log_thread_;
     std::atomic<bool> running_{false};
-    
-    // 队列大小限制
-    static constexpr size_t MAX_QUEUE_SIZE = 1000;
+
+    // 日志来源（路由器名称、用户、所在命名空间的接口缓存），路由事件日志按编号引用
+    struct LogSource {
+        std::string router_name;
+        std::string user;
+        const InterfaceCache* interfaces = nullptr;
+        // 注册时预先转义拼接的常量字段：{"event_type":"route_event","router_name":...,"user":...
+        std::string route_event_prefix;
+    };
+    // deque 追加时不移动已有元素，查找结果在日志线程中可直接引用
+    std::deque<LogSource> sources_;
+    mutable std::mutex sources_mutex_;
+    const LogSource& lookup_source(int source_id) const;
+
+    // 路由事件JSON的时间戳缓存（日志线程独占）：同一秒内只格式化毫秒部分
+    int64_t cached_timestamp_second_{-1};
+    char cached_timestamp_[24]{};
+    size_t cached_timestamp_len_{0};
+    std::string route_info_scratch_;
+    // 二进制格式：JSON记录解析回字段后再编码（日志线程独占）
+    JsonObject binary_scratch_;
     
     // 内部方法
     void log_processor_loop();
+    void write_entry(const LogEntry& entry);
+    bool should_export(const LogEntry& entry) const;
+    bool should_export(const JsonObject& data) const;
+    // 把结构化日志渲染到槽位（生产者线程；渲染先写入线程局部缓冲区，缩短占用槽位的时间）
+    void fill_json_entry(LogEntry& entry, const JsonObject& data) const;
+    void write_buffer();
+    // 当前文件改名为下一个分段并重新创建（日志线程，缓冲区已写出）
+    void rotate();
+    template <typename Fill>
+    void enqueue(Fill&& fill, LogOverflowPolicy policy);
+    void wake_consumer();
+    void wait_for_entries(int timeout_ms);
+    void flush();
+    // 路由事件直接序列化为一行JSON：常量字段取来源的预渲染前缀，只格式化变化的字段
+    void append_route_event_json(std::string& out, const LogSource& source, const RouteEventLog& event);
+    void append_wall_timestamp(std::string& out, int64_t wall_time_ms);
     std::string json_to_string(const JsonObject& json) const;
-    std::string json_value_to_string(const JsonValue& value) const;
-    std::string escape_json_string(const std::string& str) const;
 
 public:
-    Logger(const std::string& log_path = "");
+    Logger(const std::string& log_path = "", const LoggerOptions& options = LoggerOptions());
     ~Logger();
     
     // 禁用拷贝和移动
@@ -111,73 +195,32 @@ public:
     void start();
     void stop();
     
+    // 注册日志来源，返回供 RouteEventLog::source_id 使用的编号；
+    // interfaces 为该来源所在命名空间的接口缓存（nullptr 表示进程共享实例）
+    int register_source(const std::string& router_name, const std::string& user,
+                        const InterfaceCache* interfaces = nullptr);
+
     // 异步记录结构化日志
     void log_async(const JsonObject& data);
+
+    // 异步记录路由事件（不构造JSON对象）
+    void log_route_event(const RouteEventLog& event);
     
-    // 同步记录日志（用于程序退出时的最终统计）
+    // 同步记录日志（用于程序退出时的最终统计）：经由同一队列写入，返回时已落盘
     void log_sync(const JsonObject& data);
+
+    // 因队列满而丢弃的记录数
+    int64_t get_dropped_count() const { return dropped_count_.load(std::memory_order_relaxed); }
+    // 队列中等待写出的记录数（近似值）
+    size_t get_queue_depth() const { return log_queue_.size_approx(); }
+    size_t get_queue_capacity() const { return log_queue_.capacity(); }
+
+    // 加入日志入队、队列等待与写入三个阶段，以及队列深度与丢弃计数（配置了导出、分段时含其计数）
+    void append_pipeline_stats(PipelineStats::Report& report) const;
+    const LoggerOptions& get_options() const { return options_; }
     
     // 获取日志文件路径
     const std::string& get_log_file_path() const { return log_file_path_; }
-    
-    // 辅助方法：创建常用的JSON对象
-    static JsonObject create_event_log(const std::string& event_type, 
-                                      const std::string& router_name,
-                                      const std::string& user);
-    
-    static JsonObject create_session_start_log(const std::string& router_name,
-                                              int session_id,
-                                              const std::string& trigger_source,
-                                              const std::string& trigger_event_type,
-                                              const std::unordered_map<std::string, std::string>& trigger_info,
-                                              const std::string& user);
-    
-    static JsonObject create_route_event_log(const std::string& router_name,
-                                            int session_id,
-                                            const std::string& route_event_type,
-                                            int64_t route_event_number,
-                                            int session_event_number,
-                                            int64_t offset_from_trigger_ms,
-                                            const std::unordered_map<std::string, std::string>& route_info,
-                                            const std::string& user);
-    
-#if HAS_OPTIONAL
-    static JsonObject create_session_completed_log(const std::string& router_name,
-                                                  int session_id,
-                                                  const std::optional<int64_t>& convergence_time_ms,
-                                                  int route_events_count,
-                                                  int64_t session_duration_ms,
-                                                  int64_t convergence_threshold_ms,
-                                                  const std::unordered_map<std::string, std::string>& netem_info,
-                                                  const std::string& user);
-#else
-    static JsonObject create_session_completed_log(const std::string& router_name,
-                                                  int session_id,
-                                                  const optional<int64_t>& convergence_time_ms,
-                                                  int route_events_count,
-                                                  int64_t session_duration_ms,
-                                                  int64_t convergence_threshold_ms,
-                                                  const std::unordered_map<std::string, std::string>& netem_info,
-                                                  const std::string& user);
-#endif
-    
-    static JsonObject create_monitoring_start_log(const std::string& router_name,
-                                                 const std::string& user,
-                                                 int64_t convergence_threshold_ms,
-                                                 const std::string& log_file_path,
-                                                 const std::string& monitor_id);
-    
-    static JsonObject create_monitoring_completed_log(const std::string& router_name,
-                                                     const std::string& log_file_path,
-                                                     const std::string& user,
-                                                     int64_t total_listen_duration_ms,
-                                                     int64_t convergence_threshold_ms,
-                                                     int64_t total_trigger_events,
-                                                     int64_t netem_events_count,
-                                                     int64_t route_events_in_trigger,
-                                                     int64_t total_route_events,
-                                                     int completed_sessions_count,
-                                                     const std::string& monitor_id);
 
 private:
     // 设置默认日志路径
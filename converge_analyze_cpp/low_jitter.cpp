@@ -0,0 +1,141 @@
+#include "low_jitter.h"
+#include "cpu_affinity.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+namespace LowJitter {
+
+namespace {
+
+Status g_status;
+
+// 内核隔离的CPU（isolcpus=），读取失败或为空时返回空列表
+std::vector<int> isolated_cpus() {
+    std::vector<int> cpus;
+    std::ifstream file("/sys/devices/system/cpu/isolated");
+    std::string line;
+    if (!std::getline(file, line) || line.empty()) {
+        return cpus;
+    }
+    std::string error;
+    if (!CpuAffinity::parse_cpu_list(line, cpus, error)) {
+        cpus.clear();
+    }
+    return cpus;
+}
+
+} // namespace
+
+void prepare_process(const std::vector<int>& cpus) {
+    g_status.enabled = true;
+    g_status.cpus = cpus;
+
+    // 释放的内存留在进程内复用，不再经 brk/munmap 归还后重新缺页
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+        g_status.memory_locked = true;
+    } else {
+        std::cerr << "⚠️  mlockall 失败: " << strerror(errno)
+                  << "（需要 CAP_IPC_LOCK 或足够的 ulimit -l），内存仍可能被换出\n";
+    }
+
+    if (cpus.empty()) {
+        return;
+    }
+    std::vector<int> isolated = isolated_cpus();
+    g_status.cpus_isolated = std::all_of(cpus.begin(), cpus.end(), [&isolated](int cpu) {
+        return std::find(isolated.begin(), isolated.end(), cpu) != isolated.end();
+    });
+
+    // 之后创建的线程（日志、导出、压缩）继承主线程的CPU集合；事件线程启动后再绑定到自己的CPU
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        std::cerr << "⚠️  无法读取CPU集合: " << strerror(errno) << "，其余线程不避开事件线程的CPU\n";
+        return;
+    }
+    for (int cpu : cpus) {
+        CPU_CLR(cpu, &allowed);
+    }
+    if (CPU_COUNT(&allowed) == 0) {
+        std::cerr << "⚠️  --cpu-list 占用了全部可用CPU，其余线程不避开事件线程的CPU\n";
+        return;
+    }
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(allowed), &allowed);
+    if (rc != 0) {
+        std::cerr << "⚠️  无法限制其余线程的CPU: " << strerror(rc) << "\n";
+        return;
+    }
+    g_status.cpus_exclusive = true;
+}
+
+const Status& status() {
+    return g_status;
+}
+
+void append_monitoring_fields(JsonObject& log, int64_t prefaulted_bytes) {
+    if (!g_status.enabled) {
+        return;
+    }
+    log["low_jitter"] = true;
+    log["low_jitter_mlockall"] = g_status.memory_locked;
+    log["low_jitter_rt_priority"] = g_status.realtime_priority;
+    log["low_jitter_prefault_bytes"] = prefaulted_bytes;
+    if (!g_status.cpus.empty()) {
+        log["low_jitter_cpus"] = CpuAffinity::describe(g_status.cpus);
+        log["low_jitter_cpus_isolated"] = g_status.cpus_isolated;
+        log["low_jitter_cpus_exclusive"] = g_status.cpus_exclusive;
+    }
+}
+
+void prefault_stack() {
+    volatile char stack[PREFAULT_STACK_BYTES];
+    for (size_t i = 0; i < sizeof(stack); i += 4096) {
+        stack[i] = 0;
+    }
+}
+
+RealtimeSpawnScope::RealtimeSpawnScope(int priority) {
+    if (priority <= 0) {
+        return;
+    }
+    struct sched_param saved;
+    if (pthread_getschedparam(pthread_self(), &saved_policy_, &saved) != 0) {
+        return;
+    }
+    saved_priority_ = saved.sched_priority;
+
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rc != 0) {
+        std::cerr << "⚠️  无法设置 SCHED_FIFO 优先级 " << priority << ": " << strerror(rc)
+                  << "（需要 CAP_SYS_NICE 或足够的 ulimit -r），事件线程使用普通调度\n";
+        g_status.realtime_priority = 0;
+        return;
+    }
+    active_ = true;
+    g_status.realtime_priority = priority;
+}
+
+RealtimeSpawnScope::~RealtimeSpawnScope() {
+    if (!active_) {
+        return;
+    }
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = saved_priority_;
+    pthread_setschedparam(pthread_self(), saved_policy_, &param);
+}
+
+} // namespace LowJitter
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "logger.h"
+
+// 低抖动测量模式（--low-jitter）
+//
+// 测得的收敛时间中有一部分离群值来自监控器本身：首次写入会话事件内存时的缺页、netlink线程被抢占、
+// 日志线程的IO与事件线程争用同一CPU。本模式在启动时：
+//   - 预分配并预先触及会话事件内存块与日志写缓冲区，mlockall 锁定当前与以后的全部内存，
+//     关闭 malloc 向系统归还内存（否则释放后再次分配又会缺页）
+//   - 事件线程（单命名空间为netlink监控线程，多命名空间为事件线程池）以 SCHED_FIFO 运行；
+//     日志、导出、压缩等线程保持普通优先级
+//   - 配置了 --cpu-list 时事件线程绑定到这些CPU，其余线程避开这些CPU
+// 每项是否生效写入 monitoring_started 日志（low_jitter_* 字段），失败只警告不退出。
+namespace LowJitter {
+
+// 每个监控器预先分配的会话事件内存块数（每块 EventSlabPool::SLAB_BYTES）
+constexpr size_t PREFILL_SLABS = 16;
+// 事件线程启动时预先触及的栈空间
+constexpr size_t PREFAULT_STACK_BYTES = 256 * 1024;
+
+// 进程级设置的结果
+struct Status {
+    bool enabled = false;
+    bool memory_locked = false;
+    // 事件线程实际获得的 SCHED_FIFO 优先级，0 表示未生效
+    int realtime_priority = 0;
+    // 事件线程使用的CPU，以及它们是否都在内核隔离列表（isolcpus）中、其余线程是否已避开它们
+    std::vector<int> cpus;
+    bool cpus_isolated = false;
+    bool cpus_exclusive = false;
+};
+
+// 主线程在创建任何监控器之前调用一次：锁定内存、调整malloc，并让之后创建的线程避开 cpus
+void prepare_process(const std::vector<int>& cpus);
+
+const Status& status();
+
+// 在 monitoring_started 日志中加入各项设置是否生效；prefaulted_bytes 为该监控器预先触及的字节数
+void append_monitoring_fields(JsonObject& log, int64_t prefaulted_bytes);
+
+// 在调用线程的栈上预先触及 PREFAULT_STACK_BYTES（mlockall 失败时仍可避免运行中的栈缺页）
+void prefault_stack();
+
+// 作用域内调用线程以 SCHED_FIFO 运行，期间创建的线程继承该调度策略（事件线程由此获得实时优先级，
+// 结果在线程启动前即可确定并写入日志）；析构时恢复调用线程原来的调度策略。priority 为0时不做任何事
+class RealtimeSpawnScope {
+public:
+    explicit RealtimeSpawnScope(int priority);
+    ~RealtimeSpawnScope();
+
+    RealtimeSpawnScope(const RealtimeSpawnScope&) = delete;
+    RealtimeSpawnScope& operator=(const RealtimeSpawnScope&) = delete;
+
+private:
+    bool active_{false};
+    int saved_policy_{0};
+    int saved_priority_{0};
+};
+
+} // namespace LowJitter
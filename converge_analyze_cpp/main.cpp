@@ -12,9 +12,14 @@
 
 #include "convergence_monitor.h"
 #include "logger.h"
+#include "netns_group.h"
+#include "cpu_affinity.h"
+#include "low_jitter.h"
 
 // Global shutdown flag
 std::atomic<bool> shutdown_requested{false};
+// SIGUSR1：请求输出流水线统计（在主循环中处理，信号处理函数中只设置标志）
+std::atomic<bool> stats_requested{false};
 std::unique_ptr<ConvergenceMonitor> global_monitor;
 
 void signal_handler(int signal) {
@@ -27,6 +32,36 @@ void signal_handler(int signal) {
     }
 }
 
+void stats_signal_handler(int) {
+    stats_requested.store(true);
+}
+
+// 周期性写入 monitor_stats 日志，收到SIGUSR1时同时输出到控制台
+class StatsTicker {
+public:
+    explicit StatsTicker(int interval_s)
+        : interval_ns_(static_cast<int64_t>(interval_s) * EventClock::NS_PER_SEC),
+          next_ns_(EventClock::monotonic_ns() + interval_ns_) {}
+
+    template <typename Target>
+    void poll(Target& target) {
+        bool print = stats_requested.exchange(false);
+        int64_t now = EventClock::monotonic_ns();
+        bool due = interval_ns_ > 0 && now >= next_ns_;
+        if (!print && !due) {
+            return;
+        }
+        if (due) {
+            next_ns_ = now + interval_ns_;
+        }
+        target.report_pipeline_stats(print);
+    }
+
+private:
+    int64_t interval_ns_;
+    int64_t next_ns_;
+};
+
 void print_usage(const char* program_name) {
     std::cout << "异步路由收敛时间监控工具 - C++多线程版本\n\n";
     std::cout << "使用说明:\n";
@@ -35,10 +70,12 @@ void print_usage(const char* program_name) {
     std::cout << "    2. 触发事件策略:\n";
     std::cout << "       - 在IDLE状态: 任何事件(Netem或路由变更)都会立即触发新的收敛测量会话\n";
     std::cout << "       - 在监控状态: 新事件会被当作路由事件添加到当前会话中\n";
+    std::cout << "       - --max-sessions N>1 时: 其他接口上的Netem/链路触发开始并发会话，事件按 --attribution 归属\n";
     std::cout << "       - 支持的触发事件:\n";
     std::cout << "         * Netem命令: tc qdisc add dev eth0 root netem delay 10ms\n";
     std::cout << "         * 路由添加: ip route add 192.168.1.0/24 via 10.0.0.1\n";
     std::cout << "         * 路由删除: ip route del 192.168.1.0/24\n";
+    std::cout << "         * 链路变化: ip link set eth0 down / up\n";
     std::cout << "    3. 观察路由收敛过程和时间测量\n\n";
     std::cout << "  C++多线程特性:\n";
     std::cout << "    - 多线程并发处理netlink事件\n";
@@ -50,11 +87,52 @@ void print_usage(const char* program_name) {
     std::cout << "示例:\n";
     std::cout << "  " << program_name << " --threshold 3000 --router-name spine1\n";
     std::cout << "  " << program_name << " --threshold 5000 --router-name leaf2 --log-path /tmp/my_convergence.json\n";
-    std::cout << "  " << program_name << " --log-path ./logs/convergence_cpp.json\n\n";
+    std::cout << "  " << program_name << " --log-path ./logs/convergence_cpp.json\n";
+    std::cout << "  " << program_name << " --filter-proto zebra,ospf,isis,bgp --filter-qdisc netem\n\n";
     std::cout << "选项:\n";
     std::cout << "  -t, --threshold MILLISECONDS  收敛判断阈值(毫秒，默认3000ms)\n";
     std::cout << "  -r, --router-name NAME        路由器名称标识，用于日志记录(默认自动生成)\n";
     std::cout << "  -l, --log-path PATH           日志文件路径(默认: /var/log/frr/async_route_convergence_cpp.json)\n";
+    std::cout << "      --rcvbuf BYTES            Netlink接收缓冲区大小(SO_RCVBUFFORCE，默认系统值)\n";
+    std::cout << "      --batch N                 每次recvmmsg批量接收的数据报数(默认1，逐条recv)\n";
+    std::cout << "      --filter-family LIST      仅接收指定地址族的路由(inet,inet6)\n";
+    std::cout << "      --filter-proto LIST       仅接收指定协议的路由(如 zebra,ospf,isis,bgp 或编号)\n";
+    std::cout << "      --filter-table LIST       仅接收指定路由表的路由(main,local 或 0-255)\n";
+    std::cout << "      --filter-qdisc LIST       仅接收指定类型的QDisc事件(如 netem)\n";
+    std::cout << "      --no-link-triggers        链路UP/DOWN不触发新会话(仍记录为会话内事件)\n";
+    std::cout << "      --kernel-timestamps       请求内核接收时间戳(SO_TIMESTAMPNS)，不可用时使用出队时间\n";
+    std::cout << "      --source SOURCE           路由事件来源: netlink(默认), ebpf(内核FIB修改处的fexit程序，不受netlink队列溢出影响)\n";
+    std::cout << "      --max-sessions N          同时进行的会话数上限(默认1；不同接口/前缀的触发各自开始会话)\n";
+    std::cout << "      --attribution POLICY      并发会话的事件归属: all-open(默认), latest, nearest-prefix\n";
+    std::cout << "      --prefix-report N         会话结束时报告最慢的N个前缀(默认10，0关闭逐前缀跟踪)\n";
+    std::cout << "      --no-fib-mirror           不在启动时转储路由表，路由通知不做新增/变更/重复分类\n";
+    std::cout << "      --ignore-noop-routes      属性未变化的重复路由通知不延长静默期、不触发会话\n";
+    std::cout << "      --netns-dir DIR           监控目录中的全部网络命名空间(如 /var/run/netns)，每个命名空间以其名称为路由器名\n";
+    std::cout << "      --netns-glob PATTERN      仅监控名称匹配通配符的命名空间(默认 *，需配合 --netns-dir)\n";
+    std::cout << "      --workers N               多命名空间模式的事件线程数(默认1)\n";
+    std::cout << "      --cpu-list LIST           事件线程绑定的CPU(如 0-3,6)，单命名空间时绑定netlink线程\n";
+    std::cout << "      --no-work-stealing        关闭空闲事件线程迁移繁忙线程的命名空间\n";
+    std::cout << "      --retain-events MODE      已完成会话的保留方式: none(仅写日志), summary(默认), full\n";
+    std::cout << "      --log-queue N             日志队列槽位数(默认8192)\n";
+    std::cout << "      --log-overflow POLICY     日志队列满时的策略: block, drop-newest, drop-oldest(默认)\n";
+    std::cout << "      --log-format FORMAT       日志格式: json(默认), binary(使用 converge_decode 解码)\n";
+    std::cout << "      --flush-interval-ms MS    日志批量写入间隔(默认0，每批记录处理完立即写入)\n";
+    std::cout << "      --fsync POLICY            日志落盘策略: never(默认), batch, close\n";
+    std::cout << "      --log-max-size SIZE       日志超过SIZE(如 64M, 512K)后改名为分段 <文件名>.000001.json 并重新创建(默认不分段)\n";
+    std::cout << "      --log-keep N              保留的日志分段数(默认10，0表示不删除)\n";
+    std::cout << "      --log-compress MODE       分段的后台压缩: zstd(编译时启用libzstd时默认), none\n";
+    std::cout << "      --record FILE             同时把收到的原始netlink数据报及接收时间录制到抓包文件\n";
+    std::cout << "      --replay FILE             不监听内核，按虚拟时钟全速回放抓包文件后退出(可配合不同阈值反复分析)\n";
+    std::cout << "      --status-dir DIR          在DIR下发布实时状态页 <路由器名称>.status(如 /dev/shm/converge，供编排脚本轮询)\n";
+    std::cout << "      --injection-id-file FILE  会话开始时读取FILE内容作为注入编号写入会话日志(供 converge_aggregate --correlate)\n";
+    std::cout << "      --export ADDR             把会话记录实时发送到收集端: udp://HOST:PORT, tcp://HOST:PORT, unix:PATH\n";
+    std::cout << "      --export-route-events     同时导出逐条路由事件(默认只导出会话与监控起止记录)\n";
+    std::cout << "      --export-buffer BYTES     导出待发送缓冲区上限(默认4194304，超出时丢弃并计数)\n";
+    std::cout << "      --export-interval-ms MS   导出批量发送间隔(默认100，0表示有记录即发送)\n";
+    std::cout << "      --low-jitter              低抖动测量: 预分配并锁定内存(mlockall)，事件线程SCHED_FIFO，其余线程避开 --cpu-list\n";
+    std::cout << "      --rt-priority N           --low-jitter 时事件线程的SCHED_FIFO优先级(1-99，默认50)\n";
+    std::cout << "      --stats-interval SECONDS  每隔N秒写入一条monitor_stats流水线统计日志(默认60，0关闭；SIGUSR1随时输出)\n";
+    std::cout << "      --stage-sample N          流水线阶段计时的采样间隔，每N条消息计时一次(默认16，0关闭)\n";
     std::cout << "  -h, --help                    显示此帮助信息\n";
 }
 
@@ -69,23 +147,118 @@ std::string generate_router_name() {
     return "router_" + get_current_user() + "_" + std::to_string(time_t);
 }
 
+// 仅长格式的选项编号
+enum LongOnlyOption {
+    OPT_RCVBUF = 1000,
+    OPT_BATCH,
+    OPT_FILTER_FAMILY,
+    OPT_FILTER_PROTO,
+    OPT_FILTER_TABLE,
+    OPT_FILTER_QDISC,
+    OPT_NO_LINK_TRIGGERS,
+    OPT_KERNEL_TIMESTAMPS,
+    OPT_SOURCE,
+    OPT_MAX_SESSIONS,
+    OPT_ATTRIBUTION,
+    OPT_PREFIX_REPORT,
+    OPT_NO_FIB_MIRROR,
+    OPT_IGNORE_NOOP_ROUTES,
+    OPT_NETNS_DIR,
+    OPT_NETNS_GLOB,
+    OPT_WORKERS,
+    OPT_CPU_LIST,
+    OPT_NO_WORK_STEALING,
+    OPT_RETAIN_EVENTS,
+    OPT_LOG_QUEUE,
+    OPT_LOG_OVERFLOW,
+    OPT_LOG_FORMAT,
+    OPT_FLUSH_INTERVAL,
+    OPT_FSYNC,
+    OPT_LOG_MAX_SIZE,
+    OPT_LOG_KEEP,
+    OPT_LOG_COMPRESS,
+    OPT_RECORD,
+    OPT_REPLAY,
+    OPT_STATUS_DIR,
+    OPT_INJECTION_ID_FILE,
+    OPT_EXPORT,
+    OPT_EXPORT_ROUTE_EVENTS,
+    OPT_EXPORT_BUFFER,
+    OPT_EXPORT_INTERVAL,
+    OPT_LOW_JITTER,
+    OPT_RT_PRIORITY,
+    OPT_STATS_INTERVAL,
+    OPT_STAGE_SAMPLE,
+};
+
 int main(int argc, char* argv[]) {
     // 默认参数
     int64_t threshold = 3000;
     std::string router_name;
     std::string log_path;
+    MonitorOptions options;
+    std::string netns_dir;
+    std::string netns_glob;
+    WorkerPoolOptions pool_options;
+    std::string cpu_error;
+    int stats_interval_s = 60;
+    int stage_sample = PipelineStats::sample_interval();
 
     // 解析命令行参数
     static struct option long_options[] = {
         {"threshold", required_argument, 0, 't'},
         {"router-name", required_argument, 0, 'r'},
         {"log-path", required_argument, 0, 'l'},
+        {"rcvbuf", required_argument, 0, OPT_RCVBUF},
+        {"batch", required_argument, 0, OPT_BATCH},
+        {"filter-family", required_argument, 0, OPT_FILTER_FAMILY},
+        {"filter-proto", required_argument, 0, OPT_FILTER_PROTO},
+        {"filter-table", required_argument, 0, OPT_FILTER_TABLE},
+        {"filter-qdisc", required_argument, 0, OPT_FILTER_QDISC},
+        {"no-link-triggers", no_argument, 0, OPT_NO_LINK_TRIGGERS},
+        {"kernel-timestamps", no_argument, 0, OPT_KERNEL_TIMESTAMPS},
+        {"source", required_argument, 0, OPT_SOURCE},
+        {"max-sessions", required_argument, 0, OPT_MAX_SESSIONS},
+        {"attribution", required_argument, 0, OPT_ATTRIBUTION},
+        {"prefix-report", required_argument, 0, OPT_PREFIX_REPORT},
+        {"no-fib-mirror", no_argument, 0, OPT_NO_FIB_MIRROR},
+        {"ignore-noop-routes", no_argument, 0, OPT_IGNORE_NOOP_ROUTES},
+        {"netns-dir", required_argument, 0, OPT_NETNS_DIR},
+        {"netns-glob", required_argument, 0, OPT_NETNS_GLOB},
+        {"workers", required_argument, 0, OPT_WORKERS},
+        {"cpu-list", required_argument, 0, OPT_CPU_LIST},
+        {"no-work-stealing", no_argument, 0, OPT_NO_WORK_STEALING},
+        {"retain-events", required_argument, 0, OPT_RETAIN_EVENTS},
+        {"log-queue", required_argument, 0, OPT_LOG_QUEUE},
+        {"log-overflow", required_argument, 0, OPT_LOG_OVERFLOW},
+        {"log-format", required_argument, 0, OPT_LOG_FORMAT},
+        {"flush-interval-ms", required_argument, 0, OPT_FLUSH_INTERVAL},
+        {"fsync", required_argument, 0, OPT_FSYNC},
+        {"log-max-size", required_argument, 0, OPT_LOG_MAX_SIZE},
+        {"log-keep", required_argument, 0, OPT_LOG_KEEP},
+        {"log-compress", required_argument, 0, OPT_LOG_COMPRESS},
+        {"record", required_argument, 0, OPT_RECORD},
+        {"replay", required_argument, 0, OPT_REPLAY},
+        {"status-dir", required_argument, 0, OPT_STATUS_DIR},
+        {"injection-id-file", required_argument, 0, OPT_INJECTION_ID_FILE},
+        {"export", required_argument, 0, OPT_EXPORT},
+        {"export-route-events", no_argument, 0, OPT_EXPORT_ROUTE_EVENTS},
+        {"export-buffer", required_argument, 0, OPT_EXPORT_BUFFER},
+        {"export-interval-ms", required_argument, 0, OPT_EXPORT_INTERVAL},
+        {"low-jitter", no_argument, 0, OPT_LOW_JITTER},
+        {"rt-priority", required_argument, 0, OPT_RT_PRIORITY},
+        {"stats-interval", required_argument, 0, OPT_STATS_INTERVAL},
+        {"stage-sample", required_argument, 0, OPT_STAGE_SAMPLE},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
 
     int option_index = 0;
     int c;
+    std::string filter_error;
+    bool filter_ok = true;
+    long long log_queue_capacity = static_cast<long long>(options.logger.queue_capacity);
+    long long export_buffer_bytes = static_cast<long long>(options.logger.exporter.buffer_bytes);
     while ((c = getopt_long(argc, argv, "t:r:l:h", long_options, &option_index)) != -1) {
         switch (c) {
             case 't':
@@ -97,6 +270,160 @@ int main(int argc, char* argv[]) {
             case 'l':
                 log_path = optarg;
                 break;
+            case OPT_RCVBUF:
+                options.netlink.rcvbuf_bytes = std::stoi(optarg);
+                break;
+            case OPT_BATCH:
+                options.netlink.batch_size = static_cast<unsigned int>(std::stoul(optarg));
+                break;
+            case OPT_FILTER_FAMILY:
+                filter_ok = filter_ok && NetlinkSocketFilter::parse_families(
+                    optarg, options.netlink.filter.families, filter_error);
+                break;
+            case OPT_FILTER_PROTO:
+                filter_ok = filter_ok && NetlinkSocketFilter::parse_protocols(
+                    optarg, options.netlink.filter.protocols, filter_error);
+                break;
+            case OPT_FILTER_TABLE:
+                filter_ok = filter_ok && NetlinkSocketFilter::parse_tables(
+                    optarg, options.netlink.filter.tables, filter_error);
+                break;
+            case OPT_FILTER_QDISC:
+                filter_ok = filter_ok && NetlinkSocketFilter::parse_qdisc_kinds(
+                    optarg, options.netlink.filter.qdisc_kinds, filter_error);
+                break;
+            case OPT_NO_LINK_TRIGGERS:
+                options.link_triggers = false;
+                break;
+            case OPT_KERNEL_TIMESTAMPS:
+                options.netlink.kernel_timestamps = true;
+                break;
+            case OPT_SOURCE:
+                if (!NetlinkMonitor::parse_route_source(optarg, options.netlink.route_source)) {
+                    std::cerr << "❌ 错误: 未知的路由事件来源 '" << optarg << "'，可选 netlink, ebpf\n";
+                    return 1;
+                }
+                break;
+            case OPT_MAX_SESSIONS:
+                options.max_sessions = std::stoi(optarg);
+                break;
+            case OPT_ATTRIBUTION:
+                if (!MonitorOptions::parse_attribution(optarg, options.attribution)) {
+                    std::cerr << "❌ 错误: 未知的事件归属策略 '" << optarg
+                              << "'，可选 all-open, latest, nearest-prefix\n";
+                    return 1;
+                }
+                break;
+            case OPT_PREFIX_REPORT:
+                options.prefix_report = std::stoi(optarg);
+                break;
+            case OPT_NO_FIB_MIRROR:
+                options.fib_mirror = false;
+                break;
+            case OPT_IGNORE_NOOP_ROUTES:
+                options.ignore_noop_routes = true;
+                break;
+            case OPT_NETNS_DIR:
+                netns_dir = optarg;
+                break;
+            case OPT_NETNS_GLOB:
+                netns_glob = optarg;
+                break;
+            case OPT_WORKERS:
+                pool_options.workers = std::stoi(optarg);
+                break;
+            case OPT_CPU_LIST:
+                if (!CpuAffinity::parse_cpu_list(optarg, pool_options.cpus, cpu_error)) {
+                    std::cerr << "❌ 错误: " << cpu_error << "\n";
+                    return 1;
+                }
+                break;
+            case OPT_NO_WORK_STEALING:
+                pool_options.work_stealing = false;
+                break;
+            case OPT_RETAIN_EVENTS:
+                if (!MonitorOptions::parse_retention(optarg, options.retain_events)) {
+                    std::cerr << "❌ 错误: 未知的会话保留方式 '" << optarg << "'，可选 none, summary, full\n";
+                    return 1;
+                }
+                break;
+            case OPT_LOG_QUEUE:
+                log_queue_capacity = std::stoll(optarg);
+                break;
+            case OPT_LOG_OVERFLOW:
+                if (!LoggerOptions::parse_overflow_policy(optarg, options.logger.overflow_policy)) {
+                    std::cerr << "❌ 错误: 未知的日志溢出策略 '" << optarg
+                              << "'，可选 block, drop-newest, drop-oldest\n";
+                    return 1;
+                }
+                break;
+            case OPT_LOG_FORMAT:
+                if (!LoggerOptions::parse_format(optarg, options.logger.format)) {
+                    std::cerr << "❌ 错误: 未知的日志格式 '" << optarg << "'，可选 json, binary\n";
+                    return 1;
+                }
+                break;
+            case OPT_FLUSH_INTERVAL:
+                options.logger.flush_interval_ms = std::stoi(optarg);
+                break;
+            case OPT_FSYNC:
+                if (!LoggerOptions::parse_fsync_policy(optarg, options.logger.fsync_policy)) {
+                    std::cerr << "❌ 错误: 未知的日志落盘策略 '" << optarg
+                              << "'，可选 never, batch, close\n";
+                    return 1;
+                }
+                break;
+            case OPT_LOG_MAX_SIZE:
+                if (!LogRotation::parse_size(optarg, options.logger.max_size_bytes)) {
+                    std::cerr << "❌ 错误: 无法解析日志分段大小 '" << optarg << "'，格式如 64M, 512K, 1048576\n";
+                    return 1;
+                }
+                break;
+            case OPT_LOG_KEEP:
+                options.logger.keep_segments = std::stoi(optarg);
+                break;
+            case OPT_LOG_COMPRESS:
+                if (!LogRotation::parse_compression(optarg, options.logger.compression)) {
+                    std::cerr << "❌ 错误: 未知的日志压缩方式 '" << optarg << "'，可选 zstd, none\n";
+                    return 1;
+                }
+                break;
+            case OPT_RECORD:
+                options.netlink.record_path = optarg;
+                break;
+            case OPT_REPLAY:
+                options.netlink.replay_path = optarg;
+                break;
+            case OPT_STATUS_DIR:
+                options.status_dir = optarg;
+                break;
+            case OPT_INJECTION_ID_FILE:
+                options.injection_id_file = optarg;
+                break;
+            case OPT_EXPORT:
+                options.logger.exporter.address = optarg;
+                break;
+            case OPT_EXPORT_ROUTE_EVENTS:
+                options.logger.exporter.route_events = true;
+                break;
+            case OPT_EXPORT_BUFFER:
+                export_buffer_bytes = std::stoll(optarg);
+                break;
+            case OPT_EXPORT_INTERVAL:
+                options.logger.exporter.interval_ms = std::stoi(optarg);
+                break;
+            case OPT_LOW_JITTER:
+                options.low_jitter = true;
+                break;
+            case OPT_RT_PRIORITY:
+                options.realtime_priority = std::stoi(optarg);
+                break;
+            case OPT_STATS_INTERVAL:
+                stats_interval_s = std::stoi(optarg);
+                break;
+            case OPT_STAGE_SAMPLE:
+                stage_sample = std::stoi(optarg);
+                break;
             case 'h':
                 print_usage(argv[0]);
                 return 0;
@@ -113,6 +440,117 @@ int main(int argc, char* argv[]) {
         std::cerr << "❌ 错误: 收敛阈值必须大于0\n";
         return 1;
     }
+    if (options.netlink.rcvbuf_bytes < 0) {
+        std::cerr << "❌ 错误: 接收缓冲区大小不能为负数\n";
+        return 1;
+    }
+    if (options.netlink.batch_size == 0) {
+        std::cerr << "❌ 错误: 批量大小必须大于0\n";
+        return 1;
+    }
+    if (options.realtime_priority < 1 || options.realtime_priority > 99) {
+        std::cerr << "❌ 错误: 实时优先级必须在1-99之间\n";
+        return 1;
+    }
+    if (stats_interval_s < 0 || stage_sample < 0) {
+        std::cerr << "❌ 错误: 统计间隔与采样间隔不能为负数\n";
+        return 1;
+    }
+    PipelineStats::set_sample_interval(stage_sample);
+    if (options.max_sessions <= 0) {
+        std::cerr << "❌ 错误: 并发会话数上限必须大于0\n";
+        return 1;
+    }
+    if (pool_options.workers <= 0) {
+        std::cerr << "❌ 错误: 事件线程数必须大于0\n";
+        return 1;
+    }
+    if (!netns_glob.empty() && netns_dir.empty()) {
+        std::cerr << "❌ 错误: --netns-glob 需要与 --netns-dir 一起使用\n";
+        return 1;
+    }
+    if (options.prefix_report < 0) {
+        std::cerr << "❌ 错误: 前缀报告数不能为负数\n";
+        return 1;
+    }
+    if (options.ignore_noop_routes && !options.fib_mirror) {
+        std::cerr << "❌ 错误: --ignore-noop-routes 需要FIB镜像，不能与 --no-fib-mirror 一起使用\n";
+        return 1;
+    }
+    if (log_queue_capacity <= 0) {
+        std::cerr << "❌ 错误: 日志队列槽位数必须大于0\n";
+        return 1;
+    }
+    options.logger.queue_capacity = static_cast<size_t>(log_queue_capacity);
+    if (options.logger.flush_interval_ms < 0) {
+        std::cerr << "❌ 错误: 日志写入间隔不能为负数\n";
+        return 1;
+    }
+    if (options.logger.keep_segments < 0) {
+        std::cerr << "❌ 错误: 保留的日志分段数不能为负数\n";
+        return 1;
+    }
+    if (options.logger.compression == LogCompression::ZSTD && !LogRotation::compression_available()) {
+        std::cerr << "❌ 错误: 本版本编译时未启用libzstd，无法使用 --log-compress zstd\n";
+        return 1;
+    }
+    if (options.logger.exporter.enabled()) {
+        ExportEndpoint endpoint;
+        std::string export_error;
+        if (!ExportEndpoint::parse(options.logger.exporter.address, endpoint, export_error)) {
+            std::cerr << "❌ 错误: " << export_error << "\n";
+            return 1;
+        }
+    }
+    if (export_buffer_bytes <= 0 || options.logger.exporter.interval_ms < 0) {
+        std::cerr << "❌ 错误: 导出缓冲区上限必须大于0，发送间隔不能为负数\n";
+        return 1;
+    }
+    options.logger.exporter.buffer_bytes = static_cast<size_t>(export_buffer_bytes);
+    if (!filter_ok) {
+        std::cerr << "❌ 错误: " << filter_error << "\n";
+        return 1;
+    }
+    if (!options.netlink.record_path.empty() && !options.netlink.replay_path.empty()) {
+        std::cerr << "❌ 错误: --record 与 --replay 不能同时使用\n";
+        return 1;
+    }
+    if (!netns_dir.empty() && (!options.netlink.record_path.empty() || !options.netlink.replay_path.empty())) {
+        std::cerr << "❌ 错误: --record/--replay 仅支持单命名空间模式，不能与 --netns-dir 一起使用\n";
+        return 1;
+    }
+    if (options.netlink.route_source == RouteEventSource::EBPF &&
+        (!options.netlink.record_path.empty() || !options.netlink.replay_path.empty())) {
+        std::cerr << "❌ 错误: 抓包只包含netlink数据报，--source ebpf 不能与 --record/--replay 一起使用\n";
+        return 1;
+    }
+
+    // 单命名空间时CPU列表的第一个CPU用于netlink监控线程
+    if (netns_dir.empty() && !pool_options.cpus.empty()) {
+        options.netlink.cpu = pool_options.cpus.front();
+    }
+
+    // 多命名空间模式：启动前列出目标命名空间
+    std::vector<std::string> netns_names;
+    if (!netns_dir.empty()) {
+        std::string netns_error;
+        if (!NetnsMonitorGroup::list_namespaces(netns_dir, netns_glob.empty() ? "*" : netns_glob,
+                                                netns_names, netns_error)) {
+            std::cerr << "❌ 错误: " << netns_error << "\n";
+            return 1;
+        }
+    }
+
+    // 低抖动模式：在创建任何监控器与线程之前锁定内存，并让之后创建的线程避开事件线程的CPU
+    if (options.low_jitter) {
+        options.logger.preallocate = true;
+        options.netlink.prefault_stack = true;
+        std::vector<int> event_cpus = pool_options.cpus;
+        if (netns_dir.empty() && !event_cpus.empty()) {
+            event_cpus.resize(1);
+        }
+        LowJitter::prepare_process(event_cpus);
+    }
 
     // 生成默认路由器名称
     if (router_name.empty()) {
@@ -122,6 +560,7 @@ int main(int argc, char* argv[]) {
     // 设置信号处理
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    signal(SIGUSR1, stats_signal_handler);
 
     // 打印启动信息
     auto now = std::chrono::system_clock::now();
@@ -129,24 +568,107 @@ int main(int argc, char* argv[]) {
     std::cout << "异步路由收敛监控工具启动 (C++多线程版) - " 
               << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S") << "\n";
     std::cout << "参数: 收敛阈值=" << threshold << "ms\n";
-    std::cout << "路由器名称: " << router_name << "\n";
-    std::cout << "触发策略: 仅在IDLE状态时触发新会话，监控中作为路由事件\n";
+    if (netns_names.empty()) {
+        std::cout << "路由器名称: " << router_name << "\n";
+    } else {
+        std::cout << "命名空间: " << netns_names.size() << " 个 (" << netns_dir << "/"
+                  << (netns_glob.empty() ? "*" : netns_glob) << ")，事件线程=" << pool_options.workers
+                  << ", CPU=" << CpuAffinity::describe(pool_options.cpus) << "\n";
+    }
+    std::cout << "Netlink接收: 批量=" << options.netlink.batch_size << ", 缓冲区="
+              << (options.netlink.rcvbuf_bytes > 0 ? std::to_string(options.netlink.rcvbuf_bytes) : "系统默认") << "\n";
+    std::cout << "内核过滤: " << NetlinkSocketFilter::describe(options.netlink.filter) << "\n";
+    std::cout << "会话保留: " << MonitorOptions::retention_name(options.retain_events) << "\n";
+    std::cout << "前缀跟踪: "
+              << (options.prefix_report > 0 ? "报告最慢 " + std::to_string(options.prefix_report) + " 个前缀" : "关闭")
+              << "\n";
+    std::cout << "FIB镜像: "
+              << (options.fib_mirror ? (options.ignore_noop_routes ? "开启，忽略重复通知" : "开启") : "关闭")
+              << "\n";
+    std::cout << "并发会话: 上限=" << options.max_sessions << ", 归属="
+              << MonitorOptions::attribution_name(options.attribution) << "\n";
+    std::cout << "日志队列: " << options.logger.queue_capacity << " 槽位, 溢出策略="
+              << LoggerOptions::overflow_policy_name(options.logger.overflow_policy) << "\n";
+    std::cout << "日志写入: 格式=" << LoggerOptions::format_name(options.logger.format) << ", 间隔="
+              << (options.logger.flush_interval_ms > 0 ? std::to_string(options.logger.flush_interval_ms) + "ms" : "每批")
+              << ", 落盘=" << LoggerOptions::fsync_policy_name(options.logger.fsync_policy) << "\n";
+    if (options.logger.max_size_bytes > 0) {
+        std::cout << "日志分段: 上限=" << options.logger.max_size_bytes << " 字节, 保留="
+                  << (options.logger.keep_segments > 0 ? std::to_string(options.logger.keep_segments) : "全部")
+                  << ", 压缩=" << LogRotation::compression_name(options.logger.compression) << "\n";
+    }
+    if (options.low_jitter) {
+        const LowJitter::Status& jitter = LowJitter::status();
+        std::cout << "低抖动: 内存锁定=" << (jitter.memory_locked ? "是" : "否")
+                  << ", 事件线程SCHED_FIFO=" << options.realtime_priority
+                  << ", CPU=" << CpuAffinity::describe(jitter.cpus);
+        if (!jitter.cpus.empty()) {
+            std::cout << " (隔离=" << (jitter.cpus_isolated ? "是" : "否")
+                      << ", 其余线程避开=" << (jitter.cpus_exclusive ? "是" : "否") << ")";
+        }
+        std::cout << "\n";
+    }
+    if (!options.netlink.replay_path.empty()) {
+        std::cout << "计时: 回放抓包的虚拟时钟 (" << options.netlink.replay_path << ")\n";
+    } else {
+        std::cout << "计时: CLOCK_MONOTONIC纳秒, "
+                  << (options.netlink.kernel_timestamps ? "内核接收时间戳(SO_TIMESTAMPNS)" : "出队时间戳") << "\n";
+        if (options.netlink.route_source == RouteEventSource::EBPF) {
+            std::cout << "路由来源: eBPF fexit(fib_table_insert/delete, fib6_add/del)，记录内核修改FIB的时刻；"
+                      << "QDisc、链路与下一跳对象仍来自netlink\n";
+        }
+    }
+    if (options.max_sessions > 1) {
+        std::cout << "触发策略: 不同接口/前缀的触发各自开始会话(最多" << options.max_sessions
+                  << "个)，路由变化仅在IDLE状态时触发\n";
+    } else {
+        std::cout << "触发策略: 仅在IDLE状态时触发新会话，监控中作为路由事件\n";
+    }
+    std::cout << "流水线统计: "
+              << (stats_interval_s > 0 ? "每" + std::to_string(stats_interval_s) + "秒写入monitor_stats" : "不定期写入")
+              << ", 阶段计时"
+              << (stage_sample > 0 ? "每" + std::to_string(stage_sample) + "条消息采样一次" : "关闭")
+              << " (kill -USR1 " << getpid() << " 输出到控制台)\n";
+    std::cout << "触发来源: Netem、路由、下一跳对象" << (options.link_triggers ? "、链路UP/DOWN" : "") << "\n";
     std::cout << "性能优化: C++多线程 + 原子操作 + 无锁数据结构\n";
     
     std::string actual_log_path = log_path.empty() ? "默认路径" : log_path;
     std::cout << "日志路径: " << actual_log_path << "\n";
     std::cout << "使用 Ctrl+C 停止监听\n\n";
 
+    if (!netns_names.empty()) {
+        try {
+            // 所有命名空间共享一个日志文件，每条记录的 router_name 为命名空间名称
+            NetnsMonitorGroup group(threshold, log_path, options, pool_options);
+            group.start(netns_dir, netns_names);
+
+            StatsTicker stats(stats_interval_s);
+            while (!shutdown_requested.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                stats.poll(group);
+            }
+
+            group.stop();
+            std::cout << "\n程序正常退出\n";
+        } catch (const std::exception& e) {
+            std::cerr << "❌ 程序运行出错: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
     try {
         // 创建监控器
-        global_monitor = std::make_unique<ConvergenceMonitor>(threshold, router_name, log_path);
+        global_monitor = std::make_unique<ConvergenceMonitor>(threshold, router_name, log_path, options);
 
         // 开始监控
         global_monitor->start_monitoring();
 
-        // 等待关闭信号
-        while (!shutdown_requested.load()) {
+        // 等待关闭信号（回放模式下抓包处理完即结束）
+        StatsTicker stats(stats_interval_s);
+        while (!shutdown_requested.load() && !global_monitor->replay_finished()) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            stats.poll(*global_monitor);
         }
 
         // 停止监控
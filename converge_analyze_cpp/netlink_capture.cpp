@@ -0,0 +1,194 @@
+#include "netlink_capture.h"
+#include "event_clock.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "抓包格式按小端序直接拷贝整数，暂不支持大端平台"
+#endif
+
+namespace NetlinkCapture {
+
+namespace {
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t written = ::write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        len -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+Writer::~Writer() {
+    close();
+}
+
+bool Writer::open(const std::string& path, std::string& error) {
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        error = "无法创建抓包文件 " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    int64_t realtime_ns, monotonic_ns;
+    EventClock::wall_anchor(realtime_ns, monotonic_ns);
+
+    buffer_.reserve(BUFFER_BYTES + MAX_RECORD_SIZE);
+    buffer_.append(MAGIC, sizeof(MAGIC));
+    put<uint32_t>(buffer_, VERSION);
+    put<uint32_t>(buffer_, 0);
+    put<int64_t>(buffer_, realtime_ns);
+    put<int64_t>(buffer_, monotonic_ns);
+    return true;
+}
+
+void Writer::append(RecordType type, int64_t timestamp, const void* data, size_t len) {
+    if (fd_ < 0 || len > MAX_RECORD_SIZE) {
+        return;
+    }
+
+    put<uint8_t>(buffer_, type);
+    buffer_.append(3, '\0');
+    put<uint32_t>(buffer_, static_cast<uint32_t>(len));
+    put<int64_t>(buffer_, timestamp);
+    buffer_.append(static_cast<const char*>(data), len);
+    record_count_++;
+    byte_count_ += static_cast<int64_t>(RECORD_HEADER_SIZE + len);
+
+    if (buffer_.size() >= BUFFER_BYTES) {
+        flush();
+    }
+}
+
+void Writer::flush() {
+    if (buffer_.empty() || write_failed_) {
+        buffer_.clear();
+        return;
+    }
+    if (!write_all(fd_, buffer_.data(), buffer_.size())) {
+        // 只提示一次，之后的记录直接丢弃，不影响监控本身
+        write_failed_ = true;
+        std::cerr << "⚠️  写入抓包文件失败: " << strerror(errno) << "，停止录制\n";
+    }
+    buffer_.clear();
+}
+
+void Writer::close() {
+    if (fd_ < 0) {
+        return;
+    }
+    flush();
+    ::close(fd_);
+    fd_ = -1;
+}
+
+Reader::~Reader() {
+    close();
+}
+
+bool Reader::open(const std::string& path, std::string& error) {
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        error = "无法打开抓包文件 " + path + ": " + strerror(errno);
+        return false;
+    }
+    buffer_.resize(BUFFER_BYTES);
+
+    char header[FILE_HEADER_SIZE];
+    if (!read_exact(header, sizeof(header), false)) {
+        error = path + ": 文件头不完整";
+        return false;
+    }
+    if (memcmp(header, MAGIC, sizeof(MAGIC)) != 0) {
+        error = path + ": 不是netlink抓包文件";
+        return false;
+    }
+    uint32_t version;
+    memcpy(&version, header + 8, sizeof(version));
+    if (version > VERSION) {
+        error = path + ": 不支持的抓包格式版本 " + std::to_string(version);
+        return false;
+    }
+    memcpy(&anchor_realtime_ns_, header + 16, sizeof(anchor_realtime_ns_));
+    memcpy(&anchor_monotonic_ns_, header + 24, sizeof(anchor_monotonic_ns_));
+    return true;
+}
+
+bool Reader::read_exact(void* out, size_t n, bool at_boundary) {
+    char* dest = static_cast<char*>(out);
+    size_t copied = 0;
+    while (copied < n) {
+        if (buffer_pos_ == buffer_len_) {
+            ssize_t len = ::read(fd_, buffer_.data(), buffer_.size());
+            if (len < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                error_ = std::string("读取失败: ") + strerror(errno);
+                return false;
+            }
+            if (len == 0) {
+                if (!(at_boundary && copied == 0)) {
+                    error_ = "文件在记录中间结束（录制被中断？）";
+                }
+                return false;
+            }
+            buffer_pos_ = 0;
+            buffer_len_ = static_cast<size_t>(len);
+        }
+        size_t chunk = std::min(n - copied, buffer_len_ - buffer_pos_);
+        memcpy(dest + copied, buffer_.data() + buffer_pos_, chunk);
+        buffer_pos_ += chunk;
+        copied += chunk;
+    }
+    return true;
+}
+
+bool Reader::next(Record& record) {
+    if (fd_ < 0) {
+        return false;
+    }
+
+    char header[RECORD_HEADER_SIZE];
+    if (!read_exact(header, sizeof(header), true)) {
+        return false;
+    }
+    uint32_t len;
+    record.type = static_cast<uint8_t>(header[0]);
+    memcpy(&len, header + 4, sizeof(len));
+    memcpy(&record.timestamp, header + 8, sizeof(record.timestamp));
+    if (len > MAX_RECORD_SIZE) {
+        error_ = "记录长度超出上限: " + std::to_string(len);
+        return false;
+    }
+
+    record.data.resize(len);
+    return read_exact(record.data.data(), len, false);
+}
+
+void Reader::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+} // namespace NetlinkCapture
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 原始netlink流量抓包（--record / --replay）
+//
+// 文件头(32字节): 8字节魔数 "CVGNLCAP" | uint32 版本 | uint32 保留 | int64 墙上时钟锚点 | int64 单调时钟锚点
+// 记录(16字节头 + 数据): uint8 类型 | 3字节保留 | uint32 数据长度 | int64 接收时间(单调时钟纳秒)
+//
+// 数据为内核原样送达的数据报（可含多条nlmsghdr），整数按小端序存储。
+// 回放时时间戳构成虚拟时钟，收敛定时器按虚拟时间到期。
+namespace NetlinkCapture {
+
+constexpr char MAGIC[8] = {'C', 'V', 'G', 'N', 'L', 'C', 'A', 'P'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t FILE_HEADER_SIZE = 32;
+constexpr size_t RECORD_HEADER_SIZE = 16;
+constexpr uint32_t MAX_RECORD_SIZE = 1 << 20;
+
+enum RecordType : uint8_t {
+    DATAGRAM = 1,       // 多播通知数据报
+    LINK_DUMP = 2,      // 启动时RTM_GETLINK转储的应答数据报
+    ROUTE_DUMP = 3,     // RTM_GETROUTE / RTM_GETNEXTHOP 转储的应答数据报（启动或重新同步）
+    DUMP_DONE = 4,      // 路由转储结束，数据为1字节的成功标志
+    OVERRUN = 5         // 接收队列溢出，数据为int64估计丢失数
+};
+
+struct Record {
+    uint8_t type = 0;
+    int64_t timestamp = 0;
+    std::vector<char> data;
+};
+
+// 写入端：只在netlink监控线程中使用，记录先进入用户态缓冲区，攒满后一次write
+class Writer {
+public:
+    Writer() = default;
+    ~Writer();
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    void append(RecordType type, int64_t timestamp, const void* data, size_t len);
+    // 写出缓冲区并关闭文件
+    void close();
+
+    bool is_open() const { return fd_ >= 0; }
+    int64_t record_count() const { return record_count_; }
+    int64_t byte_count() const { return byte_count_; }
+
+private:
+    static constexpr size_t BUFFER_BYTES = 1 << 20;
+
+    int fd_{-1};
+    bool write_failed_{false};
+    std::string buffer_;
+    int64_t record_count_{0};
+    int64_t byte_count_{0};
+
+    void flush();
+};
+
+// 读取端：按块顺序读取，next() 在文件结束或格式错误时返回false（错误信息见 error()）
+class Reader {
+public:
+    Reader() = default;
+    ~Reader();
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    bool next(Record& record);
+    void close();
+
+    // 录制时的时钟锚点
+    int64_t anchor_realtime_ns() const { return anchor_realtime_ns_; }
+    int64_t anchor_monotonic_ns() const { return anchor_monotonic_ns_; }
+    const std::string& error() const { return error_; }
+
+private:
+    static constexpr size_t BUFFER_BYTES = 1 << 20;
+
+    int fd_{-1};
+    std::vector<char> buffer_;
+    size_t buffer_pos_{0};
+    size_t buffer_len_{0};
+    int64_t anchor_realtime_ns_{0};
+    int64_t anchor_monotonic_ns_{0};
+    std::string error_;
+
+    // 读满n字节；在记录边界处遇到文件结束时返回false且不设置错误
+    bool read_exact(void* out, size_t n, bool at_boundary);
+};
+
+} // namespace NetlinkCapture
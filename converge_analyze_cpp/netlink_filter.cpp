@@ -0,0 +1,327 @@
+#include "netlink_filter.h"
+#include "event_records.h"
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cstddef>
+#include <cerrno>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+namespace {
+
+// 消息内偏移（nlmsghdr为16字节，负载紧随其后）
+constexpr uint32_t OFF_NLMSG_TYPE = offsetof(struct nlmsghdr, nlmsg_type);
+constexpr uint32_t OFF_PAYLOAD = NLMSG_HDRLEN;
+constexpr uint32_t OFF_RTM_FAMILY = OFF_PAYLOAD + offsetof(struct rtmsg, rtm_family);
+constexpr uint32_t OFF_RTM_TABLE = OFF_PAYLOAD + offsetof(struct rtmsg, rtm_table);
+constexpr uint32_t OFF_RTM_PROTOCOL = OFF_PAYLOAD + offsetof(struct rtmsg, rtm_protocol);
+// 内核在QDisc通知中总是首先填充TCA_KIND属性
+constexpr uint32_t OFF_TCA_FIRST = OFF_PAYLOAD + NLMSG_ALIGN(sizeof(struct tcmsg));
+constexpr uint32_t OFF_TCA_LEN = OFF_TCA_FIRST + offsetof(struct rtattr, rta_len);
+constexpr uint32_t OFF_TCA_TYPE = OFF_TCA_FIRST + offsetof(struct rtattr, rta_type);
+constexpr uint32_t OFF_TCA_DATA = OFF_TCA_FIRST + RTA_LENGTH(0);
+
+// 返回值即保留的字节数：接受时不能截断消息
+constexpr uint32_t BPF_ACCEPT = 0xFFFFFFFF;
+constexpr uint32_t BPF_DROP = 0;
+
+// 带符号标签的经典BPF汇编器，条件跳转在finish时解析为相对偏移
+class BpfAssembler {
+public:
+    static constexpr int NEXT = -1;
+
+    int new_label() {
+        label_pos_.push_back(-1);
+        return static_cast<int>(label_pos_.size()) - 1;
+    }
+
+    void bind(int label) { label_pos_[label] = static_cast<int>(insns_.size()); }
+
+    void load_byte(uint32_t offset) { emit(BPF_LD | BPF_B | BPF_ABS, offset); }
+    void load_half(uint32_t offset) { emit(BPF_LD | BPF_H | BPF_ABS, offset); }
+    void load_word(uint32_t offset) { emit(BPF_LD | BPF_W | BPF_ABS, offset); }
+    void ret(uint32_t k) { emit(BPF_RET | BPF_K, k); }
+
+    void jump_eq(uint32_t k, int jt, int jf) {
+        Insn insn;
+        insn.code = BPF_JMP | BPF_JEQ | BPF_K;
+        insn.k = k;
+        insn.jt_label = jt;
+        insn.jf_label = jf;
+        insns_.push_back(insn);
+    }
+
+    // 解析跳转，偏移超出8位范围时返回空程序
+    std::vector<struct sock_filter> finish() const {
+        std::vector<struct sock_filter> program;
+        program.reserve(insns_.size());
+        for (size_t i = 0; i < insns_.size(); ++i) {
+            const Insn& insn = insns_[i];
+            int jt = resolve(insn.jt_label, i);
+            int jf = resolve(insn.jf_label, i);
+            if (jt < 0 || jt > 255 || jf < 0 || jf > 255) {
+                return {};
+            }
+            program.push_back(BPF_JUMP(insn.code, insn.k,
+                                       static_cast<uint8_t>(jt), static_cast<uint8_t>(jf)));
+        }
+        return program;
+    }
+
+private:
+    struct Insn {
+        uint16_t code = 0;
+        uint32_t k = 0;
+        int jt_label = NEXT;
+        int jf_label = NEXT;
+    };
+
+    std::vector<Insn> insns_;
+    std::vector<int> label_pos_;
+
+    void emit(uint16_t code, uint32_t k) {
+        Insn insn;
+        insn.code = code;
+        insn.k = k;
+        insns_.push_back(insn);
+    }
+
+    int resolve(int label, size_t index) const {
+        if (label == NEXT) {
+            return 0;
+        }
+        int target = label_pos_[label];
+        if (target < 0) {
+            return -1;
+        }
+        return target - static_cast<int>(index) - 1;
+    }
+};
+
+// 依次比较累加器与候选值：命中跳转到match，全部不命中跳转到miss
+void emit_match_any(BpfAssembler& as, const std::vector<uint8_t>& values, int match, int miss) {
+    for (size_t i = 0; i < values.size(); ++i) {
+        bool last = (i + 1 == values.size());
+        as.jump_eq(values[i], match, last ? miss : BpfAssembler::NEXT);
+    }
+}
+
+} // namespace
+
+std::vector<std::string> NetlinkSocketFilter::split_list(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+bool NetlinkSocketFilter::parse_families(const std::string& list, std::vector<uint8_t>& out,
+                                         std::string& error) {
+    for (const auto& item : split_list(list)) {
+        if (item == "inet" || item == "ipv4" || item == "4") {
+            out.push_back(AF_INET);
+        } else if (item == "inet6" || item == "ipv6" || item == "6") {
+            out.push_back(AF_INET6);
+        } else {
+            error = "未知地址族: " + item + " (可选: inet, inet6)";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool NetlinkSocketFilter::parse_protocols(const std::string& list, std::vector<uint8_t>& out,
+                                          std::string& error) {
+    for (const auto& item : split_list(list)) {
+        int value = EventFormat::protocol_from_name(item);
+        if (value < 0) {
+            char* end = nullptr;
+            long number = strtol(item.c_str(), &end, 10);
+            if (end == item.c_str() || *end != '\0' || number < 0 || number > 255) {
+                error = "未知路由协议: " + item;
+                return false;
+            }
+            value = static_cast<int>(number);
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+    return true;
+}
+
+bool NetlinkSocketFilter::parse_tables(const std::string& list, std::vector<uint8_t>& out,
+                                       std::string& error) {
+    for (const auto& item : split_list(list)) {
+        if (item == "main") {
+            out.push_back(RT_TABLE_MAIN);
+        } else if (item == "local") {
+            out.push_back(RT_TABLE_LOCAL);
+        } else if (item == "default") {
+            out.push_back(RT_TABLE_DEFAULT);
+        } else {
+            // 大于255的表号在rtm_table中被压缩为RT_TABLE_COMPAT，无法在内核侧区分
+            char* end = nullptr;
+            long number = strtol(item.c_str(), &end, 10);
+            if (end == item.c_str() || *end != '\0' || number < 0 || number > 255) {
+                error = "路由表必须为 main/local/default 或 0-255: " + item;
+                return false;
+            }
+            out.push_back(static_cast<uint8_t>(number));
+        }
+    }
+    return true;
+}
+
+bool NetlinkSocketFilter::parse_qdisc_kinds(const std::string& list, std::vector<std::string>& out,
+                                            std::string& error) {
+    for (const auto& item : split_list(list)) {
+        if (item.size() >= 16) {
+            error = "QDisc类型名称过长: " + item;
+            return false;
+        }
+        out.push_back(item);
+    }
+    return true;
+}
+
+std::vector<struct sock_filter> NetlinkSocketFilter::build_program(const NetlinkFilterSpec& spec) {
+    BpfAssembler as;
+    int drop = as.new_label();
+    int route = as.new_label();
+    int qdisc = as.new_label();
+
+    // 按消息类型分派；BPF绝对加载按网络字节序读取，因此常量需转换为网络字节序
+    as.load_half(OFF_NLMSG_TYPE);
+    as.jump_eq(htons(RTM_NEWROUTE), route, BpfAssembler::NEXT);
+    as.jump_eq(htons(RTM_DELROUTE), route, BpfAssembler::NEXT);
+    as.jump_eq(htons(RTM_NEWQDISC), qdisc, BpfAssembler::NEXT);
+    as.jump_eq(htons(RTM_DELQDISC), qdisc, BpfAssembler::NEXT);
+    if (!spec.qdisc_kinds.empty()) {
+        as.jump_eq(htons(RTM_GETQDISC), drop, BpfAssembler::NEXT);
+    }
+    as.ret(BPF_ACCEPT);
+
+    // 路由消息：依次检查地址族、路由表、协议
+    as.bind(route);
+    if (!spec.families.empty()) {
+        int next = as.new_label();
+        as.load_byte(OFF_RTM_FAMILY);
+        emit_match_any(as, spec.families, next, drop);
+        as.bind(next);
+    }
+    if (!spec.tables.empty()) {
+        int next = as.new_label();
+        as.load_byte(OFF_RTM_TABLE);
+        emit_match_any(as, spec.tables, next, drop);
+        as.bind(next);
+    }
+    if (!spec.protocols.empty()) {
+        int next = as.new_label();
+        as.load_byte(OFF_RTM_PROTOCOL);
+        emit_match_any(as, spec.protocols, next, drop);
+        as.bind(next);
+    }
+    as.ret(BPF_ACCEPT);
+
+    // QDisc消息：比较首个属性TCA_KIND的长度与内容（内核以零填充到4字节对齐）
+    as.bind(qdisc);
+    if (!spec.qdisc_kinds.empty()) {
+        as.load_half(OFF_TCA_TYPE);
+        as.jump_eq(htons(TCA_KIND), BpfAssembler::NEXT, drop);
+
+        for (const auto& kind : spec.qdisc_kinds) {
+            int next_kind = as.new_label();
+            uint32_t data_len = static_cast<uint32_t>(kind.size()) + 1;
+
+            as.load_half(OFF_TCA_LEN);
+            as.jump_eq(htons(static_cast<uint16_t>(RTA_LENGTH(data_len))), BpfAssembler::NEXT, next_kind);
+
+            unsigned char padded[20] = {0};
+            memcpy(padded, kind.data(), kind.size());
+            uint32_t words = (data_len + 3) / 4;
+            for (uint32_t w = 0; w < words; ++w) {
+                uint32_t value = 0;
+                memcpy(&value, padded + w * 4, 4);
+                as.load_word(OFF_TCA_DATA + w * 4);
+                as.jump_eq(htonl(value), BpfAssembler::NEXT, next_kind);
+            }
+            as.ret(BPF_ACCEPT);
+            as.bind(next_kind);
+        }
+        as.ret(BPF_DROP);
+    }
+    as.ret(BPF_ACCEPT);
+
+    as.bind(drop);
+    as.ret(BPF_DROP);
+
+    return as.finish();
+}
+
+bool NetlinkSocketFilter::attach(int fd, const NetlinkFilterSpec& spec) {
+    std::vector<struct sock_filter> program = build_program(spec);
+    if (program.empty()) {
+        std::cerr << "⚠️  BPF过滤程序生成失败（过滤条件过多）\n";
+        return false;
+    }
+
+    struct sock_fprog fprog;
+    fprog.len = static_cast<unsigned short>(program.size());
+    fprog.filter = program.data();
+
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0) {
+        std::cerr << "⚠️  附加BPF过滤器失败: " << strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+std::string NetlinkSocketFilter::describe(const NetlinkFilterSpec& spec) {
+    if (!spec.enabled()) {
+        return "无";
+    }
+
+    std::ostringstream oss;
+    const char* sep = "";
+    if (!spec.families.empty()) {
+        oss << sep << "family=";
+        for (size_t i = 0; i < spec.families.size(); ++i) {
+            oss << (i ? "," : "") << (spec.families[i] == AF_INET ? "inet" : "inet6");
+        }
+        sep = " ";
+    }
+    if (!spec.protocols.empty()) {
+        oss << sep << "proto=";
+        for (size_t i = 0; i < spec.protocols.size(); ++i) {
+            const char* name = EventFormat::protocol_to_name(spec.protocols[i]);
+            oss << (i ? "," : "");
+            if (name) {
+                oss << name;
+            } else {
+                oss << static_cast<int>(spec.protocols[i]);
+            }
+        }
+        sep = " ";
+    }
+    if (!spec.tables.empty()) {
+        oss << sep << "table=";
+        for (size_t i = 0; i < spec.tables.size(); ++i) {
+            oss << (i ? "," : "") << static_cast<int>(spec.tables[i]);
+        }
+        sep = " ";
+    }
+    if (!spec.qdisc_kinds.empty()) {
+        oss << sep << "qdisc=";
+        for (size_t i = 0; i < spec.qdisc_kinds.size(); ++i) {
+            oss << (i ? "," : "") << spec.qdisc_kinds[i];
+        }
+    }
+    return oss.str();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <linux/filter.h>
+
+// 内核侧netlink过滤条件（空列表表示不过滤该维度）
+struct NetlinkFilterSpec {
+    std::vector<uint8_t> families;          // 路由地址族: AF_INET / AF_INET6
+    std::vector<uint8_t> protocols;         // 路由协议: RTPROT_*
+    std::vector<uint8_t> tables;            // 路由表: rtm_table
+    std::vector<std::string> qdisc_kinds;   // QDisc类型: netem、tbf 等
+
+    bool enabled() const {
+        return !families.empty() || !protocols.empty() ||
+               !tables.empty() || !qdisc_kinds.empty();
+    }
+};
+
+// 经典BPF套接字过滤器：在内核中丢弃无关的netlink通知，监控线程不会为其唤醒
+//
+// 过滤器只检查数据报中的第一条消息；内核的多播通知每个数据报只携带一条消息。
+// 路由、QDisc以外的消息类型（错误、转储结束等）始终放行。
+class NetlinkSocketFilter {
+public:
+    // 解析逗号分隔的命令行参数，失败时返回false并设置error
+    static bool parse_families(const std::string& list, std::vector<uint8_t>& out, std::string& error);
+    static bool parse_protocols(const std::string& list, std::vector<uint8_t>& out, std::string& error);
+    static bool parse_tables(const std::string& list, std::vector<uint8_t>& out, std::string& error);
+    static bool parse_qdisc_kinds(const std::string& list, std::vector<std::string>& out, std::string& error);
+
+    // 根据过滤条件生成BPF程序
+    static std::vector<struct sock_filter> build_program(const NetlinkFilterSpec& spec);
+
+    // 将过滤器附加到套接字（SO_ATTACH_FILTER）
+    static bool attach(int fd, const NetlinkFilterSpec& spec);
+
+    // 过滤条件的可读描述，用于启动信息和日志
+    static std::string describe(const NetlinkFilterSpec& spec);
+
+private:
+    static std::vector<std::string> split_list(const std::string& list);
+};
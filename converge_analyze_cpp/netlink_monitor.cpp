@@ -1,4 +1,6 @@
 #include "netlink_monitor.h"
+#include "cpu_affinity.h"
+#include "low_jitter.h"
 #include <iostream>
 #include <cstring>
 #include <cerrno>
@@ -6,11 +8,31 @@
 #include <arpa/inet.h>
 #include <unordered_map>
 #include <unordered_set>
+#include <algorithm>
 #include <fcntl.h>
 #include <thread>
 #include <chrono>
 #include <sys/epoll.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
+#include <sstream>
+
+namespace {
+
+// FNV-1a：下一跳列表摘要，只用于判断是否变化
+constexpr uint32_t FNV_OFFSET = 2166136261u;
+
+uint32_t fnv1a(uint32_t hash, const void* data, size_t len) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+} // namespace
 
 // NetlinkSocket 实现
 NetlinkSocket::NetlinkSocket(int protocol, uint32_t groups) : fd_(-1) {
@@ -62,7 +84,9 @@ ssize_t NetlinkSocket::send_message(const void* message, size_t message_size) {
 }
 
 // NetlinkMonitor 实现
-NetlinkMonitor::NetlinkMonitor() : netlink_socket_fd_(-1), epoll_fd_(-1) {
+NetlinkMonitor::NetlinkMonitor()
+    : netlink_socket_fd_(-1), epoll_fd_(-1), dump_socket_fd_(-1), timer_fd_(-1),
+      interfaces_(&InterfaceCache::instance()) {
     shutdown_pipe_[0] = -1;
     shutdown_pipe_[1] = -1;
 }
@@ -71,6 +95,25 @@ NetlinkMonitor::~NetlinkMonitor() {
     stop_monitoring();
 }
 
+bool NetlinkMonitor::parse_route_source(const std::string& name, RouteEventSource& source) {
+    if (name == "netlink") {
+        source = RouteEventSource::NETLINK;
+    } else if (name == "ebpf") {
+        source = RouteEventSource::EBPF;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* NetlinkMonitor::route_source_name(RouteEventSource source) {
+    switch (source) {
+        case RouteEventSource::NETLINK: return "netlink";
+        case RouteEventSource::EBPF: return "ebpf";
+    }
+    return "unknown";
+}
+
 void NetlinkMonitor::set_route_callback(RouteEventCallback callback) {
     route_callback_ = std::move(callback);
 }
@@ -79,14 +122,98 @@ void NetlinkMonitor::set_qdisc_callback(QdiscEventCallback callback) {
     qdisc_callback_ = std::move(callback);
 }
 
+void NetlinkMonitor::set_nexthop_callback(NexthopEventCallback callback) {
+    nexthop_callback_ = std::move(callback);
+}
+
+void NetlinkMonitor::set_link_callback(LinkEventCallback callback) {
+    link_callback_ = std::move(callback);
+}
+
 void NetlinkMonitor::set_unified_callback(NetlinkEventCallback callback) {
     unified_callback_ = std::move(callback);
 }
 
+void NetlinkMonitor::set_overrun_callback(OverrunCallback callback) {
+    overrun_callback_ = std::move(callback);
+}
+
+void NetlinkMonitor::set_dump_callbacks(DumpRouteCallback route_callback, DumpDoneCallback done_callback) {
+    dump_route_callback_ = std::move(route_callback);
+    dump_done_callback_ = std::move(done_callback);
+}
+
+void NetlinkMonitor::set_timer_callback(TimerCallback callback) {
+    timer_callback_ = std::move(callback);
+}
+
+void NetlinkMonitor::set_options(const NetlinkMonitorOptions& options) {
+    options_ = options;
+    if (options_.batch_size == 0) {
+        options_.batch_size = 1;
+    }
+    if (options_.batch_size > MAX_BATCH_SIZE) {
+        options_.batch_size = MAX_BATCH_SIZE;
+    }
+    if (options_.inject_only) {
+        virtual_clock_ = true;
+        virtual_now_ns_.store(EventClock::monotonic_ns(), std::memory_order_relaxed);
+    }
+}
+
 bool NetlinkMonitor::start_monitoring() {
     if (running_.load()) {
         return true;
     }
+    if (replaying_) {
+        running_.store(true);
+        monitor_thread_ = std::thread(&NetlinkMonitor::replay_loop, this);
+        return true;
+    }
+    if (options_.inject_only) {
+        // 没有启动转储：FIB镜像从空表开始
+        running_.store(true);
+        if (options_.initial_route_dump && dump_done_callback_) {
+            dump_done_callback_(false);
+        }
+        return true;
+    }
+    if (!open_descriptors()) {
+        return false;
+    }
+
+    running_.store(true);
+
+    // 启动统一监控线程
+    monitor_thread_ = std::thread(&NetlinkMonitor::unified_monitor_loop, this);
+    return true;
+}
+
+bool NetlinkMonitor::start_external() {
+    if (running_.load()) {
+        return true;
+    }
+    if (replaying_) {
+        std::cerr << "Replay is not supported with an external event loop\n";
+        return false;
+    }
+    if (!open_descriptors()) {
+        return false;
+    }
+
+    external_loop_ = true;
+    running_.store(true);
+    return true;
+}
+
+bool NetlinkMonitor::open_descriptors() {
+    if (!options_.record_path.empty()) {
+        std::string error;
+        if (!capture_.open(options_.record_path, error)) {
+            std::cerr << "❌ " << error << "\n";
+            return false;
+        }
+    }
 
     try {
         // 创建统一的netlink套接字
@@ -96,6 +223,24 @@ bool NetlinkMonitor::start_monitoring() {
             return false;
         }
 
+        // 注册接收环同样在转储之前，转储与之后的路由记录之间不会遗漏
+        if (options_.route_source == RouteEventSource::EBPF && !open_route_ring()) {
+            close(netlink_socket_fd_);
+            netlink_socket_fd_ = -1;
+            return false;
+        }
+
+        // 预分配批量接收缓冲池
+        setup_receive_pool();
+
+        // 多播套接字已绑定，此后的链路变化都会排队，转储与通知之间不会遗漏
+        if (!load_interface_table()) {
+            std::cerr << "⚠️  RTM_GETLINK转储失败，接口名称将按需查询\n";
+        }
+        if (options_.initial_route_dump && !load_route_table()) {
+            std::cerr << "⚠️  RTM_GETROUTE转储失败，路由变化分类从空表开始\n";
+        }
+
         // 创建用于优雅关闭的管道
         if (pipe2(shutdown_pipe_, O_CLOEXEC | O_NONBLOCK) < 0) {
             std::cerr << "Failed to create shutdown pipe\n";
@@ -147,11 +292,45 @@ bool NetlinkMonitor::start_monitoring() {
             return false;
         }
 
-        running_.store(true);
+        // 创建RIB转储套接字并添加到epoll
+        dump_socket_fd_ = create_dump_socket();
+        ev.events = EPOLLIN;
+        ev.data.fd = dump_socket_fd_;
+        if (dump_socket_fd_ < 0 ||
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, dump_socket_fd_, &ev) < 0) {
+            std::cerr << "Failed to set up route dump socket\n";
+            close_descriptors();
+            return false;
+        }
+
+        // 创建收敛定时器并添加到epoll
+        timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        ev.events = EPOLLIN;
+        ev.data.fd = timer_fd_;
+        if (timer_fd_ < 0 ||
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &ev) < 0) {
+            std::cerr << "Failed to set up convergence timer\n";
+            close_descriptors();
+            return false;
+        }
 
-        // 启动统一监控线程
-        monitor_thread_ = std::thread(&NetlinkMonitor::unified_monitor_loop, this);
+        // eBPF路由接收环
+        if (route_ring_) {
+            ev.events = EPOLLIN;
+            ev.data.fd = route_ring_->fd();
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, route_ring_->fd(), &ev) < 0) {
+                std::cerr << "Failed to add eBPF route ring to epoll\n";
+                close_descriptors();
+                return false;
+            }
+        }
 
+        // /proc/thread-self 对应本线程所在的命名空间（/proc/self 是主线程的），旧内核回退到 /proc/net
+        proc_netlink_fd_ = open("/proc/thread-self/net/netlink", O_RDONLY | O_CLOEXEC);
+        if (proc_netlink_fd_ < 0) {
+            proc_netlink_fd_ = open("/proc/net/netlink", O_RDONLY | O_CLOEXEC);
+        }
+        last_socket_drops_ = read_socket_drops();
         return true;
 
     } catch (const std::exception& e) {
@@ -193,11 +372,39 @@ void NetlinkMonitor::stop_monitoring() {
     }
 
     // 关闭所有文件描述符
+    close_descriptors();
+
+    if (capture_.is_open()) {
+        capture_.close();
+        std::cout << "📼 抓包已保存: " << options_.record_path << " (" << capture_.record_count() << " 条记录, "
+                  << (capture_.byte_count() + 1023) / 1024 << " KB)\n";
+    }
+}
+
+void NetlinkMonitor::close_descriptors() {
     if (netlink_socket_fd_ >= 0) {
         close(netlink_socket_fd_);
         netlink_socket_fd_ = -1;
     }
 
+    route_ring_.reset();
+
+    if (dump_socket_fd_ >= 0) {
+        close(dump_socket_fd_);
+        dump_socket_fd_ = -1;
+    }
+
+    if (timer_fd_ >= 0) {
+        close(timer_fd_);
+        timer_fd_ = -1;
+    }
+
+    if (proc_netlink_fd_ >= 0) {
+        std::lock_guard<std::mutex> lock(proc_mutex_);
+        close(proc_netlink_fd_);
+        proc_netlink_fd_ = -1;
+    }
+
     if (epoll_fd_ >= 0) {
         close(epoll_fd_);
         epoll_fd_ = -1;
@@ -212,10 +419,14 @@ void NetlinkMonitor::stop_monitoring() {
         close(shutdown_pipe_[1]);
         shutdown_pipe_[1] = -1;
     }
+
+    dump_in_progress_ = false;
+    dump_pending_ = false;
 }
 
 int NetlinkMonitor::create_unified_netlink_socket() {
-    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    // 非阻塞套接字：每次epoll唤醒后持续读取直到EAGAIN
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
     if (fd < 0) {
         return -1;
     }
@@ -223,8 +434,11 @@ int NetlinkMonitor::create_unified_netlink_socket() {
     struct sockaddr_nl addr;
     memset(&addr, 0, sizeof(addr));
     addr.nl_family = AF_NETLINK;
-    // 同时监听路由和TC事件
-    addr.nl_groups = RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE | RTMGRP_TC;
+    // 同时监听路由、TC和链路事件；路由来自eBPF时不订阅路由组
+    addr.nl_groups = RTMGRP_TC | RTMGRP_LINK;
+    if (options_.route_source == RouteEventSource::NETLINK) {
+        addr.nl_groups |= RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE;
+    }
     addr.nl_pid = 0;
 
     if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
@@ -232,354 +446,1283 @@ int NetlinkMonitor::create_unified_netlink_socket() {
         return -1;
     }
 
-    return fd;
-}
-
-void NetlinkMonitor::unified_monitor_loop() {
-    char buffer[NETLINK_BUFFER_SIZE];
-    struct epoll_event events[MAX_EPOLL_EVENTS];
-
-    while (running_.load()) {
-        // 使用epoll等待事件，超时时间1000ms
-        int nfds = epoll_wait(epoll_fd_, events, MAX_EPOLL_EVENTS, 1000);
+    // 下一跳对象组编号超过31，无法放入 nl_groups 位图
+    int nexthop_group = RTNLGRP_NEXTHOP;
+    if (setsockopt(fd, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &nexthop_group, sizeof(nexthop_group)) < 0) {
+        std::cerr << "⚠️  订阅RTNLGRP_NEXTHOP失败: " << strerror(errno) << "，不监控下一跳对象\n";
+    }
 
-        if (nfds < 0) {
-            if (errno == EINTR) {
-                // 被信号中断，检查是否需要退出
-                if (!running_.load()) {
-                    break;
-                }
-                continue; // 继续等待
-            }
-            if (running_.load()) {
-                std::cerr << "Epoll wait error: " << strerror(errno) << "\n";
-            }
-            break;
-        }
+    configure_receive_buffer(fd);
 
-        if (nfds == 0) {
-            // 超时，继续循环检查running状态
-            continue;
+    // 请求内核接收时间戳；不支持时保持出队时刻计时
+    if (options_.kernel_timestamps) {
+        int enable = 1;
+        if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) < 0) {
+            std::cerr << "⚠️  SO_TIMESTAMPNS 失败: " << strerror(errno) << "，使用出队时间戳\n";
         }
+    }
 
-        // 处理所有就绪的事件
-        for (int i = 0; i < nfds; ++i) {
-            if (events[i].data.fd == netlink_socket_fd_) {
-                // 读取netlink消息
-                ssize_t len = recv(netlink_socket_fd_, buffer, sizeof(buffer), 0);
-                if (len < 0) {
-                    if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
-                        continue;
-                    }
-                    if (running_.load()) {
-                        std::cerr << "Netlink recv error: " << strerror(errno) << "\n";
-                    }
-                    break;
-                }
-
-                if (len == 0) {
-                    break;
-                }
-
-                // 处理netlink消息
-                struct nlmsghdr* nlh = reinterpret_cast<struct nlmsghdr*>(buffer);
-                while (NLMSG_OK(nlh, len)) {
-                    process_netlink_message(nlh);
-                    nlh = NLMSG_NEXT(nlh, len);
-                }
-            } else if (events[i].data.fd == shutdown_pipe_[0]) {
-                // 收到关闭信号
-                char dummy;
-                read(shutdown_pipe_[0], &dummy, 1); // 清空管道
-                break; // 退出循环
-            }
-        }
+    // 在内核中丢弃无关通知，监控线程不会为其唤醒
+    if (options_.filter.enabled() && !NetlinkSocketFilter::attach(fd, options_.filter)) {
+        close(fd);
+        return -1;
     }
-}
 
-void NetlinkMonitor::process_netlink_message(const struct nlmsghdr* nlh) {
-    NetlinkMessageType msg_type = get_message_type(nlh);
+    return fd;
+}
 
-    // 根据消息类型调用相应的处理函数
-    if (msg_type == NetlinkMessageType::ROUTE_ADD ||
-        msg_type == NetlinkMessageType::ROUTE_DEL) {
-        handle_route_message(nlh);
-    } else if (msg_type == NetlinkMessageType::QDISC_ADD ||
-               msg_type == NetlinkMessageType::QDISC_DEL ||
-               msg_type == NetlinkMessageType::QDISC_GET ||
-               msg_type == NetlinkMessageType::QDISC_CHANGE) {
-        handle_qdisc_message(nlh);
+void NetlinkMonitor::configure_receive_buffer(int fd) {
+    if (options_.rcvbuf_bytes <= 0) {
+        return;
     }
 
-    // 如果设置了统一回调，也调用它
-    if (unified_callback_) {
-        unified_callback_(nlh, message_type_to_string(msg_type), msg_type);
-    }
-}
-
-NetlinkMessageType NetlinkMonitor::get_message_type(const struct nlmsghdr* nlh) {
-    switch (nlh->nlmsg_type) {
-        case RTM_NEWROUTE:
-            return NetlinkMessageType::ROUTE_ADD;
-        case RTM_DELROUTE:
-            return NetlinkMessageType::ROUTE_DEL;
-        case RTM_NEWQDISC:
-            return NetlinkMessageType::QDISC_ADD;
-        case RTM_DELQDISC:
-            return NetlinkMessageType::QDISC_DEL;
-        case RTM_GETQDISC:
-            return NetlinkMessageType::QDISC_GET;
-        default:
-            return NetlinkMessageType::UNKNOWN;
-    }
-}
-
-std::string NetlinkMonitor::message_type_to_string(NetlinkMessageType type) {
-    switch (type) {
-        case NetlinkMessageType::ROUTE_ADD:
-            return "路由添加";
-        case NetlinkMessageType::ROUTE_DEL:
-            return "路由删除";
-        case NetlinkMessageType::QDISC_ADD:
-            return "QDISC_ADD";
-        case NetlinkMessageType::QDISC_DEL:
-            return "QDISC_DEL";
-        case NetlinkMessageType::QDISC_GET:
-            return "QDISC_GET";
-        case NetlinkMessageType::QDISC_CHANGE:
-            return "QDISC_CHANGE";
-        default:
-            return "UNKNOWN";
-    }
-}
-
-void NetlinkMonitor::handle_route_message(const struct nlmsghdr* nlh) {
-    NetlinkMessageType msg_type = get_message_type(nlh);
-    
-    if (msg_type == NetlinkMessageType::ROUTE_ADD || 
-        msg_type == NetlinkMessageType::ROUTE_DEL) {
-        
-        if (route_callback_) {
-            route_callback_(nlh, message_type_to_string(msg_type));
+    // SO_RCVBUFFORCE 需要 CAP_NET_ADMIN，失败时回退到受 rmem_max 限制的 SO_RCVBUF
+    int size = options_.rcvbuf_bytes;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) < 0) {
+        std::cerr << "⚠️  SO_RCVBUFFORCE 失败 (" << strerror(errno)
+                  << ")，回退到 SO_RCVBUF\n";
+        if (setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) < 0) {
+            std::cerr << "⚠️  SO_RCVBUF 失败: " << strerror(errno) << "\n";
+            return;
         }
     }
-}
 
-void NetlinkMonitor::handle_qdisc_message(const struct nlmsghdr* nlh) {
-    NetlinkMessageType msg_type = get_message_type(nlh);
+    // 内核返回的是实际分配值（通常为请求值的两倍）
+    int actual = 0;
+    socklen_t optlen = sizeof(actual);
+    if (getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &actual, &optlen) == 0) {
+        std::cout << "   Netlink接收缓冲区: " << actual << " 字节\n";
+    }
+}
 
-    // 只处理特定的 qdisc 消息类型
-    if (msg_type != NetlinkMessageType::QDISC_ADD &&
-        msg_type != NetlinkMessageType::QDISC_DEL &&
-        msg_type != NetlinkMessageType::QDISC_GET) {
-        return; // 忽略其他类型的消息
+bool NetlinkMonitor::load_interface_table() {
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+        return false;
     }
 
-    // 解析 qdisc 信息以检查类型
-    const struct tcmsg* tcm = static_cast<const struct tcmsg*>(NLMSG_DATA(nlh));
-    int attrlen = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*tcm));
-    const struct rtattr* rta = reinterpret_cast<const struct rtattr*>(
-        reinterpret_cast<const char*>(tcm) + NLMSG_ALIGN(sizeof(*tcm)));
+    struct {
+        struct nlmsghdr nlh;
+        struct ifinfomsg ifm;
+    } req;
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    req.nlh.nlmsg_type = RTM_GETLINK;
+    req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nlh.nlmsg_seq = 1;
+    req.ifm.ifi_family = AF_UNSPEC;
+
+    if (send(fd, &req, req.nlh.nlmsg_len, 0) < 0) {
+        close(fd);
+        return false;
+    }
 
-    auto qdisc_info = NetlinkMessageParser::parse_qdisc_message(tcm, rta, attrlen);
+    InterfaceCache& cache = *interfaces_;
+    std::vector<char> buffer(NETLINK_BUFFER_SIZE);
+    bool done = false;
+    bool ok = true;
 
-    // 检查是否为 "noqueue" 类型，如果是则忽略
-    auto kind_it = qdisc_info.find("kind");
-    if (kind_it != qdisc_info.end() && kind_it->second == "noqueue") {
-        return; // 忽略 noqueue 类型的 qdisc
-    }
+    while (!done) {
+        ssize_t len = recv(fd, buffer.data(), buffer.size(), 0);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ok = false;
+            break;
+        }
+        if (capture_.is_open()) {
+            capture_.append(NetlinkCapture::LINK_DUMP, EventClock::monotonic_ns(), buffer.data(),
+                            static_cast<size_t>(len));
+        }
 
-    // 调用回调函数
-    if (qdisc_callback_) {
-        qdisc_callback_(nlh, message_type_to_string(msg_type));
+        int remaining = static_cast<int>(len);
+        const struct nlmsghdr* nlh = reinterpret_cast<const struct nlmsghdr*>(buffer.data());
+        while (NLMSG_OK(nlh, remaining)) {
+            if (nlh->nlmsg_type == NLMSG_DONE) {
+                done = true;
+                break;
+            }
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                handle_netlink_error(nlh);
+                done = true;
+                ok = false;
+                break;
+            }
+            LinkRecord link;
+            if (nlh->nlmsg_type == RTM_NEWLINK && NetlinkMessageParser::parse_link_message(nlh, link)) {
+                cache.update(link.ifindex, link.name, link.flags);
+            }
+            nlh = NLMSG_NEXT(nlh, remaining);
+        }
     }
-}
 
-void NetlinkMonitor::handle_netlink_error(const struct nlmsghdr* nlh) {
-    struct nlmsgerr* err = static_cast<struct nlmsgerr*>(NLMSG_DATA(nlh));
-    std::cerr << "Netlink error: " << strerror(-err->error) << "\n";
+    close(fd);
+    return ok;
 }
 
-// NetlinkMessageParser 实现
-std::unordered_map<std::string, std::string> NetlinkMessageParser::parse_route_message(
-    const struct rtmsg* rtm, const struct rtattr* rta, int len) {
+bool NetlinkMonitor::load_route_table() {
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+        report_dump_done(false);
+        return false;
+    }
 
-    std::unordered_map<std::string, std::string> result;
+    struct {
+        struct nlmsghdr nlh;
+        struct rtmsg rtm;
+    } req;
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+    req.nlh.nlmsg_type = RTM_GETROUTE;
+    req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nlh.nlmsg_seq = 1;
+    req.rtm.rtm_family = AF_UNSPEC;
+
+    std::vector<char> buffer(NETLINK_BUFFER_SIZE);
+    bool ok = send(fd, &req, req.nlh.nlmsg_len, 0) >= 0 && receive_dump(fd, buffer, true);
+
+    if (ok) {
+        // 下一跳对象：旧内核返回错误，不影响路由表转储的结果
+        struct {
+            struct nlmsghdr nlh;
+            struct nhmsg nhm;
+        } nh_req;
+        memset(&nh_req, 0, sizeof(nh_req));
+        nh_req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct nhmsg));
+        nh_req.nlh.nlmsg_type = RTM_GETNEXTHOP;
+        nh_req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+        nh_req.nlh.nlmsg_seq = 2;
+        nh_req.nhm.nh_family = AF_UNSPEC;
+        if (send(fd, &nh_req, nh_req.nlh.nlmsg_len, 0) >= 0) {
+            receive_dump(fd, buffer, false);
+        }
+    }
 
-    // 基本路由信息
-    result["family"] = std::to_string(rtm->rtm_family);
-    result["table"] = std::to_string(rtm->rtm_table);
-    result["protocol"] = get_route_protocol_name(rtm->rtm_protocol);
-    result["scope"] = get_route_scope_name(rtm->rtm_scope);
-    result["type"] = get_route_type_name(rtm->rtm_type);
+    close(fd);
+    report_dump_done(ok);
+    return ok;
+}
 
-    // 解析路由属性
-    parse_route_attributes(rta, len, result);
+bool NetlinkMonitor::receive_dump(int fd, std::vector<char>& buffer, bool report_errors) {
+    while (true) {
+        ssize_t len = recv(fd, buffer.data(), buffer.size(), 0);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (capture_.is_open()) {
+            capture_.append(NetlinkCapture::ROUTE_DUMP, EventClock::monotonic_ns(), buffer.data(),
+                            static_cast<size_t>(len));
+        }
 
-    return result;
+        int remaining = static_cast<int>(len);
+        const struct nlmsghdr* nlh = reinterpret_cast<const struct nlmsghdr*>(buffer.data());
+        while (NLMSG_OK(nlh, remaining)) {
+            if (nlh->nlmsg_type == NLMSG_DONE) {
+                return true;
+            }
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                if (report_errors) {
+                    handle_netlink_error(nlh);
+                }
+                return false;
+            }
+            if ((nlh->nlmsg_type == RTM_NEWROUTE || nlh->nlmsg_type == RTM_NEWNEXTHOP) && dump_route_callback_) {
+                dump_route_callback_(nlh);
+            }
+            nlh = NLMSG_NEXT(nlh, remaining);
+        }
+    }
 }
 
-std::unordered_map<std::string, std::string> NetlinkMessageParser::parse_qdisc_message(
-    const struct tcmsg* tcm, const struct rtattr* rta, int len) {
+void NetlinkMonitor::setup_receive_pool() {
+    size_t batch = options_.batch_size;
+    recv_buffer_pool_.assign(batch * NETLINK_BUFFER_SIZE, 0);
+    recv_msgs_.assign(batch, mmsghdr{});
+    recv_iovecs_.assign(batch, iovec{});
+    recv_control_pool_.assign(options_.kernel_timestamps ? batch * CONTROL_BUFFER_SIZE : 0, 0);
+
+    for (size_t i = 0; i < batch; ++i) {
+        recv_iovecs_[i].iov_base = recv_buffer_pool_.data() + i * NETLINK_BUFFER_SIZE;
+        recv_iovecs_[i].iov_len = NETLINK_BUFFER_SIZE;
+        recv_msgs_[i].msg_hdr.msg_iov = &recv_iovecs_[i];
+        recv_msgs_[i].msg_hdr.msg_iovlen = 1;
+        if (options_.kernel_timestamps) {
+            recv_msgs_[i].msg_hdr.msg_control = recv_control_pool_.data() + i * CONTROL_BUFFER_SIZE;
+            recv_msgs_[i].msg_hdr.msg_controllen = CONTROL_BUFFER_SIZE;
+        }
+    }
+}
 
-    std::unordered_map<std::string, std::string> result;
+int64_t NetlinkMonitor::datagram_receive_time(const struct msghdr& msg, int64_t dequeue_time_ns) {
+    if (msg.msg_controllen > 0) {
+        for (const struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+             cmsg = CMSG_NXTHDR(const_cast<struct msghdr*>(&msg), const_cast<struct cmsghdr*>(cmsg))) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+                struct timespec ts;
+                memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                kernel_timestamp_count_.fetch_add(1, std::memory_order_relaxed);
+                int64_t kernel_time = EventClock::realtime_to_monotonic_ns(ts);
+                kernel_queue_latency_.record(dequeue_time_ns - kernel_time);
+                return kernel_time;
+            }
+        }
+    }
 
-    // 基本QDisc信息
-    result["ifindex"] = std::to_string(tcm->tcm_ifindex);
-    result["interface"] = get_interface_name(tcm->tcm_ifindex);
-    result["handle"] = std::to_string(tcm->tcm_handle);
-    result["parent"] = std::to_string(tcm->tcm_parent);
-    result["family"] = std::to_string(tcm->tcm_family);
+    if (options_.kernel_timestamps && !kernel_timestamp_notice_shown_) {
+        kernel_timestamp_notice_shown_ = true;
+        std::cout << "ℹ️  内核未为netlink数据报提供接收时间戳，使用出队时刻的单调时间\n";
+    }
+    return dequeue_time_ns;
+}
 
-    // 解析QDisc属性
-    parse_qdisc_attributes(rta, len, result);
+bool NetlinkMonitor::drain_netlink_socket() {
+    const unsigned int batch = static_cast<unsigned int>(recv_msgs_.size());
 
-    return result;
-}
+    while (running_.load()) {
+        if (batch <= 1) {
+            // 逐条接收模式
+            struct msghdr& msg = recv_msgs_[0].msg_hdr;
+            msg.msg_controllen = recv_control_pool_.size();
+            ssize_t len = recvmsg(netlink_socket_fd_, &msg, 0);
+            if (len < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return true;
+                }
+                if (errno == ENOBUFS) {
+                    handle_overrun();
+                    continue;
+                }
+                if (running_.load()) {
+                    std::cerr << "Netlink recv error: " << strerror(errno) << "\n";
+                }
+                return false;
+            }
+            if (len == 0) {
+                return false;
+            }
+            // 出队后立即取时间，不包含解析与回调的耗时
+            int64_t dequeue_time = EventClock::monotonic_ns();
+            if (msg.msg_flags & MSG_TRUNC) {
+                std::cerr << "⚠️  Netlink数据报被截断，已丢弃\n";
+                continue;
+            }
+            process_datagram(recv_buffer_pool_.data(), static_cast<size_t>(len),
+                             datagram_receive_time(msg, dequeue_time), dequeue_time);
+            continue;
+        }
 
-void NetlinkMessageParser::parse_route_attributes(const struct rtattr* rta, int len,
-                                                 std::unordered_map<std::string, std::string>& result) {
-    while (rta_ok(rta, len)) {
-        switch (rta->rta_type) {
-            case RTA_DST: {
-                int family = std::stoi(result["family"]);
-                result["dst"] = ip_to_string(rta_data(rta), family);
-                break;
+        // 批量接收模式：一次系统调用取回多个数据报
+        for (unsigned int i = 0; i < batch; ++i) {
+            recv_msgs_[i].msg_hdr.msg_controllen = recv_control_pool_.empty() ? 0 : CONTROL_BUFFER_SIZE;
+        }
+        int received = recvmmsg(netlink_socket_fd_, recv_msgs_.data(), batch, MSG_DONTWAIT, nullptr);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
             }
-            case RTA_GATEWAY: {
-                int family = std::stoi(result["family"]);
-                result["gateway"] = ip_to_string(rta_data(rta), family);
-                break;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
             }
-            case RTA_OIF: {
-                int ifindex = *static_cast<int*>(rta_data(rta));
-                result["ifindex"] = std::to_string(ifindex);
-                result["interface"] = get_interface_name(ifindex);
-                break;
+            if (errno == ENOBUFS) {
+                handle_overrun();
+                continue;
             }
-            case RTA_PREFSRC: {
-                int family = std::stoi(result["family"]);
-                result["prefsrc"] = ip_to_string(rta_data(rta), family);
-                break;
+            if (running_.load()) {
+                std::cerr << "Netlink recvmmsg error: " << strerror(errno) << "\n";
             }
-            case RTA_PRIORITY: {
-                int priority = *static_cast<int*>(rta_data(rta));
-                result["priority"] = std::to_string(priority);
-                break;
+            return false;
+        }
+        if (received == 0) {
+            return false;
+        }
+
+        // 同一批数据报在同一次系统调用中出队
+        int64_t dequeue_time = EventClock::monotonic_ns();
+        for (int i = 0; i < received; ++i) {
+            if (recv_msgs_[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                std::cerr << "⚠️  Netlink数据报被截断，已丢弃\n";
+                continue;
             }
-            default:
-                break;
+            process_datagram(static_cast<const char*>(recv_iovecs_[i].iov_base), recv_msgs_[i].msg_len,
+                             datagram_receive_time(recv_msgs_[i].msg_hdr, dequeue_time), dequeue_time);
         }
-        rta = rta_next(rta, len);
-    }
 
-    // 设置默认值
-    if (result.find("dst") == result.end()) {
-        result["dst"] = "default";
+        // 未取满一批说明队列已清空
+        if (static_cast<unsigned int>(received) < batch) {
+            return true;
+        }
     }
-    if (result.find("gateway") == result.end()) {
-        result["gateway"] = "N/A";
+
+    return true;
+}
+
+void NetlinkMonitor::process_datagram(const char* data, size_t len, int64_t receive_time_ns,
+                                      int64_t dequeue_time_ns) {
+    receive_time_ns_ = receive_time_ns;
+    dequeue_time_ns_ = dequeue_time_ns;
+    datagram_count_.fetch_add(1, std::memory_order_relaxed);
+    if (capture_.is_open()) {
+        capture_.append(NetlinkCapture::DATAGRAM, receive_time_ns, data, len);
     }
-    if (result.find("interface") == result.end()) {
-        result["interface"] = "N/A";
+    int remaining = static_cast<int>(len);
+    const struct nlmsghdr* nlh = reinterpret_cast<const struct nlmsghdr*>(data);
+    while (NLMSG_OK(nlh, remaining)) {
+        process_netlink_message(nlh);
+        nlh = NLMSG_NEXT(nlh, remaining);
     }
 }
 
-void NetlinkMessageParser::parse_qdisc_attributes(const struct rtattr* rta, int len,
-                                                 std::unordered_map<std::string, std::string>& result) {
-    while (rta_ok(rta, len)) {
-        switch (rta->rta_type) {
-            case TCA_KIND: {
-                std::string kind(static_cast<char*>(rta_data(rta)));
-                result["kind"] = kind;
-                result["is_netem"] = (kind == "netem") ? "true" : "false";
-                break;
-            }
-            case TCA_OPTIONS:
-                // 这里可以进一步解析QDisc选项
-                break;
-            default:
-                break;
-        }
-        rta = rta_next(rta, len);
+bool NetlinkMonitor::open_route_ring() {
+    std::string error;
+    std::shared_ptr<EbpfFibSource> source = EbpfFibSource::acquire(error);
+    if (source) {
+        route_ring_ = source->open_ring(error);
+    }
+    if (!route_ring_) {
+        std::cerr << "❌ eBPF路由来源不可用: " << error << "\n";
+        return false;
     }
+    last_ring_drops_ = 0;
 
-    // 设置默认值
-    if (result.find("kind") == result.end()) {
-        result["kind"] = "unknown";
-        result["is_netem"] = "false";
+    // bpf_ktime_get_ns 是宿主的单调时钟，时间命名空间中的本地单调时间 = 宿主 + 偏移
+    std::string boot_id;
+    if (!EventClock::host_clock_identity(boot_id, timens_offset_ns_)) {
+        timens_offset_ns_ = 0;
     }
+    return true;
 }
 
-std::string NetlinkMessageParser::ip_to_string(const void* addr, int family) {
-    char str[INET6_ADDRSTRLEN];
-
-    if (family == AF_INET) {
-        if (inet_ntop(AF_INET, addr, str, INET_ADDRSTRLEN)) {
-            return std::string(str);
+void NetlinkMonitor::drain_route_ring() {
+    int64_t dequeue_time = EventClock::monotonic_ns();
+    size_t count = route_ring_->drain([this, dequeue_time](const RouteRecord& route) {
+        // 记录的时间戳是内核修改FIB的时刻，内核排队阶段即修改到出队
+        receive_time_ns_ = route.timestamp + timens_offset_ns_;
+        dequeue_time_ns_ = dequeue_time;
+        kernel_queue_latency_.record(dequeue_time - receive_time_ns_);
+
+        message_start_ns_ = 0;
+        if (PipelineStats::sample(PipelineStats::DISPATCH)) {
+            message_start_ns_ = EventClock::monotonic_ns();
+            dispatch_latency_.record(message_start_ns_ - dequeue_time_ns_);
         }
-    } else if (family == AF_INET6) {
-        if (inet_ntop(AF_INET6, addr, str, INET6_ADDRSTRLEN)) {
-            return std::string(str);
+        if (route_callback_ && route_passes_filter(route)) {
+            route_callback_(route);
         }
+    });
+    ebpf_route_count_.fetch_add(static_cast<int64_t>(count), std::memory_order_relaxed);
+
+    // 丢弃计数是累计值，增加时与netlink溢出一样重新同步
+    int64_t drops = route_ring_->dropped();
+    if (drops <= last_ring_drops_) {
+        return;
     }
+    int64_t lost = drops - last_ring_drops_;
+    last_ring_drops_ = drops;
+    overrun_count_.fetch_add(1);
+    lost_message_count_.fetch_add(lost);
+    ebpf_dropped_count_.fetch_add(lost);
+
+    std::cerr << "⚠️  eBPF路由环形缓冲区已满，丢失 " << lost << " 条路由记录，发起RIB重新同步\n";
+    if (overrun_callback_) {
+        overrun_callback_(lost);
+    }
+    request_route_dump();
+}
 
-    return "N/A";
+bool NetlinkMonitor::route_passes_filter(const RouteRecord& route) const {
+    const NetlinkFilterSpec& filter = options_.filter;
+    auto allowed = [](const std::vector<uint8_t>& list, uint8_t value) {
+        return list.empty() || std::find(list.begin(), list.end(), value) != list.end();
+    };
+    // 与netlink消息的 rtm_table 一致：大于255的表号按 RT_TABLE_COMPAT 匹配
+    uint8_t table = route.table > 255 ? static_cast<uint8_t>(RT_TABLE_COMPAT) : static_cast<uint8_t>(route.table);
+    return allowed(filter.families, route.family) && allowed(filter.protocols, route.protocol) &&
+           allowed(filter.tables, table);
 }
 
-std::string NetlinkMessageParser::get_interface_name(int ifindex) {
-    char ifname[IF_NAMESIZE];
-    if (if_indextoname(ifindex, ifname)) {
-        return std::string(ifname);
+void NetlinkMonitor::handle_overrun() {
+    // 内核已丢弃消息；套接字本身仍然可用，继续读取剩余数据
+    overrun_count_.fetch_add(1);
+
+    // 通过 /proc/net/netlink 的 Drops 列获取准确丢失数，不可用时至少计为1
+    int64_t lost = 1;
+    int64_t drops = read_socket_drops();
+    if (drops >= 0) {
+        if (drops > last_socket_drops_) {
+            lost = drops - last_socket_drops_;
+        }
+        last_socket_drops_ = drops;
     }
-    return "if" + std::to_string(ifindex);
-}
+    lost_message_count_.fetch_add(lost);
 
-std::string NetlinkMessageParser::get_route_table_name(int table) {
-    switch (table) {
-        case RT_TABLE_UNSPEC: return "unspec";
-        case RT_TABLE_COMPAT: return "compat";
-        case RT_TABLE_DEFAULT: return "default";
-        case RT_TABLE_MAIN: return "main";
-        case RT_TABLE_LOCAL: return "local";
-        default: return std::to_string(table);
+    std::cerr << "⚠️  Netlink接收队列溢出(ENOBUFS)，估计丢失 " << lost << " 条消息，发起RIB重新同步\n";
+    if (capture_.is_open()) {
+        capture_.append(NetlinkCapture::OVERRUN, EventClock::monotonic_ns(), &lost, sizeof(lost));
     }
-}
 
-std::string NetlinkMessageParser::get_route_protocol_name(int protocol) {
-    switch (protocol) {
-        case RTPROT_UNSPEC: return "unspec";
-        case RTPROT_REDIRECT: return "redirect";
-        case RTPROT_KERNEL: return "kernel";
-        case RTPROT_BOOT: return "boot";
-        case RTPROT_STATIC: return "static";
-        default: return std::to_string(protocol);
+    if (overrun_callback_) {
+        overrun_callback_(lost);
     }
+
+    request_route_dump();
 }
 
-std::string NetlinkMessageParser::get_route_scope_name(int scope) {
-    switch (scope) {
-        case RT_SCOPE_UNIVERSE: return "universe";
-        case RT_SCOPE_SITE: return "site";
-        case RT_SCOPE_LINK: return "link";
-        case RT_SCOPE_HOST: return "host";
-        case RT_SCOPE_NOWHERE: return "nowhere";
-        default: return std::to_string(scope);
-    }
+int64_t NetlinkMonitor::read_socket_drops() const {
+    int64_t rmem, drops;
+    return read_socket_proc(rmem, drops) ? drops : -1;
 }
 
-std::string NetlinkMessageParser::get_route_type_name(int type) {
-    switch (type) {
-        case RTN_UNSPEC: return "unspec";
-        case RTN_UNICAST: return "unicast";
-        case RTN_LOCAL: return "local";
-        case RTN_BROADCAST: return "broadcast";
-        case RTN_ANYCAST: return "anycast";
-        case RTN_MULTICAST: return "multicast";
-        case RTN_BLACKHOLE: return "blackhole";
-        case RTN_UNREACHABLE: return "unreachable";
-        case RTN_PROHIBIT: return "prohibit";
-        default: return std::to_string(type);
+bool NetlinkMonitor::read_socket_proc(int64_t& rmem, int64_t& drops) const {
+    std::lock_guard<std::mutex> lock(proc_mutex_);
+    struct stat st;
+    int socket_fd = netlink_socket_fd_.load(std::memory_order_relaxed);
+    if (socket_fd < 0 || proc_netlink_fd_ < 0 || fstat(socket_fd, &st) < 0) {
+        return false;
+    }
+
+    // seq_file 每次从偏移0重新生成，pread 不依赖共享的文件偏移
+    std::string content;
+    char buffer[4096];
+    off_t offset = 0;
+    ssize_t len;
+    while ((len = pread(proc_netlink_fd_, buffer, sizeof(buffer), offset)) > 0) {
+        content.append(buffer, static_cast<size_t>(len));
+        offset += len;
+    }
+
+    // 列: sk Eth Pid Groups Rmem Wmem Dump Locks Drops Inode
+    std::istringstream proc(content);
+    std::string line;
+    std::getline(proc, line);
+    while (std::getline(proc, line)) {
+        std::istringstream iss(line);
+        std::string sk, eth, pid, groups, wmem, dump, locks;
+        int64_t rmem_value = 0;
+        int64_t drops_value = 0;
+        unsigned long inode = 0;
+        if (!(iss >> sk >> eth >> pid >> groups >> rmem_value >> wmem >> dump >> locks >> drops_value >> inode)) {
+            continue;
+        }
+        if (inode == st.st_ino) {
+            rmem = rmem_value;
+            drops = drops_value;
+            return true;
+        }
+    }
+    return false;
+}
+
+int64_t NetlinkMonitor::get_receive_queue_bytes() const {
+    int64_t rmem, drops;
+    return read_socket_proc(rmem, drops) ? rmem : -1;
+}
+
+void NetlinkMonitor::append_pipeline_stats(PipelineStats::Report& report) const {
+    bool ebpf = options_.route_source == RouteEventSource::EBPF;
+    if (options_.kernel_timestamps || ebpf) {
+        report.add_stage(PipelineStats::KERNEL_QUEUE, kernel_queue_latency_);
+    }
+    report.add_stage(PipelineStats::DISPATCH, dispatch_latency_);
+    report.add_counter("netlink_datagrams", datagram_count_.load(std::memory_order_relaxed));
+    report.add_counter("netlink_messages", message_count_.load(std::memory_order_relaxed));
+    if (ebpf) {
+        report.add_counter("ebpf_route_records", ebpf_route_count_.load(std::memory_order_relaxed));
+        report.add_counter("ebpf_dropped_records", ebpf_dropped_count_.load());
+    }
+    // 套接字已关闭（最终统计）或回放模式下没有接收队列
+    int64_t queue_bytes = get_receive_queue_bytes();
+    if (queue_bytes >= 0) {
+        report.add_counter("socket_queue_bytes", queue_bytes);
+    }
+    report.add_counter("netlink_overruns", overrun_count_.load());
+    report.add_counter("lost_messages", lost_message_count_.load());
+}
+
+int NetlinkMonitor::create_dump_socket() {
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+void NetlinkMonitor::request_route_dump() {
+    if (dump_socket_fd_ < 0) {
+        return;
+    }
+
+    // 同一时刻只允许一个转储；转储期间再次溢出则在完成后重新转储
+    if (dump_in_progress_) {
+        dump_pending_ = true;
+        return;
+    }
+
+    if (!send_route_dump_request()) {
+        std::cerr << "⚠️  发送RTM_GETROUTE转储请求失败: " << strerror(errno) << "\n";
+        report_dump_done(false);
+        return;
+    }
+    dump_in_progress_ = true;
+}
+
+bool NetlinkMonitor::send_route_dump_request() {
+    struct {
+        struct nlmsghdr nlh;
+        struct rtmsg rtm;
+    } req;
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+    req.nlh.nlmsg_type = RTM_GETROUTE;
+    req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nlh.nlmsg_seq = ++dump_seq_;
+    req.rtm.rtm_family = AF_UNSPEC;
+
+    return send(dump_socket_fd_, &req, req.nlh.nlmsg_len, 0) >= 0;
+}
+
+void NetlinkMonitor::drain_dump_socket() {
+    char* buffer = recv_buffer_pool_.data();
+
+    while (dump_in_progress_) {
+        ssize_t len = recv(dump_socket_fd_, buffer, NETLINK_BUFFER_SIZE, 0);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            // 转储被中断（例如转储期间表发生变化），稍后重试
+            std::cerr << "⚠️  RIB转储接收失败: " << strerror(errno) << "\n";
+            finish_route_dump(false);
+            return;
+        }
+        if (capture_.is_open()) {
+            capture_.append(NetlinkCapture::ROUTE_DUMP, EventClock::monotonic_ns(), buffer, static_cast<size_t>(len));
+        }
+
+        int remaining = static_cast<int>(len);
+        const struct nlmsghdr* nlh = reinterpret_cast<const struct nlmsghdr*>(buffer);
+        while (NLMSG_OK(nlh, remaining)) {
+            if (nlh->nlmsg_seq != dump_seq_) {
+                // 过期转储的残留消息
+            } else if (nlh->nlmsg_type == NLMSG_DONE) {
+                finish_route_dump(true);
+                break;
+            } else if (nlh->nlmsg_type == NLMSG_ERROR) {
+                handle_netlink_error(nlh);
+                finish_route_dump(false);
+                break;
+            } else if (nlh->nlmsg_type == RTM_NEWROUTE && dump_route_callback_) {
+                dump_route_callback_(nlh);
+            }
+            nlh = NLMSG_NEXT(nlh, remaining);
+        }
+    }
+}
+
+void NetlinkMonitor::finish_route_dump(bool success) {
+    dump_in_progress_ = false;
+    report_dump_done(success);
+
+    if (dump_pending_) {
+        dump_pending_ = false;
+        request_route_dump();
+    }
+}
+
+void NetlinkMonitor::report_dump_done(bool success) {
+    if (capture_.is_open()) {
+        uint8_t flag = success ? 1 : 0;
+        capture_.append(NetlinkCapture::DUMP_DONE, EventClock::monotonic_ns(), &flag, sizeof(flag));
+    }
+    if (dump_done_callback_) {
+        dump_done_callback_(success);
+    }
+}
+
+void NetlinkMonitor::arm_deadline(int64_t deadline_ns) {
+    // 绝对时间（CLOCK_MONOTONIC）；已过去的截止时间立即到期。it_value全零表示解除，因此至少为1ns
+    if (deadline_ns <= 0) {
+        deadline_ns = 1;
+    }
+    if (virtual_clock_) {
+        virtual_deadline_ns_ = deadline_ns;
+        return;
+    }
+    if (timer_fd_ < 0) {
+        return;
+    }
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = deadline_ns / EventClock::NS_PER_SEC;
+    spec.it_value.tv_nsec = deadline_ns % EventClock::NS_PER_SEC;
+
+    if (timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+        std::cerr << "⚠️  设置收敛定时器失败: " << strerror(errno) << "\n";
+    }
+}
+
+void NetlinkMonitor::disarm_timer() {
+    if (virtual_clock_) {
+        virtual_deadline_ns_ = -1;
+        return;
+    }
+    if (timer_fd_ < 0) {
+        return;
+    }
+
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    timerfd_settime(timer_fd_, 0, &spec, nullptr);
+}
+
+void NetlinkMonitor::unified_monitor_loop() {
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+    InterfaceCache::Scope interface_scope(interfaces_);
+    if (options_.cpu >= 0) {
+        CpuAffinity::pin_current_thread(options_.cpu);
+    }
+    if (options_.prefault_stack) {
+        LowJitter::prefault_stack();
+    }
+
+    while (running_.load()) {
+        // 无限期等待：关闭通过管道唤醒，收敛截止时间由timerfd唤醒，空闲时不产生周期性唤醒
+        int nfds = epoll_wait(epoll_fd_, events, MAX_EPOLL_EVENTS, -1);
+
+        if (nfds < 0) {
+            if (errno == EINTR) {
+                // 被信号中断，检查是否需要退出
+                if (!running_.load()) {
+                    break;
+                }
+                continue; // 继续等待
+            }
+            if (running_.load()) {
+                std::cerr << "Epoll wait error: " << strerror(errno) << "\n";
+            }
+            break;
+        }
+
+        if (nfds == 0) {
+            // 超时，继续循环检查running状态
+            continue;
+        }
+
+        handle_ready_events(events, nfds);
+    }
+}
+
+bool NetlinkMonitor::open_replay(std::string& error) {
+    if (!replay_reader_.open(options_.replay_path, error)) {
+        return false;
+    }
+    replaying_ = true;
+    virtual_clock_ = true;
+    virtual_now_ns_.store(replay_reader_.anchor_monotonic_ns(), std::memory_order_relaxed);
+    EventClock::set_wall_anchor(replay_reader_.anchor_realtime_ns(), replay_reader_.anchor_monotonic_ns());
+    return true;
+}
+
+void NetlinkMonitor::fire_virtual_timers(int64_t until_ns) {
+    // 定时器回调会按剩余会话重新设置截止时间，同一时刻可能连续到期
+    while (running_.load() && virtual_deadline_ns_ >= 0 && virtual_deadline_ns_ <= until_ns) {
+        advance_virtual_now(virtual_deadline_ns_);
+        virtual_deadline_ns_ = -1;
+        if (timer_callback_) {
+            timer_callback_();
+        }
+    }
+}
+
+void NetlinkMonitor::advance_virtual_now(int64_t now_ns) {
+    // 只有事件线程写入，读-改-写无需CAS
+    if (now_ns > virtual_now_ns_.load(std::memory_order_relaxed)) {
+        virtual_now_ns_.store(now_ns, std::memory_order_relaxed);
+    }
+}
+
+void NetlinkMonitor::inject_datagram(const char* data, size_t len, int64_t receive_time_ns) {
+    InterfaceCache::Scope interface_scope(interfaces_);
+    advance_clock(receive_time_ns);
+    process_datagram(data, len, receive_time_ns, EventClock::monotonic_ns());
+}
+
+void NetlinkMonitor::advance_clock(int64_t now_ns) {
+    fire_virtual_timers(now_ns);
+    // 虚拟时间不回退（录制时内核时间戳与出队时间可能交错）
+    advance_virtual_now(now_ns);
+}
+
+void NetlinkMonitor::replay_dump_datagram(const NetlinkCapture::Record& record, bool deliver_routes) {
+    int remaining = static_cast<int>(record.data.size());
+    const struct nlmsghdr* nlh = reinterpret_cast<const struct nlmsghdr*>(record.data.data());
+    while (NLMSG_OK(nlh, remaining)) {
+        LinkRecord link;
+        if (nlh->nlmsg_type == RTM_NEWLINK && NetlinkMessageParser::parse_link_message(nlh, link)) {
+            interfaces_->update(link.ifindex, link.name, link.flags);
+        } else if (deliver_routes && (nlh->nlmsg_type == RTM_NEWROUTE || nlh->nlmsg_type == RTM_NEWNEXTHOP) &&
+                   dump_route_callback_) {
+            dump_route_callback_(nlh);
+        }
+        nlh = NLMSG_NEXT(nlh, remaining);
+    }
+}
+
+void NetlinkMonitor::replay_loop() {
+    InterfaceCache::Scope interface_scope(interfaces_);
+    if (options_.cpu >= 0) {
+        CpuAffinity::pin_current_thread(options_.cpu);
+    }
+    if (options_.prefault_stack) {
+        LowJitter::prefault_stack();
+    }
+
+    // 第一条通知之前的转储属于启动阶段：只在本次回放也建立FIB镜像时交给转储回调，
+    // 抓包中没有启动转储时按转储失败处理（镜像从空表开始）
+    bool startup = true;
+    bool startup_dump_done = false;
+    auto end_startup = [&]() {
+        startup = false;
+        if (options_.initial_route_dump && !startup_dump_done) {
+            std::cerr << "⚠️  抓包中没有启动时的路由表转储，路由变化分类从空表开始\n";
+            if (dump_done_callback_) {
+                dump_done_callback_(false);
+            }
+        }
+    };
+
+    NetlinkCapture::Record record;
+    int64_t record_count = 0;
+    int64_t wall_start = EventClock::monotonic_ns();
+    int64_t first_timestamp = virtual_now_ns_.load(std::memory_order_relaxed);
+
+    while (running_.load() && replay_reader_.next(record)) {
+        record_count++;
+        if (startup && (record.type == NetlinkCapture::DATAGRAM || record.type == NetlinkCapture::OVERRUN)) {
+            end_startup();
+        }
+
+        advance_clock(record.timestamp);
+
+        switch (record.type) {
+            case NetlinkCapture::DATAGRAM:
+                process_datagram(record.data.data(), record.data.size(), record.timestamp,
+                                 EventClock::monotonic_ns());
+                break;
+            case NetlinkCapture::LINK_DUMP:
+                replay_dump_datagram(record, false);
+                break;
+            case NetlinkCapture::ROUTE_DUMP:
+                replay_dump_datagram(record, !startup || options_.initial_route_dump);
+                break;
+            case NetlinkCapture::DUMP_DONE:
+                if (startup) {
+                    if (!options_.initial_route_dump) {
+                        break;
+                    }
+                    startup_dump_done = true;
+                }
+                if (dump_done_callback_) {
+                    dump_done_callback_(!record.data.empty() && record.data[0] != 0);
+                }
+                break;
+            case NetlinkCapture::OVERRUN: {
+                int64_t lost = 1;
+                if (record.data.size() >= sizeof(lost)) {
+                    memcpy(&lost, record.data.data(), sizeof(lost));
+                }
+                overrun_count_.fetch_add(1);
+                lost_message_count_.fetch_add(lost);
+                if (overrun_callback_) {
+                    overrun_callback_(lost);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    if (!replay_reader_.error().empty()) {
+        std::cerr << "⚠️  抓包读取中止: " << replay_reader_.error() << "\n";
+    }
+    if (running_.load()) {
+        if (startup) {
+            end_startup();
+        }
+        // 抓包结束后不再有事件，进行中的会话按静默期截止时间收敛
+        fire_virtual_timers(INT64_MAX);
+
+        int64_t elapsed_ns = EventClock::monotonic_ns() - wall_start;
+        int64_t virtual_ns = virtual_now_ns_.load(std::memory_order_relaxed) - first_timestamp;
+        std::cout << "⏹️  回放完成: " << record_count << " 条记录, 录制时长 "
+                  << static_cast<double>(virtual_ns) / EventClock::NS_PER_SEC << "秒, 回放用时 "
+                  << static_cast<double>(elapsed_ns) / EventClock::NS_PER_MS << "ms\n";
+    }
+    replay_finished_.store(true);
+}
+
+bool NetlinkMonitor::dispatch_ready() {
+    if (!running_.load() || epoll_fd_ < 0) {
+        return false;
+    }
+
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+    InterfaceCache::Scope interface_scope(interfaces_);
+    int nfds = epoll_wait(epoll_fd_, events, MAX_EPOLL_EVENTS, 0);
+    if (nfds > 0) {
+        handle_ready_events(events, nfds);
+    }
+    return running_.load();
+}
+
+bool NetlinkMonitor::handle_ready_events(const struct epoll_event* events, int count) {
+    // 处理所有就绪的事件
+    for (int i = 0; i < count; ++i) {
+        if (events[i].data.fd == netlink_socket_fd_) {
+            // 一次唤醒内读取整个突发
+            if (!drain_netlink_socket()) {
+                return false;
+            }
+        } else if (route_ring_ && events[i].data.fd == route_ring_->fd()) {
+            drain_route_ring();
+        } else if (events[i].data.fd == timer_fd_) {
+            // 收敛截止时间到期
+            uint64_t expirations = 0;
+            if (read(timer_fd_, &expirations, sizeof(expirations)) > 0 && timer_callback_) {
+                timer_callback_();
+            }
+        } else if (events[i].data.fd == dump_socket_fd_) {
+            // RIB转储应答，与通知消息在同一线程中异步处理
+            drain_dump_socket();
+        } else if (events[i].data.fd == shutdown_pipe_[0]) {
+            // 收到关闭信号
+            char dummy;
+            read(shutdown_pipe_[0], &dummy, 1); // 清空管道
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr std::array<NetlinkMonitor::MessageDispatch, NetlinkMonitor::DISPATCH_TABLE_SIZE>
+NetlinkMonitor::make_dispatch_table() {
+    std::array<MessageDispatch, DISPATCH_TABLE_SIZE> table{};
+    table[RTM_NEWROUTE] = {NetlinkMessageType::ROUTE_ADD, &NetlinkMonitor::handle_route_message};
+    table[RTM_DELROUTE] = {NetlinkMessageType::ROUTE_DEL, &NetlinkMonitor::handle_route_message};
+    table[RTM_NEWQDISC] = {NetlinkMessageType::QDISC_ADD, &NetlinkMonitor::handle_qdisc_message};
+    table[RTM_DELQDISC] = {NetlinkMessageType::QDISC_DEL, &NetlinkMonitor::handle_qdisc_message};
+    table[RTM_GETQDISC] = {NetlinkMessageType::QDISC_GET, &NetlinkMonitor::handle_qdisc_message};
+    table[RTM_NEWLINK] = {NetlinkMessageType::LINK_NEW, &NetlinkMonitor::handle_link_message};
+    table[RTM_DELLINK] = {NetlinkMessageType::LINK_DEL, &NetlinkMonitor::handle_link_message};
+    table[RTM_NEWNEXTHOP] = {NetlinkMessageType::NEXTHOP_NEW, &NetlinkMonitor::handle_nexthop_message};
+    table[RTM_DELNEXTHOP] = {NetlinkMessageType::NEXTHOP_DEL, &NetlinkMonitor::handle_nexthop_message};
+    return table;
+}
+
+void NetlinkMonitor::process_netlink_message(const struct nlmsghdr* nlh) {
+    static constexpr std::array<MessageDispatch, DISPATCH_TABLE_SIZE> DISPATCH = make_dispatch_table();
+
+    // 按采样间隔计时：记录批内排队时间，并把开始时刻交给回调记录后续阶段
+    message_count_.fetch_add(1, std::memory_order_relaxed);
+    message_start_ns_ = 0;
+    if (PipelineStats::sample(PipelineStats::DISPATCH)) {
+        message_start_ns_ = EventClock::monotonic_ns();
+        dispatch_latency_.record(message_start_ns_ - dequeue_time_ns_);
+    }
+
+    // 一次查表得到消息类型与处理函数，每条消息只解析一次
+    MessageDispatch dispatch;
+    if (nlh->nlmsg_type < DISPATCH_TABLE_SIZE) {
+        dispatch = DISPATCH[nlh->nlmsg_type];
+    }
+    if (dispatch.handler) {
+        (this->*dispatch.handler)(nlh, dispatch.type);
+    }
+
+    // 如果设置了统一回调，也调用它
+    if (unified_callback_) {
+        unified_callback_(nlh, dispatch.type);
+    }
+}
+
+void NetlinkMonitor::handle_route_message(const struct nlmsghdr* nlh, NetlinkMessageType) {
+    if (!route_callback_) {
+        return;
+    }
+    RouteRecord route;
+    if (NetlinkMessageParser::parse_route_message(nlh, route)) {
+        route_callback_(route);
+    }
+}
+
+void NetlinkMonitor::handle_qdisc_message(const struct nlmsghdr* nlh, NetlinkMessageType) {
+    QdiscRecord qdisc;
+    if (!NetlinkMessageParser::parse_qdisc_message(nlh, qdisc)) {
+        return;
+    }
+
+    // 忽略 noqueue 类型的 qdisc
+    if (qdisc.is_noqueue()) {
+        return;
+    }
+
+    if (qdisc_callback_) {
+        qdisc_callback_(qdisc);
+    }
+}
+
+void NetlinkMonitor::handle_link_message(const struct nlmsghdr* nlh, NetlinkMessageType) {
+    LinkRecord link;
+    if (!NetlinkMessageParser::parse_link_message(nlh, link)) {
+        return;
+    }
+
+    InterfaceCache& cache = *interfaces_;
+
+    // 与缓存中的旧状态比较，判断是否发生UP/DOWN变化
+    char old_name[IF_NAMESIZE];
+    uint32_t old_flags = 0;
+    bool old_alive = false;
+    bool known = cache.lookup(link.ifindex, old_name, &old_flags, &old_alive) && old_alive;
+    bool was_up = known && (old_flags & IFF_UP) && (old_flags & IFF_RUNNING);
+
+    if (link.nlmsg_type == RTM_DELLINK) {
+        // 删除消息可能不带名称，使用缓存中的名称
+        if (!link.name[0] && known) {
+            memcpy(link.name, old_name, sizeof(link.name));
+        }
+        cache.remove(link.ifindex);
+        link.up = 0;
+    } else {
+        cache.update(link.ifindex, link.name, link.flags);
+    }
+
+    bool now_up = link.up != 0;
+    if (was_up == now_up) {
+        return; // 名称、MTU等其他属性变化
+    }
+    if (!known && !now_up) {
+        return; // 新建的接口初始为DOWN，不视为状态变化
+    }
+
+    if (link_callback_) {
+        link_callback_(link);
+    }
+}
+
+void NetlinkMonitor::handle_nexthop_message(const struct nlmsghdr* nlh, NetlinkMessageType) {
+    NexthopRecord nexthop;
+    if (!NetlinkMessageParser::parse_nexthop_message(nlh, nexthop)) {
+        return;
+    }
+    if (nexthop_callback_) {
+        nexthop_callback_(nexthop);
+    }
+}
+
+void NetlinkMonitor::handle_netlink_error(const struct nlmsghdr* nlh) {
+    struct nlmsgerr* err = static_cast<struct nlmsgerr*>(NLMSG_DATA(nlh));
+    std::cerr << "Netlink error: " << strerror(-err->error) << "\n";
+}
+
+// NetlinkMessageParser 实现
+bool NetlinkMessageParser::parse_route_message(const struct nlmsghdr* nlh, RouteRecord& record) {
+    if (nlh->nlmsg_len < NLMSG_LENGTH(sizeof(struct rtmsg))) {
+        return false;
+    }
+
+    const struct rtmsg* rtm = static_cast<const struct rtmsg*>(NLMSG_DATA(nlh));
+    int attrlen = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*rtm));
+    const struct rtattr* rta = reinterpret_cast<const struct rtattr*>(
+        reinterpret_cast<const char*>(rtm) + NLMSG_ALIGN(sizeof(*rtm)));
+
+    parse_route_message(rtm, rta, attrlen, record);
+    record.nlmsg_type = nlh->nlmsg_type;
+    return true;
+}
+
+bool NetlinkMessageParser::parse_qdisc_message(const struct nlmsghdr* nlh, QdiscRecord& record) {
+    if (nlh->nlmsg_len < NLMSG_LENGTH(sizeof(struct tcmsg))) {
+        return false;
+    }
+
+    const struct tcmsg* tcm = static_cast<const struct tcmsg*>(NLMSG_DATA(nlh));
+    int attrlen = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*tcm));
+    const struct rtattr* rta = reinterpret_cast<const struct rtattr*>(
+        reinterpret_cast<const char*>(tcm) + NLMSG_ALIGN(sizeof(*tcm)));
+
+    parse_qdisc_message(tcm, rta, attrlen, record);
+    record.nlmsg_type = nlh->nlmsg_type;
+    return true;
+}
+
+bool NetlinkMessageParser::parse_link_message(const struct nlmsghdr* nlh, LinkRecord& record) {
+    if (nlh->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifinfomsg))) {
+        return false;
+    }
+
+    const struct ifinfomsg* ifm = static_cast<const struct ifinfomsg*>(NLMSG_DATA(nlh));
+    int len = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*ifm));
+    const struct rtattr* rta = reinterpret_cast<const struct rtattr*>(
+        reinterpret_cast<const char*>(ifm) + NLMSG_ALIGN(sizeof(*ifm)));
+
+    memset(&record, 0, sizeof(record));
+    record.nlmsg_type = nlh->nlmsg_type;
+    record.ifindex = ifm->ifi_index;
+    record.flags = ifm->ifi_flags;
+    record.up = ((ifm->ifi_flags & IFF_UP) && (ifm->ifi_flags & IFF_RUNNING)) ? 1 : 0;
+
+    while (rta_ok(rta, len)) {
+        switch (rta->rta_type) {
+            case IFLA_IFNAME: {
+                size_t copy_len = std::min(static_cast<size_t>(rta_len(rta)), LinkRecord::NAME_SIZE - 1);
+                memcpy(record.name, rta_data(rta), copy_len);
+                record.name[copy_len] = '\0';
+                break;
+            }
+            case IFLA_OPERSTATE:
+                if (rta_len(rta) >= 1) {
+                    record.operstate = *static_cast<const uint8_t*>(rta_data(rta));
+                }
+                break;
+            default:
+                break;
+        }
+        rta = rta_next(rta, len);
+    }
+    return true;
+}
+
+bool NetlinkMessageParser::parse_nexthop_message(const struct nlmsghdr* nlh, NexthopRecord& record) {
+    if (nlh->nlmsg_len < NLMSG_LENGTH(sizeof(struct nhmsg))) {
+        return false;
+    }
+
+    const struct nhmsg* nhm = static_cast<const struct nhmsg*>(NLMSG_DATA(nlh));
+    int len = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*nhm));
+    const struct rtattr* rta = reinterpret_cast<const struct rtattr*>(
+        reinterpret_cast<const char*>(nhm) + NLMSG_ALIGN(sizeof(*nhm)));
+
+    memset(&record, 0, sizeof(record));
+    record.nlmsg_type = nlh->nlmsg_type;
+    record.family = nhm->nh_family;
+    record.protocol = nhm->nh_protocol;
+    size_t addr_len = (record.family == AF_INET6) ? 16 : 4;
+
+    while (rta_ok(rta, len)) {
+        size_t payload = static_cast<size_t>(rta_len(rta));
+        switch (rta->rta_type) {
+            case NHA_ID:
+                if (payload >= sizeof(uint32_t)) {
+                    memcpy(&record.id, rta_data(rta), sizeof(uint32_t));
+                }
+                break;
+            case NHA_GROUP: {
+                // 组成员为定长 nexthop_grp 数组，直接在接收缓冲区中计算摘要
+                size_t count = payload / sizeof(struct nexthop_grp);
+                const struct nexthop_grp* members = static_cast<const struct nexthop_grp*>(rta_data(rta));
+                uint32_t hash = FNV_OFFSET;
+                for (size_t i = 0; i < count; ++i) {
+                    hash = fnv1a(hash, &members[i].id, sizeof(members[i].id));
+                    hash = fnv1a(hash, &members[i].weight, sizeof(members[i].weight));
+                }
+                record.group_hash = hash;
+                record.group_size = static_cast<uint16_t>(std::min<size_t>(count, UINT16_MAX));
+                record.flags |= NexthopRecord::IS_GROUP;
+                break;
+            }
+            case NHA_BLACKHOLE:
+                record.flags |= NexthopRecord::BLACKHOLE;
+                break;
+            case NHA_OIF:
+                if (payload >= sizeof(int32_t)) {
+                    memcpy(&record.ifindex, rta_data(rta), sizeof(int32_t));
+                    record.flags |= NexthopRecord::HAS_OIF;
+                }
+                break;
+            case NHA_GATEWAY:
+                if (payload >= addr_len) {
+                    memcpy(&record.gateway, rta_data(rta), addr_len);
+                    record.flags |= NexthopRecord::HAS_GATEWAY;
+                }
+                break;
+            default:
+                break;
+        }
+        rta = rta_next(rta, len);
+    }
+    return true;
+}
+
+void NetlinkMessageParser::parse_route_message(const struct rtmsg* rtm, const struct rtattr* rta,
+                                               int len, RouteRecord& record) {
+    memset(&record, 0, sizeof(record));
+
+    // 基本路由信息
+    record.family = rtm->rtm_family;
+    record.dst_len = rtm->rtm_dst_len;
+    record.table = rtm->rtm_table;
+    record.protocol = rtm->rtm_protocol;
+    record.scope = rtm->rtm_scope;
+    record.type = rtm->rtm_type;
+
+    // 解析路由属性
+    parse_route_attributes(rta, len, record);
+}
+
+void NetlinkMessageParser::parse_qdisc_message(const struct tcmsg* tcm, const struct rtattr* rta,
+                                               int len, QdiscRecord& record) {
+    memset(&record, 0, sizeof(record));
+
+    // 基本QDisc信息
+    record.ifindex = tcm->tcm_ifindex;
+    record.handle = tcm->tcm_handle;
+    record.parent = tcm->tcm_parent;
+    record.family = tcm->tcm_family;
+
+    // 解析QDisc属性
+    parse_qdisc_attributes(rta, len, record);
+}
+
+void NetlinkMessageParser::parse_route_attributes(const struct rtattr* rta, int len, RouteRecord& record) {
+    // IPv4地址4字节，IPv6地址16字节
+    size_t addr_len = (record.family == AF_INET6) ? 16 : 4;
+
+    while (rta_ok(rta, len)) {
+        size_t payload = static_cast<size_t>(rta_len(rta));
+        switch (rta->rta_type) {
+            case RTA_DST:
+                if (payload >= addr_len) {
+                    memcpy(&record.dst, rta_data(rta), addr_len);
+                    record.flags |= RouteRecord::HAS_DST;
+                }
+                break;
+            case RTA_GATEWAY:
+                if (payload >= addr_len) {
+                    memcpy(&record.gateway, rta_data(rta), addr_len);
+                    record.flags |= RouteRecord::HAS_GATEWAY;
+                }
+                break;
+            case RTA_OIF:
+                if (payload >= sizeof(int32_t)) {
+                    memcpy(&record.ifindex, rta_data(rta), sizeof(int32_t));
+                    record.flags |= RouteRecord::HAS_OIF;
+                }
+                break;
+            case RTA_PREFSRC:
+                if (payload >= addr_len) {
+                    memcpy(&record.prefsrc, rta_data(rta), addr_len);
+                    record.flags |= RouteRecord::HAS_PREFSRC;
+                }
+                break;
+            case RTA_PRIORITY:
+                if (payload >= sizeof(uint32_t)) {
+                    memcpy(&record.priority, rta_data(rta), sizeof(uint32_t));
+                    record.flags |= RouteRecord::HAS_PRIORITY;
+                }
+                break;
+            case RTA_TABLE:
+                // 表号大于255时rtm_table为RT_TABLE_COMPAT，以RTA_TABLE为准
+                if (payload >= sizeof(uint32_t)) {
+                    memcpy(&record.table, rta_data(rta), sizeof(uint32_t));
+                }
+                break;
+            case RTA_MULTIPATH:
+                // 多路径路由不带单路径的 RTA_GATEWAY / RTA_OIF，以第一个下一跳补充
+                parse_multipath(rta, record);
+                break;
+            case RTA_NH_ID:
+                if (payload >= sizeof(uint32_t)) {
+                    memcpy(&record.nh_id, rta_data(rta), sizeof(uint32_t));
+                    record.flags |= RouteRecord::HAS_NH_ID;
+                }
+                break;
+            default:
+                break;
+        }
+        rta = rta_next(rta, len);
+    }
+}
+
+void NetlinkMessageParser::parse_multipath(const struct rtattr* rta, RouteRecord& record) {
+    size_t addr_len = (record.family == AF_INET6) ? 16 : 4;
+    int remaining = rta_len(rta);
+    const struct rtnexthop* rtnh = static_cast<const struct rtnexthop*>(rta_data(rta));
+    uint32_t hash = FNV_OFFSET;
+    uint16_t count = 0;
+
+    while (RTNH_OK(rtnh, remaining)) {
+        // 接口、权重与标志（如 RTNH_F_LINKDOWN）都影响转发
+        hash = fnv1a(hash, &rtnh->rtnh_ifindex, sizeof(rtnh->rtnh_ifindex));
+        hash = fnv1a(hash, &rtnh->rtnh_hops, sizeof(rtnh->rtnh_hops));
+        hash = fnv1a(hash, &rtnh->rtnh_flags, sizeof(rtnh->rtnh_flags));
+
+        const struct rtattr* attr = RTNH_DATA(rtnh);
+        int attr_len = static_cast<int>(rtnh->rtnh_len) - static_cast<int>(RTNH_LENGTH(0));
+        while (rta_ok(attr, attr_len)) {
+            if (attr->rta_type == RTA_GATEWAY || attr->rta_type == RTA_VIA) {
+                hash = fnv1a(hash, rta_data(attr), static_cast<size_t>(rta_len(attr)));
+                if (count == 0 && attr->rta_type == RTA_GATEWAY && !record.has(RouteRecord::HAS_GATEWAY) &&
+                    static_cast<size_t>(rta_len(attr)) >= addr_len) {
+                    memcpy(&record.gateway, rta_data(attr), addr_len);
+                    record.flags |= RouteRecord::HAS_GATEWAY;
+                }
+            }
+            attr = rta_next(attr, attr_len);
+        }
+
+        if (count == 0 && !record.has(RouteRecord::HAS_OIF) && rtnh->rtnh_ifindex > 0) {
+            record.ifindex = rtnh->rtnh_ifindex;
+            record.flags |= RouteRecord::HAS_OIF;
+        }
+        if (count < UINT16_MAX) {
+            count++;
+        }
+        remaining -= RTNH_ALIGN(rtnh->rtnh_len);
+        rtnh = RTNH_NEXT(rtnh);
+    }
+
+    record.nexthop_count = count;
+    record.nexthop_hash = hash;
+    record.flags |= RouteRecord::HAS_MULTIPATH;
+}
+
+void NetlinkMessageParser::parse_qdisc_attributes(const struct rtattr* rta, int len, QdiscRecord& record) {
+    while (rta_ok(rta, len)) {
+        switch (rta->rta_type) {
+            case TCA_KIND: {
+                size_t payload = static_cast<size_t>(rta_len(rta));
+                size_t copy_len = std::min(payload, QdiscRecord::KIND_SIZE - 1);
+                memcpy(record.kind, rta_data(rta), copy_len);
+                record.kind[copy_len] = '\0';
+                break;
+            }
+            case TCA_OPTIONS:
+                // 这里可以进一步解析QDisc选项
+                break;
+            default:
+                break;
+        }
+        rta = rta_next(rta, len);
     }
 }
 
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <array>
 #include <functional>
 #include <thread>
 #include <atomic>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <unordered_map>
 #include <string>
@@ -13,9 +15,19 @@
 #include <linux/netlink.h>
 #include <linux/rtnetlink.h>
 #include <linux/pkt_sched.h>
+#include <linux/nexthop.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include "netlink_filter.h"
+#include "event_records.h"
+#include "interface_cache.h"
+#include "event_clock.h"
+#include "netlink_capture.h"
+#include "pipeline_stats.h"
+#include "ebpf_fib_source.h"
+
 // 前向声明
 class ConvergenceMonitor;
 
@@ -27,53 +39,237 @@ enum class NetlinkMessageType {
     QDISC_DEL,
     QDISC_GET,
     QDISC_CHANGE,
+    LINK_NEW,
+    LINK_DEL,
+    NEXTHOP_NEW,
+    NEXTHOP_DEL,
     UNKNOWN
 };
 
-// Netlink事件回调函数类型
-using RouteEventCallback = std::function<void(const void*, const std::string&)>;
-using QdiscEventCallback = std::function<void(const void*, const std::string&)>;
+// 路由变化的来源：rtnetlink多播通知，或内核FIB修改函数上的eBPF程序（见 ebpf_fib_source.h）
+enum class RouteEventSource {
+    NETLINK,
+    EBPF
+};
+
+// Netlink接收配置
+struct NetlinkMonitorOptions {
+    // SO_RCVBUFFORCE 请求的接收缓冲区大小（字节），0 表示保持系统默认值
+    int rcvbuf_bytes = 0;
+    // 每次 recvmmsg 批量接收的数据报数量，1 表示逐条 recv
+    unsigned int batch_size = 1;
+    // 可选的内核侧BPF过滤条件（eBPF路由来源时路由条件在用户态检查）
+    NetlinkFilterSpec filter;
+    // 路由事件来源；EBPF 时netlink套接字不再订阅路由组，QDisc、链路、下一跳与RIB转储仍走netlink
+    RouteEventSource route_source = RouteEventSource::NETLINK;
+    // 请求内核接收时间戳(SO_TIMESTAMPNS)；内核未提供时使用出队时刻的单调时间
+    bool kernel_timestamps = false;
+    // 监控线程绑定的CPU，-1 表示不绑定（外部事件循环模式下由调用者绑定）
+    int cpu = -1;
+    // 监控线程启动时预先触及栈空间（--low-jitter）
+    bool prefault_stack = false;
+    // 启动时同步转储路由表，经转储回调交给调用者（用于建立FIB镜像）
+    bool initial_route_dump = false;
+    // 把收到的原始数据报（含启动转储）录制到抓包文件，空表示不录制
+    std::string record_path;
+    // 从抓包文件回放：不创建套接字，记录的接收时间驱动虚拟时钟，空表示实时监控
+    std::string replay_path;
+    // 注入模式：不创建套接字也不启动线程，数据报由调用者通过 inject_datagram 注入（基准测试），
+    // 与回放一样使用虚拟时钟
+    bool inject_only = false;
+};
+
+// Netlink事件回调函数类型：消息在监控器中只解析一次，回调收到定长记录
+using RouteEventCallback = std::function<void(const RouteRecord&)>;
+// 已过滤 noqueue 类型
+using QdiscEventCallback = std::function<void(const QdiscRecord&)>;
+
+// 链路状态变化回调（仅在UP/DOWN状态发生变化时调用）
+using LinkEventCallback = std::function<void(const LinkRecord&)>;
+
+// 下一跳对象变化回调（RTNLGRP_NEXTHOP）
+using NexthopEventCallback = std::function<void(const NexthopRecord&)>;
 
-// 统一的netlink事件回调函数类型
-using NetlinkEventCallback = std::function<void(const void*, const std::string&, NetlinkMessageType)>;
+// 统一的netlink事件回调函数类型（每条消息调用一次，含未关注的类型）
+using NetlinkEventCallback = std::function<void(const void*, NetlinkMessageType)>;
+
+// 接收队列溢出(ENOBUFS)回调，参数为本次溢出估计丢失的消息数
+using OverrunCallback = std::function<void(int64_t)>;
+
+// RIB转储回调：逐条转储的路由消息，以及转储完成通知(参数表示是否成功)
+using DumpRouteCallback = std::function<void(const void*)>;
+using DumpDoneCallback = std::function<void(bool)>;
+
+// 定时器到期回调（在监控线程中调用）
+using TimerCallback = std::function<void()>;
 
 // Netlink监控器类
 class NetlinkMonitor {
 private:
-    // 统一的套接字文件描述符
-    int netlink_socket_fd_;
+    // 统一的套接字文件描述符（统计线程读取 /proc 时也会访问，故为原子量）
+    std::atomic<int> netlink_socket_fd_;
     int epoll_fd_;
 
+    // RIB转储专用套接字（不加入多播组，避免与通知消息交错）
+    int dump_socket_fd_;
+    uint32_t dump_seq_{0};
+    bool dump_in_progress_{false};
+    bool dump_pending_{false};
+
+    // 收敛截止时间定时器（timerfd，与netlink套接字在同一epoll集合中）
+    int timer_fd_;
+
     // 用于优雅关闭的管道
     int shutdown_pipe_[2];
 
-    // 线程管理
+    // 线程管理：外部事件循环模式下不创建监控线程，由调用者在就绪时调用 dispatch_ready
     std::atomic<bool> running_{false};
     std::thread monitor_thread_;
+    bool external_loop_{false};
+
+    // 接口名称缓存（默认为进程共享实例，其他命名空间使用各自的实例）
+    InterfaceCache* interfaces_;
 
     // 事件回调
     RouteEventCallback route_callback_;
     QdiscEventCallback qdisc_callback_;
+    LinkEventCallback link_callback_;
+    NexthopEventCallback nexthop_callback_;
     NetlinkEventCallback unified_callback_;
+    OverrunCallback overrun_callback_;
+    DumpRouteCallback dump_route_callback_;
+    DumpDoneCallback dump_done_callback_;
+    TimerCallback timer_callback_;
+
+    // 溢出统计
+    std::atomic<int64_t> overrun_count_{0};
+    std::atomic<int64_t> lost_message_count_{0};
+    int64_t last_socket_drops_{0};
 
-    // 缓冲区大小
-    static constexpr size_t NETLINK_BUFFER_SIZE = 8192;
+    // 接收配置与批量缓冲池
+    NetlinkMonitorOptions options_;
+    std::vector<char> recv_buffer_pool_;
+    std::vector<struct mmsghdr> recv_msgs_;
+    std::vector<struct iovec> recv_iovecs_;
+    std::vector<char> recv_control_pool_;
+
+    // 当前正在分发的数据报的接收时间（单调时钟纳秒）
+    int64_t receive_time_ns_{0};
+    std::atomic<int64_t> kernel_timestamp_count_{0};
+    bool kernel_timestamp_notice_shown_{false};
+
+    // 流水线阶段统计：当前数据报的出队时刻与当前消息开始处理的时刻（未采样时为0）
+    int64_t dequeue_time_ns_{0};
+    int64_t message_start_ns_{0};
+    PipelineStats::StageLatency kernel_queue_latency_;
+    PipelineStats::StageLatency dispatch_latency_;
+    std::atomic<int64_t> datagram_count_{0};
+    std::atomic<int64_t> message_count_{0};
+
+    // eBPF路由来源：本命名空间的接收环、已处理的内核丢弃计数，以及时间命名空间的单调时钟偏移
+    std::unique_ptr<EbpfRouteRing> route_ring_;
+    int64_t last_ring_drops_{0};
+    int64_t timens_offset_ns_{0};
+    std::atomic<int64_t> ebpf_route_count_{0};
+    std::atomic<int64_t> ebpf_dropped_count_{0};
+
+    // /proc/net/netlink：在套接字所在的命名空间中打开，其他线程也能读到本套接字的接收队列与丢弃计数
+    int proc_netlink_fd_{-1};
+    mutable std::mutex proc_mutex_;
+
+    // 抓包录制（只在监控线程中写入）
+    NetlinkCapture::Writer capture_;
+
+    // 抓包回放与注入模式：虚拟时钟与单次定时器的截止时间（-1 表示未设置）
+    NetlinkCapture::Reader replay_reader_;
+    bool replaying_{false};
+    bool virtual_clock_{false};
+    std::atomic<int64_t> virtual_now_ns_{0};    // 由事件线程推进，now_ns() 可在其他线程调用
+    int64_t virtual_deadline_ns_{-1};
+    std::atomic<bool> replay_finished_{false};
+
+    // 缓冲区大小：每个数据报缓冲区占用多个页面，足以容纳内核的最大netlink数据报
+    static constexpr size_t NETLINK_BUFFER_SIZE = 32768;
+    static constexpr unsigned int MAX_BATCH_SIZE = 1024;
     static constexpr int MAX_EPOLL_EVENTS = 10;
+    static constexpr size_t CONTROL_BUFFER_SIZE = CMSG_SPACE(sizeof(struct timespec));
 
     // 内部方法
     int create_unified_netlink_socket();
+    void configure_receive_buffer(int fd);
+
+    // 通过RTM_GETLINK转储填充接口名称缓存（在监控线程启动前同步执行）
+    bool load_interface_table();
+    // 通过RTM_GETROUTE与RTM_GETNEXTHOP转储把当前路由表和下一跳对象逐条交给转储回调，
+    // 完成后调用转储完成回调（同步执行）；内核不支持下一跳对象时只转储路由
+    bool load_route_table();
+    bool receive_dump(int fd, std::vector<char>& buffer, bool report_errors);
+    void setup_receive_pool();
+    bool open_descriptors();
     void unified_monitor_loop();
+
+    // 处理一批就绪事件，返回false表示本批中止（读取错误或收到关闭信号）
+    bool handle_ready_events(const struct epoll_event* events, int count);
+
+    // 持续读取套接字直到EAGAIN，返回false表示发生不可恢复的错误
+    bool drain_netlink_socket();
+    // dequeue_time_ns 为实际出队的单调时间（回放与注入时为调用时刻），用于阶段计时
+    void process_datagram(const char* data, size_t len, int64_t receive_time_ns, int64_t dequeue_time_ns);
+
+    // 从控制消息中取出内核接收时间戳；没有时返回出队时刻
+    int64_t datagram_receive_time(const struct msghdr& msg, int64_t dequeue_time_ns);
+
+    // eBPF路由来源：在调用线程所在的命名空间注册接收环；取出全部记录交给路由回调，
+    // 内核因环满丢弃记录时按溢出处理
+    bool open_route_ring();
+    void drain_route_ring();
+    // 在用户态应用过滤条件中的地址族、协议与路由表
+    bool route_passes_filter(const RouteRecord& route) const;
+
+    // ENOBUFS处理：统计丢失并发起RIB转储以重新同步
+    void handle_overrun();
+    int64_t read_socket_drops() const;
+    // 读取本套接字在 /proc/net/netlink 中的 Rmem 与 Drops 列
+    bool read_socket_proc(int64_t& rmem, int64_t& drops) const;
+
+    // RIB转储
+    int create_dump_socket();
+    bool send_route_dump_request();
+    void drain_dump_socket();
+    void finish_route_dump(bool success);
+    // 通知转储完成（录制时同时写入抓包）
+    void report_dump_done(bool success);
+    void close_descriptors();
+
+    // 回放：按记录顺序分发，每条记录之前先触发虚拟时间已到的定时器
+    void replay_loop();
+    void replay_dump_datagram(const NetlinkCapture::Record& record, bool deliver_routes);
+    // 虚拟时钟只前进不回退
+    void advance_virtual_now(int64_t now_ns);
+    void fire_virtual_timers(int64_t until_ns);
     
     void process_netlink_message(const struct nlmsghdr* nlh);
-    
-    NetlinkMessageType get_message_type(const struct nlmsghdr* nlh);
-    std::string message_type_to_string(NetlinkMessageType type);
-    
+
+    // 按 nlmsg_type 索引的分发表（编译期生成）：消息类型与处理函数，未关注的类型没有处理函数
+    using MessageHandler = void (NetlinkMonitor::*)(const struct nlmsghdr*, NetlinkMessageType);
+    struct MessageDispatch {
+        NetlinkMessageType type = NetlinkMessageType::UNKNOWN;
+        MessageHandler handler = nullptr;
+    };
+    static constexpr size_t DISPATCH_TABLE_SIZE = RTM_MAX + 1;
+    static constexpr std::array<MessageDispatch, DISPATCH_TABLE_SIZE> make_dispatch_table();
+
     // 路由消息处理
-    void handle_route_message(const struct nlmsghdr* nlh);
-    
-    // QDisc消息处理  
-    void handle_qdisc_message(const struct nlmsghdr* nlh);
+    void handle_route_message(const struct nlmsghdr* nlh, NetlinkMessageType type);
+
+    // QDisc消息处理（忽略 noqueue）
+    void handle_qdisc_message(const struct nlmsghdr* nlh, NetlinkMessageType type);
+
+    // 链路消息处理：更新接口缓存并上报UP/DOWN变化
+    void handle_link_message(const struct nlmsghdr* nlh, NetlinkMessageType type);
+
+    // 下一跳对象消息处理
+    void handle_nexthop_message(const struct nlmsghdr* nlh, NetlinkMessageType type);
     
     // 错误处理
     void handle_netlink_error(const struct nlmsghdr* nlh);
@@ -91,45 +287,114 @@ public:
     // 设置事件回调
     void set_route_callback(RouteEventCallback callback);
     void set_qdisc_callback(QdiscEventCallback callback);
+    void set_link_callback(LinkEventCallback callback);
+    void set_nexthop_callback(NexthopEventCallback callback);
     void set_unified_callback(NetlinkEventCallback callback);
+    void set_overrun_callback(OverrunCallback callback);
+    void set_dump_callbacks(DumpRouteCallback route_callback, DumpDoneCallback done_callback);
+    void set_timer_callback(TimerCallback callback);
+
+    // 路由事件来源名称（netlink / ebpf）的解析与显示
+    static bool parse_route_source(const std::string& name, RouteEventSource& source);
+    static const char* route_source_name(RouteEventSource source);
+
+    // 设置接收配置（需在start_monitoring之前调用）
+    void set_options(const NetlinkMonitorOptions& options);
+    const NetlinkMonitorOptions& get_options() const { return options_; }
+
+    // 使用独立的接口缓存（需在start_monitoring之前调用），缓存生命周期由调用者管理
+    void set_interface_cache(InterfaceCache* cache) { interfaces_ = cache; }
+    const InterfaceCache* interface_cache() const { return interfaces_; }
     
-    // 启动和停止监控
+    // 打开 replay_path 指定的抓包（需在start_monitoring之前调用），并把时钟锚点设为录制时的值，
+    // 之后 start_monitoring 启动回放线程而不是创建套接字
+    bool open_replay(std::string& error);
+    bool is_replaying() const { return replaying_; }
+    // 抓包已全部回放（剩余会话已按虚拟时间收敛）
+    bool replay_finished() const { return replay_finished_.load(); }
+    // 回放的起始虚拟时间（录制开始时的单调时钟）
+    int64_t replay_start_ns() const { return replay_reader_.anchor_monotonic_ns(); }
+
+    // 当前时间（单调时钟纳秒）：实时监控为 CLOCK_MONOTONIC，回放与注入模式为虚拟时钟
+    int64_t now_ns() const { return virtual_clock_ ? virtual_now_ns_.load(std::memory_order_relaxed)
+                                                  : EventClock::monotonic_ns(); }
+
+    // 注入模式：在调用线程中按给定接收时间处理一个数据报（可含多条消息），
+    // 之前先触发截止时间不晚于该时间的定时器；advance_clock 只推进虚拟时钟
+    void inject_datagram(const char* data, size_t len, int64_t receive_time_ns);
+    void advance_clock(int64_t now_ns);
+
+    // 启动和停止监控；套接字在调用线程当前所在的网络命名空间中创建
     bool start_monitoring();
     void stop_monitoring();
+
+    // 外部事件循环模式：创建套接字但不启动线程。poll_fd() 可加入其他epoll集合，
+    // 可读时在同一线程中调用 dispatch_ready() 处理已就绪的事件（不阻塞），返回false表示已停止
+    bool start_external();
+    int poll_fd() const { return epoll_fd_; }
+    bool dispatch_ready();
     void request_shutdown(); // 请求优雅关闭
 
+    // 请求异步RIB转储（在监控线程中调用，结果通过转储回调返回）
+    void request_route_dump();
+
+    // 设置单次定时器在给定单调时间（纳秒）到期（覆盖之前的设置），到期时在监控线程中调用定时器回调
+    void arm_deadline(int64_t deadline_ns);
+    void disarm_timer();
+
+    // 当前正在分发的消息的接收时间（单调时钟纳秒），仅在回调中有效
+    int64_t current_receive_time_ns() const { return receive_time_ns_; }
+
     // 检查是否正在运行
     bool is_running() const { return running_.load(); }
+
+    // 溢出统计
+    int64_t get_overrun_count() const { return overrun_count_.load(); }
+    int64_t get_lost_message_count() const { return lost_message_count_.load(); }
+
+    // 使用内核接收时间戳的数据报数量
+    int64_t get_kernel_timestamp_count() const { return kernel_timestamp_count_.load(); }
+
+    // 当前消息开始处理的时刻（单调时钟纳秒），该消息未被采样计时时为0，仅在回调中有效
+    int64_t current_message_start_ns() const { return message_start_ns_; }
+
+    // 接收队列中等待读取的字节数（/proc/net/netlink 的 Rmem；netlink不支持SIOCINQ），不可用时返回-1
+    int64_t get_receive_queue_bytes() const;
+
+    // 加入内核排队与批内排队两个阶段，以及收包计数与接收队列深度
+    void append_pipeline_stats(PipelineStats::Report& report) const;
 };
 
 // Netlink消息解析辅助类
 class NetlinkMessageParser {
 public:
+    // 解析完整的路由/QDisc消息到定长记录（不做堆分配），消息格式错误时返回false
+    static bool parse_route_message(const struct nlmsghdr* nlh, RouteRecord& record);
+    static bool parse_qdisc_message(const struct nlmsghdr* nlh, QdiscRecord& record);
+    static bool parse_link_message(const struct nlmsghdr* nlh, LinkRecord& record);
+    static bool parse_nexthop_message(const struct nlmsghdr* nlh, NexthopRecord& record);
+
     // 解析路由消息
-    static std::unordered_map<std::string, std::string> parse_route_message(const struct rtmsg* rtm, 
-                                                                           const struct rtattr* rta, 
-                                                                           int len);
+    static void parse_route_message(const struct rtmsg* rtm,
+                                    const struct rtattr* rta,
+                                    int len,
+                                    RouteRecord& record);
     
     // 解析QDisc消息
-    static std::unordered_map<std::string, std::string> parse_qdisc_message(const struct tcmsg* tcm, 
-                                                                           const struct rtattr* rta, 
-                                                                           int len);
+    static void parse_qdisc_message(const struct tcmsg* tcm,
+                                    const struct rtattr* rta,
+                                    int len,
+                                    QdiscRecord& record);
     
     // 解析路由属性
-    static void parse_route_attributes(const struct rtattr* rta, int len, 
-                                     std::unordered_map<std::string, std::string>& result);
+    static void parse_route_attributes(const struct rtattr* rta, int len, RouteRecord& record);
+
+    // 就地遍历RTA_MULTIPATH中的 rtnexthop 列表：统计下一跳数并计算摘要，
+    // 单路径属性缺失时以第一个下一跳的网关与接口填充
+    static void parse_multipath(const struct rtattr* rta, RouteRecord& record);
     
     // 解析QDisc属性
-    static void parse_qdisc_attributes(const struct rtattr* rta, int len, 
-                                     std::unordered_map<std::string, std::string>& result);
-    
-    // 辅助函数
-    static std::string ip_to_string(const void* addr, int family);
-    static std::string get_interface_name(int ifindex);
-    static std::string get_route_table_name(int table);
-    static std::string get_route_protocol_name(int protocol);
-    static std::string get_route_scope_name(int scope);
-    static std::string get_route_type_name(int type);
+    static void parse_qdisc_attributes(const struct rtattr* rta, int len, QdiscRecord& record);
     
 private:
     // RTA遍历宏的C++版本
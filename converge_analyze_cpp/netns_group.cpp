@@ -0,0 +1,390 @@
+#include "netns_group.h"
+#include "cpu_affinity.h"
+#include "event_clock.h"
+#include "low_jitter.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <iostream>
+#include <sched.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+NetnsMonitorGroup::NetnsMonitorGroup(int64_t convergence_threshold_ms,
+                                     const std::string& log_path,
+                                     const MonitorOptions& options,
+                                     const WorkerPoolOptions& pool_options)
+    : convergence_threshold_ms_(convergence_threshold_ms),
+      options_(options),
+      pool_options_(pool_options) {
+    pool_options_.workers = std::max(1, pool_options_.workers);
+    logger_ = std::make_shared<Logger>(log_path, options_.logger);
+    log_file_path_ = logger_->get_log_file_path();
+}
+
+NetnsMonitorGroup::~NetnsMonitorGroup() {
+    stop();
+}
+
+bool NetnsMonitorGroup::list_namespaces(const std::string& netns_dir, const std::string& pattern,
+                                        std::vector<std::string>& names, std::string& error) {
+    DIR* dir = opendir(netns_dir.c_str());
+    if (!dir) {
+        error = "无法打开命名空间目录 " + netns_dir + ": " + strerror(errno);
+        return false;
+    }
+
+    names.clear();
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        if (fnmatch(pattern.c_str(), entry->d_name, 0) != 0) {
+            continue;
+        }
+        names.emplace_back(entry->d_name);
+    }
+    closedir(dir);
+
+    std::sort(names.begin(), names.end());
+    if (names.empty()) {
+        error = netns_dir + " 中没有匹配 '" + pattern + "' 的命名空间";
+        return false;
+    }
+    return true;
+}
+
+void NetnsMonitorGroup::start(const std::string& netns_dir, const std::vector<std::string>& names) {
+    if (running_.load()) {
+        return;
+    }
+
+    int original_netns = open("/proc/self/ns/net", O_RDONLY | O_CLOEXEC);
+    if (original_netns < 0) {
+        throw std::runtime_error(std::string("无法打开当前网络命名空间: ") + strerror(errno));
+    }
+
+    logger_->start();
+
+    // 日志线程已按普通优先级创建；此后创建的事件线程继承实时调度，各命名空间的启动日志记录其结果
+    LowJitter::RealtimeSpawnScope realtime(options_.low_jitter ? options_.realtime_priority : 0);
+
+    // 逐个进入目标命名空间创建套接字，全部完成后切回原命名空间
+    std::string failure;
+    for (const auto& name : names) {
+        std::string path = netns_dir + "/" + name;
+        int netns_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (netns_fd < 0) {
+            failure = "无法打开命名空间 " + path + ": " + strerror(errno);
+            break;
+        }
+        if (setns(netns_fd, CLONE_NEWNET) < 0) {
+            failure = "无法进入命名空间 " + name + ": " + strerror(errno);
+            close(netns_fd);
+            break;
+        }
+        close(netns_fd);
+
+        try {
+            auto monitor = std::make_unique<ConvergenceMonitor>(
+                convergence_threshold_ms_, name, logger_, options_);
+            monitor->start_monitoring();
+            monitors_.push_back(std::move(monitor));
+        } catch (const std::exception& e) {
+            failure = "命名空间 " + name + " 启动监控失败: " + e.what();
+        }
+
+        if (setns(original_netns, CLONE_NEWNET) < 0) {
+            failure = std::string("无法切回原网络命名空间: ") + strerror(errno);
+        }
+        if (!failure.empty()) {
+            break;
+        }
+    }
+    close(original_netns);
+
+    if (!failure.empty()) {
+        shutdown_monitors();
+        throw std::runtime_error(failure);
+    }
+
+    // 按轮转把命名空间分配到事件线程
+    size_t worker_count = std::min(static_cast<size_t>(pool_options_.workers), monitors_.size());
+    for (size_t i = 0; i < worker_count; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->index = static_cast<int>(i);
+        if (!pool_options_.cpus.empty()) {
+            worker->cpu = pool_options_.cpus[i % pool_options_.cpus.size()];
+        }
+        worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        worker->wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        bool ok = worker->epoll_fd >= 0 && worker->wakeup_fd >= 0;
+        if (ok) {
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLIN;
+            ev.data.ptr = nullptr; // 唤醒：停止或有迁入的命名空间
+            ok = epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, worker->wakeup_fd, &ev) == 0;
+        }
+        workers_.push_back(std::move(worker));
+        if (!ok) {
+            std::string error = std::string("无法创建事件线程: ") + strerror(errno);
+            close_workers();
+            shutdown_monitors();
+            throw std::runtime_error(error);
+        }
+    }
+    for (size_t i = 0; i < monitors_.size(); ++i) {
+        ConvergenceMonitor* monitor = monitors_[i].get();
+        if (!add_monitor(workers_[i % worker_count].get(), monitor)) {
+            std::string error = "无法注册命名空间 " + monitor->router_name() + ": " + strerror(errno);
+            close_workers();
+            shutdown_monitors();
+            throw std::runtime_error(error);
+        }
+    }
+
+    running_.store(true);
+    for (auto& worker : workers_) {
+        worker->thread = std::thread(&NetnsMonitorGroup::worker_loop, this, worker.get());
+    }
+
+    std::cout << "🎯 多命名空间监控开始: " << monitors_.size() << " 个命名空间, "
+              << workers_.size() << " 个事件线程 (CPU: " << CpuAffinity::describe(pool_options_.cpus)
+              << ", 窃取: " << (pool_options_.work_stealing && workers_.size() > 1 ? "开启" : "关闭") << ")\n";
+    std::cout << "   收敛阈值: " << convergence_threshold_ms_ << "ms\n";
+    std::cout << "   等待触发事件...\n";
+}
+
+bool NetnsMonitorGroup::add_monitor(Worker* worker, ConvergenceMonitor* monitor) {
+    // 监控器自身的epoll实例可读即表示其中有就绪的套接字或定时器
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = monitor;
+    if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, monitor->netlink_monitor().poll_fd(), &ev) < 0) {
+        return false;
+    }
+    worker->monitors.push_back(monitor);
+    worker->owned.store(static_cast<int>(worker->monitors.size()), std::memory_order_relaxed);
+    return true;
+}
+
+void NetnsMonitorGroup::worker_loop(Worker* worker) {
+    if (worker->cpu >= 0) {
+        CpuAffinity::pin_current_thread(worker->cpu);
+    }
+    if (options_.low_jitter) {
+        LowJitter::prefault_stack();
+    }
+
+    // 只有允许窃取时空闲线程才定期醒来检查其他线程的负载
+    bool stealing = pool_options_.work_stealing && workers_.size() > 1;
+    int timeout_ms = stealing ? STEAL_IDLE_MS : -1;
+    struct epoll_event events[MAX_EVENTS];
+
+    while (running_.load()) {
+        int nfds = epoll_wait(worker->epoll_fd, events, MAX_EVENTS, timeout_ms);
+        if (nfds < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Epoll wait error: " << strerror(errno) << "\n";
+            break;
+        }
+        if (nfds == 0) {
+            try_steal(worker);
+            continue;
+        }
+
+        if (stealing && nfds > 1) {
+            worker->busy_ready.store(nfds, std::memory_order_relaxed);
+            worker->busy_at_ns.store(EventClock::monotonic_ns(), std::memory_order_relaxed);
+        }
+        int handed = stealing ? hand_over(worker, events, nfds) : -1;
+
+        for (int i = 0; i < nfds; ++i) {
+            if (i == handed) {
+                continue;
+            }
+            if (events[i].data.ptr == nullptr) {
+                uint64_t counter;
+                ssize_t ret = read(worker->wakeup_fd, &counter, sizeof(counter));
+                (void)ret;
+                adopt_inbox(worker);
+                continue;
+            }
+            static_cast<ConvergenceMonitor*>(events[i].data.ptr)->netlink_monitor().dispatch_ready();
+            worker->dispatches.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void NetnsMonitorGroup::try_steal(Worker* thief) {
+    // 上一个空闲周期的请求未被处理：撤回后按当前负载重新选择，请求最多存活一个周期
+    withdraw_steal(thief);
+
+    // 选择最近一个空闲周期内同时就绪命名空间最多的worker，至少要有两个就绪才值得移交
+    int64_t recent = EventClock::monotonic_ns() - STEAL_IDLE_MS * EventClock::NS_PER_MS;
+    Worker* victim = nullptr;
+    int best = 1;
+    for (auto& worker : workers_) {
+        if (worker.get() == thief || worker->busy_at_ns.load(std::memory_order_relaxed) < recent) {
+            continue;
+        }
+        int ready = worker->busy_ready.load(std::memory_order_relaxed);
+        if (ready > best && worker->owned.load(std::memory_order_relaxed) > 1) {
+            best = ready;
+            victim = worker.get();
+        }
+    }
+    if (victim) {
+        int expected = -1;
+        if (victim->steal_request.compare_exchange_strong(expected, thief->index)) {
+            thief->steal_target = victim;
+        }
+    }
+}
+
+void NetnsMonitorGroup::withdraw_steal(Worker* thief) {
+    if (!thief->steal_target) {
+        return;
+    }
+    int expected = thief->index;
+    thief->steal_target->steal_request.compare_exchange_strong(expected, -1);
+    thief->steal_target = nullptr;
+}
+
+int NetnsMonitorGroup::hand_over(Worker* victim, struct epoll_event* events, int count) {
+    if (victim->steal_request.load(std::memory_order_relaxed) < 0) {
+        return -1;
+    }
+    // 领取请求：与请求方撤回互斥，同一请求只会被撤回或处理一次
+    int thief_index = victim->steal_request.exchange(-1);
+    if (thief_index < 0) {
+        return -1;
+    }
+
+    // 移交本批最后一个就绪的命名空间（本线程先处理前面的），自己至少保留一个
+    int chosen = -1;
+    int ready = 0;
+    for (int i = 0; i < count; ++i) {
+        if (events[i].data.ptr != nullptr) {
+            ready++;
+            chosen = i;
+        }
+    }
+    if (ready < 2 || victim->monitors.size() < 2) {
+        return -1;
+    }
+
+    auto* monitor = static_cast<ConvergenceMonitor*>(events[chosen].data.ptr);
+    if (epoll_ctl(victim->epoll_fd, EPOLL_CTL_DEL, monitor->netlink_monitor().poll_fd(), nullptr) < 0) {
+        return -1;
+    }
+    auto& owned = victim->monitors;
+    owned.erase(std::remove(owned.begin(), owned.end(), monitor), owned.end());
+    victim->owned.store(static_cast<int>(owned.size()), std::memory_order_relaxed);
+
+    Worker* thief = workers_[thief_index].get();
+    {
+        std::lock_guard<std::mutex> lock(thief->inbox_mutex);
+        thief->inbox.push_back(monitor);
+    }
+    uint64_t one = 1;
+    ssize_t ret = write(thief->wakeup_fd, &one, sizeof(one));
+    (void)ret;
+    return chosen;
+}
+
+void NetnsMonitorGroup::adopt_inbox(Worker* worker) {
+    std::vector<ConvergenceMonitor*> incoming;
+    {
+        std::lock_guard<std::mutex> lock(worker->inbox_mutex);
+        incoming.swap(worker->inbox);
+    }
+    // 请求已被处理（或迁入队列为空时不再需要）：清除，避免受害方之后据此移交
+    withdraw_steal(worker);
+    for (ConvergenceMonitor* monitor : incoming) {
+        // 水平触发：迁入时仍有未处理的事件会在下一次epoll_wait中立即就绪
+        if (add_monitor(worker, monitor)) {
+            worker->stolen.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            std::cerr << "⚠️  命名空间 " << monitor->router_name() << " 迁移失败: " << strerror(errno) << "\n";
+        }
+    }
+}
+
+void NetnsMonitorGroup::close_workers() {
+    for (auto& worker : workers_) {
+        if (worker->wakeup_fd >= 0) {
+            uint64_t one = 1;
+            ssize_t ret = write(worker->wakeup_fd, &one, sizeof(one));
+            (void)ret;
+        }
+    }
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+        // 停止后迁入队列中可能还有未接收的命名空间
+        adopt_inbox(worker.get());
+        if (worker->epoll_fd >= 0) {
+            close(worker->epoll_fd);
+        }
+        if (worker->wakeup_fd >= 0) {
+            close(worker->wakeup_fd);
+        }
+    }
+}
+
+void NetnsMonitorGroup::shutdown_monitors() {
+    for (auto& monitor : monitors_) {
+        monitor->stop_monitoring();
+    }
+
+    // 日志线程可能仍在格式化引用各命名空间接口缓存的记录，停止后才能释放监控器
+    logger_->stop();
+    monitors_.clear();
+}
+
+void NetnsMonitorGroup::report_pipeline_stats(bool print_console) {
+    if (!running_.load()) {
+        return;
+    }
+    for (const auto& monitor : monitors_) {
+        monitor->report_pipeline_stats(print_console);
+    }
+    if (print_console) {
+        for (const auto& worker : workers_) {
+            std::cout << "   事件线程 #" << worker->index << ": 分发 " << worker->dispatches.load()
+                      << " 次, 迁入 " << worker->stolen.load() << "\n";
+        }
+    }
+}
+
+void NetnsMonitorGroup::stop() {
+    bool expected = true;
+    if (!running_.compare_exchange_strong(expected, false)) {
+        return;
+    }
+
+    // 先停止事件线程，之后各监控器的收尾（强制结束会话、最终统计）在本线程中串行执行
+    close_workers();
+    for (const auto& worker : workers_) {
+        std::cout << "   事件线程 #" << worker->index
+                  << (worker->cpu >= 0 ? " (CPU " + std::to_string(worker->cpu) + ")" : "")
+                  << ": 命名空间 " << worker->monitors.size()
+                  << ", 分发 " << worker->dispatches.load() << " 次, 迁入 " << worker->stolen.load() << "\n";
+    }
+    workers_.clear();
+    shutdown_monitors();
+
+    std::cout << "✅ 多命名空间监控完成，日志已保存到: " << log_file_path_ << "\n";
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "convergence_monitor.h"
+
+// 事件线程池配置
+struct WorkerPoolOptions {
+    // 事件线程数
+    int workers = 1;
+    // 绑定的CPU，第i个线程绑定到 cpus[i % cpus.size()]，为空时不绑定
+    std::vector<int> cpus;
+    // 空闲线程从繁忙线程迁移命名空间
+    bool work_stealing = true;
+};
+
+// 多命名空间监控：一个进程监控主机上的所有路由器命名空间
+//
+// 每个命名空间一个 ConvergenceMonitor（独立的会话状态机与接口缓存），netlink套接字通过
+// setns 在目标命名空间中创建后切回。所有命名空间共享一个日志记录器。
+//
+// 命名空间按轮转分配给事件线程（worker），每个worker在自己的epoll集合中等待所拥有命名空间的
+// epoll实例，并串行分发其事件；命名空间的会话状态只由其所属worker访问，热路径上没有跨线程锁。
+// 负载不均时，空闲worker向本批有多个命名空间就绪的worker发出窃取请求，后者在批次开始时把其中
+// 一个就绪的命名空间移交过去（从自己的epoll集合中移除，经加锁的迁入队列交给请求方）。
+class NetnsMonitorGroup {
+public:
+    NetnsMonitorGroup(int64_t convergence_threshold_ms,
+                      const std::string& log_path,
+                      const MonitorOptions& options,
+                      const WorkerPoolOptions& pool_options);
+    ~NetnsMonitorGroup();
+
+    NetnsMonitorGroup(const NetnsMonitorGroup&) = delete;
+    NetnsMonitorGroup& operator=(const NetnsMonitorGroup&) = delete;
+
+    // 列出目录中匹配通配符的命名空间（如 /var/run/netns 与 "clab-*"），按名称排序
+    static bool list_namespaces(const std::string& netns_dir, const std::string& pattern,
+                                std::vector<std::string>& names, std::string& error);
+
+    // 在每个命名空间中启动监控并启动事件线程；任一命名空间失败时抛出异常（启动阶段）
+    void start(const std::string& netns_dir, const std::vector<std::string>& names);
+    void stop();
+
+    // 每个命名空间写入一条 monitor_stats 日志，print_console 时同时输出到控制台
+    void report_pipeline_stats(bool print_console);
+
+    size_t size() const { return monitors_.size(); }
+    const std::string& log_file_path() const { return log_file_path_; }
+
+private:
+    // 空闲多久后尝试窃取
+    static constexpr int STEAL_IDLE_MS = 50;
+    static constexpr int MAX_EVENTS = 64;
+
+    struct Worker {
+        int index{0};
+        int cpu{-1};
+        int epoll_fd{-1};
+        int wakeup_fd{-1};
+        std::thread thread;
+
+        // 仅由本worker线程访问（启动前与停止后除外）
+        std::vector<ConvergenceMonitor*> monitors;
+        Worker* steal_target{nullptr};      // 本线程发出且尚未撤回的窃取请求所在的worker
+
+        // 跨线程：最近一次多命名空间同时就绪的批次（就绪数与单调时间）、
+        // 拥有的命名空间数、窃取请求方编号（-1表示无）、迁入队列
+        std::atomic<int> busy_ready{0};
+        std::atomic<int64_t> busy_at_ns{0};
+        std::atomic<int> owned{0};
+        std::atomic<int> steal_request{-1};
+        std::mutex inbox_mutex;
+        std::vector<ConvergenceMonitor*> inbox;
+
+        // 统计
+        std::atomic<int64_t> dispatches{0};
+        std::atomic<int64_t> stolen{0};
+    };
+
+    int64_t convergence_threshold_ms_;
+    MonitorOptions options_;
+    WorkerPoolOptions pool_options_;
+    std::shared_ptr<Logger> logger_;
+    std::string log_file_path_;
+    std::vector<std::unique_ptr<ConvergenceMonitor>> monitors_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> running_{false};
+
+    void worker_loop(Worker* worker);
+    bool add_monitor(Worker* worker, ConvergenceMonitor* monitor);
+    void adopt_inbox(Worker* worker);
+    void try_steal(Worker* thief);
+    // 撤回本线程尚未被处理的窃取请求（已被受害方领取时无操作）
+    void withdraw_steal(Worker* thief);
+    // 把本批中的一个就绪命名空间交给请求方，返回被移交的事件下标（-1表示未移交）
+    int hand_over(Worker* victim, struct epoll_event* events, int count);
+    void close_workers();
+    // 收尾各监控器并停止日志记录器
+    void shutdown_monitors();
+};
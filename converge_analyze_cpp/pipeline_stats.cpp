@@ -0,0 +1,149 @@
+#include "pipeline_stats.h"
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+
+namespace PipelineStats {
+
+namespace {
+
+std::atomic<int> g_sample_interval{16};
+thread_local std::array<int, STAGE_COUNT> t_sample_counters{};
+
+// 纳秒格式化为带单位的短文本，用于控制台输出
+std::string format_ns(int64_t ns) {
+    char buffer[32];
+    if (ns < 10 * EventClock::NS_PER_US) {
+        snprintf(buffer, sizeof(buffer), "%lldns", static_cast<long long>(ns));
+    } else if (ns < 10 * EventClock::NS_PER_MS) {
+        snprintf(buffer, sizeof(buffer), "%.1fus", static_cast<double>(ns) / EventClock::NS_PER_US);
+    } else {
+        snprintf(buffer, sizeof(buffer), "%.1fms", static_cast<double>(ns) / EventClock::NS_PER_MS);
+    }
+    return buffer;
+}
+
+} // namespace
+
+const char* stage_name(Stage stage) {
+    switch (stage) {
+        case KERNEL_QUEUE: return "kernel_queue";
+        case DISPATCH: return "dispatch";
+        case PARSE: return "parse";
+        case LOCK_WAIT: return "lock_wait";
+        case SESSION: return "session";
+        case LOG_ENQUEUE: return "log_enqueue";
+        case LOG_QUEUE: return "log_queue";
+        case LOG_WRITE: return "log_write";
+        case STAGE_COUNT: break;
+    }
+    return "unknown";
+}
+
+void set_sample_interval(int interval) {
+    g_sample_interval.store(interval < 0 ? 0 : interval, std::memory_order_relaxed);
+}
+
+int sample_interval() {
+    return g_sample_interval.load(std::memory_order_relaxed);
+}
+
+bool sample(Stage site) {
+    int interval = g_sample_interval.load(std::memory_order_relaxed);
+    if (interval <= 0) {
+        return false;
+    }
+    int& counter = t_sample_counters[site];
+    if (++counter >= interval) {
+        counter = 0;
+        return true;
+    }
+    return false;
+}
+
+size_t StageLatency::bucket_index(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - SUB_BUCKET_BITS;
+    return static_cast<size_t>(msb - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+int64_t StageLatency::bucket_upper(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return static_cast<int64_t>(index);
+    }
+    int shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+    uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return static_cast<int64_t>(lower + (1ULL << shift) - 1);
+}
+
+void StageLatency::record(int64_t ns) {
+    if (ns < 0) {
+        ns = 0;
+    }
+    buckets_[bucket_index(static_cast<uint64_t>(ns))].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(ns, std::memory_order_relaxed);
+    int64_t previous = max_.load(std::memory_order_relaxed);
+    while (ns > previous && !max_.compare_exchange_weak(previous, ns, std::memory_order_relaxed)) {
+    }
+}
+
+StageLatency::Snapshot StageLatency::snapshot() const {
+    // 各计数在读取期间可能继续增长，百分位按实际读到的区间总数计算
+    std::array<int64_t, BUCKET_COUNT> counts;
+    int64_t total = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    Snapshot snapshot;
+    snapshot.count = total;
+    snapshot.sum_ns = sum_.load(std::memory_order_relaxed);
+    snapshot.max_ns = max_.load(std::memory_order_relaxed);
+    if (total == 0) {
+        return snapshot;
+    }
+
+    const double percentiles[] = {50.0, 99.0, 99.9};
+    int64_t* outputs[] = {&snapshot.p50_ns, &snapshot.p99_ns, &snapshot.p999_ns};
+    size_t next = 0;
+    int64_t cumulative = 0;
+    for (size_t i = 0; i < BUCKET_COUNT && next < 3; ++i) {
+        cumulative += counts[i];
+        while (next < 3 && cumulative * 100.0 >= percentiles[next] * total) {
+            *outputs[next] = std::min(bucket_upper(i), snapshot.max_ns);
+            next++;
+        }
+    }
+    return snapshot;
+}
+
+void Report::add_stage(Stage stage, const StageLatency& latency) {
+    stages_.emplace_back(stage, latency.snapshot());
+}
+
+void Report::add_counter(const std::string& name, int64_t value) {
+    counters_.emplace_back(name, value);
+}
+
+void Report::print(std::ostream& out, const std::string& indent) const {
+    for (const auto& stage : stages_) {
+        const StageLatency::Snapshot& s = stage.second;
+        out << indent << std::left << std::setw(14) << stage_name(stage.first) << std::right;
+        if (s.count == 0) {
+            out << "无样本\n";
+            continue;
+        }
+        out << "n=" << s.count << " P50=" << format_ns(s.p50_ns) << " P99=" << format_ns(s.p99_ns)
+            << " P99.9=" << format_ns(s.p999_ns) << " 最大=" << format_ns(s.max_ns) << "\n";
+    }
+    for (const auto& counter : counters_) {
+        out << indent << counter.first << "=" << counter.second << "\n";
+    }
+}
+
+} // namespace PipelineStats
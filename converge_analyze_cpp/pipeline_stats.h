@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "event_clock.h"
+
+// 事件流水线各阶段的耗时统计：
+//   内核接收时间戳 → recv出队 → 开始处理消息 → 解析/FIB分类 → 等待会话锁 → 会话处理 →
+//   日志入队 → 日志线程取出 → 批量写入
+//
+// 热路径只做 relaxed 原子加，每个线程按固定间隔采样（thread_local 计数器，不共享缓存行），
+// 任意线程可随时读取快照（monitor_stats 周期日志与 SIGUSR1 转储）。
+namespace PipelineStats {
+
+enum Stage {
+    KERNEL_QUEUE,   // 内核接收时间戳 → recv出队（仅 --kernel-timestamps；--source ebpf 时为FIB修改 → 环形缓冲区出队）
+    DISPATCH,       // recv出队 → 开始处理该消息（批内排队）
+    PARSE,          // 开始处理 → 解析与FIB分类完成
+    LOCK_WAIT,      // 等待会话锁
+    SESSION,        // 持有会话锁的处理时间（含日志入队）
+    LOG_ENQUEUE,    // 日志入队（含溢出策略的等待）
+    LOG_QUEUE,      // 日志入队 → 日志线程取出
+    LOG_WRITE,      // 一次批量write（含 --log-fsync batch 的 fdatasync）
+    STAGE_COUNT
+};
+
+const char* stage_name(Stage stage);
+
+// 采样间隔：每个线程对每个采样点每 N 次调用 sample() 返回一次true，0 表示关闭阶段计时（启动前设置）。
+// 采样点按起始阶段区分计数，同一线程上交替调用的采样点互不影响
+void set_sample_interval(int interval);
+int sample_interval();
+bool sample(Stage site);
+
+// 单个阶段的对数-线性直方图（每个2的幂区段8个子区间，相对误差不超过12.5%）
+class StageLatency {
+public:
+    struct Snapshot {
+        int64_t count = 0;
+        int64_t sum_ns = 0;
+        int64_t max_ns = 0;
+        int64_t p50_ns = 0;
+        int64_t p99_ns = 0;
+        int64_t p999_ns = 0;
+    };
+
+    void record(int64_t ns);
+    Snapshot snapshot() const;
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 3;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = 64 * SUB_BUCKETS;
+
+    std::array<std::atomic<int64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<int64_t> count_{0};
+    std::atomic<int64_t> sum_{0};
+    std::atomic<int64_t> max_{0};
+
+    static size_t bucket_index(uint64_t value);
+    static int64_t bucket_upper(size_t index);
+};
+
+// 会话引擎负责的阶段
+struct SessionStages {
+    StageLatency parse;
+    StageLatency lock_wait;
+    StageLatency session;
+};
+
+// 会话锁：采样的消息记录解析（从消息开始处理到加锁前）、等锁与持锁时间。
+// message_start_ns 为0（未采样）时等同于 std::lock_guard
+template <typename Mutex>
+class TimedLock {
+public:
+    TimedLock(Mutex& mutex, SessionStages& stages, int64_t message_start_ns)
+        : mutex_(mutex), stages_(message_start_ns > 0 ? &stages : nullptr) {
+        if (!stages_) {
+            mutex_.lock();
+            return;
+        }
+        int64_t before = EventClock::monotonic_ns();
+        mutex_.lock();
+        acquired_ns_ = EventClock::monotonic_ns();
+        stages_->parse.record(before - message_start_ns);
+        stages_->lock_wait.record(acquired_ns_ - before);
+    }
+
+    ~TimedLock() {
+        if (stages_) {
+            stages_->session.record(EventClock::monotonic_ns() - acquired_ns_);
+        }
+        mutex_.unlock();
+    }
+
+    TimedLock(const TimedLock&) = delete;
+    TimedLock& operator=(const TimedLock&) = delete;
+
+private:
+    Mutex& mutex_;
+    SessionStages* stages_;
+    int64_t acquired_ns_{0};
+};
+
+// 一次统计报告：各组件把自己负责的阶段快照与计数加入报告，再输出为日志字段或控制台文本
+class Report {
+public:
+    void add_stage(Stage stage, const StageLatency& latency);
+    void add_counter(const std::string& name, int64_t value);
+
+    // 日志字段：<阶段>_count / _p50_ns / _p99_ns / _p999_ns / _max_ns / _mean_ns，以及各计数
+    template <typename JsonObjectT>
+    void append_to(JsonObjectT& log) const {
+        for (const auto& stage : stages_) {
+            std::string prefix = std::string("stage_") + stage_name(stage.first);
+            log[prefix + "_count"] = stage.second.count;
+            log[prefix + "_p50_ns"] = stage.second.p50_ns;
+            log[prefix + "_p99_ns"] = stage.second.p99_ns;
+            log[prefix + "_p999_ns"] = stage.second.p999_ns;
+            log[prefix + "_max_ns"] = stage.second.max_ns;
+            log[prefix + "_mean_ns"] = stage.second.count > 0 ? stage.second.sum_ns / stage.second.count : 0;
+        }
+        for (const auto& counter : counters_) {
+            log[counter.first] = counter.second;
+        }
+    }
+
+    void print(std::ostream& out, const std::string& indent) const;
+
+private:
+    std::vector<std::pair<Stage, StageLatency::Snapshot>> stages_;
+    std::vector<std::pair<std::string, int64_t>> counters_;
+};
+
+} // namespace PipelineStats
@@ -0,0 +1,117 @@
+#include "prefix_table.h"
+#include <algorithm>
+#include <cstring>
+#include <linux/rtnetlink.h>
+
+bool PrefixKey::operator==(const PrefixKey& other) const {
+    return table == other.table && family == other.family && len == other.len &&
+           memcmp(&addr, &other.addr, sizeof(addr)) == 0;
+}
+
+uint64_t PrefixTable::hash(const PrefixKey& key) {
+    uint64_t hi;
+    uint64_t lo;
+    memcpy(&hi, key.addr.s6_addr, sizeof(hi));
+    memcpy(&lo, key.addr.s6_addr + 8, sizeof(lo));
+
+    // splitmix64 终结函数混合各字段
+    auto mix = [](uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    };
+    uint64_t meta = (static_cast<uint64_t>(key.table) << 16) | (static_cast<uint64_t>(key.family) << 8) | key.len;
+    return mix(hi ^ mix(lo ^ mix(meta)));
+}
+
+void PrefixTable::grow() {
+    size_t capacity = slots_.empty() ? INITIAL_SLOTS : slots_.size() * 2;
+    slots_.assign(capacity, 0);
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        size_t slot = hash(entries_[i].key) & mask;
+        while (slots_[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots_[slot] = static_cast<uint32_t>(i + 1);
+    }
+}
+
+PrefixKey PrefixTable::make_key(const RouteRecord& route) {
+    PrefixKey key;
+    memset(&key, 0, sizeof(key));
+    key.table = route.table;
+    key.family = route.family;
+    key.len = route.dst_len;
+    if (route.has(RouteRecord::HAS_DST)) {
+        key.addr = route.dst;
+    }
+    return key;
+}
+
+void PrefixTable::update(const RouteRecord& route) {
+    PrefixKey key = make_key(route);
+
+    if ((entries_.size() + 1) * 2 > slots_.size()) {
+        grow();
+    }
+
+    size_t mask = slots_.size() - 1;
+    size_t slot = hash(key) & mask;
+    PrefixState* state = nullptr;
+    while (slots_[slot] != 0) {
+        PrefixState& candidate = entries_[slots_[slot] - 1];
+        if (candidate.key == key) {
+            state = &candidate;
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (!state) {
+        slots_[slot] = static_cast<uint32_t>(entries_.size() + 1);
+        entries_.emplace_back();
+        state = &entries_.back();
+        memset(state, 0, sizeof(*state));
+        state->key = key;
+        state->first_change = route.timestamp;
+    }
+
+    state->last_change = route.timestamp;
+    state->change_count++;
+    state->withdrawn = route.nlmsg_type == RTM_DELROUTE;
+    state->has_gateway = route.has(RouteRecord::HAS_GATEWAY);
+    state->gateway = route.gateway;
+    state->oif = route.has(RouteRecord::HAS_OIF) ? route.ifindex : 0;
+}
+
+void PrefixTable::slowest(size_t n, std::vector<const PrefixState*>& out) const {
+    out.clear();
+    out.reserve(entries_.size());
+    for (const auto& entry : entries_) {
+        out.push_back(&entry);
+    }
+
+    auto later = [](const PrefixState* a, const PrefixState* b) { return a->last_change > b->last_change; };
+    if (n < out.size()) {
+        std::partial_sort(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(n), out.end(), later);
+        out.resize(n);
+    } else {
+        std::sort(out.begin(), out.end(), later);
+    }
+}
+
+void PrefixTable::clear() {
+    std::vector<PrefixState>().swap(entries_);
+    std::vector<uint32_t>().swap(slots_);
+}
+
+std::string PrefixTable::prefix_string(const PrefixKey& key) {
+    if (key.len == 0) {
+        return key.family == AF_INET6 ? "default6" : "default";
+    }
+    return EventFormat::address(key.addr, key.family) + "/" + std::to_string(key.len);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+#include "event_records.h"
+
+// 前缀键：路由表 + 地址族 + 目标前缀（默认路由为 0/0）
+struct PrefixKey {
+    struct in6_addr addr;
+    uint32_t table;
+    uint8_t family;
+    uint8_t len;
+
+    bool operator==(const PrefixKey& other) const;
+};
+
+// 单个前缀在会话内的变化情况；时间为单调时钟纳秒
+struct PrefixState {
+    PrefixKey key;
+    int64_t first_change;
+    int64_t last_change;
+    uint32_t change_count;
+    bool withdrawn;             // 最后一次变化为删除
+    bool has_gateway;
+    int32_t oif;                // 最后一次变化的出接口（0表示无）
+    struct in6_addr gateway;    // 最后一次变化的下一跳
+};
+
+// 会话内的前缀表：开放寻址哈希索引 + 连续存放的前缀状态。
+// 只包含会话期间发生变化的前缀，更新为O(1)，遍历与汇总为O(变化前缀数)，与路由表总规模无关。
+// 调用者负责加锁。
+class PrefixTable {
+public:
+    // 按路由消息更新对应前缀（RTM_DELROUTE 记为撤销）
+    void update(const RouteRecord& route);
+
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+    const std::vector<PrefixState>& entries() const { return entries_; }
+
+    // 最后变化时间最晚的 n 个前缀，按最后变化时间降序
+    void slowest(size_t n, std::vector<const PrefixState*>& out) const;
+
+    // 释放全部内存
+    void clear();
+
+    size_t memory_bytes() const {
+        return entries_.capacity() * sizeof(PrefixState) + slots_.capacity() * sizeof(uint32_t);
+    }
+
+    // "10.0.0.0/24"、"default"（IPv6为 "default6"）
+    static std::string prefix_string(const PrefixKey& key);
+
+    // 由路由消息构造前缀键
+    static PrefixKey make_key(const RouteRecord& route);
+
+    static uint64_t hash(const PrefixKey& key);
+
+private:
+    static constexpr size_t INITIAL_SLOTS = 64;
+
+    std::vector<PrefixState> entries_;
+    // 哈希槽：0 为空，否则为 entries_ 下标 + 1；装载率不超过 1/2
+    std::vector<uint32_t> slots_;
+
+    void grow();
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+// 有界无锁多生产者/多消费者环形队列（Vyukov 算法）
+//
+// 槽位在构造时一次性分配，入队/出队只做原子操作与对象移动（或在槽位中原地读写），不加锁、不分配内存。
+// 每个槽位带有序号：序号等于入队位置表示可写，等于位置+1表示可读。
+// 容量向上取整为2的幂。
+template <typename T>
+class BoundedRingBuffer {
+public:
+    explicit BoundedRingBuffer(size_t capacity)
+        : capacity_(round_up_pow2(capacity < 2 ? 2 : capacity)),
+          mask_(capacity_ - 1),
+          slots_(new Slot[capacity_]) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedRingBuffer(const BoundedRingBuffer&) = delete;
+    BoundedRingBuffer& operator=(const BoundedRingBuffer&) = delete;
+
+    // 入队，队列满时返回false（不修改value）
+    bool try_push(T& value) {
+        return try_push_with([&](T& slot_value) { slot_value = std::move(value); });
+    }
+
+    // 出队，队列空时返回false
+    bool try_pop(T& out) {
+        return try_pop_with([&](T& slot_value) { out = std::move(slot_value); });
+    }
+
+    // 原地入队：fill 直接写入槽位中的对象（沿用槽位已有的内存，如字符串容量），队列满时返回false
+    template <typename Fill>
+    bool try_push_with(Fill&& fill) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos & mask_];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    fill(slot.value);
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // 已满
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 原地出队：consume 处理槽位中的对象后槽位才交还生产者（不移动对象，保留其内存供下次复用），
+    // 队列空时返回false
+    template <typename Consume>
+    bool try_pop_with(Consume&& consume) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos & mask_];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    consume(slot.value);
+                    slot.seq.store(pos + capacity_, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // 为空
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 近似判断（并发修改时仅作参考）
+    bool empty() const {
+        return dequeue_pos_.load(std::memory_order_acquire) >= enqueue_pos_.load(std::memory_order_acquire);
+    }
+
+    // 近似元素数（并发修改时仅作参考）
+    size_t size_approx() const {
+        size_t dequeued = dequeue_pos_.load(std::memory_order_acquire);
+        size_t enqueued = enqueue_pos_.load(std::memory_order_acquire);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    static size_t round_up_pow2(size_t n) {
+        size_t result = 1;
+        while (result < n) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    // 生产者与消费者位置放在不同缓存行，避免伪共享
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+};
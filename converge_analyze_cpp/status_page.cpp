@@ -0,0 +1,86 @@
+#include "status_page.h"
+#include "event_clock.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace StatusPage {
+
+namespace {
+
+constexpr int READ_ATTEMPTS = 1000;
+
+void copy_name(char* dest, size_t size, const std::string& value) {
+    size_t len = std::min(value.size(), size - 1);
+    memcpy(dest, value.data(), len);
+    dest[len] = '\0';
+}
+
+} // namespace
+
+bool read_snapshot(const Page& page, Data& out) {
+    for (int attempt = 0; attempt < READ_ATTEMPTS; ++attempt) {
+        uint32_t before = page.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        memcpy(&out, &page.data, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (page.sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Writer::~Writer() {
+    close();
+}
+
+bool Writer::open(const std::string& path, const std::string& router_name, const std::string& monitor_id,
+                  std::string& error) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error = "无法创建状态页 " + path + ": " + strerror(errno);
+        return false;
+    }
+    // 先截断再扩展：旧文件的内容（可能来自上一次运行）全部清零
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(FILE_SIZE)) != 0) {
+        error = "无法设置状态页大小 " + path + ": " + strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error = "无法映射状态页 " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    page_ = static_cast<Page*>(mapping);
+    path_ = path;
+    page_->version = VERSION;
+    page_->pid = static_cast<uint32_t>(getpid());
+    page_->start_wall_ms = EventClock::to_wall_ms(EventClock::monotonic_ns());
+    copy_name(page_->router_name, sizeof(page_->router_name), router_name);
+    copy_name(page_->monitor_id, sizeof(page_->monitor_id), monitor_id);
+    update([](Data& data) { data.state = IDLE; });
+    // 魔数最后写入：读取端看到魔数时头部已完整
+    std::atomic_thread_fence(std::memory_order_release);
+    page_->magic = MAGIC;
+    return true;
+}
+
+void Writer::close() {
+    if (page_) {
+        munmap(page_, FILE_SIZE);
+        page_ = nullptr;
+    }
+}
+
+} // namespace StatusPage
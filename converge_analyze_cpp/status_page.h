@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 实时状态页（--status-dir）：监控器把当前状态发布到 /dev/shm 下一个4KB的共享映射文件中，
+// 编排脚本只需读内存即可轮询大量路由器，无需追踪日志文件。
+//
+// 写入端只有一个（持有会话锁的线程），用序列锁保护：写入前序列号加1（奇数表示写入中），
+// 写完再加1。读取端先读序列号、复制数据、再读序列号，两次相同且为偶数时数据一致，否则重试。
+// 写入只是普通内存写，热路径上没有系统调用。
+//
+// 文件布局固定（小端序，偏移见 static_assert），experiment_utils/status_page.py 按同一布局读取：
+//   [0, 128)    头部：魔数、版本、进程号、启动时间、路由器名称、监控器编号（创建后不再变化）
+//   [128, 132)  序列号
+//   [192, ...)  Data：状态、计数与最近的会话结果
+namespace StatusPage {
+
+constexpr uint32_t MAGIC = 0x54535643;       // "CVST"
+constexpr uint16_t VERSION = 1;
+constexpr size_t FILE_SIZE = 4096;
+constexpr size_t RECENT_RESULTS = 32;
+
+enum State : uint32_t {
+    IDLE = 0,
+    MONITORING = 1,
+    STOPPED = 2         // 监控器已退出（文件保留，供编排脚本读取最终状态）
+};
+
+// 最近完成的会话（环形保存，result_count 为累计完成数，最新一条位于 (result_count-1) % RECENT_RESULTS）
+struct SessionResult {
+    int32_t session_id;
+    uint8_t trigger_source;     // TriggerRecord::Source
+    uint8_t converged;
+    uint8_t lossy;
+    uint8_t resynced;
+    int32_t route_events;
+    int32_t reserved;
+    int64_t trigger_wall_ms;    // 触发时刻（Unix毫秒）
+    int64_t convergence_us;     // 收敛时间，未收敛时为-1
+};
+
+struct Data {
+    uint32_t state;                     // State
+    uint32_t open_sessions;
+    int32_t current_session_id;         // 最近开始的进行中会话，空闲时为0
+    int32_t last_completed_session_id;
+    int64_t last_event_wall_ms;         // 最近一个会话内事件（Unix毫秒），没有时为0
+    int64_t total_route_events;
+    int64_t total_triggers;
+    int64_t completed_sessions;
+    int64_t overruns;
+    int64_t lost_messages;
+    uint32_t result_count;
+    uint32_t reserved;
+    SessionResult results[RECENT_RESULTS];
+};
+
+struct Page {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved0;
+    uint32_t pid;
+    uint32_t reserved1;
+    int64_t start_wall_ms;
+    char router_name[64];
+    char monitor_id[40];
+    std::atomic<uint32_t> sequence;
+    char padding[60];
+    Data data;
+};
+
+static_assert(sizeof(SessionResult) == 32, "status page layout");
+static_assert(offsetof(Data, results) == 72, "status page layout");
+static_assert(offsetof(Page, router_name) == 24, "status page layout");
+static_assert(offsetof(Page, sequence) == 128, "status page layout");
+static_assert(offsetof(Page, data) == 192, "status page layout");
+static_assert(sizeof(Page) <= FILE_SIZE, "status page layout");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "sequence must be lock-free in shared memory");
+
+// 按序列锁读取一致的快照，写入端长时间处于写入中（例如进程在写入时崩溃）时返回false
+bool read_snapshot(const Page& page, Data& out);
+
+// 写入端：创建并映射状态页文件
+class Writer {
+public:
+    Writer() = default;
+    ~Writer();
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    // 创建（或覆盖）状态页文件，失败时返回false并给出错误信息
+    bool open(const std::string& path, const std::string& router_name, const std::string& monitor_id,
+              std::string& error);
+    void close();
+
+    bool is_open() const { return page_ != nullptr; }
+    const std::string& path() const { return path_; }
+
+    // 在序列锁保护下修改数据；未打开时不做任何事。调用者保证只有一个写入线程
+    template <typename Fn>
+    void update(Fn&& fn) {
+        if (!page_) {
+            return;
+        }
+        uint32_t seq = page_->sequence.load(std::memory_order_relaxed);
+        page_->sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        fn(page_->data);
+        page_->sequence.store(seq + 2, std::memory_order_release);
+    }
+
+private:
+    Page* page_{nullptr};
+    std::string path_;
+};
+
+} // namespace StatusPage
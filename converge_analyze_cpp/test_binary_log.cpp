@@ -0,0 +1,375 @@
+#include "binary_log_format.h"
+#include "event_clock.h"
+#include <arpa/inet.h>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 二进制日志单元测试：编码→解码往返（全部记录类型）、分段重置与末尾截断
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cout << "❌ " << what << "\n";
+        failures++;
+    }
+}
+
+const std::string ROUTER = "router_7";
+const std::string USER = "tester";
+
+bool same_value(const JsonValue& a, const JsonValue& b) {
+    if (a.get_type() != b.get_type()) {
+        return false;
+    }
+    switch (a.get_type()) {
+        case JsonValue::STRING: return a.as_string() == b.as_string();
+        case JsonValue::INT64: return a.as_int64() == b.as_int64();
+        case JsonValue::DOUBLE: return a.as_double() == b.as_double();
+        case JsonValue::BOOL: return a.as_bool() == b.as_bool();
+    }
+    return false;
+}
+
+bool same_object(const JsonObject& a, const JsonObject& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (const auto& pair : a) {
+        auto it = b.find(pair.first);
+        if (it == b.end() || !same_value(pair.second, it->second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct in6_addr parse_address(int family, const char* text) {
+    struct in6_addr addr{};
+    inet_pton(family, text, &addr);
+    return addr;
+}
+
+// 待编码的一条记录：结构化记录或路由事件
+struct Entry {
+    bool is_route_event;
+    JsonObject object;
+    RouteEventLog event;
+    std::string interface;
+};
+
+Entry object_entry(const JsonObject& object) {
+    Entry entry{};
+    entry.is_route_event = false;
+    entry.object = object;
+    return entry;
+}
+
+Entry route_entry(const EventRecord& record, int session_id, int64_t number, const std::string& interface) {
+    Entry entry{};
+    entry.is_route_event = true;
+    entry.event.source_id = 0;
+    entry.event.session_id = session_id;
+    entry.event.route_event_number = number;
+    entry.event.session_event_number = static_cast<int>(number % 5);
+    entry.event.offset_from_trigger_ns = number * 1234567;
+    entry.event.event = record;
+    entry.interface = interface;
+    return entry;
+}
+
+// 解码后的期望值：路由事件与文本日志的JSON相同
+JsonObject expected(const Entry& entry) {
+    if (!entry.is_route_event) {
+        return entry.object;
+    }
+    return LogJson::create_route_event_log(ROUTER, entry.event, USER,
+                                           EventClock::to_wall_ms(entry.event.event.timestamp()),
+                                           entry.interface);
+}
+
+// 覆盖全部记录类型与字段值类型
+std::vector<Entry> sample_entries(int64_t base_ns) {
+    std::vector<Entry> entries;
+
+    entries.push_back(object_entry(LogJson::create_monitoring_start_log(ROUTER, USER, 200, "/tmp/test.bin", "m-1")));
+
+    JsonObject values = LogJson::create_event_log("session_completed", ROUTER, USER);
+    values["session_id"] = 3;
+    values["negative"] = static_cast<int64_t>(-42);
+    values["big"] = static_cast<int64_t>(1) << 62;
+    values["ratio"] = 0.125;
+    values["lossy"] = true;
+    values["resynced"] = false;
+    values["empty"] = "";
+    values["long_text"] = std::string(BinaryLog::MAX_INTERNED_LENGTH + 10, 'x');   // 超长字符串内联
+    entries.push_back(object_entry(values));
+
+    RouteRecord v4{};
+    v4.timestamp = base_ns + 1000;
+    v4.nlmsg_type = 24;     // RTM_NEWROUTE
+    v4.family = AF_INET;
+    v4.dst_len = 24;
+    v4.protocol = 186;      // bgp
+    v4.scope = 0;
+    v4.type = 1;
+    v4.flags = RouteRecord::HAS_DST | RouteRecord::HAS_GATEWAY | RouteRecord::HAS_OIF | RouteRecord::HAS_PRIORITY;
+    v4.change = RouteRecord::CHANGE_MODIFIED;
+    v4.table = 254;
+    v4.ifindex = 3;
+    v4.priority = 20;
+    v4.dst = parse_address(AF_INET, "10.1.2.0");
+    v4.gateway = parse_address(AF_INET, "10.0.0.1");
+    entries.push_back(route_entry(EventRecord(v4), 1, 1, "eth1"));
+
+    RouteRecord v6{};
+    v6.timestamp = base_ns + 2500;
+    v6.nlmsg_type = 25;     // RTM_DELROUTE
+    v6.family = AF_INET6;
+    v6.dst_len = 64;
+    v6.protocol = 186;
+    v6.type = 1;
+    v6.flags = RouteRecord::HAS_DST | RouteRecord::HAS_PREFSRC | RouteRecord::HAS_MULTIPATH | RouteRecord::HAS_NH_ID;
+    v6.change = RouteRecord::CHANGE_REMOVED;
+    v6.nexthop_count = 2;
+    v6.table = 254;
+    v6.nh_id = 17;
+    v6.nexthop_hash = 0xdeadbeef;
+    v6.dst = parse_address(AF_INET6, "2001:db8:1::");
+    v6.prefsrc = parse_address(AF_INET6, "2001:db8::1");
+    entries.push_back(route_entry(EventRecord(v6), 1, 2, "N/A"));
+
+    QdiscRecord qdisc{};
+    qdisc.timestamp = base_ns + 4000;
+    qdisc.nlmsg_type = 36;  // RTM_NEWQDISC
+    qdisc.family = AF_UNSPEC;
+    qdisc.ifindex = 3;
+    qdisc.handle = 0x80010000;
+    qdisc.parent = 0xffffffff;
+    strncpy(qdisc.kind, "netem", QdiscRecord::KIND_SIZE - 1);
+    entries.push_back(route_entry(EventRecord(qdisc), 2, 3, "eth1"));
+
+    LinkRecord link{};
+    link.timestamp = base_ns + 5000;
+    link.nlmsg_type = 16;   // RTM_NEWLINK
+    link.up = 0;
+    link.operstate = 2;     // IF_OPER_DOWN
+    link.ifindex = 4;
+    link.flags = 0x1003;
+    strncpy(link.name, "eth2", LinkRecord::NAME_SIZE - 1);
+    entries.push_back(route_entry(EventRecord(link), 2, 4, "eth2"));
+
+    NexthopRecord nexthop{};
+    nexthop.timestamp = base_ns + 7000;
+    nexthop.nlmsg_type = 104;   // RTM_NEWNEXTHOP
+    nexthop.family = AF_INET;
+    nexthop.flags = NexthopRecord::HAS_GATEWAY | NexthopRecord::HAS_OIF;
+    nexthop.protocol = 186;
+    nexthop.change = RouteRecord::CHANGE_NEW;
+    nexthop.id = 17;
+    nexthop.ifindex = 3;
+    nexthop.gateway = parse_address(AF_INET, "10.0.0.1");
+    entries.push_back(route_entry(EventRecord(nexthop), 2, 5, "eth1"));
+
+    NexthopRecord group{};
+    group.timestamp = base_ns + 8000;
+    group.nlmsg_type = 105;     // RTM_DELNEXTHOP
+    group.flags = NexthopRecord::IS_GROUP;
+    group.group_size = 3;
+    group.id = 18;
+    group.group_hash = 0x12345678;
+    entries.push_back(route_entry(EventRecord(group), 2, 6, "N/A"));
+
+    // 重复的前缀与字段名走字符串表引用
+    v4.timestamp = base_ns + 9000;
+    v4.change = RouteRecord::CHANGE_NOOP;
+    entries.push_back(route_entry(EventRecord(v4), 3, 7, "eth1"));
+
+    return entries;
+}
+
+void encode(BinaryLog::Encoder& encoder, std::string& out, const std::vector<Entry>& entries) {
+    for (const Entry& entry : entries) {
+        if (entry.is_route_event) {
+            encoder.append_route_event(out, entry.event, ROUTER, USER, entry.interface);
+        } else {
+            encoder.append_object(out, entry.object);
+        }
+    }
+}
+
+// 按 chunk 字节分块输入解码器；chunk为0时一次输入全部数据
+bool decode(const std::string& data, std::vector<JsonObject>& records, std::string& error, size_t chunk = 0) {
+    BinaryLog::Decoder decoder([&](const JsonObject& record) { records.push_back(record); });
+    size_t step = chunk == 0 ? data.size() : chunk;
+    for (size_t pos = 0; pos < data.size(); pos += step) {
+        if (!decoder.feed(data.data() + pos, std::min(step, data.size() - pos))) {
+            error = decoder.error();
+            return false;
+        }
+    }
+    if (!decoder.finish()) {
+        error = decoder.error();
+        return false;
+    }
+    return true;
+}
+
+void check_records(const std::vector<JsonObject>& records, const std::vector<Entry>& entries, const std::string& what) {
+    check(records.size() == entries.size(), what + ": 记录数应为 " + std::to_string(entries.size()) +
+                                                "，实际 " + std::to_string(records.size()));
+    for (size_t i = 0; i < records.size() && i < entries.size(); ++i) {
+        check(same_object(records[i], expected(entries[i])), what + ": 第 " + std::to_string(i) + " 条记录与编码前不一致");
+    }
+}
+
+// 各帧的结束位置
+std::vector<size_t> frame_ends(const std::string& data) {
+    std::vector<size_t> ends;
+    size_t pos = 0;
+    while (data.size() - pos >= BinaryLog::FRAME_HEADER_SIZE) {
+        uint32_t body_len;
+        memcpy(&body_len, data.data() + pos, sizeof(body_len));
+        pos += BinaryLog::FRAME_HEADER_SIZE + body_len;
+        ends.push_back(pos);
+    }
+    return ends;
+}
+
+void test_round_trip(int64_t base_ns) {
+    auto entries = sample_entries(base_ns);
+    BinaryLog::Encoder encoder;
+    std::string data;
+    encode(encoder, data, entries);
+
+    check(BinaryLog::is_binary_log(data.data(), data.size()), "编码结果应以流头开始");
+    check(frame_ends(data).back() == data.size(), "帧长度之和应等于数据长度");
+
+    std::vector<JsonObject> records;
+    std::string error;
+    check(decode(data, records, error), "一次输入解码失败: " + error);
+    check_records(records, entries, "一次输入");
+
+    // 任意分块（含把帧头拆开）结果相同
+    for (size_t chunk : {1, 5, 9, 64}) {
+        records.clear();
+        check(decode(data, records, error, chunk), "分块解码失败: " + error);
+        check_records(records, entries, "分块 " + std::to_string(chunk) + " 字节");
+    }
+}
+
+void test_segment_reset(int64_t base_ns) {
+    auto entries = sample_entries(base_ns);
+    BinaryLog::Encoder encoder;
+    std::string first, second;
+    encode(encoder, first, entries);
+    encoder.reset();
+    encode(encoder, second, entries);
+
+    // 重置后的分段自带流头与字符串表，可单独解码
+    check(BinaryLog::is_binary_log(second.data(), second.size()), "重置后的分段应以流头开始");
+    check(second.size() == first.size(), "重置后的分段应重新定义全部字符串");
+    std::vector<JsonObject> records;
+    std::string error;
+    check(decode(second, records, error), "单独解码重置后的分段失败: " + error);
+    check_records(records, entries, "重置后的分段");
+
+    // 分段首尾相接（同一流编号重新开始字符串表）也能连续解码
+    std::vector<Entry> both = entries;
+    both.insert(both.end(), entries.begin(), entries.end());
+    records.clear();
+    check(decode(first + second, records, error), "解码相接的分段失败: " + error);
+    check_records(records, both, "相接的分段");
+
+    // 不重置时后续记录引用前面定义的字符串，不能脱离前一部分单独解码
+    BinaryLog::Encoder shared;
+    std::string head, tail;
+    encode(shared, head, entries);
+    encode(shared, tail, entries);
+    check(tail.size() < second.size(), "未重置时重复字符串不应再次定义");
+    records.clear();
+    check(!decode(tail, records, error), "缺少流头的数据应解码失败");
+}
+
+void test_truncated_tail(int64_t base_ns) {
+    auto entries = sample_entries(base_ns);
+    BinaryLog::Encoder encoder;
+    std::string data;
+    encode(encoder, data, entries);
+    auto ends = frame_ends(data);
+
+    // 在每个字节处截断：截断点之前的完整记录全部解出，截在帧中间时 finish() 报告残留
+    for (size_t cut = 0; cut < data.size(); ++cut) {
+        std::vector<JsonObject> records;
+        BinaryLog::Decoder decoder([&](const JsonObject& record) { records.push_back(record); });
+        if (!decoder.feed(data.data(), cut)) {
+            check(false, "截断数据不应导致格式错误: " + decoder.error());
+            break;
+        }
+
+        size_t complete_frames = 0;
+        while (complete_frames < ends.size() && ends[complete_frames] <= cut) {
+            complete_frames++;
+        }
+        bool at_boundary = cut == 0 || (complete_frames > 0 && ends[complete_frames - 1] == cut);
+        if (decoder.finish() != at_boundary) {
+            check(false, "截断于 " + std::to_string(cut) + " 字节时 finish() 结果错误");
+            break;
+        }
+        if (static_cast<int64_t>(records.size()) != decoder.record_count()) {
+            check(false, "record_count 与回调次数不一致");
+            break;
+        }
+        for (size_t i = 0; i < records.size(); ++i) {
+            if (!same_object(records[i], expected(entries[i]))) {
+                check(false, "截断于 " + std::to_string(cut) + " 字节时第 " + std::to_string(i) + " 条记录错误");
+                break;
+            }
+        }
+    }
+
+    // 末尾缺少1字节：除最后一条外全部解出
+    std::vector<JsonObject> records;
+    std::string error;
+    check(!decode(data.substr(0, data.size() - 1), records, error), "末尾不完整时 finish() 应失败");
+    check(records.size() == entries.size() - 1, "末尾不完整时应解出之前的全部记录");
+}
+
+void test_corrupt_input() {
+    std::vector<JsonObject> records;
+    std::string error;
+    const std::string json = "{\"event_type\":\"route_event\"}\n";
+    check(!decode(json, records, error), "JSON文本日志应被拒绝");
+
+    BinaryLog::Encoder encoder;
+    std::string data;
+    encoder.append_object(data, LogJson::create_event_log("session_started", ROUTER, USER));
+    uint32_t huge = BinaryLog::MAX_RECORD_SIZE + 1;
+    memcpy(&data[0], &huge, sizeof(huge));
+    check(!decode(data, records, error), "超长记录长度应报告文件损坏");
+}
+
+} // namespace
+
+int main() {
+    std::cout << "测试二进制日志编解码...\n";
+
+    int64_t realtime_ns, monotonic_ns;
+    EventClock::wall_anchor(realtime_ns, monotonic_ns);
+
+    test_round_trip(monotonic_ns);
+    test_segment_reset(monotonic_ns);
+    test_truncated_tail(monotonic_ns);
+    test_corrupt_input();
+
+    if (failures > 0) {
+        std::cout << "❌ " << failures << " 项检查失败\n";
+        return 1;
+    }
+    std::cout << "✅ 二进制日志测试通过\n";
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include "histogram.h"
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+// HdrHistogram 单元测试：区间边界、精度、百分位与序列化/合并
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cout << "❌ " << what << "\n";
+        failures++;
+    }
+}
+
+constexpr int64_t MAX_US = 3600LL * 1000000;
+constexpr int DIGITS = 3;
+
+// 解析 serialize() 的输出："区间下界:计数,..."
+std::map<int64_t, int64_t> parse(const std::string& text) {
+    std::map<int64_t, int64_t> bins;
+    const char* pos = text.data();
+    const char* end = pos + text.size();
+    while (pos < end) {
+        const char* item_end = static_cast<const char*>(memchr(pos, ',', end - pos));
+        if (!item_end) {
+            item_end = end;
+        }
+        int64_t value = 0, count = 0;
+        auto first = std::from_chars(pos, item_end, value);
+        std::from_chars(first.ptr + 1, item_end, count);
+        bins[value] += count;
+        pos = item_end + 1;
+    }
+    return bins;
+}
+
+// 只含单个样本的直方图所在区间的下界
+int64_t bin_lower_bound(int64_t value) {
+    HdrHistogram hist(MAX_US, DIGITS);
+    hist.record(value);
+    return parse(hist.serialize()).begin()->first;
+}
+
+void test_empty() {
+    HdrHistogram hist(MAX_US, DIGITS);
+    check(hist.total_count() == 0, "空直方图的样本数应为0");
+    check(hist.value_at_percentile(50.0) == 0, "空直方图的百分位应为0");
+    check(hist.min() == 0 && hist.max() == 0, "空直方图的最小/最大值应为0");
+    check(hist.serialize().empty(), "空直方图的序列化应为空串");
+}
+
+void test_bucket_edges() {
+    // 第一个区段（0-2047）逐值精确
+    for (int64_t value : {0, 1, 1023, 1024, 2047}) {
+        check(bin_lower_bound(value) == value, "小值应精确记录: " + std::to_string(value));
+    }
+
+    // 3位有效数字时 100000us 落在 [99968, 100031]：区间跨越100ms边界
+    check(bin_lower_bound(100000) == 99968, "100000 所在区间下界应为 99968");
+    check(bin_lower_bound(99968) == 99968 && bin_lower_bound(100031) == 99968, "99968 与 100031 应在同一区间");
+    check(bin_lower_bound(100032) == 100032, "100032 应开始新区间");
+    HdrHistogram layout(MAX_US, DIGITS);
+    check(layout.highest_equivalent_value(99968) == 100031, "99968 所在区间上界应为 100031");
+    check(layout.highest_equivalent_value(2048) == 2049, "2048 所在区间上界应为 2049");
+    check(layout.highest_equivalent_value(1000) == 1000, "第一个区段的区间上界应为其本身");
+
+    // 区段交界处：2048 起区间宽度为2
+    check(bin_lower_bound(2048) == 2048 && bin_lower_bound(2049) == 2048, "2048/2049 应在同一区间");
+    check(bin_lower_bound(2050) == 2050, "2050 应开始新区间");
+
+    // 任意值所在区间的下界不大于该值，且宽度满足有效数字要求
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int64_t> dist(0, MAX_US);
+    for (int i = 0; i < 10000; ++i) {
+        int64_t value = dist(rng);
+        int64_t lower = bin_lower_bound(value);
+        if (lower > value || value - lower > value / 1000) {
+            check(false, "区间下界超出精度范围: " + std::to_string(value) + " -> " + std::to_string(lower));
+            break;
+        }
+    }
+
+    // 超出上限的值记录为上限并计入溢出
+    HdrHistogram hist(MAX_US, DIGITS);
+    hist.record(MAX_US * 2);
+    hist.record(-5);
+    check(hist.overflow_count() == 1, "超出上限的值应计入 overflow_count");
+    check(hist.max() == MAX_US, "超出上限的值应记录为上限");
+    check(hist.min() == 0, "负值应记录为0");
+}
+
+void test_percentiles() {
+    HdrHistogram hist(MAX_US, DIGITS);
+    for (int64_t value = 1; value <= 1000; ++value) {
+        hist.record(value);
+    }
+    check(hist.total_count() == 1000, "样本数应为1000");
+    check(hist.min() == 1 && hist.max() == 1000, "最小/最大值应为1/1000");
+    check(hist.value_at_percentile(50.0) == 500, "P50 应为500");
+    check(hist.value_at_percentile(99.0) == 990, "P99 应为990");
+    check(hist.value_at_percentile(100.0) == 1000, "P100 应为最大值");
+    check(hist.value_at_percentile(0.0) == 1, "P0 应为最小值");
+    check(hist.mean() == 500.5, "平均值应为500.5");
+
+    // 区间上界不超过实际最大值：落在同一区间的样本返回真实最大值而非区间上界
+    HdrHistogram edge(MAX_US, DIGITS);
+    for (int i = 0; i < 10; ++i) {
+        edge.record(100000 + i);
+    }
+    check(edge.value_at_percentile(50.0) == 100009, "同一区间内的P50应截断到最大值 100009");
+    for (double pct : {0.0, 50.0, 100.0}) {
+        check(edge.value_at_percentile(pct) >= edge.min(), "百分位不应小于最小样本");
+    }
+
+    // 大值的百分位相对误差在有效数字范围内
+    HdrHistogram large(MAX_US, DIGITS);
+    for (int64_t value = 1; value <= 1000; ++value) {
+        large.record(value * 1000003);
+    }
+    int64_t p90 = large.value_at_percentile(90.0);
+    int64_t expected = 900 * 1000003LL;
+    check(p90 >= expected && p90 - expected <= expected / 1000, "大值P90 应在0.1%误差内: " + std::to_string(p90));
+}
+
+void test_serialize_merge() {
+    HdrHistogram a(MAX_US, DIGITS);
+    HdrHistogram b(MAX_US, DIGITS);
+    HdrHistogram all(MAX_US, DIGITS);
+    std::mt19937_64 rng(7);
+    std::lognormal_distribution<double> dist(11.0, 1.5);
+    for (int i = 0; i < 5000; ++i) {
+        int64_t value = static_cast<int64_t>(dist(rng));
+        (i % 3 ? a : b).record(value);
+        all.record(value);
+    }
+
+    // 序列化只含非零区间，计数之和等于样本数，区间按下界升序
+    auto bins = parse(all.serialize());
+    int64_t total = 0;
+    for (const auto& bin : bins) {
+        check(bin.second > 0, "序列化不应包含零计数区间");
+        total += bin.second;
+    }
+    check(total == all.total_count(), "序列化计数之和应等于样本数");
+    check(!bins.empty() && bins.begin()->first <= all.min(), "最小区间下界不应大于最小样本");
+
+    // 相同有效数字的直方图按区间下界相加等于直接记录全部样本
+    auto merged = parse(a.serialize());
+    for (const auto& bin : parse(b.serialize())) {
+        merged[bin.first] += bin.second;
+    }
+    check(merged == bins, "按区间下界合并应与直接记录全部样本一致");
+
+    // 再次记录各区间下界得到相同的序列化结果：下界是区间的规范值
+    HdrHistogram replay(MAX_US, DIGITS);
+    for (const auto& bin : bins) {
+        for (int64_t i = 0; i < bin.second; ++i) {
+            replay.record(bin.first);
+        }
+    }
+    check(replay.serialize() == all.serialize(), "按区间下界重放应得到相同的序列化结果");
+}
+
+} // namespace
+
+int main() {
+    std::cout << "测试 HdrHistogram...\n";
+
+    test_empty();
+    test_bucket_edges();
+    test_percentiles();
+    test_serialize_merge();
+
+    if (failures > 0) {
+        std::cout << "❌ " << failures << " 项检查失败\n";
+        return 1;
+    }
+    std::cout << "✅ HdrHistogram 测试通过\n";
+    return 0;
+}
@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""
+接收 ConvergenceAnalyzer --export 发送的会话记录（仅标准库）。
+
+用法:
+  python3 export_collector.py udp://0.0.0.0:9300 -o results.json
+  python3 export_collector.py tcp://0.0.0.0:9300 -o results.json
+  python3 export_collector.py unix:/tmp/converge.sock -o results.json
+  python3 export_collector.py udp://0.0.0.0:9300 -o results.json --offsets offsets.csv
+
+记录与JSON日志格式相同（每行一个JSON对象），按到达顺序追加到输出文件，
+实验结束后可直接用 converge_aggregate 汇总。控制台实时打印每个完成的会话。
+
+--offsets 在退出时写出各时钟相对收集端时钟的估计偏移（供 converge_aggregate --clock-offsets）：
+记录时间减去到达时间 = 偏移 - 批量等待 - 传输延迟，取最大值即为偏移的下界估计（毫秒精度）。
+同一主机（monitoring_started 中 clock_boot_id 相同）的路由器合并估计，键为 boot_id。
+"""
+
+import json
+import os
+import selectors
+import socket
+import sys
+import time
+from datetime import datetime, timezone
+from typing import Dict, Optional, TextIO
+
+
+def parse_address(address: str):
+    if address.startswith("unix:"):
+        path = address[5:]
+        if path.startswith("//"):
+            path = path[2:]
+        return "unix", path
+    for scheme in ("udp", "tcp"):
+        prefix = scheme + "://"
+        if address.startswith(prefix):
+            host, _, port = address[len(prefix):].rpartition(":")
+            return scheme, (host.strip("[]") or "0.0.0.0", int(port))
+    raise ValueError(f"未知的地址: {address}")
+
+
+def parse_timestamp_ms(text: str) -> Optional[float]:
+    try:
+        dt = datetime.strptime(text, "%Y-%m-%dT%H:%M:%S.%fZ").replace(tzinfo=timezone.utc)
+    except (TypeError, ValueError):
+        return None
+    return dt.timestamp() * 1000.0
+
+
+class Collector:
+    def __init__(self, out: Optional[TextIO]):
+        self.out = out
+        self.records = 0
+        self.completed = 0
+        self.invalid = 0
+        self.boot_ids: Dict[str, str] = {}
+        self.offsets: Dict[str, float] = {}
+        self.recv_ms = 0.0
+
+    def estimate_offset(self, record: Dict) -> None:
+        router = record.get("router_name")
+        if record.get("event_type") == "monitoring_started" and record.get("clock_boot_id"):
+            self.boot_ids[router] = record["clock_boot_id"]
+        sent_ms = parse_timestamp_ms(record.get("timestamp"))
+        if router is None or sent_ms is None:
+            return
+        key = self.boot_ids.get(router, router)
+        delta = sent_ms - self.recv_ms
+        if key not in self.offsets or delta > self.offsets[key]:
+            self.offsets[key] = delta
+
+    def write_offsets(self, path: str) -> None:
+        with open(path, "w") as f:
+            f.write("clock,offset_ms\n")
+            for key, offset in sorted(self.offsets.items()):
+                f.write(f"{key},{offset:.3f}\n")
+
+    def handle_line(self, line: bytes) -> None:
+        line = line.strip()
+        if not line:
+            return
+        try:
+            record = json.loads(line)
+        except ValueError:
+            self.invalid += 1
+            return
+        self.records += 1
+        self.estimate_offset(record)
+        if self.out is not None:
+            self.out.write(line.decode("utf-8", errors="replace") + "\n")
+        if record.get("event_type") == "session_completed":
+            self.completed += 1
+            conv = record.get("convergence_time_ms")
+            conv_text = f"{conv}ms" if conv is not None else "未收敛"
+            print(f"{record.get('router_name')}: 会话#{record.get('session_id')} {conv_text} "
+                  f"路由事件={record.get('route_events_count')}", flush=True)
+
+    def handle_chunk(self, chunk: bytes) -> None:
+        self.recv_ms = time.time() * 1000.0
+        for line in chunk.split(b"\n"):
+            self.handle_line(line)
+
+
+def serve(address: str, collector: Collector) -> None:
+    scheme, target = parse_address(address)
+    if scheme == "udp":
+        family = socket.AF_INET6 if ":" in target[0] else socket.AF_INET
+        sock = socket.socket(family, socket.SOCK_DGRAM)
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 8 << 20)
+        sock.bind(target)
+        while True:
+            collector.handle_chunk(sock.recv(65536))
+
+    if scheme == "unix":
+        if os.path.exists(target):
+            os.unlink(target)
+        listener = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    else:
+        family = socket.AF_INET6 if ":" in target[0] else socket.AF_INET
+        listener = socket.socket(family, socket.SOCK_STREAM)
+        listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    listener.bind(target)
+    listener.listen(1024)
+    listener.setblocking(False)
+
+    sel = selectors.DefaultSelector()
+    sel.register(listener, selectors.EVENT_READ)
+    partial: Dict[socket.socket, bytes] = {}
+    while True:
+        for key, _ in sel.select():
+            sock = key.fileobj
+            if sock is listener:
+                conn, _ = listener.accept()
+                conn.setblocking(False)
+                sel.register(conn, selectors.EVENT_READ)
+                partial[conn] = b""
+                continue
+            data = sock.recv(1 << 16)
+            if not data:
+                # 连接末尾不完整的行丢弃：监控器重连后会从该行开头重发
+                sel.unregister(sock)
+                partial.pop(sock, None)
+                sock.close()
+                continue
+            buf = partial[sock] + data
+            complete, _, rest = buf.rpartition(b"\n")
+            partial[sock] = rest
+            if complete:
+                collector.handle_chunk(complete)
+
+
+def main() -> None:
+    args = sys.argv[1:]
+    paths: Dict[str, Optional[str]] = {"-o": None, "--offsets": None}
+    for flag in paths:
+        if flag in args:
+            i = args.index(flag)
+            if i + 1 >= len(args):
+                print(f"{flag} 需要文件路径")
+                sys.exit(1)
+            paths[flag] = args[i + 1]
+            del args[i:i + 2]
+    out_path = paths["-o"]
+    if len(args) != 1:
+        print("使用方法: python export_collector.py <udp://HOST:PORT|tcp://HOST:PORT|unix:PATH> "
+              "[-o 输出文件] [--offsets 时钟偏移文件]")
+        sys.exit(1)
+
+    out = open(out_path, "a", buffering=1) if out_path else None
+    collector = Collector(out)
+    try:
+        serve(args[0], collector)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if out is not None:
+            out.close()
+        if paths["--offsets"]:
+            collector.write_offsets(paths["--offsets"])
+        print(f"共接收 {collector.records} 条记录，完成会话 {collector.completed} 个，无法解析 {collector.invalid} 行")
+
+
+if __name__ == "__main__":
+    main()
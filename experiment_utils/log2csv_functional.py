@@ -3,7 +3,12 @@
 简化版收敛日志转CSV工具（仅标准库）
 
 用法:
-  python3 log2csv_functional.py <输入目录或JSON文件> <输出CSV文件>
+  python3 log2csv_functional.py <输入目录或JSON文件> <输出CSV文件> [--drop-lossy]
+
+  --drop-lossy  丢弃接收溢出(lossy=true)且未完成RIB重新同步的会话样本
+
+每次监听都写出了带直方图的 monitoring_completed 时，直接合并其中的收敛时间直方图，
+不再逐条解析 session_completed；旧版日志或未正常结束的监听回退到逐事件统计。
 
 输出列（满足绘图脚本 experiment_utils/draw/converge_draw_{N}x{N}.py 的要求）:
   - router_name
@@ -12,14 +17,16 @@
   - convergence_p50_ms
   - convergence_p75_ms
   - convergence_p95_ms
+  - lossy_sessions（发生netlink接收溢出的会话数，用于评估样本可信度）
 """
 
 import csv
 import json
+import math
 import os
 import sys
 from pathlib import Path
-from typing import Dict, List, Tuple
+from typing import Dict, List, Optional, Tuple
 
 # 确保可以作为脚本运行时也能导入 experiment_utils（需在导入前注入）
 THIS_DIR = os.path.dirname(os.path.abspath(__file__))
@@ -49,6 +56,65 @@ def percentiles(values: List[float]) -> Tuple[float, float, float]:
     return pick(0.5), pick(0.75), pick(0.95)
 
 
+def parse_histogram(text: str) -> Dict[int, int]:
+    """解析 monitoring_completed 中的稀疏直方图 "区间下界:计数,..."。"""
+    hist: Dict[int, int] = {}
+    if not text:
+        return hist
+    for item in text.split(","):
+        value, _, count = item.partition(":")
+        hist[int(value)] = hist.get(int(value), 0) + int(count)
+    return hist
+
+
+def merge_histogram(target: Dict[int, int], hist: Dict[int, int]) -> None:
+    """有效数字相同的直方图按区间下界相加即可合并。"""
+    for value, count in hist.items():
+        target[value] = target.get(value, 0) + count
+
+
+def bin_upper_bound(value: int, significant_digits: int = 3) -> int:
+    """value 所在直方图区间的上界（含），与 HdrHistogram::highest_equivalent_value 一致。"""
+    sub_bucket_count_magnitude = math.ceil(math.log2(2 * 10 ** significant_digits))
+    sub_bucket_mask = (1 << sub_bucket_count_magnitude) - 1
+    bucket_index = (value | sub_bucket_mask).bit_length() - sub_bucket_count_magnitude
+    lowest = (value >> bucket_index) << bucket_index
+    return lowest + (1 << bucket_index) - 1
+
+
+def histogram_percentiles(hist: Dict[int, int], min_value: Optional[int] = None, max_value: Optional[int] = None,
+                          scale: float = 1000.0) -> Tuple[float, float, float]:
+    """与 percentiles() 相同的索引规则，在直方图区间上计算 P50, P75, P95（默认微秒→毫秒）。
+
+    取区间上界并截断到样本的实际最小/最大值（与监控器的 value_at_percentile 相同），
+    因此结果不会小于最小样本；旧版日志没有样本范围时不截断。
+    """
+    n = sum(hist.values())
+    if n == 0:
+        return -1.0, -1.0, -1.0
+    buckets = sorted(hist.items())
+
+    def pick(pct: float) -> float:
+        idx_float = (n - 1) * pct
+        idx = int(idx_float) if idx_float.is_integer() else int(idx_float) + 1
+        idx = min(idx, n - 1)
+        lower = buckets[-1][0]
+        cumulative = 0
+        for value, count in buckets:
+            cumulative += count
+            if cumulative > idx:
+                lower = value
+                break
+        value = bin_upper_bound(lower)
+        if max_value is not None:
+            value = min(value, max_value)
+        if min_value is not None:
+            value = max(value, min_value)
+        return value / scale
+
+    return pick(0.5), pick(0.75), pick(0.95)
+
+
 def infer_router_name_from_path(file_path: str) -> str:
     for part in Path(file_path).parts:
         if part.startswith("router_"):
@@ -73,7 +139,13 @@ def parse_json_lines(file_path: str) -> List[Dict]:
     return events
 
 
-def gather_router_stats_from_events(events: List[Dict], file_path: str) -> Dict[str, Dict]:
+def is_untrusted_session(ev: Dict) -> bool:
+    """会话期间发生接收溢出且未能重新同步时，收敛时间不可信。"""
+    return bool(ev.get("lossy")) and not bool(ev.get("resynced"))
+
+
+def gather_router_stats_from_events(events: List[Dict], file_path: str,
+                                    drop_lossy: bool = False) -> Dict[str, Dict]:
     """将事件按 router_name 聚合，统计分位点和触发事件数量。"""
     by_router: Dict[str, Dict] = {}
     for ev in events:
@@ -82,9 +154,14 @@ def gather_router_stats_from_events(events: List[Dict], file_path: str) -> Dict[
             "file_path": file_path,
             "convergence_times": [],
             "trigger_events": 0,
+            "lossy_sessions": 0,
         })
         # 收集会话完成的收敛时间
         if ev.get("event_type") == "session_completed":
+            if ev.get("lossy"):
+                s["lossy_sessions"] += 1
+            if drop_lossy and is_untrusted_session(ev):
+                continue
             ct = ev.get("convergence_time_ms")
             if isinstance(ct, (int, float)):
                 s["convergence_times"].append(float(ct))
@@ -96,6 +173,64 @@ def gather_router_stats_from_events(events: List[Dict], file_path: str) -> Dict[
     return by_router
 
 
+def gather_router_stats_from_summaries(file_path: str) -> Optional[Dict[str, Dict]]:
+    """只解析 monitoring_started / monitoring_completed 行并合并其中的直方图。
+
+    任一路由器存在没有直方图摘要的监听（旧版本或异常退出）时返回 None，由调用者回退到逐事件统计。
+    """
+    started: Dict[str, int] = {}
+    by_router: Dict[str, Dict] = {}
+    try:
+        with open(file_path, "r", encoding="utf-8") as f:
+            for line in f:
+                # 先做子串过滤，避免对每条路由事件做JSON解析
+                if '"monitoring_' not in line:
+                    continue
+                try:
+                    ev = json.loads(line)
+                except json.JSONDecodeError:
+                    continue
+                router_name = ev.get("router_name") or infer_router_name_from_path(file_path)
+                event_type = ev.get("event_type")
+                if event_type == "monitoring_started":
+                    started[router_name] = started.get(router_name, 0) + 1
+                elif event_type == "monitoring_completed":
+                    if "convergence_time_us_histogram" not in ev:
+                        return None
+                    s = by_router.setdefault(router_name, {
+                        "file_path": file_path,
+                        "histogram": {},
+                        "min_us": None,
+                        "max_us": None,
+                        "range_known": True,
+                        "trigger_events": 0,
+                        "lossy_sessions": 0,
+                        "runs": 0,
+                    })
+                    hist = parse_histogram(ev["convergence_time_us_histogram"])
+                    merge_histogram(s["histogram"], hist)
+                    if hist:
+                        if "convergence_min_us" in ev and "convergence_max_us" in ev:
+                            lo, hi = int(ev["convergence_min_us"]), int(ev["convergence_max_us"])
+                            s["min_us"] = lo if s["min_us"] is None else min(s["min_us"], lo)
+                            s["max_us"] = hi if s["max_us"] is None else max(s["max_us"], hi)
+                        else:
+                            # 旧版本日志没有样本范围，合并后的区间上界不截断
+                            s["range_known"] = False
+                    s["trigger_events"] += int(ev.get("netem_detected_count", 0)) + int(ev.get("route_events_in_trigger", 0))
+                    s["lossy_sessions"] += int(ev.get("lossy_sessions_count", 0))
+                    s["runs"] += 1
+    except OSError:
+        return None
+
+    if not by_router:
+        return None
+    for router_name, count in started.items():
+        if by_router.get(router_name, {}).get("runs", 0) != count:
+            return None
+    return by_router
+
+
 def find_json_files(input_path: str) -> List[str]:
     p = Path(input_path)
     if p.is_file():
@@ -105,7 +240,7 @@ def find_json_files(input_path: str) -> List[str]:
     return [str(fp) for fp in p.rglob("*.json")]
 
 
-def build_rows(input_path: str) -> List[Dict]:
+def build_rows(input_path: str, drop_lossy: bool = False) -> List[Dict]:
     rows: List[Dict] = []
     json_files = find_json_files(input_path)
     if not json_files:
@@ -115,11 +250,30 @@ def build_rows(input_path: str) -> List[Dict]:
     with ProgressReporter() as pr:
         task = pr.create_task(f"处理JSON: {len(json_files)} 个文件", total=len(json_files))
         for json_file in json_files:
+            # 有损样本需要逐会话判断，直方图摘要无法区分
+            summaries = None if drop_lossy else gather_router_stats_from_summaries(json_file)
+            if summaries is not None:
+                for router_name, s in summaries.items():
+                    known = s["range_known"]
+                    p50, p75, p95 = histogram_percentiles(s["histogram"], s["min_us"] if known else None,
+                                                          s["max_us"] if known else None)
+                    rows.append({
+                        "router_name": router_name,
+                        "log_file_path": s["file_path"],
+                        "total_trigger_events": s["trigger_events"],
+                        "convergence_p50_ms": p50,
+                        "convergence_p75_ms": p75,
+                        "convergence_p95_ms": p95,
+                        "lossy_sessions": s["lossy_sessions"],
+                    })
+                pr.update_task(task, 1)
+                continue
+
             events = parse_json_lines(json_file)
             if not events:
                 pr.update_task(task, 1)
                 continue
-            by_router = gather_router_stats_from_events(events, json_file)
+            by_router = gather_router_stats_from_events(events, json_file, drop_lossy)
             for router_name, s in by_router.items():
                 p50, p75, p95 = percentiles(s["convergence_times"]) if s["convergence_times"] else (-1.0, -1.0, -1.0)
                 rows.append({
@@ -129,6 +283,7 @@ def build_rows(input_path: str) -> List[Dict]:
                     "convergence_p50_ms": p50,
                     "convergence_p75_ms": p75,
                     "convergence_p95_ms": p95,
+                    "lossy_sessions": s["lossy_sessions"],
                 })
             pr.update_task(task, 1)
     return rows
@@ -143,6 +298,7 @@ def write_csv(rows: List[Dict], output_csv: str) -> None:
         fieldnames = [
             "router_name", "log_file_path", "total_trigger_events",
             "convergence_p50_ms", "convergence_p75_ms", "convergence_p95_ms",
+            "lossy_sessions",
         ]
         with open(output_path, "w", newline="", encoding="utf-8") as f:
             csv.DictWriter(f, fieldnames=fieldnames).writeheader()
@@ -159,12 +315,15 @@ def write_csv(rows: List[Dict], output_csv: str) -> None:
 
 
 def main() -> None:
-    if len(sys.argv) != 3:
-        print("使用方法: python log2csv_functional.py <输入目录或JSON文件> <输出CSV文件>")
+    args = sys.argv[1:]
+    drop_lossy = "--drop-lossy" in args
+    args = [a for a in args if a != "--drop-lossy"]
+    if len(args) != 2:
+        print("使用方法: python log2csv_functional.py <输入目录或JSON文件> <输出CSV文件> [--drop-lossy]")
         sys.exit(1)
-    input_path, output_csv = sys.argv[1], sys.argv[2]
+    input_path, output_csv = args[0], args[1]
     log_info(f"开始处理: {input_path}")
-    rows = build_rows(input_path)
+    rows = build_rows(input_path, drop_lossy)
     write_csv(rows, output_csv)
     log_success("完成")
 
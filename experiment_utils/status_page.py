@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""
+读取 ConvergenceAnalyzer --status-dir 发布的实时状态页（仅标准库）。
+
+用法:
+  python3 status_page.py <状态页目录或.status文件>...            # 打印各路由器当前状态
+  python3 status_page.py <目录> --wait-idle [超时秒数]            # 等待全部路由器回到空闲
+
+状态页是4KB的共享映射文件，布局与 converge_analyze_cpp/status_page.h 一致，用序列锁保护：
+读取前后序列号相同且为偶数时数据一致。轮询只读内存，不影响监控器的热路径。
+"""
+
+import mmap
+import os
+import struct
+import sys
+import time
+from pathlib import Path
+from typing import Dict, List, Optional
+
+MAGIC = 0x54535643
+VERSION = 1
+FILE_SIZE = 4096
+RECENT_RESULTS = 32
+
+HEADER = struct.Struct("<IHHIIq64s40s")       # [0, 128)
+SEQUENCE_OFFSET = 128
+DATA_OFFSET = 192
+DATA = struct.Struct("<IIiiqqqqqqII")         # [192, 264)
+RESULT = struct.Struct("<iBBBBiiqq")          # 每条32字节
+RESULTS_OFFSET = DATA_OFFSET + DATA.size
+DATA_END = RESULTS_OFFSET + RESULT.size * RECENT_RESULTS
+
+STATE_NAMES = {0: "IDLE", 1: "MONITORING", 2: "STOPPED"}
+TRIGGER_SOURCES = {0: "netem", 1: "route", 2: "link", 3: "nexthop"}
+
+
+def _text(raw: bytes) -> str:
+    return raw.split(b"\0", 1)[0].decode("utf-8", errors="replace")
+
+
+def _pid_alive(pid: int) -> bool:
+    try:
+        os.kill(pid, 0)
+    except ProcessLookupError:
+        return False
+    except PermissionError:
+        return True
+    return True
+
+
+def read_status(path: str, attempts: int = 1000) -> Optional[Dict]:
+    """读取一份一致的状态快照；文件不存在、格式不符或一直处于写入中时返回 None。"""
+    try:
+        with open(path, "rb") as f:
+            mm = mmap.mmap(f.fileno(), FILE_SIZE, prot=mmap.PROT_READ)
+    except (OSError, ValueError):
+        return None
+
+    try:
+        magic, version, _, pid, _, start_ms, router, monitor_id = HEADER.unpack_from(mm, 0)
+        if magic != MAGIC or version != VERSION:
+            return None
+        for _ in range(attempts):
+            before = struct.unpack_from("<I", mm, SEQUENCE_OFFSET)[0]
+            if before & 1:
+                continue
+            raw = mm[DATA_OFFSET:DATA_END]
+            if struct.unpack_from("<I", mm, SEQUENCE_OFFSET)[0] == before:
+                break
+        else:
+            return None
+    finally:
+        mm.close()
+
+    (state, open_sessions, current_session, last_completed, last_event_ms, route_events,
+     triggers, completed, overruns, lost, result_count, _) = DATA.unpack_from(raw, 0)
+
+    results: List[Dict] = []
+    for i in range(min(result_count, RECENT_RESULTS)):
+        # 从最新一条开始
+        index = (result_count - 1 - i) % RECENT_RESULTS
+        (session_id, source, converged, lossy, resynced, events, _, trigger_ms,
+         convergence_us) = RESULT.unpack_from(raw, DATA.size + index * RESULT.size)
+        results.append({
+            "session_id": session_id,
+            "trigger_source": TRIGGER_SOURCES.get(source, str(source)),
+            "converged": bool(converged),
+            "lossy": bool(lossy),
+            "resynced": bool(resynced),
+            "route_events": events,
+            "trigger_wall_ms": trigger_ms,
+            "convergence_ms": convergence_us / 1000.0 if convergence_us >= 0 else None,
+        })
+
+    state_name = STATE_NAMES.get(state, str(state))
+    if state_name != "STOPPED" and not _pid_alive(pid):
+        # 进程异常退出，状态页停留在最后一次写入
+        state_name = "DEAD"
+    return {
+        "path": path,
+        "router_name": _text(router),
+        "monitor_id": _text(monitor_id),
+        "pid": pid,
+        "start_wall_ms": start_ms,
+        "state": state_name,
+        "open_sessions": open_sessions,
+        "current_session_id": current_session,
+        "last_completed_session_id": last_completed,
+        "last_event_wall_ms": last_event_ms,
+        "total_route_events": route_events,
+        "total_triggers": triggers,
+        "completed_sessions": completed,
+        "overruns": overruns,
+        "lost_messages": lost,
+        "recent_results": results,
+    }
+
+
+def find_status_files(inputs: List[str]) -> List[str]:
+    files: List[str] = []
+    for item in inputs:
+        p = Path(item)
+        if p.is_dir():
+            files.extend(sorted(str(fp) for fp in p.glob("*.status")))
+        elif p.exists():
+            files.append(str(p))
+    return files
+
+
+def wait_until_idle(paths: List[str], timeout: float = 300.0, interval: float = 0.05) -> bool:
+    """等待所有路由器处于空闲（或已停止）状态；超时返回 False。"""
+    deadline = time.monotonic() + timeout
+    while True:
+        statuses = [read_status(p) for p in paths]
+        if all(s is not None and s["state"] in ("IDLE", "STOPPED") for s in statuses):
+            return True
+        if time.monotonic() >= deadline:
+            return False
+        time.sleep(interval)
+
+
+def main() -> None:
+    args = sys.argv[1:]
+    wait_timeout: Optional[float] = None
+    if "--wait-idle" in args:
+        i = args.index("--wait-idle")
+        wait_timeout = 300.0
+        if i + 1 < len(args):
+            try:
+                wait_timeout = float(args[i + 1])
+                del args[i + 1]
+            except ValueError:
+                pass
+        del args[i]
+    if not args:
+        print("使用方法: python status_page.py <状态页目录或.status文件>... [--wait-idle [超时秒数]]")
+        sys.exit(1)
+
+    files = find_status_files(args)
+    if not files:
+        print(f"未找到状态页: {' '.join(args)}")
+        sys.exit(1)
+
+    if wait_timeout is not None:
+        ok = wait_until_idle(files, wait_timeout)
+        print("全部空闲" if ok else "等待超时")
+        sys.exit(0 if ok else 2)
+
+    for path in files:
+        s = read_status(path)
+        if s is None:
+            print(f"{path}: 无法读取")
+            continue
+        last = s["recent_results"][0] if s["recent_results"] else None
+        last_text = ""
+        if last is not None:
+            conv = f"{last['convergence_ms']:.3f}ms" if last["convergence_ms"] is not None else "未收敛"
+            last_text = f" 最近会话#{last['session_id']}={conv}"
+        print(f"{s['router_name']}: {s['state']} 会话={s['current_session_id']} 进行中={s['open_sessions']} "
+              f"完成={s['completed_sessions']} 路由事件={s['total_route_events']}{last_text}")
+
+
+if __name__ == "__main__":
+    main()